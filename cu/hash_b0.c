@@ -16,19 +16,26 @@
  */
 
 #include <cu/hash.h>
+#include <cu/wordarr.h>
 #include <cu/test.h>
 #include <time.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #define clockavg(t, n) ((t)/((double)CLOCKS_PER_SEC*(n)))
 
-int
-main()
+#define BULK_WORDS 256
+
+static volatile cu_word_t _sink;
+
+static void
+_bench_bj(void)
 {
     int sizew;
     cu_word_t arr[8];
 
-    cu_init();
+    printf("%3s %12s%12s%12s%12s\n",
+	   "n", "bj", "bj_noinit", "bj_nw", "bj_nw_noinit");
     for (sizew = 1; sizew <= 8; ++sizew) {
 	int N = 40000000 / (1 + (sizew - 1)/3);
 	int i;
@@ -77,5 +84,98 @@ main()
 	}
 	fputc('\n', stdout);
     }
+}
+
+static void
+_bench_pm_and_cmp(void)
+{
+    int sizew, i;
+    cu_word_t arr0[8], arr1[8];
+
+    for (i = 0; i < 8; ++i)
+	arr0[i] = arr1[i] = lrand48();
+    printf("\n%3s %12s%12s%12s%12s\n", "n", "2pm", "3pm", "eq", "cmp");
+    for (sizew = 1; sizew <= 8; ++sizew) {
+	int N = 40000000 / (1 + (sizew - 1)/3);
+	cu_word_t acc = 0;
+	clock_t t_2pm, t_3pm, t_eq, t_cmp;
+
+	t_2pm = -clock();
+	for (i = 0; i < N; ++i)
+	    acc += cu_wordarr_hash_2pm(sizew, arr0, 0);
+	t_2pm += clock();
+
+	t_3pm = -clock();
+	for (i = 0; i < N; ++i)
+	    acc += cu_wordarr_hash_3pm(sizew, arr0, 0);
+	t_3pm += clock();
+
+	/* Make the arrays differ in the last word a quarter of the time, as
+	 * they would on hash collisions. */
+	t_eq = -clock();
+	for (i = 0; i < N; ++i) {
+	    arr1[sizew - 1] ^= (i & 3) == 0;
+	    acc += cu_wordarr_eq(sizew, arr0, arr1);
+	    arr1[sizew - 1] = arr0[sizew - 1];
+	}
+	t_eq += clock();
+
+	t_cmp = -clock();
+	for (i = 0; i < N; ++i) {
+	    arr1[sizew - 1] ^= (i & 3) == 0;
+	    acc += cu_wordarr_cmp(sizew, arr0, arr1);
+	    arr1[sizew - 1] = arr0[sizew - 1];
+	}
+	t_cmp += clock();
+
+	_sink = acc;
+	printf("%3d %12lg%12lg%12lg%12lg\n", sizew,
+	       clockavg(t_2pm, N), clockavg(t_3pm, N),
+	       clockavg(t_eq, N), clockavg(t_cmp, N));
+    }
+}
+
+static void
+_bench_bulk(void)
+{
+    int i;
+    int N = 400000;
+    cu_word_t src0[BULK_WORDS + 1], src1[BULK_WORDS + 1], dst[BULK_WORDS];
+    clock_t t_and, t_skewcopy, t_skewxor;
+
+    for (i = 0; i <= BULK_WORDS; ++i) {
+	src0[i] = lrand48();
+	src1[i] = lrand48();
+    }
+
+    t_and = -clock();
+    for (i = 0; i < N; ++i)
+	cu_wordarr_copy_bitimg2(CU_BOOL2F_AND, BULK_WORDS, dst, src0, src1);
+    t_and += clock();
+
+    t_skewcopy = -clock();
+    for (i = 0; i < N; ++i)
+	cu_wordarr_skewcopy(BULK_WORDS, dst, 13, src0);
+    t_skewcopy += clock();
+
+    t_skewxor = -clock();
+    for (i = 0; i < N; ++i)
+	cu_wordarr_skewcopy_bitimg2(CU_BOOL2F_XOR, BULK_WORDS, dst,
+				    13, src0, 29, src1);
+    t_skewxor += clock();
+
+    _sink = dst[BULK_WORDS - 1];
+    printf("\n%d words: and %lg, skewcopy %lg, skewed xor %lg\n", BULK_WORDS,
+	   clockavg(t_and, N), clockavg(t_skewcopy, N),
+	   clockavg(t_skewxor, N));
+}
+
+int
+main()
+{
+    cu_init();
+    _bench_bj();
+    _bench_pm_and_cmp();
+    _bench_bulk();
     return 2*!!cu_test_bug_count();
 }
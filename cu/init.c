@@ -37,6 +37,7 @@ void cuP_diag_init(void);
 void cuP_idr_init(void);
 void cuP_str_init(void);
 void cuP_wstring_init(void);
+void cuP_wordarr_init(void);
 
 cu_bool_t cuP_locale_is_utf8;
 pthread_mutexattr_t cuP_mutexattr;
@@ -169,6 +170,8 @@ cu_init(void)
     cuP_memory_init();
     cuP_diag_init();
     cuP_debug_init();
+    if (!cuconf_get_bool("CU_DISABLE_SIMD"))
+	cuP_wordarr_init();
 
     /* Now, we can emit warnings. */
     if (warn_hash_func)
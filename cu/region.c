@@ -0,0 +1,114 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cu/region.h>
+#include <cu/memory.h>
+#include <cu/tstate.h>
+#include <string.h>
+
+#define MIN_CHUNK_SIZE 0x2000
+#define MAX_CHUNK_SIZE 0x100000
+
+struct cuP_region_chunk
+{
+    struct cuP_region_chunk *prev;
+    char *end;
+    char *used_end;	/* set when the chunk is left */
+};
+
+#define CHUNK_HEADER_SIZE cu_size_alignceil(sizeof(struct cuP_region_chunk))
+#define CHUNK_DATA(chunk) ((char *)(chunk) + CHUNK_HEADER_SIZE)
+
+void
+cu_region_init(cu_region_t region)
+{
+    region->chunk = NULL;
+    region->free_ptr = region->free_end = NULL;
+}
+
+cu_region_t
+cu_region_new(void)
+{
+    cu_region_t region = cu_gnew(struct cu_region);
+    cu_region_init(region);
+    return region;
+}
+
+void *
+cuP_region_alloc_slow(cu_region_t region, size_t size)
+{
+    struct cuP_region_chunk *chunk;
+    size_t chunk_size = MIN_CHUNK_SIZE;
+    char *ptr;
+
+    if (region->chunk) {
+	chunk_size = (region->free_end - CHUNK_DATA(region->chunk))*2;
+	if (chunk_size > MAX_CHUNK_SIZE)
+	    chunk_size = MAX_CHUNK_SIZE;
+	region->chunk->used_end = region->free_ptr;
+    }
+    if (chunk_size < size)
+	chunk_size = size;
+    chunk = cu_galloc(CHUNK_HEADER_SIZE + chunk_size);
+    chunk->prev = region->chunk;
+    chunk->end = CHUNK_DATA(chunk) + chunk_size;
+    region->chunk = chunk;
+    ptr = CHUNK_DATA(chunk);
+    region->free_ptr = ptr + size;
+    region->free_end = chunk->end;
+    return ptr;
+}
+
+void
+cu_region_pop(cu_region_t region, cu_region_mark_t mark)
+{
+    char *used_end;
+    if (!mark->chunk) {
+	cu_region_drop(region);
+	return;
+    }
+    if (region->chunk == mark->chunk)
+	used_end = region->free_ptr;
+    else
+	used_end = mark->chunk->used_end;
+    memset(mark->free_ptr, 0, used_end - mark->free_ptr);
+    region->chunk = mark->chunk;
+    region->free_ptr = mark->free_ptr;
+    region->free_end = mark->chunk->end;
+}
+
+size_t
+cu_region_byte_count(cu_region_t region)
+{
+    struct cuP_region_chunk *chunk = region->chunk;
+    size_t count;
+    if (!chunk)
+	return 0;
+    count = region->free_ptr - CHUNK_DATA(chunk);
+    for (chunk = chunk->prev; chunk; chunk = chunk->prev)
+	count += chunk->end - CHUNK_DATA(chunk);
+    return count;
+}
+
+cu_region_t
+cu_tregion(void)
+{
+    cuP_tstate_t tstate = cuP_tstate();
+    if (!tstate->region)
+	tstate->region = cu_region_new();
+    return tstate->region;
+}
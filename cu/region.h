@@ -0,0 +1,112 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CU_REGION_H
+#define CU_REGION_H
+
+#include <cu/fwd.h>
+#include <cu/size.h>
+
+CU_BEGIN_DECLARATIONS
+/** \defgroup cu_region_h cu/region.h: Region Allocation
+ ** @{ \ingroup cu_util_mod
+ **
+ ** A region hands out memory by incrementing a pointer into a chunk of
+ ** collectable memory, and frees it all at once, either completely with \ref
+ ** cu_region_drop or back to a mark saved by \ref cu_region_push.  This is
+ ** meant for algorithms which build many short-lived nodes, since the
+ ** collector only sees a few large chunks instead of the individual nodes.
+ **
+ ** The chunks are traced, so objects in a region keep other collectable
+ ** objects alive, and the region keeps its chunks alive.  Pointers into a
+ ** region must not be used after the memory has been released by \ref
+ ** cu_region_pop or \ref cu_region_drop, and must not be passed to \ref
+ ** cu_gfree.  Memory returned by \ref cu_region_alloc is zeroed and fully
+ ** aligned.  A region is not thread-safe, but \ref cu_tregion provides one
+ ** region per thread. */
+
+struct cuP_region_chunk;
+
+/** A region allocator. */
+struct cu_region
+{
+    struct cuP_region_chunk *chunk;
+    char *free_ptr;
+    char *free_end;
+};
+
+/** A saved allocation point of a region. */
+struct cu_region_mark
+{
+    struct cuP_region_chunk *chunk;
+    char *free_ptr;
+};
+
+/** Construct \a region as an empty region. */
+void cu_region_init(cu_region_t region);
+
+/** Return a new empty region. */
+cu_region_t cu_region_new(void);
+
+void *cuP_region_alloc_slow(cu_region_t region, size_t size);
+
+/** Allocate \a size bytes of zeroed memory from \a region. */
+CU_SINLINE void *
+cu_region_alloc(cu_region_t region, size_t size)
+{
+    char *ptr = region->free_ptr;
+    size = cu_size_alignceil(size);
+    if (cu_expect_false((size_t)(region->free_end - ptr) < size))
+	return cuP_region_alloc_slow(region, size);
+    region->free_ptr = ptr + size;
+    return ptr;
+}
+
+/** Save the current allocation point of \a region in \a mark. */
+CU_SINLINE void
+cu_region_push(cu_region_t region, cu_region_mark_t mark)
+{
+    mark->chunk = region->chunk;
+    mark->free_ptr = region->free_ptr;
+}
+
+/** Release all memory allocated from \a region after \a mark was saved.  The
+ ** time is proportional to the memory allocated since \a mark within the
+ ** chunk which was current at the time, since that part is cleared for reuse.
+ ** Later chunks are released in constant time. */
+void cu_region_pop(cu_region_t region, cu_region_mark_t mark);
+
+/** Release all memory allocated from \a region in constant time.  Marks of
+ ** \a region are invalidated. */
+CU_SINLINE void
+cu_region_drop(cu_region_t region)
+{
+    region->chunk = NULL;
+    region->free_ptr = region->free_end = NULL;
+}
+
+/** Returns the number of bytes allocated from \a region, including space
+ ** left unused at the end of all but the current chunk. */
+size_t cu_region_byte_count(cu_region_t region);
+
+/** Returns a region owned by the calling thread. */
+cu_region_t cu_tregion(void);
+
+/** @} */
+CU_END_DECLARATIONS
+
+#endif
@@ -0,0 +1,85 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cu/region.h>
+#include <cu/test.h>
+#include <cu/conf.h>
+#include <cu/memory.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MARK_CNT 16
+#define ALLOC_CNT 10000
+
+static cu_bool_t
+_is_zero(char *p, size_t size)
+{
+    while (size--)
+	if (*p++)
+	    return cu_false;
+    return cu_true;
+}
+
+static void
+_test_marks(cu_region_t region)
+{
+    int i, j;
+    struct cu_region_mark mark_arr[MARK_CNT];
+    size_t count_arr[MARK_CNT];
+
+    for (i = 0; i < MARK_CNT; ++i) {
+	count_arr[i] = cu_region_byte_count(region);
+	cu_region_push(region, &mark_arr[i]);
+	for (j = 0; j < ALLOC_CNT/MARK_CNT; ++j) {
+	    size_t size = lrand48() % (j % 64 == 63? 40000 : 100) + 1;
+	    char *p = cu_region_alloc(region, size);
+	    cu_test_assert(((uintptr_t)p & (CUCONF_MAXALIGN - 1)) == 0);
+	    cu_test_assert(_is_zero(p, size));
+	    memset(p, 0xa5, size);
+	}
+	cu_test_assert(cu_region_byte_count(region) > count_arr[i]);
+    }
+    while (i > 0) {
+	--i;
+	if (lrand48() % 2) {
+	    cu_region_pop(region, &mark_arr[i]);
+	    cu_test_assert(cu_region_byte_count(region) == count_arr[i]);
+	}
+    }
+    cu_region_pop(region, &mark_arr[0]);
+    cu_test_assert(cu_region_byte_count(region) == count_arr[0]);
+}
+
+int
+main()
+{
+    int i;
+    cu_region_t region;
+    cu_init();
+
+    region = cu_region_new();
+    for (i = 0; i < 8; ++i)
+	_test_marks(region);
+    cu_region_drop(region);
+    cu_test_assert(cu_region_byte_count(region) == 0);
+
+    for (i = 0; i < 8; ++i)
+	_test_marks(cu_tregion());
+    cu_test_assert(cu_tregion() == cu_tregion());
+
+    return 2*!!cu_test_bug_count();
+}
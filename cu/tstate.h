@@ -66,6 +66,7 @@ struct cuP_tstate
     void *unord_fl_arr[cuP_FL_CNT];
     cu_rarex_t *jammed_on_rarex;
     cu_bool_t jammed_on_write;
+    struct cu_region *region;
 
     /* cuflow */
     struct cuflowP_windstate *windstate;
@@ -19,6 +19,256 @@
 #include <cu/word.h>
 #include <cu/bool.h>
 #include <cu/util.h>
+#include <cu/size.h>
+
+/* SIMD Kernels
+ * ============
+ *
+ * The binary bit-image operations and the skewed copies are also provided as
+ * SSE2 and AVX2 kernels on x86_64, and the bit count as POPCNT and AVX2
+ * kernels.  They are selected by cuP_wordarr_init according to the features
+ * of the CPU.  Each copy kernel takes a bit offset for each source, which may
+ * be zero, and covers the vector part of the loop with unaligned loads,
+ * leaving the last few words to a scalar loop.  The vector loop stops one word
+ * short of the end, so it reads no further than the corresponding scalar
+ * code. */
+
+#if CU_WORD_WIDTH == 64 && defined(__x86_64__) && defined(__GNUC__)
+#  define CUP_WORDARR_X86 1
+#  include <immintrin.h>
+#endif
+
+#ifdef CUP_WORDARR_X86
+
+/* Below this many words, the scalar loops are used. */
+#define SIMD_MIN_COUNT 8
+
+typedef void (*_kern1_t)(size_t count, cu_word_t *dst,
+			 int offset, cu_word_t const *src);
+typedef void (*_kern2_t)(size_t count, cu_word_t *dst,
+			 int offset0, cu_word_t const *src0,
+			 int offset1, cu_word_t const *src1);
+
+static _kern1_t _skewcopy_kern;
+static _kern1_t _skewcopy_bitnot_kern;
+static _kern2_t _bitimg2_kern_arr[16];
+static size_t (*_bit_count_kern)(size_t count, cu_word_t const *arr);
+
+CU_SINLINE cu_word_t
+_skewword(cu_word_t const *src, size_t i, int offset)
+{
+    if (offset == 0)
+	return src[i];
+    else
+	return (src[i] >> offset) | (src[i + 1] << (CU_WORD_WIDTH - offset));
+}
+
+#define _SKEWLOAD(src, i, lsh, rsh)					\
+    V_OR(V_SRL(V_LOADU((src) + (i)), lsh),				\
+	 V_SLL(V_LOADU((src) + (i) + 1), rsh))
+
+#define _KERN1_DEF(isa, name, vexpr, sexpr)				\
+    static CUP_TARGET_##isa void					\
+    _##isa##_##name(size_t count, cu_word_t *dst,			\
+		    int offset0, cu_word_t const *src0)			\
+    {									\
+	__m128i lsh0 = _mm_cvtsi32_si128(offset0);			\
+	__m128i rsh0 = _mm_cvtsi32_si128(CU_WORD_WIDTH - offset0);	\
+	V_T ones = V_ONES();						\
+	size_t i;							\
+	for (i = 0; i + V_WORDS < count; i += V_WORDS) {		\
+	    V_T x0 = _SKEWLOAD(src0, i, lsh0, rsh0);			\
+	    V_STOREU(dst + i, vexpr);					\
+	}								\
+	(void)ones;							\
+	for (; i < count; ++i) {					\
+	    cu_word_t x0 = _skewword(src0, i, offset0);			\
+	    dst[i] = sexpr;						\
+	}								\
+    }
+
+#define _KERN2_DEF(isa, name, vexpr, sexpr)				\
+    static CUP_TARGET_##isa void					\
+    _##isa##_##name(size_t count, cu_word_t *dst,			\
+		    int offset0, cu_word_t const *src0,			\
+		    int offset1, cu_word_t const *src1)			\
+    {									\
+	__m128i lsh0 = _mm_cvtsi32_si128(offset0);			\
+	__m128i rsh0 = _mm_cvtsi32_si128(CU_WORD_WIDTH - offset0);	\
+	__m128i lsh1 = _mm_cvtsi32_si128(offset1);			\
+	__m128i rsh1 = _mm_cvtsi32_si128(CU_WORD_WIDTH - offset1);	\
+	V_T ones = V_ONES();						\
+	size_t i;							\
+	for (i = 0; i + V_WORDS < count; i += V_WORDS) {		\
+	    V_T x0 = _SKEWLOAD(src0, i, lsh0, rsh0);			\
+	    V_T x1 = _SKEWLOAD(src1, i, lsh1, rsh1);			\
+	    V_STOREU(dst + i, vexpr);					\
+	}								\
+	(void)ones;							\
+	for (; i < count; ++i) {					\
+	    cu_word_t x0 = _skewword(src0, i, offset0);			\
+	    cu_word_t x1 = _skewword(src1, i, offset1);			\
+	    dst[i] = sexpr;						\
+	}								\
+    }
+
+#define _KERN_DEFS(isa)							\
+    _KERN1_DEF(isa, skewcopy, x0, x0)					\
+    _KERN1_DEF(isa, skewcopy_bitnot, V_XOR(x0, ones), ~x0)		\
+    _KERN2_DEF(isa, nor, V_XOR(V_OR(x0, x1), ones), ~(x0 | x1))		\
+    _KERN2_DEF(isa, xor, V_XOR(x0, x1), x0 ^ x1)			\
+    _KERN2_DEF(isa, nand, V_XOR(V_AND(x0, x1), ones), ~(x0 & x1))	\
+    _KERN2_DEF(isa, and, V_AND(x0, x1), x0 & x1)			\
+    _KERN2_DEF(isa, iff, V_XOR(V_XOR(x0, x1), ones), ~(x0 ^ x1))	\
+    _KERN2_DEF(isa, or, V_OR(x0, x1), x0 | x1)				\
+    _KERN2_DEF(isa, not_and, V_ANDNOT(x0, x1), ~x0 & x1)		\
+    _KERN2_DEF(isa, and_not, V_ANDNOT(x1, x0), x0 & ~x1)		\
+    _KERN2_DEF(isa, not_or, V_OR(V_XOR(x0, ones), x1), ~x0 | x1)	\
+    _KERN2_DEF(isa, or_not, V_OR(x0, V_XOR(x1, ones)), x0 | ~x1)
+
+/* SSE2 is part of the x86_64 base architecture. */
+#define CUP_TARGET_sse2
+#define V_T		__m128i
+#define V_WORDS		2
+#define V_LOADU(p)	_mm_loadu_si128((__m128i const *)(p))
+#define V_STOREU(p, x)	_mm_storeu_si128((__m128i *)(p), x)
+#define V_ONES()	_mm_set1_epi32(-1)
+#define V_OR		_mm_or_si128
+#define V_AND		_mm_and_si128
+#define V_XOR		_mm_xor_si128
+#define V_ANDNOT	_mm_andnot_si128
+#define V_SRL		_mm_srl_epi64
+#define V_SLL		_mm_sll_epi64
+_KERN_DEFS(sse2)
+#undef V_T
+#undef V_WORDS
+#undef V_LOADU
+#undef V_STOREU
+#undef V_ONES
+#undef V_OR
+#undef V_AND
+#undef V_XOR
+#undef V_ANDNOT
+#undef V_SRL
+#undef V_SLL
+
+#define CUP_TARGET_avx2 __attribute__((target("avx2")))
+#define V_T		__m256i
+#define V_WORDS		4
+#define V_LOADU(p)	_mm256_loadu_si256((__m256i const *)(p))
+#define V_STOREU(p, x)	_mm256_storeu_si256((__m256i *)(p), x)
+#define V_ONES()	_mm256_set1_epi32(-1)
+#define V_OR		_mm256_or_si256
+#define V_AND		_mm256_and_si256
+#define V_XOR		_mm256_xor_si256
+#define V_ANDNOT	_mm256_andnot_si256
+#define V_SRL		_mm256_srl_epi64
+#define V_SLL		_mm256_sll_epi64
+_KERN_DEFS(avx2)
+
+static __attribute__((target("popcnt"))) size_t
+_popcnt_bit_count(size_t count, cu_word_t const *arr)
+{
+    size_t n0 = 0, n1 = 0, n2 = 0, n3 = 0;
+    for (; count >= 4; count -= 4, arr += 4) {
+	n0 += __builtin_popcountll(arr[0]);
+	n1 += __builtin_popcountll(arr[1]);
+	n2 += __builtin_popcountll(arr[2]);
+	n3 += __builtin_popcountll(arr[3]);
+    }
+    while (count--)
+	n0 += __builtin_popcountll(*arr++);
+    return n0 + n1 + n2 + n3;
+}
+
+/* Counts bits of each nibble by table lookup with vpshufb, and sums the bytes
+ * with vpsadbw.  Byte sums are flushed before they can overflow, which is
+ * after 31 vectors at most 8 bits per byte each. */
+static __attribute__((target("avx2,popcnt"))) size_t
+_avx2_bit_count(size_t count, cu_word_t const *arr)
+{
+    __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3,
+				      1, 2, 2, 3, 2, 3, 3, 4,
+				      0, 1, 1, 2, 1, 2, 2, 3,
+				      1, 2, 2, 3, 2, 3, 3, 4);
+    __m256i low_mask = _mm256_set1_epi8(0x0f);
+    __m256i zero = _mm256_setzero_si256();
+    __m256i acc = zero;
+    size_t n;
+    while (count >= 4) {
+	size_t vec_cnt = cu_size_min(count/4, 31);
+	__m256i byte_acc = zero;
+	count -= 4*vec_cnt;
+	while (vec_cnt--) {
+	    __m256i x = _mm256_loadu_si256((__m256i const *)arr);
+	    __m256i lo = _mm256_and_si256(x, low_mask);
+	    __m256i hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), low_mask);
+	    byte_acc = _mm256_add_epi8(byte_acc,
+				       _mm256_shuffle_epi8(lookup, lo));
+	    byte_acc = _mm256_add_epi8(byte_acc,
+				       _mm256_shuffle_epi8(lookup, hi));
+	    arr += 4;
+	}
+	acc = _mm256_add_epi64(acc, _mm256_sad_epu8(byte_acc, zero));
+    }
+    n = _mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1)
+      + _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3);
+    while (count--)
+	n += __builtin_popcountll(*arr++);
+    return n;
+}
+
+#define _KERN_SET(isa)							\
+    do {								\
+	_skewcopy_kern = _##isa##_skewcopy;				\
+	_skewcopy_bitnot_kern = _##isa##_skewcopy_bitnot;		\
+	_bitimg2_kern_arr[CU_BOOL2F_NOR] = _##isa##_nor;		\
+	_bitimg2_kern_arr[CU_BOOL2F_XOR] = _##isa##_xor;		\
+	_bitimg2_kern_arr[CU_BOOL2F_NAND] = _##isa##_nand;		\
+	_bitimg2_kern_arr[CU_BOOL2F_AND] = _##isa##_and;		\
+	_bitimg2_kern_arr[CU_BOOL2F_IFF] = _##isa##_iff;		\
+	_bitimg2_kern_arr[CU_BOOL2F_OR] = _##isa##_or;			\
+	_bitimg2_kern_arr[CU_BOOL2F_NOT_AND] = _##isa##_not_and;	\
+	_bitimg2_kern_arr[CU_BOOL2F_AND_NOT] = _##isa##_and_not;	\
+	_bitimg2_kern_arr[CU_BOOL2F_NOT_OR] = _##isa##_not_or;		\
+	_bitimg2_kern_arr[CU_BOOL2F_OR_NOT] = _##isa##_or_not;		\
+    } while (0)
+
+void
+cuP_wordarr_init(void)
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+	_KERN_SET(avx2);
+    else
+	_KERN_SET(sse2);
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+	_bit_count_kern = _avx2_bit_count;
+    else if (__builtin_cpu_supports("popcnt"))
+	_bit_count_kern = _popcnt_bit_count;
+}
+
+#else /* !CUP_WORDARR_X86 */
+
+void
+cuP_wordarr_init(void)
+{
+}
+
+#endif /* !CUP_WORDARR_X86 */
+
+size_t
+cu_wordarr_bit_count(size_t count, cu_word_t const *arr)
+{
+    size_t n = 0;
+#ifdef CUP_WORDARR_X86
+    if (_bit_count_kern)
+	return (*_bit_count_kern)(count, arr);
+#endif
+    while (count--)
+	n += cu_word_bit_count(*arr++);
+    return n;
+}
 
 void
 cu_wordarr_copy_bitimg(cu_bool1f_t f, size_t count, cu_word_t *dst,
@@ -44,6 +294,12 @@ void
 cu_wordarr_copy_bitimg2(cu_bool2f_t f, size_t count, cu_word_t *dst,
 			cu_word_t const *left, cu_word_t const *right)
 {
+#ifdef CUP_WORDARR_X86
+    if (count >= SIMD_MIN_COUNT && _bitimg2_kern_arr[f]) {
+	(*_bitimg2_kern_arr[f])(count, dst, 0, left, 0, right);
+	return;
+    }
+#endif
     switch (f) {
 	case CU_BOOL2F_FALSE:
 	    cu_wordarr_fill(count, dst, CU_WORD_C(0));
@@ -129,6 +385,12 @@ cu_wordarr_skewcopy(size_t count, cu_word_t *dst,
 	cu_wordarr_copy(count, dst, src);
 	return;
     }
+#ifdef CUP_WORDARR_X86
+    if (count >= SIMD_MIN_COUNT && _skewcopy_kern) {
+	(*_skewcopy_kern)(count, dst, src_offset, src);
+	return;
+    }
+#endif
 
     a = *src++;
     while (count--) {
@@ -148,6 +410,12 @@ cu_wordarr_skewcopy_bitnot(size_t count, cu_word_t *dst,
 	cu_wordarr_copy_bitnot(count, dst, src);
 	return;
     }
+#ifdef CUP_WORDARR_X86
+    if (count >= SIMD_MIN_COUNT && _skewcopy_bitnot_kern) {
+	(*_skewcopy_bitnot_kern)(count, dst, src_offset, src);
+	return;
+    }
+#endif
 
     a = *src++;
     while (count--) {
@@ -326,6 +594,13 @@ cu_wordarr_skewcopy_bitimg2(cu_bool2f_t f, size_t count, cu_word_t *dst,
 	    break;
     }
 
+#ifdef CUP_WORDARR_X86
+    if (count >= SIMD_MIN_COUNT && _bitimg2_kern_arr[f]) {
+	(*_bitimg2_kern_arr[f])(count, dst, offset0, src0, offset1, src1);
+	return;
+    }
+#endif
+
     /* The case where offset0 or offset1 is zero must be handled specially not
      * only for efficiency, but also to avoid reading past the end of src0 or
      * src1. */
@@ -77,6 +77,9 @@ cu_wordarr_copy_bitnot(size_t count, cu_word_t *dst, cu_word_t const *src)
     }
 }
 
+/** The number of set bits in the \a count words starting at \a arr. */
+size_t cu_wordarr_bit_count(size_t count, cu_word_t const *arr);
+
 /** Store to \a dst upto \a dst + \a count the bitwise image of \a src upwards
  ** under \a f. */
 void cu_wordarr_copy_bitimg(cu_bool1f_t f, size_t count, cu_word_t *dst,
@@ -189,32 +189,22 @@ size_t
 cucon_bitarray_find(cucon_bitarray_t ba, size_t start, cu_bool_t val)
 {
     size_t size = ba->size;
-    size_t i, l, r;
+    size_t i, r;
     size_t n = cu_size_ceil_div(ba->size, CU_WORD_WIDTH);
     cu_word_t *arr = ba->arr;
+    cu_word_t flip = val? CU_WORD_C(0) : ~CU_WORD_C(0);
+    cu_word_t x;
+    if (start >= size)
+	return (size_t)-1;
     i = start / CU_WORD_WIDTH;
-    l = start % CU_WORD_WIDTH;
-    if (l) {
-	if (arr[i]) {
-	    r = i*CU_WORD_WIDTH + cu_size_log2_lowbit(arr[i] >> l) + l;
-	    return r >= size? (size_t)-1 : r;
-	}
-	++i;
-    }
-    if (val) {
-	for (; i < n; ++i)
-	    if (arr[i] != 0) {
-		r = i*CU_WORD_WIDTH + cu_size_log2_lowbit(arr[i]);
-		return r >= size? (size_t)-1 : r;
-	    }
-    } else {
-	for (; i < n; ++i)
-	    if (~arr[i] != 0) {
-		r = i*CU_WORD_WIDTH + cu_size_log2_lowbit(~arr[i]);
-		return r >= size? (size_t)-1 : r;
-	    }
+    x = (arr[i] ^ flip) & ~WORD_MASK(start % CU_WORD_WIDTH);
+    while (!x) {
+	if (++i >= n)
+	    return (size_t)-1;
+	x = arr[i] ^ flip;
     }
-    return (size_t)-1;
+    r = i*CU_WORD_WIDTH + cu_word_log2_lowbit(x);
+    return r >= size? (size_t)-1 : r;
 }
 
 size_t
@@ -231,8 +221,9 @@ cucon_bitarray_find2(cucon_bitarray_t ba0, cucon_bitarray_t ba1, size_t start,
     l = start % CU_WORD_WIDTH;
     if (l) {
 	x01 = (val0? arr0[i] : ~arr0[i]) & (val1? arr1[i] : ~arr1[i]);
+	x01 &= ~WORD_MASK(l);
 	if (x01) {
-	    r = i*CU_WORD_WIDTH + (cu_size_log2_lowbit(x01 >> l) + l);
+	    r = i*CU_WORD_WIDTH + cu_size_log2_lowbit(x01);
 	    return r >= size? (size_t)-1 : r;
 	}
 	++i;
@@ -247,6 +238,32 @@ cucon_bitarray_find2(cucon_bitarray_t ba0, cucon_bitarray_t ba1, size_t start,
     return (size_t)-1;
 }
 
+size_t
+cucon_bitarray_popcount(cucon_bitarray_t ba)
+{
+    return cucon_bitarray_popcount_range(ba, 0, ba->size);
+}
+
+size_t
+cucon_bitarray_popcount_range(cucon_bitarray_t ba, size_t i, size_t j)
+{
+    size_t iword = i/CU_WORD_WIDTH;
+    size_t ibit = i%CU_WORD_WIDTH;
+    size_t jword = j/CU_WORD_WIDTH;
+    size_t jbit = j%CU_WORD_WIDTH;
+    size_t n;
+    if (i >= j)
+	return 0;
+    if (iword == jword)
+	return cu_word_bit_count(ba->arr[iword]
+				 & (WORD_MASK(jbit) & ~WORD_MASK(ibit)));
+    n = cu_word_bit_count(ba->arr[iword] & ~WORD_MASK(ibit));
+    n += cu_wordarr_bit_count(jword - iword - 1, ba->arr + iword + 1);
+    if (jbit)
+	n += cu_word_bit_count(ba->arr[jword] & WORD_MASK(jbit));
+    return n;
+}
+
 static void
 _bitarray_realloc(cucon_bitarray_t ba, size_t new_cap, size_t new_size)
 {
@@ -385,3 +402,104 @@ cucon_bitarray_update_img_bool2f(cu_bool2f_t f, cucon_bitarray_t ba,
     cu_wordarr_copy_bitimg2(f, cu_size_ceil_div(ba->size, CU_WORD_WIDTH),
 			    ba->arr, ba->arr, ba_src->arr);
 }
+
+
+/* Rank and Select
+ * =============== */
+
+#define RS_BLOCK_BITS 512
+#define RS_BLOCK_WORDS (RS_BLOCK_BITS/CU_WORD_WIDTH)
+
+void
+cucon_bitarray_rsindex_init(cucon_bitarray_rsindex_t index,
+			    cucon_bitarray_t ba)
+{
+    size_t size = ba->size;
+    size_t block_cnt = cu_size_ceil_div(size, RS_BLOCK_BITS);
+    size_t k, n = 0;
+    index->ba = ba;
+    index->block_cnt = block_cnt;
+    index->rank_arr = cu_galloc_atomic(sizeof(size_t)*(block_cnt + 1));
+    for (k = 0; k < block_cnt; ++k) {
+	index->rank_arr[k] = n;
+	n += cucon_bitarray_popcount_range(
+		ba, k*RS_BLOCK_BITS, cu_size_min((k + 1)*RS_BLOCK_BITS, size));
+    }
+    index->rank_arr[block_cnt] = n;
+}
+
+cucon_bitarray_rsindex_t
+cucon_bitarray_rsindex_new(cucon_bitarray_t ba)
+{
+    cucon_bitarray_rsindex_t index = cu_gnew(struct cucon_bitarray_rsindex);
+    cucon_bitarray_rsindex_init(index, ba);
+    return index;
+}
+
+size_t
+cucon_bitarray_rsindex_rank(cucon_bitarray_rsindex_t index, size_t i)
+{
+    cu_word_t *arr = index->ba->arr;
+    size_t iword = i/CU_WORD_WIDTH;
+    size_t ibit = i%CU_WORD_WIDTH;
+    size_t k = i/RS_BLOCK_BITS;
+    size_t n = index->rank_arr[k];
+    cu_debug_assert(i <= index->ba->size);
+    n += cu_wordarr_bit_count(iword - k*RS_BLOCK_WORDS,
+			      arr + k*RS_BLOCK_WORDS);
+    if (ibit)
+	n += cu_word_bit_count(arr[iword] & WORD_MASK(ibit));
+    return n;
+}
+
+/* The position of set bit number j of x, which must have more than j set
+ * bits.  The word is narrowed down by halves to a byte before stepping. */
+static unsigned int
+_word_select(cu_word_t x, size_t j)
+{
+    unsigned int pos = 0;
+    int w;
+    for (w = CU_WORD_WIDTH/2; w >= 8; w /= 2) {
+	size_t c = cu_word_bit_count(x & WORD_MASK(w));
+	if (j >= c) {
+	    j -= c;
+	    x >>= w;
+	    pos += w;
+	}
+    }
+    while (j--)
+	x &= x - CU_WORD_C(1);
+    return pos + cu_word_log2_lowbit(x);
+}
+
+size_t
+cucon_bitarray_rsindex_select(cucon_bitarray_rsindex_t index, size_t j)
+{
+    size_t *rank_arr = index->rank_arr;
+    cu_word_t *arr = index->ba->arr;
+    size_t k_min = 0, k_max = index->block_cnt;
+    size_t i;
+
+    if (j >= rank_arr[index->block_cnt])
+	return (size_t)-1;
+
+    /* Find the last block starting with at most j set bits before it. */
+    while (k_max - k_min > 1) {
+	size_t k_mid = (k_min + k_max)/2;
+	if (rank_arr[k_mid] <= j)
+	    k_min = k_mid;
+	else
+	    k_max = k_mid;
+    }
+    j -= rank_arr[k_min];
+
+    /* Scan the block.  Bits past the end of the array can only come after
+     * the target, since there are more than j set bits before the end. */
+    for (i = k_min*RS_BLOCK_WORDS;; ++i) {
+	cu_word_t x = arr[i];
+	size_t c = cu_word_bit_count(x);
+	if (j < c)
+	    return i*CU_WORD_WIDTH + _word_select(x, j);
+	j -= c;
+    }
+}
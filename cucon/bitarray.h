@@ -104,9 +104,28 @@ cucon_bitarray_at(cucon_bitarray_t ba, size_t i)
  ** value, or \c -1 if not found. */
 size_t cucon_bitarray_find(cucon_bitarray_t ba, size_t start, cu_bool_t value);
 
+/** Return the lowest index greater or equal to \a start where \a ba holds a
+ ** set bit, or \c -1 if not found. */
+CU_SINLINE size_t
+cucon_bitarray_find_next_set(cucon_bitarray_t ba, size_t start)
+{ return cucon_bitarray_find(ba, start, cu_true); }
+
+/** Return the lowest index greater or equal to \a start where \a ba holds a
+ ** cleared bit, or \c -1 if not found. */
+CU_SINLINE size_t
+cucon_bitarray_find_next_clear(cucon_bitarray_t ba, size_t start)
+{ return cucon_bitarray_find(ba, start, cu_false); }
+
 size_t cucon_bitarray_find2(cucon_bitarray_t ba0, cucon_bitarray_t ba1,
 			    size_t start, cu_bool_t val0, cu_bool_t val1);
 
+/** The number of set bits in \a ba. */
+size_t cucon_bitarray_popcount(cucon_bitarray_t ba);
+
+/** The number of set bits in the range [\a low, \a high) of \a ba. */
+size_t cucon_bitarray_popcount_range(cucon_bitarray_t ba,
+				     size_t low, size_t high);
+
 /** Resize \a ba to \a size, adjusting the capacity in geometric progression as
  ** needed. */
 void cucon_bitarray_resize_gp(cucon_bitarray_t ba, size_t size);
@@ -167,6 +186,54 @@ void cucon_bitarray_update_img_bool1f(cu_bool1f_t f, cucon_bitarray_t ba);
 void cucon_bitarray_update_img_bool2f(cu_bool2f_t f, cucon_bitarray_t ba,
 				      cucon_bitarray_t arg1);
 
+/** Set \a ba to the bitwise conjunction of itself and \a src. */
+CU_SINLINE void
+cucon_bitarray_update_and(cucon_bitarray_t ba, cucon_bitarray_t src)
+{ cucon_bitarray_update_img_bool2f(CU_BOOL2F_AND, ba, src); }
+
+/** Set \a ba to the bitwise disjunction of itself and \a src. */
+CU_SINLINE void
+cucon_bitarray_update_or(cucon_bitarray_t ba, cucon_bitarray_t src)
+{ cucon_bitarray_update_img_bool2f(CU_BOOL2F_OR, ba, src); }
+
+/** Set \a ba to the bitwise exclusive disjunction of itself and \a src. */
+CU_SINLINE void
+cucon_bitarray_update_xor(cucon_bitarray_t ba, cucon_bitarray_t src)
+{ cucon_bitarray_update_img_bool2f(CU_BOOL2F_XOR, ba, src); }
+
+/** Clear the bits of \a ba which are set in \a src. */
+CU_SINLINE void
+cucon_bitarray_update_and_not(cucon_bitarray_t ba, cucon_bitarray_t src)
+{ cucon_bitarray_update_img_bool2f(CU_BOOL2F_AND_NOT, ba, src); }
+
+/** A rank and select index over a bit array.  It stores the number of set
+ ** bits preceding each block of 512 bits, so that \ref
+ ** cucon_bitarray_rsindex_rank takes constant time and \ref
+ ** cucon_bitarray_rsindex_select takes logarithmic time.  The index must be
+ ** rebuilt after the bit array is modified. */
+struct cucon_bitarray_rsindex
+{
+    cucon_bitarray_t ba;
+    size_t block_cnt;
+    size_t *rank_arr;
+};
+
+/** Construct \a index as a rank and select index for \a ba. */
+void cucon_bitarray_rsindex_init(cucon_bitarray_rsindex_t index,
+				 cucon_bitarray_t ba);
+
+/** Return a rank and select index for \a ba. */
+cucon_bitarray_rsindex_t cucon_bitarray_rsindex_new(cucon_bitarray_t ba);
+
+/** The number of set bits before position \a i of the indexed array.
+ ** \pre \a i is at most the size of the array. */
+size_t cucon_bitarray_rsindex_rank(cucon_bitarray_rsindex_t index, size_t i);
+
+/** The position of set bit number \a j counting from 0, or \c -1 if the
+ ** indexed array has no more than \a j set bits. */
+size_t cucon_bitarray_rsindex_select(cucon_bitarray_rsindex_t index,
+				     size_t j);
+
 /** @} */
 CU_END_DECLARATIONS
 
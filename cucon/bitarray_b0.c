@@ -19,6 +19,7 @@
 #include <cu/test.h>
 #include <time.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #define REPEAT 100
 #define ARR_SIZE 1000000
@@ -54,10 +55,82 @@ _test()
 	   _time_per_call(t_set), _time_per_call(t_get));
 }
 
+static double
+_time_per_bit(clock_t t)
+{
+    return t/((double)CLOCKS_PER_SEC*REPEAT*ARR_SIZE);
+}
+
+static void
+_bench_bulk()
+{
+    size_t i, repeat;
+    size_t n_pop = 0, n_find = 0, n_rank = 0;
+    clock_t t_and = 0, t_or = 0, t_pop = 0, t_find = 0, t_rank = 0;
+    clock_t t_select = 0;
+    struct cucon_bitarray ba0, ba1, sparse;
+    struct cucon_bitarray_rsindex index;
+
+    cucon_bitarray_init(&ba0, ARR_SIZE);
+    cucon_bitarray_init(&ba1, ARR_SIZE);
+    cucon_bitarray_init_fill(&sparse, ARR_SIZE, cu_false);
+    for (i = 0; i < ARR_SIZE; ++i) {
+	cucon_bitarray_set_at(&ba0, i, lrand48() % 2);
+	cucon_bitarray_set_at(&ba1, i, lrand48() % 2);
+	if (lrand48() % 100 == 0)
+	    cucon_bitarray_set_at(&sparse, i, cu_true);
+    }
+    cucon_bitarray_rsindex_init(&index, &ba0);
+
+    for (repeat = 0; repeat < REPEAT; ++repeat) {
+	t_and -= clock();
+	cucon_bitarray_update_and(&ba1, &ba0);
+	t_and += clock();
+
+	t_or -= clock();
+	cucon_bitarray_update_or(&ba1, &ba0);
+	t_or += clock();
+
+	t_pop -= clock();
+	n_pop += cucon_bitarray_popcount(&ba0);
+	t_pop += clock();
+
+	t_find -= clock();
+	for (i = cucon_bitarray_find_next_set(&sparse, 0); i != (size_t)-1;
+	     i = cucon_bitarray_find_next_set(&sparse, i + 1))
+	    ++n_find;
+	t_find += clock();
+
+	t_rank -= clock();
+	for (i = 0; i < ARR_SIZE; i += 97)
+	    n_rank += cucon_bitarray_rsindex_rank(&index, i);
+	t_rank += clock();
+
+	t_select -= clock();
+	for (i = 0; i < ARR_SIZE/2; i += 97)
+	    n_rank += cucon_bitarray_rsindex_select(&index, i/2);
+	t_select += clock();
+    }
+    printf("Per bit:\n"
+	   "t_and:    %12.2lg\n"
+	   "t_or:     %12.2lg\n"
+	   "t_pop:    %12.2lg\n"
+	   "t_find:   %12.2lg  (1%% density)\n"
+	   "Per query:\n"
+	   "t_rank:   %12.2lg\n"
+	   "t_select: %12.2lg\n",
+	   _time_per_bit(t_and), _time_per_bit(t_or),
+	   _time_per_bit(t_pop), _time_per_bit(t_find),
+	   _time_per_bit(t_rank)*97, _time_per_bit(t_select)*97*2);
+    if (n_pop + n_find + n_rank == 0)
+	fputc('\n', stdout);
+}
+
 int
 main()
 {
     cucon_init();
     _test();
+    _bench_bulk();
     return 2*!!cu_test_bug_count();
 }
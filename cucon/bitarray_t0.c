@@ -178,6 +178,46 @@ _test_img(size_t size)
     }
 }
 
+static void
+_test_count_and_rank(size_t size)
+{
+    size_t i, j, k, n;
+    cucon_bitarray_t ba = _new_random(size);
+    struct cucon_bitarray_rsindex index;
+
+    n = 0;
+    for (i = 0; i < size; ++i)
+	n += cucon_bitarray_at(ba, i);
+    cu_test_assert(cucon_bitarray_popcount(ba) == n);
+
+    i = lrand48() % (size + 1);
+    j = i + lrand48() % (size - i + 1);
+    n = 0;
+    for (k = i; k < j; ++k)
+	n += cucon_bitarray_at(ba, k);
+    cu_test_assert(cucon_bitarray_popcount_range(ba, i, j) == n);
+
+    for (i = 0; i < size; ++i) {
+	for (k = i; k < size && !cucon_bitarray_at(ba, k); ++k);
+	cu_test_assert(cucon_bitarray_find_next_set(ba, i)
+		       == (k < size? k : (size_t)-1));
+	for (k = i; k < size && cucon_bitarray_at(ba, k); ++k);
+	cu_test_assert(cucon_bitarray_find_next_clear(ba, i)
+		       == (k < size? k : (size_t)-1));
+    }
+
+    cucon_bitarray_rsindex_init(&index, ba);
+    n = 0;
+    for (i = 0; i <= size; ++i) {
+	cu_test_assert(cucon_bitarray_rsindex_rank(&index, i) == n);
+	if (i < size && cucon_bitarray_at(ba, i)) {
+	    cu_test_assert(cucon_bitarray_rsindex_select(&index, n) == i);
+	    ++n;
+	}
+    }
+    cu_test_assert(cucon_bitarray_rsindex_select(&index, n) == (size_t)-1);
+}
+
 void
 _test(size_t size)
 {
@@ -185,6 +225,7 @@ _test(size_t size)
     _test_resize(size);
     _test_cmp(size);
     _test_img(size);
+    _test_count_and_rank(size);
 }
 
 int
@@ -194,5 +235,6 @@ main()
     cucon_init();
     for (i = 1; i < 400; ++i)
 	_test(i);
+    _test_count_and_rank(5000);
     return 2*!!cu_test_bug_count();
 }
@@ -0,0 +1,162 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CUCON_FPMAP_H
+#define CUCON_FPMAP_H
+
+#include <cucon/fwd.h>
+#include <cucon/fumap.h>
+
+CU_BEGIN_DECLARATIONS
+/** \defgroup cucon_fpmap_h cucon/fpmap.h: Flat Pointer-Keyed Hash Map
+ ** @{ \ingroup cucon_maps_and_sets_mod
+ **
+ ** This is a pointer-keyed wrapper around \ref cucon_fumap_h, and an
+ ** alternative to \ref cucon_pmap_h when slot pointers need not survive
+ ** modifications of the map.
+ **
+ ** \see cucon_fumap_h
+ ** \see cucon_pmap_h */
+
+/** A pointer-keyed map with fixed-size inline value slots. */
+struct cucon_fpmap
+{
+    struct cucon_fumap impl;
+};
+
+/** An iterator over the elements of a \ref cucon_fpmap. */
+struct cucon_fpmap_itr
+{
+    struct cucon_fumap_itr impl;
+};
+
+/** \copydoc cucon_fumap_init */
+CU_SINLINE void cucon_fpmap_init(cucon_fpmap_t map, size_t slot_size)
+{ cucon_fumap_init(&map->impl, slot_size); }
+
+/** \copydoc cucon_fumap_new */
+CU_SINLINE cucon_fpmap_t cucon_fpmap_new(size_t slot_size)
+{ return (cucon_fpmap_t)cucon_fumap_new(slot_size); }
+
+/** \copydoc cucon_fumap_init_copy */
+CU_SINLINE void cucon_fpmap_init_copy(cucon_fpmap_t dst, cucon_fpmap_t src)
+{ cucon_fumap_init_copy(&dst->impl, &src->impl); }
+
+/** \copydoc cucon_fumap_new_copy */
+CU_SINLINE cucon_fpmap_t cucon_fpmap_new_copy(cucon_fpmap_t src)
+{ return (cucon_fpmap_t)cucon_fumap_new_copy(&src->impl); }
+
+/** \copydoc cucon_fumap_swap */
+CU_SINLINE void cucon_fpmap_swap(cucon_fpmap_t map0, cucon_fpmap_t map1)
+{ cucon_fumap_swap(&map0->impl, &map1->impl); }
+
+/** \copydoc cucon_fumap_clear */
+CU_SINLINE void cucon_fpmap_clear(cucon_fpmap_t map)
+{ cucon_fumap_clear(&map->impl); }
+
+/** \copydoc cucon_fumap_reserve */
+CU_SINLINE void cucon_fpmap_reserve(cucon_fpmap_t map, size_t count)
+{ cucon_fumap_reserve(&map->impl, count); }
+
+/** \copydoc cucon_fumap_insert_mem */
+CU_SINLINE cu_bool_t
+cucon_fpmap_insert_mem(cucon_fpmap_t map, void const *key, cu_ptr_ptr_t slot)
+{ return cucon_fumap_insert_mem(&map->impl, (uintptr_t)key, slot); }
+
+/** \copydoc cucon_fumap_insert_void */
+CU_SINLINE cu_bool_t cucon_fpmap_insert_void(cucon_fpmap_t map, void const *key)
+{ return cucon_fumap_insert_mem(&map->impl, (uintptr_t)key, NULL); }
+
+/** \copydoc cucon_fumap_insert_ptr */
+CU_SINLINE cu_bool_t
+cucon_fpmap_insert_ptr(cucon_fpmap_t map, void const *key, void *ptr)
+{ return cucon_fumap_insert_ptr(&map->impl, (uintptr_t)key, ptr); }
+
+/** \copydoc cucon_fumap_insert_int */
+CU_SINLINE cu_bool_t
+cucon_fpmap_insert_int(cucon_fpmap_t map, void const *key, int val)
+{ return cucon_fumap_insert_int(&map->impl, (uintptr_t)key, val); }
+
+/** \copydoc cucon_fumap_replace_ptr */
+CU_SINLINE void *
+cucon_fpmap_replace_ptr(cucon_fpmap_t map, void const *key, void *ptr)
+{ return cucon_fumap_replace_ptr(&map->impl, (uintptr_t)key, ptr); }
+
+/** \copydoc cucon_fumap_erase */
+CU_SINLINE cu_bool_t cucon_fpmap_erase(cucon_fpmap_t map, void const *key)
+{ return cucon_fumap_erase(&map->impl, (uintptr_t)key); }
+
+/** \copydoc cucon_fumap_erase_ptr */
+CU_SINLINE void *cucon_fpmap_erase_ptr(cucon_fpmap_t map, void const *key)
+{ return cucon_fumap_erase_ptr(&map->impl, (uintptr_t)key); }
+
+/** \copydoc cucon_fumap_find_mem */
+CU_SINLINE void *cucon_fpmap_find_mem(cucon_fpmap_t map, void const *key)
+{ return cucon_fumap_find_mem(&map->impl, (uintptr_t)key); }
+
+/** \copydoc cucon_fumap_find_ptr */
+CU_SINLINE void *cucon_fpmap_find_ptr(cucon_fpmap_t map, void const *key)
+{ return cucon_fumap_find_ptr(&map->impl, (uintptr_t)key); }
+
+/** \copydoc cucon_fumap_find_int */
+CU_SINLINE int cucon_fpmap_find_int(cucon_fpmap_t map, void const *key)
+{ return cucon_fumap_find_int(&map->impl, (uintptr_t)key); }
+
+/** \copydoc cucon_fumap_find_void */
+CU_SINLINE cu_bool_t cucon_fpmap_find_void(cucon_fpmap_t map, void const *key)
+{ return cucon_fumap_find_mem(&map->impl, (uintptr_t)key) != NULL; }
+
+/** \copydoc cucon_fumap_iter_mem */
+void cucon_fpmap_iter_mem(cucon_fpmap_t map,
+			  cu_clop(cb, void, void const *key, void *slot));
+
+/** \copydoc cucon_fumap_conj_mem */
+cu_bool_t cucon_fpmap_conj_mem(cucon_fpmap_t map,
+			       cu_clop(cb, cu_bool_t, void const *, void *));
+
+/** \copydoc cucon_fumap_iter_keys */
+void cucon_fpmap_iter_keys(cucon_fpmap_t map, cu_clop(cb, void, void const *));
+
+/** \copydoc cucon_fumap_conj_keys */
+cu_bool_t cucon_fpmap_conj_keys(cucon_fpmap_t map,
+				cu_clop(cb, cu_bool_t, void const *));
+
+/** \copydoc cucon_fumap_itr_init */
+CU_SINLINE void cucon_fpmap_itr_init(cucon_fpmap_itr_t itr, cucon_fpmap_t map)
+{ cucon_fumap_itr_init(&itr->impl, &map->impl); }
+
+/** \copydoc cucon_fumap_itr_get_mem */
+CU_SINLINE void *
+cucon_fpmap_itr_get_mem(cucon_fpmap_itr_t itr, void const **key_out)
+{ return cucon_fumap_itr_get_mem(&itr->impl, (uintptr_t *)key_out); }
+
+/** \copydoc cucon_fumap_size */
+CU_SINLINE size_t cucon_fpmap_size(cucon_fpmap_t map)
+{ return cucon_fumap_size(&map->impl); }
+
+/** \copydoc cucon_fumap_is_empty */
+CU_SINLINE cu_bool_t cucon_fpmap_is_empty(cucon_fpmap_t map)
+{ return cucon_fumap_is_empty(&map->impl); }
+
+/** \copydoc cucon_fumap_dump_stats */
+CU_SINLINE void cucon_fpmap_dump_stats(cucon_fpmap_t map, FILE *out)
+{ cucon_fumap_dump_stats(&map->impl, out); }
+
+/** @} */
+CU_END_DECLARATIONS
+
+#endif
@@ -0,0 +1,591 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cucon/fumap.h>
+#include <cucon/fpmap.h>
+#include <cu/memory.h>
+#include <cu/hash.h>
+#include <cu/int.h>
+#include <cu/size.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
+/* Control Codes
+ * =============
+ *
+ * Each entry of the element array has a control code.  A full entry stores
+ * the top 7 bits of the hash of its key, so the high bit is clear.  The
+ * remaining codes are CTRL_EMPTY for never used entries and CTRL_DELETED for
+ * erased entries which lookups must probe past.
+ *
+ * The array is divided into aligned groups of GROUP_WIDTH entries which are
+ * probed with triangular steps.  A lookup ends at the first group containing
+ * an empty entry, so an erased entry can only be made empty if its group
+ * already contains one. */
+
+#define CTRL_EMPTY	0x80
+#define CTRL_DELETED	0xfe
+#define CTRL_IS_FULL(c) (!((c) & 0x80))
+
+#define H1(hash) ((size_t)(hash))
+#define H2(hash) ((unsigned char)((hash) >> (sizeof(cu_hash_t)*8 - 7)))
+
+#ifdef __SSE2__
+
+#define GROUP_WIDTH 16
+
+typedef unsigned int _bitmask_t;
+
+CU_SINLINE __m128i
+_group_load(unsigned char const *ctrl)
+{ return _mm_loadu_si128((__m128i const *)ctrl); }
+
+CU_SINLINE _bitmask_t
+_group_match(unsigned char const *ctrl, unsigned char h2)
+{
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_group_load(ctrl),
+					    _mm_set1_epi8(h2)));
+}
+
+CU_SINLINE _bitmask_t
+_group_match_empty(unsigned char const *ctrl)
+{
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_group_load(ctrl),
+					    _mm_set1_epi8((char)CTRL_EMPTY)));
+}
+
+CU_SINLINE _bitmask_t
+_group_match_empty_or_deleted(unsigned char const *ctrl)
+{ return _mm_movemask_epi8(_group_load(ctrl)); }
+
+#define BITMASK_SHIFT 0
+
+#else /* !__SSE2__ */
+
+/* Portable fallback working on 8 control codes packed in a 64 bit word, with
+ * the result in the high bit of each byte. */
+
+#define GROUP_WIDTH 8
+#define LSBS UINT64_C(0x0101010101010101)
+#define MSBS UINT64_C(0x8080808080808080)
+
+typedef uint64_t _bitmask_t;
+
+CU_SINLINE uint64_t
+_group_load(unsigned char const *ctrl)
+{
+#ifdef CUCONF_WORDS_BIGENDIAN
+    int i;
+    uint64_t g = 0;
+    for (i = GROUP_WIDTH - 1; i >= 0; --i)
+	g = (g << 8) | ctrl[i];
+    return g;
+#else
+    uint64_t g;
+    memcpy(&g, ctrl, sizeof(g));
+    return g;
+#endif
+}
+
+/* May give false positives for bytes above a true match, which are rejected
+ * when comparing the keys. */
+CU_SINLINE _bitmask_t
+_group_match(unsigned char const *ctrl, unsigned char h2)
+{
+    uint64_t x = _group_load(ctrl) ^ (LSBS * h2);
+    return (x - LSBS) & ~x & MSBS;
+}
+
+CU_SINLINE _bitmask_t
+_group_match_empty(unsigned char const *ctrl)
+{
+    uint64_t g = _group_load(ctrl);
+    return g & (~g << 6) & MSBS;
+}
+
+CU_SINLINE _bitmask_t
+_group_match_empty_or_deleted(unsigned char const *ctrl)
+{ return _group_load(ctrl) & MSBS; }
+
+#define BITMASK_SHIFT 3
+
+#endif /* !__SSE2__ */
+
+CU_SINLINE unsigned int
+_bitmask_lowest(_bitmask_t m)
+{
+#ifdef __GNUC__
+    return (sizeof(m) > sizeof(unsigned int)? __builtin_ctzll(m)
+					    : __builtin_ctz(m)) >> BITMASK_SHIFT;
+#else
+    return cu_uint64_log2_lowbit(m) >> BITMASK_SHIFT;
+#endif
+}
+
+#define BITMASK_NEXT(m) ((m) & ((m) - 1))
+
+/* An all-empty group shared by maps which have not allocated yet. */
+static unsigned char const _empty_group[16] = {
+    CTRL_EMPTY, CTRL_EMPTY, CTRL_EMPTY, CTRL_EMPTY,
+    CTRL_EMPTY, CTRL_EMPTY, CTRL_EMPTY, CTRL_EMPTY,
+    CTRL_EMPTY, CTRL_EMPTY, CTRL_EMPTY, CTRL_EMPTY,
+    CTRL_EMPTY, CTRL_EMPTY, CTRL_EMPTY, CTRL_EMPTY,
+};
+
+
+/* Implementation
+ * ============== */
+
+#define ELT(map, i) ((map)->arr + (i)*(map)->elt_size)
+#define ELT_KEY(elt) (*(uintptr_t *)(elt))
+#define ELT_SLOT(elt) ((void *)((elt) + sizeof(uintptr_t)))
+
+CU_SINLINE cu_hash_t
+_hash(uintptr_t key)
+{ return cu_hash_mix((cu_hash_t)key); }
+
+/* The maximum number of full or deleted entries for a given capacity. */
+CU_SINLINE size_t
+_capacity_to_growth(size_t cap)
+{ return cap - cap/8; }
+
+static size_t
+_capacity_for(size_t count)
+{
+    size_t cap = GROUP_WIDTH;
+    while (_capacity_to_growth(cap) < count)
+	cap *= 2;
+    return cap;
+}
+
+void
+cucon_fumap_init(cucon_fumap_t map, size_t slot_size)
+{
+    map->size = 0;
+    map->mask = GROUP_WIDTH - 1;
+    map->growth_left = 0;
+    map->elt_size = sizeof(uintptr_t)
+		  + cu_size_mulceil(slot_size, sizeof(uintptr_t));
+    map->ctrl = (unsigned char *)_empty_group;
+    map->arr = NULL;
+}
+
+cucon_fumap_t
+cucon_fumap_new(size_t slot_size)
+{
+    cucon_fumap_t map = cu_gnew(struct cucon_fumap);
+    cucon_fumap_init(map, slot_size);
+    return map;
+}
+
+void
+cucon_fumap_init_copy(cucon_fumap_t dst, cucon_fumap_t src)
+{
+    size_t cap;
+    if (!src->arr) {
+	cucon_fumap_init(dst, cucon_fumap_slot_size(src));
+	return;
+    }
+    cap = src->mask + 1;
+    memcpy(dst, src, sizeof(struct cucon_fumap));
+    dst->ctrl = cu_galloc_atomic(cap);
+    memcpy(dst->ctrl, src->ctrl, cap);
+    dst->arr = cu_galloc(cap*src->elt_size);
+    memcpy(dst->arr, src->arr, cap*src->elt_size);
+}
+
+cucon_fumap_t
+cucon_fumap_new_copy(cucon_fumap_t src)
+{
+    cucon_fumap_t dst = cu_gnew(struct cucon_fumap);
+    cucon_fumap_init_copy(dst, src);
+    return dst;
+}
+
+void
+cucon_fumap_swap(cucon_fumap_t map0, cucon_fumap_t map1)
+{
+    struct cucon_fumap tmp;
+    memcpy(&tmp, map0, sizeof(struct cucon_fumap));
+    memcpy(map0, map1, sizeof(struct cucon_fumap));
+    memcpy(map1, &tmp, sizeof(struct cucon_fumap));
+}
+
+void
+cucon_fumap_clear(cucon_fumap_t map)
+{
+    if (!map->arr)
+	return;
+    memset(map->ctrl, CTRL_EMPTY, map->mask + 1);
+    memset(map->arr, 0, (map->mask + 1)*map->elt_size);
+    map->size = 0;
+    map->growth_left = _capacity_to_growth(map->mask + 1);
+}
+
+/* Returns the index of the first empty or deleted entry on the probe sequence
+ * of hash. */
+static size_t
+_find_non_full(cucon_fumap_t map, cu_hash_t hash)
+{
+    size_t pos = H1(hash) & map->mask & ~(size_t)(GROUP_WIDTH - 1);
+    size_t step = 0;
+    for (;;) {
+	_bitmask_t m = _group_match_empty_or_deleted(map->ctrl + pos);
+	if (m)
+	    return pos + _bitmask_lowest(m);
+	step += GROUP_WIDTH;
+	pos = (pos + step) & map->mask;
+    }
+}
+
+static void
+_rehash(cucon_fumap_t map, size_t new_cap)
+{
+    size_t i, old_cap = map->mask + 1;
+    unsigned char *old_ctrl = map->ctrl;
+    char *old_arr = map->arr;
+
+    map->mask = new_cap - 1;
+    map->ctrl = cu_galloc_atomic(new_cap);
+    memset(map->ctrl, CTRL_EMPTY, new_cap);
+    map->arr = cu_galloc(new_cap*map->elt_size);
+    if (old_arr)
+	for (i = 0; i < old_cap; ++i)
+	    if (CTRL_IS_FULL(old_ctrl[i])) {
+		char *elt = old_arr + i*map->elt_size;
+		cu_hash_t hash = _hash(ELT_KEY(elt));
+		size_t j = _find_non_full(map, hash);
+		map->ctrl[j] = H2(hash);
+		memcpy(ELT(map, j), elt, map->elt_size);
+	    }
+    map->growth_left = _capacity_to_growth(new_cap) - map->size;
+    if (old_arr) {
+	cu_gfree_atomic(old_ctrl);
+	cu_gfree(old_arr);
+    }
+}
+
+void
+cucon_fumap_reserve(cucon_fumap_t map, size_t count)
+{
+    if (count > map->size && count - map->size > map->growth_left) {
+	size_t cap = _capacity_for(count);
+	if (map->arr && cap < map->mask + 1)
+	    cap = map->mask + 1;
+	_rehash(map, cap);
+    }
+}
+
+/* Returns the index of key or (size_t)-1 if not present. */
+CU_SINLINE size_t
+_find_index(cucon_fumap_t map, uintptr_t key, cu_hash_t hash)
+{
+    unsigned char h2 = H2(hash);
+    size_t pos = H1(hash) & map->mask & ~(size_t)(GROUP_WIDTH - 1);
+    size_t step = 0;
+    for (;;) {
+	unsigned char const *g = map->ctrl + pos;
+	_bitmask_t m;
+	for (m = _group_match(g, h2); m; m = BITMASK_NEXT(m)) {
+	    size_t i = pos + _bitmask_lowest(m);
+	    if (ELT_KEY(ELT(map, i)) == key)
+		return i;
+	}
+	if (_group_match_empty(g))
+	    return (size_t)-1;
+	step += GROUP_WIDTH;
+	pos = (pos + step) & map->mask;
+    }
+}
+
+cu_bool_t
+cucon_fumap_insert_mem(cucon_fumap_t map, uintptr_t key, cu_ptr_ptr_t slot)
+{
+    cu_hash_t hash = _hash(key);
+    size_t i = _find_index(map, key, hash);
+    char *elt;
+    if (i != (size_t)-1) {
+	if (slot)
+	    *(void **)slot = ELT_SLOT(ELT(map, i));
+	return cu_false;
+    }
+    i = _find_non_full(map, hash);
+    if (map->ctrl[i] == CTRL_EMPTY) {
+	if (map->growth_left == 0) {
+	    /* Out of empty entries.  If at least a quarter of the used entries
+	     * are deleted, purge them in place, otherwise double the
+	     * capacity. */
+	    size_t cap = map->mask + 1;
+	    if (!map->arr)
+		_rehash(map, GROUP_WIDTH);
+	    else if (map->size*4 <= _capacity_to_growth(cap)*3)
+		_rehash(map, cap);
+	    else
+		_rehash(map, cap*2);
+	    i = _find_non_full(map, hash);
+	}
+	--map->growth_left;
+    }
+    map->ctrl[i] = H2(hash);
+    ++map->size;
+    elt = ELT(map, i);
+    ELT_KEY(elt) = key;
+    if (slot)
+	*(void **)slot = ELT_SLOT(elt);
+    return cu_true;
+}
+
+cu_bool_t
+cucon_fumap_insert_ptr(cucon_fumap_t map, uintptr_t key, void *ptr)
+{
+    void **slot;
+    if (cucon_fumap_insert_mem(map, key, &slot)) {
+	*slot = ptr;
+	return cu_true;
+    }
+    else
+	return cu_false;
+}
+
+cu_bool_t
+cucon_fumap_insert_int(cucon_fumap_t map, uintptr_t key, int val)
+{
+    int *slot;
+    if (cucon_fumap_insert_mem(map, key, &slot)) {
+	*slot = val;
+	return cu_true;
+    }
+    else
+	return cu_false;
+}
+
+void *
+cucon_fumap_replace_ptr(cucon_fumap_t map, uintptr_t key, void *ptr)
+{
+    void **slot;
+    if (cucon_fumap_insert_mem(map, key, &slot)) {
+	*slot = ptr;
+	return NULL;
+    }
+    else {
+	void *old_ptr = *slot;
+	*slot = ptr;
+	return old_ptr;
+    }
+}
+
+static void
+_erase_at(cucon_fumap_t map, size_t i)
+{
+    size_t pos = i & ~(size_t)(GROUP_WIDTH - 1);
+    char *elt = ELT(map, i);
+    if (_group_match_empty(map->ctrl + pos)) {
+	map->ctrl[i] = CTRL_EMPTY;
+	++map->growth_left;
+    }
+    else
+	map->ctrl[i] = CTRL_DELETED;
+    memset(elt, 0, map->elt_size); /* don't retain garbage */
+    --map->size;
+}
+
+cu_bool_t
+cucon_fumap_erase(cucon_fumap_t map, uintptr_t key)
+{
+    size_t i = _find_index(map, key, _hash(key));
+    if (i == (size_t)-1)
+	return cu_false;
+    _erase_at(map, i);
+    return cu_true;
+}
+
+void *
+cucon_fumap_erase_ptr(cucon_fumap_t map, uintptr_t key)
+{
+    size_t i = _find_index(map, key, _hash(key));
+    void *ptr;
+    if (i == (size_t)-1)
+	return NULL;
+    ptr = *(void **)ELT_SLOT(ELT(map, i));
+    _erase_at(map, i);
+    return ptr;
+}
+
+void *
+cucon_fumap_find_mem(cucon_fumap_t map, uintptr_t key)
+{
+    size_t i = _find_index(map, key, _hash(key));
+    return i == (size_t)-1? NULL : ELT_SLOT(ELT(map, i));
+}
+
+void
+cucon_fumap_iter_mem(cucon_fumap_t map,
+		     cu_clop(cb, void, uintptr_t, void *))
+{
+    size_t i, cap = cucon_fumap_capacity(map);
+    for (i = 0; i < cap; ++i)
+	if (CTRL_IS_FULL(map->ctrl[i])) {
+	    char *elt = ELT(map, i);
+	    cu_call(cb, ELT_KEY(elt), ELT_SLOT(elt));
+	}
+}
+
+cu_bool_t
+cucon_fumap_conj_mem(cucon_fumap_t map,
+		     cu_clop(cb, cu_bool_t, uintptr_t, void *))
+{
+    size_t i, cap = cucon_fumap_capacity(map);
+    for (i = 0; i < cap; ++i)
+	if (CTRL_IS_FULL(map->ctrl[i])) {
+	    char *elt = ELT(map, i);
+	    if (!cu_call(cb, ELT_KEY(elt), ELT_SLOT(elt)))
+		return cu_false;
+	}
+    return cu_true;
+}
+
+void
+cucon_fumap_iter_keys(cucon_fumap_t map, cu_clop(cb, void, uintptr_t))
+{
+    size_t i, cap = cucon_fumap_capacity(map);
+    for (i = 0; i < cap; ++i)
+	if (CTRL_IS_FULL(map->ctrl[i]))
+	    cu_call(cb, ELT_KEY(ELT(map, i)));
+}
+
+cu_bool_t
+cucon_fumap_conj_keys(cucon_fumap_t map, cu_clop(cb, cu_bool_t, uintptr_t))
+{
+    size_t i, cap = cucon_fumap_capacity(map);
+    for (i = 0; i < cap; ++i)
+	if (CTRL_IS_FULL(map->ctrl[i]))
+	    if (!cu_call(cb, ELT_KEY(ELT(map, i))))
+		return cu_false;
+    return cu_true;
+}
+
+void
+cucon_fumap_itr_init(cucon_fumap_itr_t itr, cucon_fumap_t map)
+{
+    itr->map = map;
+    itr->index = 0;
+}
+
+void *
+cucon_fumap_itr_get_mem(cucon_fumap_itr_t itr, uintptr_t *key_out)
+{
+    cucon_fumap_t map = itr->map;
+    size_t cap = cucon_fumap_capacity(map);
+    while (itr->index < cap) {
+	size_t i = itr->index++;
+	if (CTRL_IS_FULL(map->ctrl[i])) {
+	    char *elt = ELT(map, i);
+	    if (key_out)
+		*key_out = ELT_KEY(elt);
+	    return ELT_SLOT(elt);
+	}
+    }
+    return NULL;
+}
+
+void
+cucon_fumap_dump_stats(cucon_fumap_t map, FILE *out)
+{
+    size_t i, cap = cucon_fumap_capacity(map);
+    size_t n_deleted = 0, n_probes = 0, max_probes = 0;
+    for (i = 0; i < cap; ++i) {
+	if (map->ctrl[i] == CTRL_DELETED)
+	    ++n_deleted;
+	else if (CTRL_IS_FULL(map->ctrl[i])) {
+	    cu_hash_t hash = _hash(ELT_KEY(ELT(map, i)));
+	    size_t pos = H1(hash) & map->mask & ~(size_t)(GROUP_WIDTH - 1);
+	    size_t step = 0, n = 1;
+	    while (pos != (i & ~(size_t)(GROUP_WIDTH - 1))) {
+		step += GROUP_WIDTH;
+		pos = (pos + step) & map->mask;
+		++n;
+	    }
+	    n_probes += n;
+	    if (n > max_probes)
+		max_probes = n;
+	}
+    }
+    fprintf(out, "cucon_fumap_t @ %p: size = %zd, capacity = %zd, "
+	    "deleted = %zd, group width = %d\n",
+	    (void *)map, map->size, cap, n_deleted, GROUP_WIDTH);
+    if (map->size)
+	fprintf(out, "    average group probes = %lf, max = %zd\n",
+		n_probes/(double)map->size, max_probes);
+}
+
+
+/* Pointer-Keyed Iteration
+ * ======================= */
+
+void
+cucon_fpmap_iter_mem(cucon_fpmap_t map,
+		     cu_clop(cb, void, void const *, void *))
+{
+    cucon_fumap_t impl = &map->impl;
+    size_t i, cap = cucon_fumap_capacity(impl);
+    for (i = 0; i < cap; ++i)
+	if (CTRL_IS_FULL(impl->ctrl[i])) {
+	    char *elt = ELT(impl, i);
+	    cu_call(cb, (void const *)ELT_KEY(elt), ELT_SLOT(elt));
+	}
+}
+
+cu_bool_t
+cucon_fpmap_conj_mem(cucon_fpmap_t map,
+		     cu_clop(cb, cu_bool_t, void const *, void *))
+{
+    cucon_fumap_t impl = &map->impl;
+    size_t i, cap = cucon_fumap_capacity(impl);
+    for (i = 0; i < cap; ++i)
+	if (CTRL_IS_FULL(impl->ctrl[i])) {
+	    char *elt = ELT(impl, i);
+	    if (!cu_call(cb, (void const *)ELT_KEY(elt), ELT_SLOT(elt)))
+		return cu_false;
+	}
+    return cu_true;
+}
+
+void
+cucon_fpmap_iter_keys(cucon_fpmap_t map, cu_clop(cb, void, void const *))
+{
+    cucon_fumap_t impl = &map->impl;
+    size_t i, cap = cucon_fumap_capacity(impl);
+    for (i = 0; i < cap; ++i)
+	if (CTRL_IS_FULL(impl->ctrl[i]))
+	    cu_call(cb, (void const *)ELT_KEY(ELT(impl, i)));
+}
+
+cu_bool_t
+cucon_fpmap_conj_keys(cucon_fpmap_t map, cu_clop(cb, cu_bool_t, void const *))
+{
+    cucon_fumap_t impl = &map->impl;
+    size_t i, cap = cucon_fumap_capacity(impl);
+    for (i = 0; i < cap; ++i)
+	if (CTRL_IS_FULL(impl->ctrl[i]))
+	    if (!cu_call(cb, (void const *)ELT_KEY(ELT(impl, i))))
+		return cu_false;
+    return cu_true;
+}
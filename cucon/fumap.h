@@ -0,0 +1,194 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CUCON_FUMAP_H
+#define CUCON_FUMAP_H
+
+#include <cucon/fwd.h>
+#include <cu/clos.h>
+#include <stdio.h>
+#include <limits.h>
+#include <stdint.h>
+
+CU_BEGIN_DECLARATIONS
+/** \defgroup cucon_fumap_h cucon/fumap.h: Flat Integer-Keyed Hash Map
+ ** @{ \ingroup cucon_maps_and_sets_mod
+ **
+ ** This is an open-addressing alternative to \ref cucon_umap_h.  Keys and
+ ** value slots are stored inline in a single array instead of on separately
+ ** allocated nodes.  Each array entry has a one-byte control code holding 7
+ ** bits of the hash of its key, and a lookup compares a group of control codes
+ ** at a time, using SSE2 where available, so that most mismatches are
+ ** rejected without touching the keys.
+ **
+ ** All slots of a map have the same size, given when the map is initialised,
+ ** and are aligned to the size of \c uintptr_t.  Since insertions may move
+ ** the elements, a slot pointer is only valid until the next insertion into
+ ** or erase from the map.  Use \ref cucon_umap_h if you need stable slots.
+ **
+ ** \see cucon_fpmap_h
+ ** \see cucon_umap_h */
+
+/** An integer-keyed map with fixed-size inline value slots. */
+struct cucon_fumap
+{
+    size_t size;	/* the number of elements in the map */
+    size_t mask;	/* = capacity - 1 */
+    size_t growth_left;	/* number of empty entries we may still fill */
+    size_t elt_size;	/* size of each entry in arr, including the key */
+    unsigned char *ctrl;
+    char *arr;
+};
+
+/** An iterator over the elements of a \ref cucon_fumap. */
+struct cucon_fumap_itr
+{
+    cucon_fumap_t map;
+    size_t index;
+};
+
+/** Construct \a map as an empty map with slots of \a slot_size bytes. */
+void cucon_fumap_init(cucon_fumap_t map, size_t slot_size);
+
+/** Return an empty map with slots of \a slot_size bytes. */
+cucon_fumap_t cucon_fumap_new(size_t slot_size);
+
+/** Construct \a dst as a copy of \a src, where the slots are copied with
+ ** memcpy. */
+void cucon_fumap_init_copy(cucon_fumap_t dst, cucon_fumap_t src);
+
+/** Return a copy of \a src, where the slots are copied with memcpy. */
+cucon_fumap_t cucon_fumap_new_copy(cucon_fumap_t src);
+
+/** Swap the contents of \a map0 with \a map1. */
+void cucon_fumap_swap(cucon_fumap_t map0, cucon_fumap_t map1);
+
+/** The size of the value slots of \a map. */
+CU_SINLINE size_t cucon_fumap_slot_size(cucon_fumap_t map)
+{ return map->elt_size - sizeof(uintptr_t); }
+
+/** Remove all elements from \a map, keeping the capacity. */
+void cucon_fumap_clear(cucon_fumap_t map);
+
+/** Make room for \a count elements in \a map, so that inserting up to that
+ ** many elements will not cause a rehash. */
+void cucon_fumap_reserve(cucon_fumap_t map, size_t count);
+
+/** If \a key has a mapping in \a map, set \c *\a slot to a pointer to the
+ ** value and return false, else create a new mapping with an uninitialised
+ ** slot, assign a pointer to it to \c *\a slot, and return true.  \a slot may
+ ** be \c NULL if the slot size is zero. */
+cu_bool_t cucon_fumap_insert_mem(cucon_fumap_t map, uintptr_t key,
+				 cu_ptr_ptr_t slot);
+
+/** Insert \a key into \a map unless it exists.  Returns true iff the
+ ** insertion was done. */
+CU_SINLINE cu_bool_t cucon_fumap_insert_void(cucon_fumap_t map, uintptr_t key)
+{ return cucon_fumap_insert_mem(map, key, NULL); }
+
+/** Insert (\a key, \a ptr) into \a map if \a key is not present.  Returns
+ ** true iff the insertion was done.
+ ** \pre The slots of \a map must hold pointers. */
+cu_bool_t cucon_fumap_insert_ptr(cucon_fumap_t map, uintptr_t key, void *ptr);
+
+/** Insert (\a key, \a val) into \a map if \a key is not present.  Returns
+ ** true iff the insertion was done.
+ ** \pre The slots of \a map must hold \c int values. */
+cu_bool_t cucon_fumap_insert_int(cucon_fumap_t map, uintptr_t key, int val);
+
+/** If \a key is bound in \a map, replace its pointer with \a ptr and return
+ ** the old pointer, else bind \a key to \a ptr and return \c NULL.
+ ** \pre The slots of \a map must hold pointers. */
+void *cucon_fumap_replace_ptr(cucon_fumap_t map, uintptr_t key, void *ptr);
+
+/** If \a key has a mapping in \a map, erase it and return true, else return
+ ** false. */
+cu_bool_t cucon_fumap_erase(cucon_fumap_t map, uintptr_t key);
+
+/** If \a key has a mapping in \a map, erase it and return the pointer stored
+ ** in its slot, else return \c NULL.
+ ** \pre The slots of \a map must hold pointers. */
+void *cucon_fumap_erase_ptr(cucon_fumap_t map, uintptr_t key);
+
+/** If \a key has a mapping in \a map, return a pointer to the slot, else
+ ** return \c NULL. */
+void *cucon_fumap_find_mem(cucon_fumap_t map, uintptr_t key);
+
+/** If \a key has a mapping in \a map, return the pointer stored in the slot,
+ ** else return \c NULL.
+ ** \pre The slots of \a map must hold pointers. */
+CU_SINLINE void *cucon_fumap_find_ptr(cucon_fumap_t map, uintptr_t key)
+{
+    void **slot = (void **)cucon_fumap_find_mem(map, key);
+    return slot? *slot : NULL;
+}
+
+/** If \a key has a mapping in \a map, return the \c int stored in the slot,
+ ** else return \c INT_MIN.
+ ** \pre The slots of \a map must hold \c int values. */
+CU_SINLINE int cucon_fumap_find_int(cucon_fumap_t map, uintptr_t key)
+{
+    int *slot = (int *)cucon_fumap_find_mem(map, key);
+    return slot? *slot : INT_MIN;
+}
+
+/** True iff \a map contains \a key. */
+CU_SINLINE cu_bool_t cucon_fumap_find_void(cucon_fumap_t map, uintptr_t key)
+{ return cucon_fumap_find_mem(map, key) != NULL; }
+
+/** Call \a cb on each key and slot of \a map. */
+void cucon_fumap_iter_mem(cucon_fumap_t map,
+			  cu_clop(cb, void, uintptr_t key, void *slot));
+
+/** Sequentially conjunct \a cb over the keys and slots of \a map. */
+cu_bool_t cucon_fumap_conj_mem(cucon_fumap_t map,
+			       cu_clop(cb, cu_bool_t, uintptr_t, void *));
+
+/** Call \a cb on each key of \a map. */
+void cucon_fumap_iter_keys(cucon_fumap_t map, cu_clop(cb, void, uintptr_t));
+
+/** Sequentially conjunct \a cb over the keys of \a map. */
+cu_bool_t cucon_fumap_conj_keys(cucon_fumap_t map,
+				cu_clop(cb, cu_bool_t, uintptr_t));
+
+/** Initialise \a itr to point before the first element of \a map.  The
+ ** iterator is invalidated by insertions into and erasures from \a map. */
+void cucon_fumap_itr_init(cucon_fumap_itr_t itr, cucon_fumap_t map);
+
+/** Advance \a itr to the next element, store its key in \c *\a key_out and
+ ** return a pointer to its slot, or return \c NULL if there are no more
+ ** elements. */
+void *cucon_fumap_itr_get_mem(cucon_fumap_itr_t itr, uintptr_t *key_out);
+
+/** Return the number of elements in \a map. */
+CU_SINLINE size_t cucon_fumap_size(cucon_fumap_t map) { return map->size; }
+
+/** True iff \a map is empty. */
+CU_SINLINE cu_bool_t cucon_fumap_is_empty(cucon_fumap_t map)
+{ return !map->size; }
+
+/** The number of entries in the underlying array of \a map. */
+CU_SINLINE size_t cucon_fumap_capacity(cucon_fumap_t map)
+{ return map->arr? map->mask + 1 : 0; }
+
+/** For profiling use. */
+void cucon_fumap_dump_stats(cucon_fumap_t map, FILE *out);
+
+/** @} */
+CU_END_DECLARATIONS
+
+#endif
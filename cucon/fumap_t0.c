@@ -0,0 +1,170 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cucon/fumap.h>
+#include <cucon/fpmap.h>
+#include <cucon/umap.h>
+#include <cu/test.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define KEY_RANGE 4000
+#define N_OPS 200000
+
+struct myslot_s
+{
+    int val;
+    uintptr_t check;
+};
+
+cu_clos_def(_check_elt, cu_prot(cu_bool_t, uintptr_t key, void *slot),
+    ( cucon_umap_t ref;
+      size_t count; ))
+{
+    cu_clos_self(_check_elt);
+    struct myslot_s *myslot = slot;
+    ++self->count;
+    cu_test_assert_size_eq(myslot->check, key*7);
+    cu_test_assert_int_eq(myslot->val, cucon_umap_find_int(self->ref, key));
+    return cu_true;
+}
+
+static void
+_check_equal(cucon_fumap_t map, cucon_umap_t ref)
+{
+    _check_elt_t check;
+    struct cucon_fumap_itr itr;
+    uintptr_t key;
+    struct myslot_s *slot;
+    size_t count = 0;
+
+    check.ref = ref;
+    check.count = 0;
+    cu_test_assert(cucon_fumap_conj_mem(map, _check_elt_prep(&check)));
+    cu_test_assert_size_eq(check.count, cucon_umap_size(ref));
+
+    cucon_fumap_itr_init(&itr, map);
+    while ((slot = cucon_fumap_itr_get_mem(&itr, &key))) {
+	cu_test_assert_int_eq(slot->val, cucon_umap_find_int(ref, key));
+	++count;
+    }
+    cu_test_assert_size_eq(count, cucon_umap_size(ref));
+}
+
+static void
+_test_random(int verb)
+{
+    struct cucon_fumap map;
+    struct cucon_umap ref;
+    struct cucon_fumap map_copy;
+    size_t n_copy;
+    int i;
+
+    cucon_fumap_init(&map, sizeof(struct myslot_s));
+    cucon_umap_init(&ref);
+    cu_test_assert_size_eq(cucon_fumap_slot_size(&map),
+			   sizeof(struct myslot_s));
+    cu_test_assert(!cucon_fumap_find_void(&map, 0));
+    cu_test_assert(!cucon_fumap_erase(&map, 0));
+
+    for (i = 0; i < N_OPS; ++i) {
+	uintptr_t key = lrand48() % KEY_RANGE;
+	struct myslot_s *slot;
+	switch (lrand48() % 4) {
+	    case 0:
+	    case 1:
+		if (cucon_fumap_insert_mem(&map, key, &slot)) {
+		    slot->val = i;
+		    slot->check = key*7;
+		    cu_test_assert(cucon_umap_insert_int(&ref, key, i));
+		}
+		else {
+		    cu_test_assert_int_eq(slot->val,
+					  cucon_umap_find_int(&ref, key));
+		    cu_test_assert_size_eq(slot->check, key*7);
+		}
+		break;
+	    case 2:
+		cu_test_assert_int_eq(cucon_fumap_erase(&map, key),
+				      cucon_umap_erase(&ref, key));
+		break;
+	    case 3:
+		slot = cucon_fumap_find_mem(&map, key);
+		if (slot)
+		    cu_test_assert_int_eq(slot->val,
+					  cucon_umap_find_int(&ref, key));
+		else
+		    cu_test_assert(!cucon_umap_find_void(&ref, key));
+		break;
+	}
+	cu_test_assert_size_eq(cucon_fumap_size(&map), cucon_umap_size(&ref));
+    }
+    _check_equal(&map, &ref);
+    if (verb)
+	cucon_fumap_dump_stats(&map, stdout);
+
+    cucon_fumap_init_copy(&map_copy, &map);
+    _check_equal(&map_copy, &ref);
+    n_copy = cucon_fumap_size(&map_copy);
+
+    /* Erase everything and check that the map is usable afterwards. */
+    for (i = 0; i < KEY_RANGE; ++i)
+	cucon_umap_erase(&ref, i), cucon_fumap_erase(&map, i);
+    cu_test_assert_size_eq(cucon_fumap_size(&map), 0);
+    _check_equal(&map, &ref);
+    cu_test_assert_size_eq(cucon_fumap_size(&map_copy), n_copy);
+}
+
+static void
+_test_ptr(void)
+{
+    struct cucon_fpmap map;
+    int *keys[1000];
+    int i;
+
+    cucon_fpmap_init(&map, sizeof(void *));
+    cucon_fpmap_reserve(&map, 1000);
+    for (i = 0; i < 1000; ++i) {
+	keys[i] = cu_gnew(int);
+	cu_test_assert(cucon_fpmap_insert_ptr(&map, keys[i], keys[i] + 1));
+	cu_test_assert(!cucon_fpmap_insert_ptr(&map, keys[i], NULL));
+    }
+    cu_test_assert(cucon_fumap_capacity(&map.impl) >= 1000);
+    for (i = 0; i < 1000; ++i)
+	cu_test_assert_ptr_eq(cucon_fpmap_find_ptr(&map, keys[i]),
+			      keys[i] + 1);
+    for (i = 0; i < 1000; i += 2)
+	cu_test_assert_ptr_eq(cucon_fpmap_replace_ptr(&map, keys[i], keys[i]),
+			      keys[i] + 1);
+    for (i = 0; i < 1000; i += 2)
+	cu_test_assert_ptr_eq(cucon_fpmap_erase_ptr(&map, keys[i]), keys[i]);
+    cu_test_assert_size_eq(cucon_fpmap_size(&map), 500);
+    for (i = 0; i < 1000; ++i)
+	cu_test_assert_int_eq(cucon_fpmap_find_void(&map, keys[i]), i % 2);
+    cucon_fpmap_clear(&map);
+    cu_test_assert(cucon_fpmap_is_empty(&map));
+    cu_test_assert(!cucon_fpmap_find_void(&map, keys[1]));
+}
+
+int
+main()
+{
+    cu_init();
+    _test_random(1);
+    _test_ptr();
+    return 2*!!cu_test_bug_count();
+}
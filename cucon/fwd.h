@@ -27,6 +27,7 @@ CU_BEGIN_DECLARATIONS
 typedef struct cucon_array		*cucon_arr_t;		/* arr.h */
 typedef struct cucon_array		*cucon_array_t;		/* array.h */
 typedef struct cucon_bitarray		*cucon_bitarray_t;	/* bitarray.h */
+typedef struct cucon_bitarray_rsindex	*cucon_bitarray_rsindex_t;
 typedef struct cucon_bitarray_slice	*cucon_bitarray_slice_t;
 typedef struct cucon_bitarray		*cucon_bitvect_t;	/* bitvect.h */
 typedef struct cucon_digraph		*cucon_digraph_t;	/* digraph.h */
@@ -36,6 +37,10 @@ typedef struct cucon_fibheap		*cucon_fibheap_t;	/* fibheap.h */
 typedef struct cucon_fibnode		*cucon_fibnode_t;	/* fibheap.h */
 typedef struct cucon_fibq		*cucon_fibq_t;		/* fibq.h */
 typedef struct cucon_fibqnode		*cucon_fibqnode_t;	/* fibq.h */
+typedef struct cucon_fpmap		*cucon_fpmap_t;		/* fpmap.h */
+typedef struct cucon_fpmap_itr		*cucon_fpmap_itr_t;	/* fpmap.h */
+typedef struct cucon_fumap		*cucon_fumap_t;		/* fumap.h */
+typedef struct cucon_fumap_itr		*cucon_fumap_itr_t;	/* fumap.h */
 typedef struct cucon_hmap		*cucon_hmap_t;		/* hmap.h */
 typedef struct cucon_hzmap		*cucon_hzmap_t;		/* hzmap.h */
 typedef struct cucon_hzmap_itr		*cucon_hzmap_itr_t;	/* hzmap.h */
@@ -18,6 +18,7 @@
 
 #include <cucon/list.h>
 #include <cu/memory.h>
+#include <cu/region.h>
 #include <cu/ptr_seq.h>
 #include <string.h>
 
@@ -209,6 +210,34 @@ cucon_list_insert_ptr(cucon_listnode_t pos, void *ptr)
     return node;
 }
 
+cucon_listnode_t
+cucon_list_insert_mem_region(cu_region_t region, cucon_listnode_t pos,
+			     size_t size)
+{
+    struct cucon_listnode *node
+	= cu_region_alloc(region, sizeof(struct cucon_listnode) + size);
+    node->next = pos;
+    node->prev = pos->prev;
+    pos->prev = node;
+    node->prev->next = node;
+    return node;
+}
+
+cucon_listnode_t
+cucon_list_insert_ptr_region(cu_region_t region, cucon_listnode_t pos,
+			     void *ptr)
+{
+    cucon_listnode_t node;
+    node = cu_region_alloc(region,
+			   sizeof(struct cucon_listnode) + sizeof(void *));
+    node->next = pos;
+    node->prev = pos->prev;
+    pos->prev = node;
+    node->prev->next = node;
+    cucon_listnode_set_ptr(node, ptr);
+    return node;
+}
+
 cucon_listnode_t
 cucon_list_extract(cucon_listnode_t node)
 {
@@ -129,6 +129,19 @@ cucon_listnode_t cucon_list_insert_mem(cucon_listnode_t node, size_t size);
 /** Insert a new node before \a node, which holds the pointer \a ptr. */
 cucon_listnode_t cucon_list_insert_ptr(cucon_listnode_t node, void *ptr);
 
+/** As \ref cucon_list_insert_mem, but allocate the new node from \a region.
+ ** The list must not be used after the node is released by \ref
+ ** cu_region_pop or \ref cu_region_drop, and the node must not be passed to
+ ** \ref cucon_list_extract_ptr. */
+cucon_listnode_t cucon_list_insert_mem_region(cu_region_t region,
+					      cucon_listnode_t node,
+					      size_t size);
+
+/** As \ref cucon_list_insert_ptr, but allocate the new node from \a region,
+ ** with the same restrictions as \ref cucon_list_insert_mem_region. */
+cucon_listnode_t cucon_list_insert_ptr_region(cu_region_t region,
+					      cucon_listnode_t node, void *ptr);
+
 /** Remove \a node from its list and return it as an isolated node. */
 cucon_listnode_t cucon_list_extract(cucon_listnode_t node);
 
@@ -137,7 +150,8 @@ cucon_listnode_t cucon_list_extract(cucon_listnode_t node);
 void *cucon_list_extract_mem(cucon_listnode_t node);
 
 /** Return the pointer stored as the value of \a node after unlinking it from
- ** its list. */
+ ** its list.  This also frees \a node, so it cannot be used on nodes
+ ** allocated from a region. */
 void *cucon_list_extract_ptr(cucon_listnode_t node);
 
 /** Erase element pointed to by \a node from its list and return an iterator to
@@ -237,6 +251,28 @@ CU_SINLINE cucon_listnode_t
 cucon_list_append_ptr(cucon_list_t list, void *p)
 { return cucon_list_insert_ptr(cucon_list_end(list), p); }
 
+/** Insert an element allocated from \a region as the first in the list. */
+CU_SINLINE cucon_listnode_t
+cucon_list_prepend_mem_region(cu_region_t region, cucon_list_t list,
+			      size_t size)
+{ return cucon_list_insert_mem_region(region, cucon_list_begin(list), size); }
+
+/** Insert a pointer allocated from \a region as the first in the list. */
+CU_SINLINE cucon_listnode_t
+cucon_list_prepend_ptr_region(cu_region_t region, cucon_list_t list, void *p)
+{ return cucon_list_insert_ptr_region(region, cucon_list_begin(list), p); }
+
+/** Insert an element allocated from \a region as the last in the list. */
+CU_SINLINE cucon_listnode_t
+cucon_list_append_mem_region(cu_region_t region, cucon_list_t list,
+			     size_t size)
+{ return cucon_list_insert_mem_region(region, cucon_list_end(list), size); }
+
+/** Insert a pointer allocated from \a region as the last in the list. */
+CU_SINLINE cucon_listnode_t
+cucon_list_append_ptr_region(cu_region_t region, cucon_list_t list, void *p)
+{ return cucon_list_insert_ptr_region(region, cucon_list_end(list), p); }
+
 /** Append \a src to \a dst, descructing \a src. */
 cucon_listnode_t
 cucon_list_append_list_dct(cucon_list_t dst, cucon_list_t src);
@@ -62,6 +62,10 @@ CU_SINLINE void cucon_pmap_init(cucon_pmap_t map)
 CU_SINLINE cucon_pmap_t cucon_pmap_new(void)
 { return (cucon_pmap_t)cucon_umap_new(); }
 
+/** \copydoc cucon_umap_init_region */
+CU_SINLINE void cucon_pmap_init_region(cucon_pmap_t map, cu_region_t region)
+{ cucon_umap_init_region(&map->impl, region); }
+
 /** Construct \a dst as a copy of \a src but dropping all value slots. */
 CU_SINLINE void cucon_pmap_init_copy_void(cucon_pmap_t dst, cucon_pmap_t src)
 { cucon_umap_init_copy_void(&dst->impl, &src->impl); }
@@ -18,6 +18,7 @@
 #include <cu/clos.h>
 #include <cucon/po.h>
 #include <cucon/pmap.h>
+#include <cucon/bitarray.h>
 #include <cu/memory.h>
 #include <cucon/priq.h>
 #include <cucon/algo_colour.h>
@@ -39,6 +40,9 @@ cucon_po_cct_2elt(cucon_po_t po, cucon_poelt_t bot, cucon_poelt_t top)
     cu_debug_assert(cucon_list_is_empty(&top->ipreds));
     po->bot->level = 0;
     po->top->level = 1;
+    po->bot->index_succs = NULL;
+    po->top->index_succs = NULL;
+    po->index_count = 0;
 #ifdef CUCON_PO_ELT_LINKS_PO
     po->bot->po = po;
     po->top->po = po;
@@ -54,6 +58,9 @@ cucon_po_cct_2elt_cct(cucon_po_t po, cucon_poelt_t bot, cucon_poelt_t top)
     po->bot = bot;
     bot->level = 0;
     top->level = 1;
+    bot->index_succs = NULL;
+    top->index_succs = NULL;
+    po->index_count = 0;
 #ifdef CUCON_PO_ELT_LINKS_PO
     bot->po = po;
     top->po = po;
@@ -106,6 +113,7 @@ cucon_poelt_cct(cucon_poelt_t e)
 {
     cucon_list_init(&e->isuccs);
     cucon_list_init(&e->ipreds);
+    e->index_succs = NULL;
 #if defined(CUCON_PO_ELT_LINKS_PO) && !defined(CU_NDEBUG)
     e->po = NULL;
 #endif
@@ -117,6 +125,7 @@ cucon_poelt_new_alloc(size_t size)
     cucon_poelt_t elt = cu_galloc(sizeof(struct cucon_poelt) + size);
     cucon_list_init(&elt->isuccs);
     cucon_list_init(&elt->ipreds);
+    elt->index_succs = NULL;
 #if defined(CUCON_PO_ELT_LINKS_PO) && !defined(CU_NDEBUG)
     elt->po = NULL;
 #endif
@@ -179,6 +188,83 @@ _po_update_level(cucon_poelt_t e)
     }
 }
 
+
+/* Reachability Index
+ * ------------------ */
+
+CU_SINLINE cu_bool_t
+_po_index_at(cucon_bitarray_t ba, size_t i)
+{
+    return i < cucon_bitarray_size(ba) && cucon_bitarray_at(ba, i);
+}
+
+CU_SINLINE void
+_po_index_set(cucon_bitarray_t ba, size_t i)
+{
+    if (i < cucon_bitarray_size(ba))
+	cucon_bitarray_set_at(ba, i, cu_true);
+    else
+	cucon_bitarray_resize_set_at(ba, i, cu_false, cu_true);
+}
+
+/* Set the bits of 'dst' which are set in 'src', growing 'dst' as needed.
+ * Only the first cucon_bitarray_size(src) bits of 'src' are defined. */
+static void
+_po_index_update_or(cucon_bitarray_t dst, cucon_bitarray_t src)
+{
+    size_t i;
+    size_t n = cucon_bitarray_size(src) / CU_WORD_WIDTH;
+    size_t r = cucon_bitarray_size(src) % CU_WORD_WIDTH;
+    if (cucon_bitarray_size(dst) < cucon_bitarray_size(src))
+	cucon_bitarray_resize_fill_gp(dst, cucon_bitarray_size(src),
+				      cu_false);
+    for (i = 0; i < n; ++i)
+	dst->arr[i] |= src->arr[i];
+    if (r)
+	dst->arr[n] |= src->arr[n] & ((CU_WORD_C(1) << r) - 1);
+}
+
+/* Record 'e_succ' and its successors as successors of 'e', and propagate
+ * downwards.  Predecessors of an element which already has 'e_succ' in its
+ * index already have the full upper span of 'e_succ' in theirs. */
+static void
+_po_index_add_succ(cucon_poelt_t e, cucon_poelt_t e_succ)
+{
+    cucon_po_ipred_it_t it;
+    if (_po_index_at(e->index_succs, e_succ->index_no))
+	return;
+    _po_index_set(e->index_succs, e_succ->index_no);
+    _po_index_update_or(e->index_succs, e_succ->index_succs);
+    for (it = cucon_po_ipred_begin(e); it != cucon_po_ipred_end(e);
+	 it = cucon_po_ipred_it_next(it))
+	_po_index_add_succ(cucon_po_ipred_it_get(it), e_succ);
+}
+
+static void
+_po_index_build(cucon_po_t po, cucon_poelt_t e)
+{
+    cucon_po_isucc_it_t it;
+    cucon_bitarray_t ba;
+    e->index_no = po->index_count++;
+    ba = cucon_bitarray_new(0);
+    for (it = cucon_po_isucc_begin(e); it != cucon_po_isucc_end(e);
+	 it = cucon_po_isucc_it_next(it)) {
+	cucon_poelt_t e_succ = cucon_po_isucc_it_get(it);
+	if (!e_succ->index_succs)
+	    _po_index_build(po, e_succ);
+	_po_index_set(ba, e_succ->index_no);
+	_po_index_update_or(ba, e_succ->index_succs);
+    }
+    e->index_succs = ba;
+}
+
+void
+cucon_po_enable_index(cucon_po_t po)
+{
+    if (po->index_count == 0)
+	_po_index_build(po, po->bot);
+}
+
 void
 cucon_po_insert_cct(cucon_po_t po, cucon_poelt_t e)
 {
@@ -192,6 +278,14 @@ cucon_po_insert_cct(cucon_po_t po, cucon_poelt_t e)
     cucon_list_prepend_ptr(&po->bot->isuccs, e);
     cucon_list_prepend_ptr(&po->top->ipreds, e);
     _po_update_level(e);
+    if (po->index_count) {
+	e->index_no = po->index_count++;
+	e->index_succs = cucon_bitarray_new(0);
+	_po_index_set(e->index_succs, po->top->index_no);
+	_po_index_set(po->bot->index_succs, e->index_no);
+    }
+    else
+	e->index_succs = NULL;
 }
 
 cucon_poelt_t
@@ -286,6 +380,8 @@ cu_bool_t
 cucon_po_prec(cucon_poelt_t e0, cucon_poelt_t e1)
 {
     struct cucon_pmap done;
+    if (e0->index_succs)
+	return _po_index_at(e0->index_succs, e1->index_no);
     cucon_pmap_init(&done);
     return _po_prec(e0, e1, &done);
 }
@@ -351,6 +447,8 @@ cucon_po_constrain_prec(cucon_po_t po, cucon_poelt_t e0, cucon_poelt_t e1)
 	return cu_false;
     if (cucon_po_prec(e0, e1))
 	return cu_true;
+    if (po->index_count && cucon_po_prec(e1, e0))
+	return cu_false;
 #ifdef CUCONP_USE_PO_COLLECT_LSPAN
     cucon_pmap_init(&lspan0);
     if (_po_prec_collect_lspan(e1, e0, &lspan0))
@@ -369,6 +467,8 @@ cucon_po_constrain_prec(cucon_po_t po, cucon_poelt_t e0, cucon_poelt_t e1)
     cucon_list_prepend_ptr(&e0->isuccs, e1);
     cucon_list_prepend_ptr(&e1->ipreds, e0);
     _po_update_level(e1);
+    if (po->index_count)
+	_po_index_add_succ(e0, e1);
     return cu_true;
 }
 
@@ -35,6 +35,7 @@ struct cucon_po
 {
     struct cucon_poelt *bot;
     struct cucon_poelt *top;
+    size_t index_count;	/* number of indexed elements, 0 if no index */
 };
 
 struct cucon_poelt
@@ -44,6 +45,10 @@ struct cucon_poelt
 
     unsigned int level;	/* for topological traversal */
 
+    /* Reachability index, see cucon_po_enable_index. */
+    size_t index_no;
+    cucon_bitarray_t index_succs;
+
 #ifdef CUCON_PO_ELT_LINKS_PO
     struct cucon_po *po;
 #endif
@@ -149,6 +154,23 @@ cucon_poelt_t	cucon_poelt_of_data(void *slot);
 
 /* void		cucon_po_erase(cucon_poelt_t e); */
 
+/*!Build a reachability index for \a po which is kept up to date by
+ * subsequent calls to \ref cucon_po_insert_mem, \ref cucon_po_insert_ptr,
+ * \ref cucon_po_insert_cct, and \ref cucon_po_constrain_prec.  With the
+ * index, \ref cucon_po_prec and \ref cucon_po_preceq take constant time
+ * instead of searching the successors of the first argument.  The index
+ * stores a bit-vector of the successors of each element, so it needs
+ * memory quadratic in the number of elements, and each new constraint
+ * updates the bit-vectors of all predecessors which did not already reach
+ * the new successor.  It is therefore best suited for mostly static
+ * orders which are queried often.  Calling this function on an indexed
+ * order has no effect. */
+void		cucon_po_enable_index(cucon_po_t po);
+
+/*!True iff \a po has a reachability index. */
+CU_SINLINE cu_bool_t
+cucon_po_has_index(cucon_po_t po) { return po->index_count > 0; }
+
 /*!If \a e1 ≼ \a e0, return false, else force the constraint \a e0 ≺ \a e1
  * and return true. */
 cu_bool_t	cucon_po_constrain_prec(cucon_po_t po,
@@ -16,6 +16,7 @@
  */
 
 #include <cucon/po.h>
+#include <stdlib.h>
 #include <time.h>
 
 typedef unsigned long eltval_t;
@@ -68,6 +69,63 @@ report(char const *what, size_t cnt, clock_t t)
     printf("%30s: %10lg\n", what, cnt*(double)CLOCKS_PER_SEC/t);
 }
 
+/* Issue 'qcnt' random precedence queries among the 'cnt' elements of 'arr'.
+ * The pairs are drawn in advance so that only the queries are timed. */
+static clock_t
+query_many(size_t cnt, cucon_poelt_t *arr, size_t qcnt, size_t *prec_cnt)
+{
+    size_t n;
+    size_t *pairs = malloc(sizeof(size_t)*2*qcnt);
+    clock_t t;
+    *prec_cnt = 0;
+    for (n = 0; n < 2*qcnt; ++n)
+	pairs[n] = lrand48() % cnt;
+    t = -clock();
+    for (n = 0; n < qcnt; ++n)
+	*prec_cnt += cucon_po_preceq(arr[pairs[2*n]], arr[pairs[2*n + 1]]);
+    t += clock();
+    free(pairs);
+    return t;
+}
+
+static void
+bench_queries(size_t cnt, size_t qcnt)
+{
+    cucon_poelt_t *arr = malloc(sizeof(cucon_poelt_t)*cnt);
+    cucon_po_t po, po_idx;
+    size_t prec_cnt, prec_cnt_idx;
+    clock_t t_ins, t_ins_idx, t_build, t_q, t_q_idx;
+
+    /* Without index, then with an index built afterwards. */
+    srand48(cnt);
+    po = cucon_po_new_mem(sizeof(eltval_t), sizeof(eltval_t));
+    t_ins = insert_some(po, cnt/2, cnt, arr);
+    srand48(cnt + 1);
+    t_q = query_many(cnt, arr, qcnt, &prec_cnt);
+    t_build = -clock();
+    cucon_po_enable_index(po);
+    t_build += clock();
+    srand48(cnt + 1);
+    t_q_idx = query_many(cnt, arr, qcnt, &prec_cnt_idx);
+    if (prec_cnt != prec_cnt_idx)
+	fprintf(stderr, "Indexed and plain queries disagree.\n");
+
+    /* With an index maintained during insertion. */
+    srand48(cnt);
+    po_idx = cucon_po_new_mem(sizeof(eltval_t), sizeof(eltval_t));
+    cucon_po_enable_index(po_idx);
+    t_ins_idx = insert_some(po_idx, cnt/2, cnt, arr);
+
+    printf("%6zd elements, %zd queries, %zd hits:\n", cnt, qcnt, prec_cnt);
+    report("insert", cnt, t_ins);
+    report("insert, indexed", cnt, t_ins_idx);
+    printf("%30s: %10lg s\n", "index build",
+	   t_build/(double)CLOCKS_PER_SEC);
+    report("query", qcnt, t_q);
+    report("query, indexed", qcnt, t_q_idx);
+    free(arr);
+}
+
 #define N 1000
 int
 main()
@@ -82,5 +140,8 @@ main()
     report("insert", N, t0);
     report("check", N, t1);
     printf("connection count: %zd\n", cucon_po_debug_count_connections(po));
+    bench_queries(250, 1000000);
+    bench_queries(500, 1000000);
+    bench_queries(1000, 1000000);
     return 0;
 }
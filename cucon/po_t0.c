@@ -141,8 +141,10 @@ check_inf_of_list(cucon_poelt_t *ve)
 /* main
  * ---- */
 
+/* Run the tests, enabling the reachability index before the insertion
+ * round number k_index, or never if k_index is negative. */
 void
-check_all()
+check_all(int k_index)
 {
     /* NB. N must be larger than big, check_inf_of_list:N */
     int const N = 1000;
@@ -161,6 +163,8 @@ check_all()
     for (i = 0; i < N; ++i)
 	ve[i] = 0;
     for (k = 0; k < N/2; ++k) {
+	if (k == k_index)
+	    cucon_po_enable_index(po);
 	if (k < 2) {
 	    if (k == 0)
 		i = small;
@@ -198,6 +202,18 @@ check_all()
 	assert(cucon_po_preceq(ve[i], ve[j]) == bitpreceq(i, j));
 	assert(cucon_po_preceq(ve[j], ve[i]) == bitpreceq(j, i));
     }
+    if (cucon_po_has_index(po)) {
+	for (i = 0; i < N; ++i) {
+	    if (!ve[i])
+		continue;
+	    cu_test_assert(cucon_po_prec(cucon_po_bot(po), ve[i]));
+	    cu_test_assert(cucon_po_prec(ve[i], cucon_po_top(po)));
+	    for (j = 0; j < N; ++j)
+		if (ve[j])
+		    cu_test_assert(cucon_po_preceq(ve[i], ve[j])
+				   == bitpreceq(i, j));
+	}
+    }
 
     main0cl.accum = cucon_umap_new();
     cucon_po_iter_open_range(ve[small], ve[big], main0_prep(&main0cl));
@@ -225,9 +241,9 @@ main()
     int i;
     cu_init();
     cu_set_verbosity(11);
-    check_all();
+    check_all(-1);
     cu_set_verbosity(10);
     for (i = 0; i < 20; ++i)
-	check_all();
+	check_all(i % 3 == 0? -1 : i % 3 == 1? 0 : 100);
     return 2*!!cu_test_bug_count();
 }
@@ -128,6 +128,19 @@ cucon_priq_pop_front(cucon_priq_t q)
     return result;
 }
 
+void
+cuconP_priq_template_expand(void **arr, size_t *capacity, size_t elt_size)
+{
+    size_t old_capacity = *capacity;
+    void *old_arr = *arr;
+    *capacity = old_capacity == 0? 4 : 2*old_capacity;
+    *arr = cu_galloc(elt_size*(*capacity));
+    if (old_capacity) {
+	memcpy(*arr, old_arr, elt_size*old_capacity);
+	cu_gfree(old_arr);
+    }
+}
+
 void
 cucon_priq_dump(cucon_priq_t q,
 	      cu_clop(print_key_fn, void, void *key, FILE *out),
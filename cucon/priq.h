@@ -27,6 +27,7 @@
 
 #include <cucon/fwd.h>
 #include <cu/clos.h>
+#include <cu/memory.h>
 #include <stdio.h>
 
 CU_BEGIN_DECLARATIONS
@@ -74,6 +75,88 @@ void cucon_priq_dump(cucon_priq_t q,
 		     cu_clop(print_key_fn, void, void *key, FILE *out),
 		     FILE *out);
 
+
+void cuconP_priq_template_expand(void **arr, size_t *capacity, size_t elt_size);
+
+/** A template which defines a priority queue with name prefix \a name,
+ ** storing elements of type \a elt_t by value in an \a arity-ary heap.
+ ** \a prior(x, y) is a function or function-like macro which is called
+ ** directly on the elements, and as for \ref cucon_priq, the front element
+ ** \a x fulfils <tt>prior(x, y)</tt> for all other \c y in the queue.
+ **
+ ** Since there are no closure calls and no per-element allocations, this is
+ ** considerably faster than \ref cucon_priq for small element types.  An
+ ** \a arity of 4 is usually a good choice, as it makes the heap shallower
+ ** while keeping the children of a node within a cache line or two.
+ **
+ ** The template defines <tt>struct name</tt>, \c name_t as a pointer to it,
+ ** and the inline functions \c name_init, \c name_new, \c name_count, \c
+ ** name_is_empty, \c name_front, \c name_insert, and \c name_pop_front,
+ ** which behave like their \ref cucon_priq counterparts, except that \c
+ ** name_front returns a pointer to the front element, and \c
+ ** name_pop_front must not be called on an empty queue. */
+#define CUCON_PRIQ_TEMPLATE(name, elt_t, arity, prior)			\
+    typedef struct name *name##_t;					\
+    struct name								\
+    {									\
+	size_t count;							\
+	size_t capacity;						\
+	elt_t *arr;							\
+    };									\
+									\
+    CU_SINLINE void name##_init(name##_t q)				\
+    { q->count = 0; q->capacity = 0; q->arr = NULL; }			\
+									\
+    CU_SINLINE name##_t name##_new(void)				\
+    { name##_t q = cu_gnew(struct name); name##_init(q); return q; }	\
+									\
+    CU_SINLINE size_t name##_count(name##_t q) { return q->count; }	\
+									\
+    CU_SINLINE cu_bool_t name##_is_empty(name##_t q)			\
+    { return q->count == 0; }						\
+									\
+    CU_SINLINE elt_t *name##_front(name##_t q) { return &q->arr[0]; }	\
+									\
+    CU_SINLINE void name##_insert(name##_t q, elt_t x)			\
+    {									\
+	size_t n = q->count;						\
+	if (n >= q->capacity)						\
+	    cuconP_priq_template_expand((void **)&q->arr, &q->capacity,	\
+					sizeof(elt_t));			\
+	while (n > 0) {							\
+	    size_t m = (n - 1)/(arity);					\
+	    if (prior(q->arr[m], x))					\
+		break;							\
+	    q->arr[n] = q->arr[m];					\
+	    n = m;							\
+	}								\
+	q->arr[n] = x;							\
+	++q->count;							\
+    }									\
+									\
+    CU_SINLINE elt_t name##_pop_front(name##_t q)			\
+    {									\
+	size_t i = 0, n = --q->count;					\
+	elt_t result = q->arr[0];					\
+	elt_t x = q->arr[n];						\
+	for (;;) {							\
+	    size_t j, j_min = (arity)*i + 1, j_end = j_min + (arity);	\
+	    if (j_min >= n)						\
+		break;							\
+	    if (j_end > n)						\
+		j_end = n;						\
+	    for (j = j_min + 1; j < j_end; ++j)				\
+		if (prior(q->arr[j], q->arr[j_min]))			\
+		    j_min = j;						\
+	    if (prior(x, q->arr[j_min]))				\
+		break;							\
+	    q->arr[i] = q->arr[j_min];					\
+	    i = j_min;							\
+	}								\
+	q->arr[i] = x;							\
+	return result;							\
+    }
+
 /** @} */
 CU_END_DECLARATIONS
 
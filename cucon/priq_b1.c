@@ -0,0 +1,139 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2009  Petter Urkedal <urkedal@nbi.dk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Compares the queues instantiated with CUCON_PRIQ_TEMPLATE to cucon_priq,
+ * cucon_fibheap and cucon_fibq, using the same insert/pop pattern as
+ * cucon/priq_b0.c.  Times are per operation, in nanoseconds. */
+
+#include <cucon/priq.h>
+#include <cucon/fibheap.h>
+#include <cucon/fibheap_test.h>
+#include <cucon/fibq.h>
+#include <cucon/fibq_test.h>
+#include <cu/test.h>
+#include <cu/memory.h>
+#include <limits.h>
+#include <stdio.h>
+#include <time.h>
+
+#define REPEAT 20000
+#define N_INS_POP 16 /* power of 2 */
+#define VMAX INT_MAX
+#define MAX_CARD (1 << 20)
+
+#define INT_PRIOREQ(i0, i1) ((i0) <= (i1))
+CUCON_PRIQ_TEMPLATE(_int_priq2, int, 2, INT_PRIOREQ)
+CUCON_PRIQ_TEMPLATE(_int_priq4, int, 4, INT_PRIOREQ)
+
+/* A typical element for graph search, a distance and a vertex. */
+struct _dv { double distance; void *vertex; };
+#define DV_PRIOREQ(x, y) ((x).distance <= (y).distance)
+CUCON_PRIQ_TEMPLATE(_dv_priq4, struct _dv, 4, DV_PRIOREQ)
+
+cu_clop_def(_priq_prioreq, cu_bool_t, void *x, void *y)
+{
+    return *(int *)x <= *(int *)y;
+}
+
+static void
+_priq_insert(cucon_priq_t Q, int v)
+{
+    int *p = cu_gnew(int);
+    *p = v;
+    cucon_priq_insert(Q, p);
+}
+
+static int
+_priq_pop(cucon_priq_t Q)
+{
+    int *p = cucon_priq_pop_front(Q);
+    return p? *p : -1;
+}
+
+static void
+_dv_insert(_dv_priq4_t Q, int v)
+{
+    struct _dv x;
+    x.distance = v;
+    x.vertex = NULL;
+    _dv_priq4_insert(Q, x);
+}
+
+static int
+_dv_pop(_dv_priq4_t Q)
+{
+    return _dv_priq4_pop_front(Q).distance;
+}
+
+/* Keeps the popped values alive. */
+static unsigned int _sink;
+
+#define BENCH(Q, card, insert, pop)					\
+    do {								\
+	int round;							\
+	clock_t t = 0;							\
+	while (card(Q) < avg_card - N_INS_POP/2)			\
+	    insert(Q, lrand48() % VMAX);				\
+	for (round = 0; round < REPEAT; ++round) {			\
+	    int i, values[N_INS_POP];					\
+	    for (i = 0; i < N_INS_POP; ++i)				\
+		values[i] = lrand48() % VMAX;				\
+	    t -= clock();						\
+	    for (i = 0; i < N_INS_POP; ++i)				\
+		insert(Q, values[i]);					\
+	    for (i = 0; i < N_INS_POP; ++i)				\
+		_sink += pop(Q);					\
+	    t += clock();						\
+	}								\
+	printf(" %8.1lf", t*scl);					\
+    } while (0)
+
+static void
+_bench()
+{
+    cucon_priq_t Q_priq = cucon_priq_new(cu_clop_ref(_priq_prioreq));
+    cucon_fibheap_t Q_fibheap = cucon_fibheap_new(cu_clop_ref(_fibnode_prioreq));
+    cucon_fibq_t Q_fibq = cucon_fibq_new(cu_clop_ref(_fibq_prioreq));
+    _int_priq2_t Q_int2 = _int_priq2_new();
+    _int_priq4_t Q_int4 = _int_priq4_new();
+    _dv_priq4_t Q_dv4 = _dv_priq4_new();
+    size_t avg_card;
+
+    printf("%8s %8s %8s %8s %8s %8s %8s\n", "card", "priq", "fibheap",
+	   "fibq", "int/2", "int/4", "dv/4");
+    for (avg_card = N_INS_POP/2.0; avg_card <= MAX_CARD; avg_card *= 4) {
+	double scl = 1e9/((double)CLOCKS_PER_SEC*REPEAT*N_INS_POP);
+	printf("%8zd", avg_card);
+	BENCH(Q_priq, cucon_priq_count, _priq_insert, _priq_pop);
+	BENCH(Q_fibheap, cucon_fibheap_card, _fibheap_insert, _fibheap_pop);
+	BENCH(Q_fibq, cucon_fibq_card, _fibq_insert, _fibq_pop);
+	BENCH(Q_int2, _int_priq2_count, _int_priq2_insert,
+	      _int_priq2_pop_front);
+	BENCH(Q_int4, _int_priq4_count, _int_priq4_insert,
+	      _int_priq4_pop_front);
+	BENCH(Q_dv4, _dv_priq4_count, _dv_insert, _dv_pop);
+	printf("\n");
+    }
+}
+
+int
+main()
+{
+    cu_init();
+    _bench();
+    return 2*!!cu_test_bug_count();
+}
@@ -31,6 +31,38 @@ cu_clop_def(int_print, void, void *i0, FILE* out)
     fprintf(out, "%d", *(int*)i0);
 }
 
+#define INT_LESS(i0, i1) ((i0) < (i1))
+CUCON_PRIQ_TEMPLATE(int_priq2, int, 2, INT_LESS)
+CUCON_PRIQ_TEMPLATE(int_priq4, int, 4, INT_LESS)
+CUCON_PRIQ_TEMPLATE(int_priq5, int, 5, INT_LESS)
+
+#define TEST_TEMPLATE(name)						\
+static void								\
+test_##name()								\
+{									\
+    int i;								\
+    struct name q;							\
+    name##_init(&q);							\
+    for (i = 0; i < 4000; ++i) {					\
+	int j, l = 0;							\
+	int n = lrand48() % 200;					\
+	for (j = 0; j < n; ++j)						\
+	    name##_insert(&q, lrand48() % 100);				\
+	n = lrand48() % 200;						\
+	for (j = 0; j < n && !name##_is_empty(&q); ++j) {		\
+	    int k = *name##_front(&q);					\
+	    int k_pop = name##_pop_front(&q);				\
+	    assert(k_pop == k);						\
+	    assert(k >= l);						\
+	    l = k;							\
+	}								\
+    }									\
+}
+
+TEST_TEMPLATE(int_priq2)
+TEST_TEMPLATE(int_priq4)
+TEST_TEMPLATE(int_priq5)
+
 int
 main()
 {
@@ -78,5 +110,8 @@ main()
 	}
     }
 
+    test_int_priq2();
+    test_int_priq4();
+    test_int_priq5();
     return 0;
 }
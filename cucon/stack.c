@@ -18,6 +18,7 @@
 #include <cucon/stack.h>
 #include <cu/ptr_seq.h>
 #include <cu/memory.h>
+#include <cu/region.h>
 #include <cu/util.h>
 #include <cu/diag.h>
 #include <cu/ptr.h>
@@ -33,6 +34,23 @@ cucon_stack_init(cucon_stack_t stack)
 {
     stack->prev = NULL;
     stack->begin = stack->sp = stack->end = cuconP_STACK_NOADDRESS;
+    stack->region = NULL;
+}
+
+void
+cucon_stack_init_region(cucon_stack_t stack, cu_region_t region)
+{
+    cucon_stack_init(stack);
+    stack->region = region;
+}
+
+CU_SINLINE void *
+_chunk_alloc(cucon_stack_t stack, size_t size)
+{
+    if (stack->region)
+	return cu_region_alloc(stack->region, size);
+    else
+	return cu_galloc(size);
 }
 
 void
@@ -59,7 +77,8 @@ cuconP_stack_expand(cucon_stack_t stack, size_t size)
 	chunk_size = size;
     else
 	chunk_size = cuconP_STACK_CHUNK_SIZE;
-    prev = cu_galloc(CU_ALIGNED_SIZEOF(struct cucon_stack) + chunk_size);
+    prev = _chunk_alloc(stack,
+			CU_ALIGNED_SIZEOF(struct cucon_stack) + chunk_size);
     prev->prev = stack->prev;
     prev->begin = stack->begin;
     prev->sp = stack->sp;
@@ -150,7 +169,7 @@ cucon_stack_continuous_top(cucon_stack_t stack, size_t size)
 	    n -= stack0->end - stack0->sp;
 	} while (n > 0);
 	size -= n;
-	new_begin = cu_galloc(size);
+	new_begin = _chunk_alloc(stack, size);
 	new_end = cu_ptr_add(new_begin, size);
 	sp = new_begin;
 	stack1 = stack;
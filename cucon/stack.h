@@ -44,12 +44,20 @@ struct cucon_stack
     char *begin;	/* lowest address for current capacity */
     char *sp;		/* lowest address in use */
     char *end;		/* boundary to prev */
+    cu_region_t region;	/* where chunks are allocated, or NULL */
 };
 
 /** Construct \a stack as an empty stack. */
 void cucon_stack_init(cucon_stack_t stack);
 
-/** Construct \a dst as a copy of \a src. */
+/** Construct \a stack as an empty stack which allocates its chunks from \a
+ ** region, or from the heap if \a region is \c NULL.  \a stack must not be
+ ** used after the chunks are released by \ref cu_region_pop or \ref
+ ** cu_region_drop. */
+void cucon_stack_init_region(cucon_stack_t stack, cu_region_t region);
+
+/** Construct \a dst as a copy of \a src.  The copy allocates from the
+ ** heap. */
 void cucon_stack_init_copy(cucon_stack_t dst, cucon_stack_t src);
 
 /** True iff stack is empty. */
@@ -25,6 +25,7 @@
 #include <cu/idr.h>
 #include <cu/util.h>
 #include <cu/ptr.h>
+#include <cu/region.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -79,17 +80,33 @@ typedef unsigned long cucon_pmap_hash_t;
 /* Implementation
  * ============== */
 
+CU_SINLINE void *
+_node_alloc(cucon_umap_t umap, size_t size)
+{
+    if (umap->region)
+	return cu_region_alloc(umap->region, size);
+    else
+	return cu_galloc(size);
+}
+
 void
-cucon_umap_init(cucon_umap_t umap)
+cucon_umap_init_region(cucon_umap_t umap, cu_region_t region)
 {
     umap->arr = cu_galloc(sizeof(cucon_umap_node_t)
 			   *(MIN_SIZE + 1));
     umap->mask = MIN_SIZE - 1;
     umap->size = 0;
+    umap->region = region;
     memset(umap->arr, 0, MIN_SIZE*sizeof(cucon_umap_node_t));
     umap->arr[MIN_SIZE] = (void*)-1;
 }
 
+void
+cucon_umap_init(cucon_umap_t umap)
+{
+    cucon_umap_init_region(umap, NULL);
+}
+
 cucon_umap_t
 cucon_umap_new()
 {
@@ -105,6 +122,7 @@ cucon_umap_init_copy_void(cucon_umap_t dst, cucon_umap_t src)
     size_t n;
     dst->size = src->size;
     dst->mask = N;
+    dst->region = NULL;
     ++N;
     dst->arr = cu_galloc(sizeof(cucon_umap_node_t)*(N + 1));
     for (n = 0; n < N; ++n) {
@@ -137,6 +155,7 @@ cucon_umap_init_copy_mem(cucon_umap_t dst, cucon_umap_t src, size_t slot_size)
     size_t full_size = sizeof(struct cucon_umap_node) + slot_size;
     dst->size = src->size;
     dst->mask = N;
+    dst->region = NULL;
     ++N;
     dst->arr = cu_galloc(sizeof(cucon_umap_node_t)*(N + 1));
     for (n = 0; n < N; ++n) {
@@ -162,6 +181,7 @@ cucon_umap_init_copy_mem_ctor(
     size_t n;
     dst->size = src->size;
     dst->mask = N;
+    dst->region = NULL;
     ++N;
     dst->arr = cu_galloc(sizeof(cucon_umap_node_t)*(N + 1));
     for (n = 0; n < N; ++n) {
@@ -192,6 +212,7 @@ cucon_umap_init_copy_node(
     size_t n;
     dst->size = src->size;
     dst->mask = N;
+    dst->region = NULL;
     ++N;
     dst->arr = cu_galloc(sizeof(cucon_umap_node_t)*(N + 1));
     for (n = 0; n < N; ++n) {
@@ -346,7 +367,7 @@ cucon_umap_insert_new_node(cucon_umap_t map, uintptr_t key,
 	node = node->next;
     }
     ++map->size;
-    node = cu_galloc(node_size);
+    node = _node_alloc(map, node_size);
     node->key = key;
     node->next = *head;
     *head = *(cucon_umap_node_t *)node_out = node;
@@ -394,7 +415,7 @@ cucon_umap_insert_mem(cucon_umap_t umap, uintptr_t key, size_t size,
     }
     ++umap->size;
     node = *node0
-	= cu_galloc(CU_ALIGNED_SIZEOF(struct cucon_umap_node) + size);
+	= _node_alloc(umap, CU_ALIGNED_SIZEOF(struct cucon_umap_node) + size);
     node->key = key;
     node->next = NULL;
     if (value)
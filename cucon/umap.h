@@ -44,6 +44,7 @@ struct cucon_umap
     size_t size; /* the number of elements in the map. */
     size_t mask; /* = capacity - 1 */
     cucon_umap_node_t *arr;
+    cu_region_t region; /* where nodes are allocated, or NULL for the heap */
 };
 
 struct cucon_umap_node
@@ -71,6 +72,13 @@ void cucon_umap_init(cucon_umap_t map);
 /** Return an empty property map. */
 cucon_umap_t cucon_umap_new(void);
 
+/** Construct \a map as an empty property map which allocates its nodes from
+ ** \a region, or from the heap if \a region is \c NULL.  \a map must not be
+ ** used after the nodes are released by \ref cu_region_pop or \ref
+ ** cu_region_drop, but it can be dropped along with the nodes without
+ ** clearing it first.  Copies of \a map allocate from the heap. */
+void cucon_umap_init_region(cucon_umap_t map, cu_region_t region);
+
 /** Return an empty property map with <tt>void *</tt> keys. */
 
 /** Construct \a dst as a copy of \a src but dropping all value slots. */
@@ -0,0 +1,103 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cucon/umap.h>
+#include <cucon/fumap.h>
+#include <cu/memory.h>
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Compares cucon_umap with cucon_fumap for insertions, successful and failed
+ * lookups, and erasures on keys which look like pointers to small objects. */
+
+#define KEY(i) ((uintptr_t)(i)*sizeof(void *)*2 + 0x100000)
+
+static double
+_rate(clock_t t, size_t n)
+{ return t/((double)CLOCKS_PER_SEC*n)*1e9; }
+
+static void
+_bench(size_t N)
+{
+    size_t i, j, J = 0x100000/N + 1;
+    clock_t t_umap[4] = {0, 0, 0, 0};
+    clock_t t_fumap[4] = {0, 0, 0, 0};
+    size_t count = 0;
+
+    for (j = 0; j < J; ++j) {
+	struct cucon_umap umap;
+	struct cucon_fumap fumap;
+
+	cucon_umap_init(&umap);
+	t_umap[0] -= clock();
+	for (i = 0; i < N; ++i)
+	    cucon_umap_insert_ptr(&umap, KEY(i), &umap);
+	t_umap[0] += clock();
+	t_umap[1] -= clock();
+	for (i = 0; i < N; ++i)
+	    count += !!cucon_umap_find_mem(&umap, KEY(i));
+	t_umap[1] += clock();
+	t_umap[2] -= clock();
+	for (i = N; i < 2*N; ++i)
+	    count += !!cucon_umap_find_mem(&umap, KEY(i));
+	t_umap[2] += clock();
+	t_umap[3] -= clock();
+	for (i = 0; i < N; ++i)
+	    cucon_umap_erase(&umap, KEY(i));
+	t_umap[3] += clock();
+
+	cucon_fumap_init(&fumap, sizeof(void *));
+	t_fumap[0] -= clock();
+	for (i = 0; i < N; ++i)
+	    cucon_fumap_insert_ptr(&fumap, KEY(i), &fumap);
+	t_fumap[0] += clock();
+	t_fumap[1] -= clock();
+	for (i = 0; i < N; ++i)
+	    count += !!cucon_fumap_find_mem(&fumap, KEY(i));
+	t_fumap[1] += clock();
+	t_fumap[2] -= clock();
+	for (i = N; i < 2*N; ++i)
+	    count += !!cucon_fumap_find_mem(&fumap, KEY(i));
+	t_fumap[2] += clock();
+	t_fumap[3] -= clock();
+	for (i = 0; i < N; ++i)
+	    cucon_fumap_erase(&fumap, KEY(i));
+	t_fumap[3] += clock();
+    }
+    if (count != 2*N*J)
+	fprintf(stderr, "Unexpected hit count %zd.\n", count);
+    printf("%8zd  umap %8.2lf%8.2lf%8.2lf%8.2lf\n", N,
+	   _rate(t_umap[0], N*J), _rate(t_umap[1], N*J),
+	   _rate(t_umap[2], N*J), _rate(t_umap[3], N*J));
+    printf("%8s fumap %8.2lf%8.2lf%8.2lf%8.2lf\n", "",
+	   _rate(t_fumap[0], N*J), _rate(t_fumap[1], N*J),
+	   _rate(t_fumap[2], N*J), _rate(t_fumap[3], N*J));
+}
+
+int
+main(int argc, char **argv)
+{
+    int i, max_log2 = argc > 1? atoi(argv[1]) : 20;
+    cu_init();
+    printf("Times are in ns per operation.\n");
+    printf("%8s%6s%8s%8s%8s%8s\n", "size", "", "insert", "hit", "miss",
+	   "erase");
+    for (i = 2; i <= max_log2; i += 2)
+	_bench((size_t)1 << i);
+    return 0;
+}
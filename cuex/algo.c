@@ -31,6 +31,7 @@
 #include <cu/idr.h>
 #include <cu/int.h>
 #include <cu/ptr_seq.h>
+#include <cu/region.h>
 #include <cucon/list.h>
 #include <cucon/pmap.h>
 #include <cucon/pset.h>
@@ -448,6 +449,49 @@ cuex_substitute_pmap(cuex_t ex, cucon_pmap_t pmap)
     }
 }
 
+static cuex_t
+_substitute_pmap_memo(cuex_t ex, cucon_pmap_t pmap, cucon_pmap_t memo)
+{
+    cuex_t repl = cucon_pmap_find_ptr(pmap, ex);
+    if (repl != NULL)
+	return repl;
+    else {
+	cuex_meta_t meta = cuex_meta(ex);
+	if (cuex_meta_is_opr(meta) && cuex_opr_r(meta) > 0) {
+	    cuex_t *slot;
+	    if (!cucon_pmap_insert_mem(memo, ex, sizeof(cuex_t), &slot))
+		return *slot;
+	    CUEX_OPN_TRAN(meta, ex, subex,
+			    _substitute_pmap_memo(subex, pmap, memo));
+	    *slot = ex;
+	}
+	return ex;
+    }
+}
+
+cuex_t
+cuex_substitute_pmap_memo(cuex_t ex, cucon_pmap_t pmap)
+{
+    cuex_substitute_pmap_many(pmap, 1, &ex, &ex);
+    return ex;
+}
+
+void
+cuex_substitute_pmap_many(cucon_pmap_t pmap, size_t count,
+			  cuex_t const *ex_arr, cuex_t *res_arr)
+{
+    cu_region_t region = cu_tregion();
+    struct cu_region_mark mark;
+    struct cucon_pmap memo;
+    size_t i;
+
+    cu_region_push(region, &mark);
+    cucon_pmap_init_region(&memo, region);
+    for (i = 0; i < count; ++i)
+	res_arr[i] = _substitute_pmap_memo(ex_arr[i], pmap, &memo);
+    cu_region_pop(region, &mark);
+}
+
 cuex_t
 cuex_leftmost_with_meta(cuex_t ex, cuex_meta_t search_meta)
 {
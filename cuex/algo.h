@@ -122,6 +122,17 @@ cuex_t cuex_substitute_ex(cuex_t e, cuex_t var, cuex_t value);
  ** values, where \a pmap maps from \ref cuex_t to \ref cuex_t */
 cuex_t cuex_substitute_pmap(cuex_t e, cucon_pmap_t pmap);
 
+/** Same as \ref cuex_substitute_pmap, but visits each shared subterm of \a
+ ** e only once, using a scratch table keyed on node identity. */
+cuex_t cuex_substitute_pmap_memo(cuex_t e, cucon_pmap_t pmap);
+
+/** Stores the result of \ref cuex_substitute_pmap on \a e_arr[i] in \a
+ ** res_arr[i] for each \a i less than \a count, visiting subterms shared
+ ** within and across the expressions only once.  \a res_arr may equal \a
+ ** e_arr. */
+void cuex_substitute_pmap_many(cucon_pmap_t pmap, size_t count,
+			       cuex_t const *e_arr, cuex_t *res_arr);
+
 /** Return the leftmost leaf of \a e with the meta \a meta. */
 cuex_t cuex_leftmost_with_meta(cuex_t e, cuex_meta_t meta);
 
@@ -21,6 +21,7 @@
 #include <cuex/opn.h>
 #include <cuex/oprdefs.h>
 #include <cudyn/misc.h>
+#include <cucon/pmap.h>
 #include <cu/test.h>
 
 cu_clop_def(is_const, cu_bool_t, cuex_t e)
@@ -85,11 +86,38 @@ test_msg()
     cu_test_assert(ep == cuex_msg_unify(e[0], e[1], msg_cb2_prep(&cb2)));
 }
 
+/* Check cuex_substitute_pmap_memo and cuex_substitute_pmap_many against
+ * cuex_substitute_pmap on an expression where each level is shared twice. */
+void
+test_substitute_pmap_memo()
+{
+    struct cucon_pmap pmap;
+    cuex_t v[3], e[17], r[17];
+    int i;
+    for (i = 0; i < 3; ++i)
+	v[i] = cuex_var_new_e();
+    e[0] = v[0];
+    for (i = 1; i < 17; ++i)
+	e[i] = cuex_o2_gprod(e[i - 1],
+			     cuex_o2_gexpt(e[i - 1], v[i % 3]));
+    cucon_pmap_init(&pmap);
+    cucon_pmap_insert_ptr(&pmap, v[0], cudyn_int(0));
+    cucon_pmap_insert_ptr(&pmap, v[1], cudyn_int(1));
+    cucon_pmap_insert_ptr(&pmap, e[3], v[1]);
+    for (i = 0; i < 17; i += 4)
+	cu_test_assert(cuex_substitute_pmap_memo(e[i], &pmap)
+		       == cuex_substitute_pmap(e[i], &pmap));
+    cuex_substitute_pmap_many(&pmap, 17, e, r);
+    for (i = 0; i < 17; ++i)
+	cu_test_assert(r[i] == cuex_substitute_pmap(e[i], &pmap));
+}
+
 int
 main()
 {
     cuex_init();
     test();
     test_msg();
+    test_substitute_pmap_memo();
     return 0;
 }
@@ -0,0 +1,381 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Stream Format
+ *
+ *     stream ::= "cuex" version record*
+ *     record ::= ROOT ref
+ *		| OPR select arity flags name_size name_byte*
+ *		| IDR size byte*
+ *		| SVAR qcode
+ *		| HVAR kind qcode index
+ *		| OPN_BASE + opr_index ref*
+ *
+ * All integers are written with custo_fwrite_uintmax.  Each record except ROOT
+ * and OPR defines the next node, numbered from zero.  An OPR record defines
+ * the next operator index, and a node which is an operation is written as its
+ * operator index offset by OPN_BASE followed by its operands.  A ref is the
+ * distance from the next node number back to the node it refers to, which
+ * keeps it small for the common case of recently written nodes.
+ */
+
+#include <cuex/binary_io.h>
+#include <cuex/ex.h>
+#include <cuex/opn.h>
+#include <cuex/oprinfo.h>
+#include <cuex/var.h>
+#include <custo/binary_io.h>
+#include <cu/idr.h>
+#include <cu/memory.h>
+#include <cu/clos.h>
+#include <string.h>
+
+#define VERSION		1
+
+#define TAG_ROOT	0
+#define TAG_OPR		1
+#define TAG_IDR		2
+#define TAG_SVAR	3
+#define TAG_HVAR	4
+#define TAG_OPN_BASE	8
+
+static char const _magic[4] = "cuex";
+
+
+/* == Writer == */
+
+static cu_bool_t
+_write_bytes(char const *arr, size_t size, FILE *out)
+{
+    return custo_fwrite_uintmax(size, out)
+	&& (size == 0 || fwrite(arr, size, 1, out) == 1);
+}
+
+static cu_bool_t
+_write_opr(cuex_binwriter_t writer, cuex_meta_t opr, uintmax_t *index_out)
+{
+    size_t *slot;
+    cuex_oprinfo_t oi;
+    char const *name;
+
+    if (!cucon_umap_insert_mem(&writer->opr_index, opr, sizeof(size_t),
+			       &slot)) {
+	*index_out = *slot;
+	return cu_true;
+    }
+    *index_out = *slot = writer->opr_cnt++;
+    oi = cuex_oprinfo(opr);
+    name = oi? cuex_oprinfo_name(oi) : "";
+    return custo_fwrite_uintmax(TAG_OPR, writer->out)
+	&& custo_fwrite_uintmax(cuex_opr_index(opr), writer->out)
+	&& custo_fwrite_uintmax(cuex_opr_r(opr), writer->out)
+	&& custo_fwrite_uintmax(cuex_opr_flags(opr) >> CUEX_OPR_FLAGS_SHIFT,
+				writer->out)
+	&& _write_bytes(name, strlen(name), writer->out);
+}
+
+static cu_bool_t
+_write_node(cuex_binwriter_t writer, cuex_t e, size_t *id_out)
+{
+    cuex_meta_t meta;
+    size_t *slot;
+    FILE *out = writer->out;
+
+    slot = cucon_pmap_find_mem(&writer->node_index, e);
+    if (slot) {
+	*id_out = *slot;
+	return cu_true;
+    }
+
+    meta = cuex_meta(e);
+    if (cuex_meta_is_opr(meta)) {
+	cu_rank_t i, r = cuex_opr_r(meta);
+	size_t *sub_id_arr = cu_salloc(r*sizeof(size_t));
+	uintmax_t opr_index;
+	for (i = 0; i < r; ++i)
+	    if (!_write_node(writer, cuex_opn_at(e, i), &sub_id_arr[i]))
+		return cu_false;
+	if (!_write_opr(writer, meta, &opr_index))
+	    return cu_false;
+	if (!custo_fwrite_uintmax(TAG_OPN_BASE + opr_index, out))
+	    return cu_false;
+	for (i = 0; i < r; ++i)
+	    if (!custo_fwrite_uintmax(writer->node_cnt - sub_id_arr[i], out))
+		return cu_false;
+    }
+    else if (cuex_is_idr(e)) {
+	char const *name = cu_idr_to_cstr(cuex_idr_from_ex(e));
+	if (!custo_fwrite_uintmax(TAG_IDR, out)
+		|| !_write_bytes(name, strlen(name), out))
+	    return cu_false;
+    }
+    else if (cuex_is_varmeta(meta) && cuexP_varmeta_wsize(meta) == 0) {
+	if (cuex_is_varmeta_k(meta, cuex_varkind_svar)) {
+	    if (!custo_fwrite_uintmax(TAG_SVAR, out)
+		    || !custo_fwrite_uintmax(cuex_varmeta_qcode(meta), out))
+		return cu_false;
+	}
+	else if (cuex_is_varmeta_k(meta, cuex_varkind_ivar)
+		 || cuex_is_varmeta_k(meta, cuex_varkind_rvar)) {
+	    cuex_varkind_t kind = cuex_is_varmeta_k(meta, cuex_varkind_ivar)
+				? cuex_varkind_ivar : cuex_varkind_rvar;
+	    if (!custo_fwrite_uintmax(TAG_HVAR, out)
+		    || !custo_fwrite_uintmax(kind, out)
+		    || !custo_fwrite_uintmax(cuex_varmeta_qcode(meta), out)
+		    || !custo_fwrite_uintmax(cuex_varmeta_index(meta), out))
+		return cu_false;
+	}
+	else
+	    return cu_false;
+    }
+    else
+	return cu_false;
+
+    cucon_pmap_insert_mem(&writer->node_index, e, sizeof(size_t), &slot);
+    *id_out = *slot = writer->node_cnt++;
+    return cu_true;
+}
+
+cu_bool_t
+cuex_binwriter_init(cuex_binwriter_t writer, FILE *out)
+{
+    writer->out = out;
+    cucon_pmap_init(&writer->node_index);
+    cucon_umap_init(&writer->opr_index);
+    writer->node_cnt = 0;
+    writer->opr_cnt = 0;
+    return fwrite(_magic, sizeof(_magic), 1, out) == 1
+	&& custo_fwrite_uintmax(VERSION, out);
+}
+
+cuex_binwriter_t
+cuex_binwriter_new(FILE *out)
+{
+    cuex_binwriter_t writer = cu_gnew(struct cuex_binwriter);
+    if (!cuex_binwriter_init(writer, out))
+	return NULL;
+    return writer;
+}
+
+cu_bool_t
+cuex_binwriter_put(cuex_binwriter_t writer, cuex_t e)
+{
+    size_t id;
+    return _write_node(writer, e, &id)
+	&& custo_fwrite_uintmax(TAG_ROOT, writer->out)
+	&& custo_fwrite_uintmax(writer->node_cnt - id, writer->out);
+}
+
+
+/* == Reader == */
+
+cu_clos_def(_find_opr_by_name,
+	    cu_prot(cu_bool_t, cuex_oprinfo_t oi),
+    ( char const *name;
+      cu_rank_t r;
+      cuex_meta_t opr; ))
+{
+    cu_clos_self(_find_opr_by_name);
+    cuex_meta_t opr = cuex_oprinfo_opr(oi);
+    if (cuex_opr_r(opr) == self->r
+	    && strcmp(cuex_oprinfo_name(oi), self->name) == 0) {
+	self->opr = opr;
+	return cu_false;
+    }
+    return cu_true;
+}
+
+/* Reads the body of an OPR record.  If the operator has a name, it is resolved
+ * against the operators registered in this process, so that the stream does
+ * not depend on the operator numbering as long as names are unique. */
+static cu_bool_t
+_read_opr(cuex_binreader_t reader)
+{
+    FILE *in = reader->in;
+    uintmax_t index, r, flags, name_size;
+    cuex_meta_t opr;
+    cuex_oprinfo_t oi;
+    char *name;
+
+    if (!custo_fread_uintmax(&index, in) || !custo_fread_uintmax(&r, in)
+	    || !custo_fread_uintmax(&flags, in)
+	    || !custo_fread_uintmax(&name_size, in))
+	return cu_false;
+    if (r > CUEX_OPR_ARITY_MASK >> CUEX_OPR_ARITY_SHIFT
+	    || index > CUEX_OPR_SELECT_MASK >> CUEX_OPR_SELECT_SHIFT
+	    || flags > CUEX_OPR_FLAGS_MASK >> CUEX_OPR_FLAGS_SHIFT)
+	return cu_false;
+    opr = cuex_opr(index, r) | (flags << CUEX_OPR_FLAGS_SHIFT);
+    if (name_size > 0) {
+	name = cu_galloc_atomic(name_size + 1);
+	if (fread(name, name_size, 1, in) != 1)
+	    return cu_false;
+	name[name_size] = 0;
+	oi = cuex_oprinfo(opr);
+	if (!oi || strcmp(cuex_oprinfo_name(oi), name) != 0) {
+	    _find_opr_by_name_t cb;
+	    cb.name = name;
+	    cb.r = r;
+	    if (cuex_oprinfo_conj(_find_opr_by_name_prep(&cb)))
+		return cu_false;
+	    opr = cb.opr;
+	}
+    }
+    *(cuex_meta_t *)cucon_array_extend_gp(&reader->opr_arr,
+					  sizeof(cuex_meta_t)) = opr;
+    ++reader->opr_cnt;
+    return cu_true;
+}
+
+static cu_bool_t
+_read_ref(cuex_binreader_t reader, cuex_t *e_out)
+{
+    uintmax_t dist;
+    if (!custo_fread_uintmax(&dist, reader->in)
+	    || dist == 0 || dist > reader->node_cnt)
+	return cu_false;
+    *e_out = ((cuex_t *)cucon_array_begin(&reader->node_arr))
+	     [reader->node_cnt - dist];
+    return cu_true;
+}
+
+static cuex_t
+_read_idr(FILE *in)
+{
+    char buf[256];
+    uintmax_t size;
+    char *arr;
+    if (!custo_fread_uintmax(&size, in))
+	return NULL;
+    arr = size <= sizeof(buf)? buf : cu_galloc_atomic(size);
+    if (size > 0 && fread(arr, size, 1, in) != 1)
+	return NULL;
+    return cu_idr_by_charr(arr, size);
+}
+
+/* Kept out of cuex_binreader_get, since the stack allocation must be released
+ * before the next record is read. */
+static cuex_t
+_read_opn(cuex_binreader_t reader, cuex_meta_t opr)
+{
+    cu_rank_t i, r = cuex_opr_r(opr);
+    cuex_t *sub_arr = cu_salloc(r*sizeof(cuex_t));
+    for (i = 0; i < r; ++i)
+	if (!_read_ref(reader, &sub_arr[i]))
+	    return NULL;
+    return cuex_opn_by_arr(opr, sub_arr);
+}
+
+cu_bool_t
+cuex_binreader_init(cuex_binreader_t reader, FILE *in)
+{
+    char magic[sizeof(_magic)];
+    uintmax_t version;
+    reader->in = in;
+    cucon_array_init(&reader->node_arr, cu_false, 0);
+    cucon_array_init(&reader->opr_arr, cu_true, 0);
+    reader->node_cnt = 0;
+    reader->opr_cnt = 0;
+    return fread(magic, sizeof(magic), 1, in) == 1
+	&& memcmp(magic, _magic, sizeof(magic)) == 0
+	&& custo_fread_uintmax(&version, in)
+	&& version == VERSION;
+}
+
+cuex_binreader_t
+cuex_binreader_new(FILE *in)
+{
+    cuex_binreader_t reader = cu_gnew(struct cuex_binreader);
+    if (!cuex_binreader_init(reader, in))
+	return NULL;
+    return reader;
+}
+
+cuex_t
+cuex_binreader_get(cuex_binreader_t reader)
+{
+    FILE *in = reader->in;
+    for (;;) {
+	uintmax_t tag, x, y, z;
+	cuex_meta_t *opr_arr;
+	cuex_t e;
+	if (!custo_fread_uintmax(&tag, in))
+	    return NULL;
+	switch (tag) {
+	    case TAG_ROOT:
+		if (!_read_ref(reader, &e))
+		    return NULL;
+		return e;
+	    case TAG_OPR:
+		if (!_read_opr(reader))
+		    return NULL;
+		continue;
+	    case TAG_IDR:
+		e = _read_idr(in);
+		if (!e)
+		    return NULL;
+		break;
+	    case TAG_SVAR:
+		if (!custo_fread_uintmax(&x, in) || x > cuex_qcode_n)
+		    return NULL;
+		e = cuex_var_new((cuex_qcode_t)x);
+		break;
+	    case TAG_HVAR:
+		if (!custo_fread_uintmax(&x, in)
+			|| !custo_fread_uintmax(&y, in)
+			|| !custo_fread_uintmax(&z, in))
+		    return NULL;
+		if ((x != cuex_varkind_ivar && x != cuex_varkind_rvar)
+			|| y > cuex_qcode_n
+			|| z > CUEXP_VARMETA_INDEX_MASK
+			       >> CUEXP_VARMETA_INDEX_SHIFT)
+		    return NULL;
+		e = cuexP_halloc(cuex_varmeta_kqi((cuex_meta_t)x,
+						  (cuex_meta_t)y,
+						  (cuex_meta_t)z), 0, NULL);
+		break;
+	    default:
+		if (tag - TAG_OPN_BASE >= reader->opr_cnt)
+		    return NULL;
+		opr_arr = cucon_array_begin(&reader->opr_arr);
+		e = _read_opn(reader, opr_arr[tag - TAG_OPN_BASE]);
+		if (!e)
+		    return NULL;
+		break;
+	}
+	*(cuex_t *)cucon_array_extend_gp(&reader->node_arr, sizeof(cuex_t))
+	    = e;
+	++reader->node_cnt;
+    }
+}
+
+cu_bool_t
+cuex_fwrite_binary(cuex_t e, FILE *out)
+{
+    struct cuex_binwriter writer;
+    return cuex_binwriter_init(&writer, out)
+	&& cuex_binwriter_put(&writer, e);
+}
+
+cuex_t
+cuex_fread_binary(FILE *in)
+{
+    struct cuex_binreader reader;
+    if (!cuex_binreader_init(&reader, in))
+	return NULL;
+    return cuex_binreader_get(&reader);
+}
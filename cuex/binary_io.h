@@ -0,0 +1,104 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CUEX_BINARY_IO_H
+#define CUEX_BINARY_IO_H
+
+#include <cuex/fwd.h>
+#include <cucon/pmap.h>
+#include <cucon/umap.h>
+#include <cucon/array.h>
+#include <stdio.h>
+
+CU_BEGIN_DECLARATIONS
+/** \defgroup cuex_binary_io_h cuex/binary_io.h: Binary Serialisation
+ ** @{ \ingroup cuex_mod
+ **
+ ** A compact binary format for expression DAGs, built on the integer encoding
+ ** of libcusto.  Each distinct subexpression is written once in
+ ** post-order and later occurrences are written as back-references, so
+ ** hash-consed sharing is preserved both in the stream and in the
+ ** reconstructed expressions.  Operators are written to an operator table on
+ ** first use, along with their names from \ref cuex_oprinfo when available,
+ ** and identifiers are written as strings on first use.  The reader rebuilds
+ ** the expressions bottom-up through the hash-consing allocator in a single
+ ** pass over the stream.
+ **
+ ** Supported are operations, identifiers (\ref cu_idr_h "cu_idr_t"),
+ ** variables created by \ref cuex_var_new, which are recreated as fresh
+ ** variables with the same quantisation, and hash-consed variables without
+ ** slots, such as \ref cuex_ivar and \ref cuex_rvar.  Writing other objects
+ ** fails. */
+
+/** Writer state.  Expressions written to the same writer share
+ ** back-references, and the writer keeps them alive until it is dropped. */
+struct cuex_binwriter
+{
+    FILE *out;
+    struct cucon_pmap node_index;
+    struct cucon_umap opr_index;
+    size_t node_cnt;
+    size_t opr_cnt;
+};
+
+/** Reader state corresponding to \ref cuex_binwriter. */
+struct cuex_binreader
+{
+    FILE *in;
+    struct cucon_array node_arr;
+    struct cucon_array opr_arr;
+    size_t node_cnt;
+    size_t opr_cnt;
+};
+
+/** Initialises \a writer to write to \a out, and writes the file header.
+ ** Returns false on I/O error. */
+cu_bool_t cuex_binwriter_init(cuex_binwriter_t writer, FILE *out);
+
+/** Returns a new writer to \a out after writing the file header, or \c NULL
+ ** on I/O error. */
+cuex_binwriter_t cuex_binwriter_new(FILE *out);
+
+/** Writes \a e as the next root expression of the stream.  Subexpressions
+ ** already written by \a writer are referred to instead of written again.
+ ** Returns false on I/O error or if \a e contains objects which can not be
+ ** serialised. */
+cu_bool_t cuex_binwriter_put(cuex_binwriter_t writer, cuex_t e);
+
+/** Initialises \a reader to read from \a in and checks the file header.
+ ** Returns false if the header is missing or of an unsupported version. */
+cu_bool_t cuex_binreader_init(cuex_binreader_t reader, FILE *in);
+
+/** Returns a new reader from \a in, or \c NULL if the file header is missing
+ ** or of an unsupported version. */
+cuex_binreader_t cuex_binreader_new(FILE *in);
+
+/** Reads the next root expression written by \ref cuex_binwriter_put.
+ ** Returns \c NULL at the end of the stream or if the stream is malformed. */
+cuex_t cuex_binreader_get(cuex_binreader_t reader);
+
+/** Writes a stream containing the single root \a e to \a out.  Returns false
+ ** on failure, see \ref cuex_binwriter_put. */
+cu_bool_t cuex_fwrite_binary(cuex_t e, FILE *out);
+
+/** Reads the first root of the stream \a in, or returns \c NULL on failure. */
+cuex_t cuex_fread_binary(FILE *in);
+
+/** @} */
+CU_END_DECLARATIONS
+
+#endif
@@ -0,0 +1,175 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Compares loading an expression from the binary format with parsing the
+ * same expression from a plain S-expression text.  The tree has no text
+ * parser of its own, so a minimal one is included here as the baseline. */
+
+#include <cuex/binary_io.h>
+#include <cuex/opn.h>
+#include <cu/idr.h>
+#include <cu/memory.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#define IDR_CNT 1024
+#define POOL_CNT 256
+#define REPEAT 8
+
+static cu_idr_t idr_arr[IDR_CNT];
+static cuex_t pool_arr[POOL_CNT];
+
+/* A random term of the given depth.  When share_freq is non-zero, a fraction
+ * 1/share_freq of the subterms are picked from a pool of earlier subterms, so
+ * that the result is a DAG with moderate sharing. */
+static cuex_t
+_make_term(int depth, int share_freq)
+{
+    cuex_t sub_arr[3];
+    cuex_t e;
+    int i, r;
+    if (depth <= 0)
+	return idr_arr[lrand48() % IDR_CNT];
+    if (share_freq && lrand48() % share_freq == 0 && depth < 6)
+	return pool_arr[lrand48() % POOL_CNT];
+    r = lrand48() % 3 + 1;
+    for (i = 0; i < r; ++i)
+	sub_arr[i] = _make_term(depth - 1 - lrand48() % 2, share_freq);
+    e = cuex_opn_by_arr(cuex_opr(lrand48() % 8 + 1, r), sub_arr);
+    if (depth < 6)
+	pool_arr[lrand48() % POOL_CNT] = e;
+    return e;
+}
+
+static void
+_write_text(cuex_t e, FILE *out)
+{
+    cuex_meta_t meta = cuex_meta(e);
+    if (cuex_meta_is_opr(meta)) {
+	cu_rank_t i, r = cuex_opr_r(meta);
+	fprintf(out, "(f%d", (int)cuex_opr_index(meta));
+	for (i = 0; i < r; ++i) {
+	    fputc(' ', out);
+	    _write_text(cuex_opn_at(e, i), out);
+	}
+	fputc(')', out);
+    }
+    else
+	fputs(cu_idr_to_cstr(e), out);
+}
+
+static cuex_t
+_parse_text(char const **s_ref)
+{
+    char const *s = *s_ref;
+    cuex_t e;
+    if (*s == '(') {
+	cuex_t sub_arr[3];
+	int index, r = 0;
+	index = strtol(s + 2, (char **)&s, 10);
+	while (*s == ' ') {
+	    ++s;
+	    sub_arr[r++] = _parse_text(&s);
+	}
+	if (*s++ != ')')
+	    return NULL;
+	e = cuex_opn_by_arr(cuex_opr(index, r), sub_arr);
+    }
+    else {
+	char const *s0 = s;
+	while (isalnum((unsigned char)*s))
+	    ++s;
+	e = cu_idr_by_charr(s0, s - s0);
+    }
+    *s_ref = s;
+    return e;
+}
+
+static cuex_t
+_load_text(FILE *in)
+{
+    char *buf, *s;
+    long size;
+    cuex_t e;
+    fseek(in, 0, SEEK_END);
+    size = ftell(in);
+    rewind(in);
+    buf = cu_galloc_atomic(size + 1);
+    if (fread(buf, 1, size, in) != size)
+	return NULL;
+    buf[size] = 0;
+    s = buf;
+    e = _parse_text((char const **)&s);
+    cu_gfree_atomic(buf);
+    return e;
+}
+
+static void
+_bench(char const *name, int depth, int share_freq)
+{
+    FILE *bin_file = tmpfile();
+    FILE *text_file = tmpfile();
+    cuex_t e = _make_term(depth, share_freq);
+    clock_t t_bin, t_text;
+    int i;
+
+    cuex_fwrite_binary(e, bin_file);
+    _write_text(e, text_file);
+    fflush(text_file);
+
+    t_bin = -clock();
+    for (i = 0; i < REPEAT; ++i) {
+	rewind(bin_file);
+	if (cuex_fread_binary(bin_file) != e)
+	    fprintf(stderr, "Binary load failed.\n");
+    }
+    t_bin += clock();
+
+    t_text = -clock();
+    for (i = 0; i < REPEAT; ++i)
+	if (_load_text(text_file) != e)
+	    fprintf(stderr, "Text load failed.\n");
+    t_text += clock();
+
+    printf("%s\n", name);
+    printf("    binary: %9ld bytes, %8.3lf s/load\n", ftell(bin_file),
+	   t_bin/((double)CLOCKS_PER_SEC*REPEAT));
+    printf("    text:   %9ld bytes, %8.3lf s/load\n", ftell(text_file),
+	   t_text/((double)CLOCKS_PER_SEC*REPEAT));
+    fclose(bin_file);
+    fclose(text_file);
+}
+
+int
+main()
+{
+    int i;
+    cuex_init();
+    for (i = 0; i < IDR_CNT; ++i) {
+	char name[16];
+	sprintf(name, "x%d", i);
+	idr_arr[i] = cu_idr_by_cstr(name);
+    }
+    for (i = 0; i < POOL_CNT; ++i)
+	pool_arr[i] = idr_arr[i];
+    _bench("Tree", 26, 0);
+    _bench("DAG", 28, 8);
+    return 0;
+}
@@ -0,0 +1,163 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cuex/binary_io.h>
+#include <cuex/ex.h>
+#include <cuex/opn.h>
+#include <cuex/var.h>
+#include <cucon/pmap.h>
+#include <cu/idr.h>
+#include <cu/test.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#define LEAF_CNT 64
+#define NODE_CNT 4000
+#define ROOT_CNT 8
+
+static cuex_t leaf_arr[LEAF_CNT];
+
+/* A DAG with heavy sharing, built by combining random earlier nodes. */
+static void
+_make_dag(cuex_t *node_arr, size_t node_cnt)
+{
+    size_t i;
+    for (i = 0; i < LEAF_CNT; ++i) {
+	char name[16];
+	switch (i % 4) {
+	    case 0:
+		sprintf(name, "x%d", (int)i);
+		leaf_arr[i] = cu_idr_by_cstr(name);
+		break;
+	    case 1:
+		leaf_arr[i] = cuex_var_new(i % 8 == 1? cuex_qcode_e
+						     : cuex_qcode_u);
+		break;
+	    case 2:
+		leaf_arr[i] = cuex_ivar_n(i);
+		break;
+	    case 3:
+		leaf_arr[i] = cuex_opn(cuex_opr(i, 0));
+		break;
+	}
+	node_arr[i] = leaf_arr[i];
+    }
+    for (; i < node_cnt; ++i) {
+	cuex_t sub_arr[3];
+	int j, r = lrand48() % 4;
+	/* Prefer recent nodes, so that the DAG gets deep and shared. */
+	for (j = 0; j < r; ++j)
+	    sub_arr[j] = node_arr[i - 1 - lrand48() % (i < 32? i : 32)];
+	node_arr[i] = cuex_opn_by_arr(cuex_opr(lrand48() % 5 + 1, r),
+				      sub_arr);
+    }
+}
+
+/* True iff e0 and e1 are equal up to a renaming of the cuex_var_new
+ * variables.  The correspondence of visited nodes is accumulated in
+ * node_map, which also ensures that shared nodes are only compared once. */
+static cu_bool_t
+_eq_mod_vars(cuex_t e0, cuex_t e1, cucon_pmap_t node_map)
+{
+    cuex_meta_t meta = cuex_meta(e0);
+    if (!cucon_pmap_insert_ptr(node_map, e0, e1))
+	return cucon_pmap_find_ptr(node_map, e0) == e1;
+    if (meta != cuex_meta(e1))
+	return cu_false;
+    if (cuex_meta_is_opr(meta)) {
+	cu_rank_t i;
+	for (i = 0; i < cuex_opr_r(meta); ++i)
+	    if (!_eq_mod_vars(cuex_opn_at(e0, i), cuex_opn_at(e1, i),
+			      node_map))
+		return cu_false;
+	return cu_true;
+    }
+    if (cuex_is_varmeta(meta) && cuex_is_varmeta_k(meta, cuex_varkind_svar))
+	return cu_true;
+    return e0 == e1;
+}
+
+static void
+_test_roundtrip(void)
+{
+    static cuex_t node_arr[NODE_CNT];
+    cuex_t root_arr[ROOT_CNT];
+    struct cuex_binwriter writer;
+    struct cuex_binreader reader;
+    struct cucon_pmap node_map;
+    FILE *file = tmpfile();
+    long size_one, size_sep, size_all;
+    int k;
+
+    _make_dag(node_arr, NODE_CNT);
+    for (k = 0; k < ROOT_CNT; ++k)
+	root_arr[k] = node_arr[NODE_CNT - 1 - k*7];
+
+    /* Each root on its own, then all roots in the same stream, where the
+     * later roots mostly refer back to nodes written for the first one. */
+    size_one = size_sep = 0;
+    for (k = 0; k < ROOT_CNT; ++k) {
+	rewind(file);
+	cu_test_assert(cuex_fwrite_binary(root_arr[k], file));
+	size_sep += ftell(file);
+	if (k == 0)
+	    size_one = ftell(file);
+    }
+    rewind(file);
+    cu_test_assert(cuex_binwriter_init(&writer, file));
+    for (k = 0; k < ROOT_CNT; ++k)
+	cu_test_assert(cuex_binwriter_put(&writer, root_arr[k]));
+    size_all = ftell(file);
+    cu_test_assert(size_all < size_sep*3/4);
+
+    rewind(file);
+    cu_test_assert(cuex_binreader_init(&reader, file));
+    cucon_pmap_init(&node_map);
+    for (k = 0; k < ROOT_CNT; ++k) {
+	cuex_t e = cuex_binreader_get(&reader);
+	cu_test_assert(e != NULL);
+	cu_test_assert(_eq_mod_vars(root_arr[k], e, &node_map));
+    }
+    cu_test_assert(cuex_binreader_get(&reader) == NULL);
+
+    /* A truncated stream must be rejected without crashing. */
+    rewind(file);
+    cu_test_assert(ftruncate(fileno(file), size_one/2) == 0);
+    cu_test_assert(cuex_fread_binary(file) == NULL);
+    fclose(file);
+}
+
+static void
+_test_var_free(void)
+{
+    FILE *file = tmpfile();
+    cuex_t x = cu_idr_by_cstr("x");
+    cuex_t e = cuex_opn(cuex_opr(1, 2), x, cuex_opn(cuex_opr(2, 1), x));
+    cu_test_assert(cuex_fwrite_binary(e, file));
+    rewind(file);
+    cu_test_assert(cuex_fread_binary(file) == e);
+    fclose(file);
+}
+
+int
+main()
+{
+    cuex_init();
+    _test_var_free();
+    _test_roundtrip();
+    return 2*!!cu_test_bug_count();
+}
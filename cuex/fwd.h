@@ -24,6 +24,8 @@ CU_BEGIN_DECLARATIONS
 /** \defgroup cuex_fwd_h cuex/fwd.h: Forward Declarations
  ** @{ \ingroup cuex_mod */
 
+typedef struct cuex_binreader	*cuex_binreader_t;	/* binary_io.h */
+typedef struct cuex_binwriter	*cuex_binwriter_t;	/* binary_io.h */
 typedef struct cuex_fpvar	*cuex_fpvar_t;		/* fpvar.h */
 typedef struct cuex_gvar	*cuex_gvar_t;		/* gvar.h */
 typedef struct cuex_occurtree	*cuex_occurtree_t;	/* occurtree.h */
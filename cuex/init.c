@@ -18,6 +18,7 @@
 #include <cuex/fwd.h>
 #include <cufo/fwd.h>
 #include <cugra/fwd.h>
+#include <cuflow/fwd.h>
 #include <cuex/tpvar.h>
 
 void cudynP_init(void);
@@ -45,6 +46,7 @@ cuex_init()
 
     cufo_init();
     cugra_init();
+    cuflow_init();
     cuexP_ex_init();
     cuex_oprdefs_init();
     cuexP_var_init();
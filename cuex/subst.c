@@ -26,6 +26,8 @@
 #include <cuex/tvar.h>
 #include <cufo/stream.h>
 #include <cufo/tagdefs.h>
+#include <cu/region.h>
+#include <string.h>
 
 
 /* Expensive debugging */
@@ -133,6 +135,14 @@ cuex_subst_new(cuex_qcset_t qcset)
     return subst;
 }
 
+void
+cuex_subst_init_region(cuex_subst_t subst, cuex_qcset_t qcset,
+		       cu_region_t region)
+{
+    cuexP_subst_init(subst, NULL, qcset, cu_true);
+    cucon_pmap_init_region(&subst->var_to_veqv, region);
+}
+
 void
 cuex_subst_init_nonidem(cuex_subst_t subst, cuex_qcset_t qcset)
 {
@@ -683,6 +693,69 @@ cuex_subst_apply(cuex_subst_t subst, cuex_t ex)
 	return ex;
 }
 
+/* Same as cuexP_subst_apply, but records the result for each operation in
+ * memo, so that shared subterms are only visited once. */
+static cuex_t
+_subst_apply_memo(cuex_subst_t subst, cuex_t ex, cucon_pmap_t memo)
+{
+    cuex_meta_t meta;
+tailcall:
+    while (cuex_is_varmeta(meta = cuex_meta(ex))) {
+	cuex_veqv_t vq;
+	vq = cuex_subst_cref(subst, cuex_var_from_ex(ex));
+	if (vq) {
+	    if (vq->value) {
+		if (cuex_meta(vq->value) == CUEX_O1_SUBST_BLOCK)
+		    return ex;
+		ex = vq->value;
+		goto tailcall;
+	    }
+	    else
+		return cucon_slink_get_ptr(vq->var_link);
+	}
+	return ex;
+    }
+    if (cuex_meta_is_opr(meta) && cuex_opr_r(meta) > 0) {
+	cuex_t *slot;
+	if (!cucon_pmap_insert_mem(memo, ex, sizeof(cuex_t), &slot))
+	    return *slot;
+	CUEX_OPN_TRAN(meta, ex, subex, _subst_apply_memo(subst, subex, memo));
+	*slot = ex;
+    }
+    return ex;
+}
+
+cuex_t
+cuex_subst_apply_memo(cuex_subst_t subst, cuex_t ex)
+{
+    cuex_subst_apply_many(subst, 1, &ex, &ex);
+    return ex;
+}
+
+void
+cuex_subst_apply_many(cuex_subst_t subst, size_t count,
+		      cuex_t const *ex_arr, cuex_t *res_arr)
+{
+    cu_region_t region;
+    struct cu_region_mark mark;
+    struct cucon_pmap memo;
+    size_t i;
+
+    if (!subst) {
+	if (res_arr != ex_arr)
+	    memmove(res_arr, ex_arr, count*sizeof(cuex_t));
+	return;
+    }
+    if (!subst->is_idem)
+	cu_bugf("Apply is undefined for non-idempotent substitution.");
+    region = cu_tregion();
+    cu_region_push(region, &mark);
+    cucon_pmap_init_region(&memo, region);
+    for (i = 0; i < count; ++i)
+	res_arr[i] = _subst_apply_memo(subst, ex_arr[i], &memo);
+    cu_region_pop(region, &mark);
+}
+
 
 /* -- cuex_subst_update_tvar_types */
 
@@ -105,6 +105,12 @@ void cuex_subst_init(cuex_subst_t subst, cuex_qcset_t qcset);
 
 void cuex_subst_init_nonidem(cuex_subst_t subst, cuex_qcset_t qcset);
 
+/*!Construct \a subst as with \ref cuex_subst_init, except that the variable
+ * map is allocated from \a region.  \a subst must not be used after the
+ * memory is released from \a region, and can not be cloned. */
+void cuex_subst_init_region(cuex_subst_t subst, cuex_qcset_t qcset,
+			    cu_region_t region);
+
 CU_SINLINE void cuex_subst_init_uw(cuex_subst_t subst)
 { cuex_subst_init(subst, cuex_qcset_uw); }
 CU_SINLINE void cuex_subst_init_e(cuex_subst_t subst)
@@ -202,6 +208,19 @@ cuex_t cuex_subst_lookup(cuex_subst_t subst, cuex_var_t var);
  * \pre \a subst is idempotent. */
 cuex_t cuex_subst_apply(cuex_subst_t subst, cuex_t ex);
 
+/*!Same as \ref cuex_subst_apply, but visits each shared subterm of \a ex
+ * only once, using a scratch table keyed on node identity.  Prefer this for
+ * large expressions with much sharing.
+ * \pre \a subst is idempotent. */
+cuex_t cuex_subst_apply_memo(cuex_subst_t subst, cuex_t ex);
+
+/*!Stores the application of \a subst to \a ex_arr[i] in \a res_arr[i] for
+ * each \a i less than \a count.  Subterms shared within and across the
+ * expressions are only visited once.  \a res_arr may equal \a ex_arr.
+ * \pre \a subst is idempotent. */
+void cuex_subst_apply_many(cuex_subst_t subst, size_t count,
+			   cuex_t const *ex_arr, cuex_t *res_arr);
+
 /*!Update each <tt>cuex_tvar_t</tt> type in \a ex to the result of applying
  * \a subst to it. */
 void cuex_subst_update_tvar_types(cuex_subst_t subst, cuex_t ex);
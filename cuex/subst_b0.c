@@ -0,0 +1,152 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cuex/subst.h>
+#include <cuex/algo.h>
+#include <cuex/oprdefs.h>
+#include <cuex/opn.h>
+#include <cuex/var.h>
+#include <cucon/pmap.h>
+#include <cu/idr.h>
+#include <cu/test.h>
+#include <stdio.h>
+#include <time.h>
+
+#define VAR_CNT 16
+#define BATCH_SIZE 64
+
+static cuex_t var_arr[VAR_CNT];
+
+static double
+_seconds(clock_t t)
+{
+    return t/(double)CLOCKS_PER_SEC;
+}
+
+/* An expression with 2^depth paths but only O(depth) distinct nodes. */
+static cuex_t
+_shared_ex(int depth)
+{
+    cuex_t e = var_arr[0];
+    int i;
+    for (i = 1; i <= depth; ++i)
+	e = cuex_o2_apply(e, cuex_o2_gprod(var_arr[i % VAR_CNT], e));
+    return e;
+}
+
+/* A batch of expressions which share random subterms of a common pool. */
+static void
+_shared_batch(int pool_size, cuex_t *ex_arr)
+{
+    cuex_t *pool = cu_galloc(pool_size*sizeof(cuex_t));
+    int i;
+    for (i = 0; i < VAR_CNT; ++i)
+	pool[i] = var_arr[i];
+    for (; i < pool_size; ++i)
+	pool[i] = cuex_o2_apply(pool[lrand48() % i], pool[lrand48() % i]);
+    for (i = 0; i < BATCH_SIZE; ++i)
+	ex_arr[i] = pool[pool_size - 1 - lrand48() % (pool_size/4)];
+}
+
+static void
+bench_depth(cuex_subst_t subst, cucon_pmap_t pmap, int depth)
+{
+    cuex_t e = _shared_ex(depth);
+    cuex_t r_plain, r_memo;
+    clock_t t_plain, t_memo, t_pmap_plain, t_pmap_memo;
+
+    t_plain = -clock();
+    r_plain = cuex_subst_apply(subst, e);
+    t_plain += clock();
+    t_memo = -clock();
+    r_memo = cuex_subst_apply_memo(subst, e);
+    t_memo += clock();
+    cu_test_assert_ptr_eq(r_plain, r_memo);
+
+    t_pmap_plain = -clock();
+    r_plain = cuex_substitute_pmap(e, pmap);
+    t_pmap_plain += clock();
+    t_pmap_memo = -clock();
+    r_memo = cuex_substitute_pmap_memo(e, pmap);
+    t_pmap_memo += clock();
+    cu_test_assert_ptr_eq(r_plain, r_memo);
+
+    printf("%5d %10.3lg %10.3lg %10.3lg %10.3lg\n", depth,
+	   _seconds(t_plain), _seconds(t_memo),
+	   _seconds(t_pmap_plain), _seconds(t_pmap_memo));
+}
+
+static void
+bench_batch(cuex_subst_t subst, int pool_size)
+{
+    cuex_t ex_arr[BATCH_SIZE], res_arr[BATCH_SIZE];
+    clock_t t_single, t_many;
+    int i;
+
+    _shared_batch(pool_size, ex_arr);
+    t_single = -clock();
+    for (i = 0; i < BATCH_SIZE; ++i)
+	res_arr[i] = cuex_subst_apply_memo(subst, ex_arr[i]);
+    t_single += clock();
+    t_many = -clock();
+    cuex_subst_apply_many(subst, BATCH_SIZE, ex_arr, ex_arr);
+    t_many += clock();
+    for (i = 0; i < BATCH_SIZE; ++i)
+	cu_test_assert_ptr_eq(ex_arr[i], res_arr[i]);
+    printf("%9d %10.3lg %10.3lg\n", pool_size,
+	   _seconds(t_single), _seconds(t_many));
+}
+
+int
+main()
+{
+    cuex_subst_t subst;
+    struct cucon_pmap pmap;
+    clock_t t_tot = -clock();
+    int i;
+
+    cuex_init();
+    for (i = 0; i < VAR_CNT; ++i)
+	var_arr[i] = cuex_var_new_u();
+
+    /* Bind every other variable to a small term. */
+    subst = cuex_subst_new_uw();
+    cucon_pmap_init(&pmap);
+    for (i = 0; i < VAR_CNT; i += 2) {
+	char name[8];
+	cuex_t value;
+	sprintf(name, "c%d", i);
+	value = cuex_o2_apply(cu_idr_by_cstr(name), var_arr[i + 1]);
+	if (!cuex_subst_unify(subst, var_arr[i], value))
+	    cu_bugf("Unexpected unification failure.");
+	cucon_pmap_insert_ptr(&pmap, var_arr[i], value);
+    }
+
+    printf("# Applying to a term with 2^depth paths.\n"
+	   "# depth      apply       memo      pmap   pmap memo\n");
+    for (i = 4; i <= 22; i += 2)
+	bench_depth(subst, &pmap, i);
+
+    printf("\n# Applying to %d terms drawn from a shared pool.\n"
+	   "# pool size  one-by-one    many\n", BATCH_SIZE);
+    for (i = 1000; i <= 64000; i *= 4)
+	bench_batch(subst, i);
+
+    t_tot += clock();
+    fprintf(stderr, "Total time: %lg\n", _seconds(t_tot));
+    return 2*!!cu_test_bug_count();
+}
@@ -35,6 +35,33 @@ unify(cuex_subst_t subst, cuex_t ex0, cuex_t ex1, cu_bool_t expect)
     }
 }
 
+/* Check cuex_subst_apply_memo and cuex_subst_apply_many against
+ * cuex_subst_apply on an expression where each level is shared twice. */
+static void
+test_apply_memo(cuex_t *v, cuex_t *c)
+{
+    cuex_subst_t sig = cuex_subst_new_uw();
+    cuex_t e[17], r[17];
+    int i;
+    e[0] = v[6];
+    for (i = 1; i < 17; ++i)
+	e[i] = cuex_o2_apply(e[i - 1],
+			     cuex_o2_gprod(e[i - 1], i % 3? v[7] : c[1]));
+    unify(sig, v[6], cuex_o2_apply(c[0], v[8]), cu_true);
+    unify(sig, v[7], v[8], cu_true);
+    for (i = 0; i < 17; i += 4)
+	cu_test_assert_ptr_eq(cuex_subst_apply_memo(sig, e[i]),
+			      cuex_subst_apply(sig, e[i]));
+    cuex_subst_apply_many(sig, 17, e, r);
+    for (i = 0; i < 17; ++i)
+	cu_test_assert_ptr_eq(r[i], cuex_subst_apply(sig, e[i]));
+    cuex_subst_apply_many(sig, 17, e, e);
+    for (i = 0; i < 17; ++i)
+	cu_test_assert_ptr_eq(e[i], r[i]);
+    cuex_subst_apply_many(NULL, 17, e, r);
+    cu_test_assert_ptr_eq(r[16], e[16]);
+}
+
 int
 main()
 {
@@ -83,6 +110,8 @@ main()
     unify(sig0, v[2], v[0], cu_true);
     cu_test_assert(cuex_subst_lookup(sig0, cuex_var_from_ex(v[1])) == v[3]);
 
+    test_apply_memo(v, c);
+
 #ifdef CUCONF_HAVE_BUDDY
     /* non-idempotent substitutions */
     sig0 = cuex_subst_new_nonidem(cuex_qcset_uw);
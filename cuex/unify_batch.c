@@ -0,0 +1,156 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cuex/unify_batch.h>
+#include <cuex/subst.h>
+#include <cuex/algo.h>
+#include <cuflow/sched.h>
+#include <cuflow/cdisj.h>
+#include <cuflow/workers.h>
+#include <cu/region.h>
+
+/* The smallest number of problems to schedule as a separate task.  A
+ * unification of small expressions is comparable in cost to scheduling a
+ * closure, so it does not pay to split further. */
+#define MIN_GRAIN 16
+
+/* Solves the index range [begin, end) by bisecting it until it is no longer
+ * than grain, scheduling the lower halves on the worker threads. */
+cu_clos_def(_run_range, cu_prot0(void),
+    ( size_t begin, end, grain;
+      cu_clop(leaf, void, size_t, size_t); ))
+{
+    cu_clos_self(_run_range);
+    _run_range_t sub;
+    AO_t cdisj = 0;
+    size_t mid;
+
+    if (self->end - self->begin <= self->grain) {
+	cu_call(self->leaf, self->begin, self->end);
+	return;
+    }
+    mid = self->begin + (self->end - self->begin)/2;
+    sub.begin = self->begin;
+    sub.end = mid;
+    sub.grain = self->grain;
+    sub.leaf = self->leaf;
+    cuflow_sched_call(_run_range_prep(&sub), &cdisj);
+    self->begin = mid;
+    cu_call0(_run_range_prep(self));
+    cuflow_cdisj_wait_while(&cdisj);
+}
+
+static void
+_run(size_t cnt, cu_clop(leaf, void, size_t, size_t))
+{
+    _run_range_t top;
+    int worker_cnt = cuflow_workers_count();
+    size_t grain;
+
+    if (worker_cnt == 0 || cnt <= MIN_GRAIN) {
+	cu_call(leaf, 0, cnt);
+	return;
+    }
+
+    /* Aim for a few tasks per thread so that uneven problems balance. */
+    grain = cnt/(4*(worker_cnt + 1));
+    if (grain < MIN_GRAIN)
+	grain = MIN_GRAIN;
+    top.begin = 0;
+    top.end = cnt;
+    top.grain = grain;
+    top.leaf = leaf;
+    cu_call0(_run_range_prep(&top));
+}
+
+
+/* -- cuex_subst_unify_batch */
+
+cu_clos_def(_subst_unify_leaf, cu_prot(void, size_t begin, size_t end),
+    ( struct cuex_unify_job *job_arr;
+      cuex_qcset_t scratch_qcset; ))
+{
+    cu_clos_self(_subst_unify_leaf);
+    cu_region_t region = NULL;
+    struct cu_region_mark mark;
+    struct cuex_subst scratch;
+    size_t i;
+
+    for (i = begin; i < end; ++i) {
+	struct cuex_unify_job *job = &self->job_arr[i];
+	cuex_subst_t subst = job->subst;
+	if (subst) {
+	    if (!cuex_subst_unify(subst, job->ex0, job->ex1))
+		job->result = NULL;
+	    else if (subst->is_idem)
+		job->result = cuex_subst_apply(subst, job->ex0);
+	    else
+		job->result = job->ex0;
+	}
+	else {
+	    if (!region) {
+		region = cu_tregion();
+		cu_region_push(region, &mark);
+	    }
+	    cuex_subst_init_region(&scratch, self->scratch_qcset, region);
+	    if (cuex_subst_unify(&scratch, job->ex0, job->ex1))
+		job->result = cuex_subst_apply(&scratch, job->ex0);
+	    else
+		job->result = NULL;
+	    cu_region_pop(region, &mark);
+	}
+    }
+}
+
+void
+cuex_subst_unify_batch(size_t job_cnt, struct cuex_unify_job *job_arr,
+		       cuex_qcset_t scratch_qcset)
+{
+    _subst_unify_leaf_t leaf;
+    leaf.job_arr = job_arr;
+    leaf.scratch_qcset = scratch_qcset;
+    _run(job_cnt, _subst_unify_leaf_prep(&leaf));
+}
+
+
+/* -- cuex_msg_unify_batch */
+
+cu_clos_def(_msg_unify_leaf, cu_prot(void, size_t begin, size_t end),
+    ( cuex_t const *ex0_arr;
+      cuex_t const *ex1_arr;
+      cuex_t *result_arr;
+      cu_clop(unify, cuex_t, cuex_t, cuex_t); ))
+{
+    cu_clos_self(_msg_unify_leaf);
+    size_t i;
+    for (i = begin; i < end; ++i)
+	self->result_arr[i] = cuex_msg_unify(self->ex0_arr[i],
+					     self->ex1_arr[i], self->unify);
+}
+
+void
+cuex_msg_unify_batch(size_t cnt, cuex_t const *ex0_arr,
+		     cuex_t const *ex1_arr, cuex_t *result_arr,
+		     cu_clop(unify, cuex_t, cuex_t, cuex_t))
+{
+    _msg_unify_leaf_t leaf;
+    leaf.ex0_arr = ex0_arr;
+    leaf.ex1_arr = ex1_arr;
+    leaf.result_arr = result_arr;
+    leaf.unify = unify;
+    _run(cnt, _msg_unify_leaf_prep(&leaf));
+}
@@ -0,0 +1,72 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CUEX_UNIFY_BATCH_H
+#define CUEX_UNIFY_BATCH_H
+
+#include <cuex/fwd.h>
+#include <cuex/qcode.h>
+#include <cu/clos.h>
+
+CU_BEGIN_DECLARATIONS
+/** \defgroup cuex_unify_batch_h cuex/unify_batch.h: Parallel Batches of Unifications
+ ** @{ \ingroup cuex_mod
+ **
+ ** These functions solve an array of independent unification problems,
+ ** splitting the array into ranges which are run on the \ref cuflow_workers_h
+ ** "cuflow worker threads".  The calls return when all problems are solved.
+ ** Without spawned workers, the problems are solved in the calling thread.
+ ** Expressions are hash-consed, so results may be shared freely between
+ ** threads. */
+
+/** A problem for \ref cuex_subst_unify_batch. */
+struct cuex_unify_job
+{
+    /** The substitution to extend, or \c NULL to unify in a scratch
+     ** substitution which is discarded after computing \e result.  Two jobs
+     ** of the same batch must not share a substitution. */
+    cuex_subst_t subst;
+
+    /** The expressions to unify. */
+    cuex_t ex0, ex1;
+
+    /** Set to \c NULL if unification fails, otherwise to the application of
+     ** the substitution to \e ex0 if it is idempotent, else to \e ex0. */
+    cuex_t result;
+};
+
+/** Runs \ref cuex_subst_unify on each of the \a job_cnt elements of \a
+ ** job_arr and stores the results in the \e result fields.  Jobs without a
+ ** substitution are unified in a substitution where variables of
+ ** quantisation in \a scratch_qcset are substitutable.  Scratch
+ ** substitutions keep their variable maps in the thread-local region of
+ ** \ref cu_tregion, which is rewound after each job. */
+void cuex_subst_unify_batch(size_t job_cnt, struct cuex_unify_job *job_arr,
+			    cuex_qcset_t scratch_qcset);
+
+/** Stores <code>\ref cuex_msg_unify(\a ex0_arr[i], \a ex1_arr[i], \a
+ ** unify)</code> in \a result_arr[i] for each \e i less than \a cnt.  Since
+ ** \a unify is called concurrently from worker threads, it must be
+ ** thread-safe. */
+void cuex_msg_unify_batch(size_t cnt, cuex_t const *ex0_arr,
+			  cuex_t const *ex1_arr, cuex_t *result_arr,
+			  cu_clop(unify, cuex_t, cuex_t e0sub, cuex_t e1sub));
+
+/** @} */
+CU_END_DECLARATIONS
+
+#endif
@@ -0,0 +1,133 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cuex/unify_batch.h>
+#include <cuex/subst.h>
+#include <cuex/oprdefs.h>
+#include <cuex/opn.h>
+#include <cuex/var.h>
+#include <cuflow/workers.h>
+#include <cuflow/time.h>
+#include <cu/idr.h>
+#include <cu/test.h>
+#include <stdio.h>
+
+#define VAR_CNT 64
+#define CONST_CNT 8
+
+static cuex_t var_arr[2][VAR_CNT];
+static cuex_t const_arr[CONST_CNT];
+
+static cuex_t
+_random_ex(int depth, int side)
+{
+    if (depth == 0 || lrand48() % 6 == 0) {
+	if (lrand48() % 3 == 0)
+	    return var_arr[side][lrand48() % VAR_CNT];
+	else
+	    return const_arr[lrand48() % CONST_CNT];
+    }
+    return cuex_o2_apply(_random_ex(depth - 1, side),
+			 _random_ex(depth - 1, side));
+}
+
+/* Return e with some subexpressions replaced by variables of the other side,
+ * so that most pairs are unifiable. */
+static cuex_t
+_perturb(cuex_t e)
+{
+    if (lrand48() % 8 == 0)
+	return var_arr[1][lrand48() % VAR_CNT];
+    if (cuex_meta(e) == CUEX_O2_APPLY)
+	return cuex_o2_apply(_perturb(cuex_opn_at(e, 0)),
+			     _perturb(cuex_opn_at(e, 1)));
+    return e;
+}
+
+static double
+_seconds(cuflow_walltime_t t)
+{
+    return t/(double)CUFLOW_WALLTIME_SECOND;
+}
+
+static void
+bench(size_t job_cnt, int depth)
+{
+    struct cuex_unify_job *job_arr = cu_galloc(job_cnt*sizeof(*job_arr));
+    cuex_t *ref_arr = cu_galloc(job_cnt*sizeof(cuex_t));
+    static int const worker_cnts[] = {0, 1, 2, 4, 8};
+    cuflow_walltime_t t;
+    size_t i, fail_cnt = 0;
+    int k;
+
+    for (i = 0; i < job_cnt; ++i) {
+	job_arr[i].ex0 = _random_ex(depth, 0);
+	job_arr[i].ex1 = _perturb(job_arr[i].ex0);
+	if (lrand48() % 4 == 0)
+	    job_arr[i].ex1 = _perturb(_random_ex(depth, 0));
+    }
+
+    t = -cuflow_walltime();
+    for (i = 0; i < job_cnt; ++i) {
+	cuex_subst_t subst = cuex_subst_new_uw();
+	if (cuex_subst_unify(subst, job_arr[i].ex0, job_arr[i].ex1))
+	    ref_arr[i] = cuex_subst_apply(subst, job_arr[i].ex0);
+	else {
+	    ref_arr[i] = NULL;
+	    ++fail_cnt;
+	}
+    }
+    t += cuflow_walltime();
+    printf("%6zd jobs of depth %2d, %3zd%% unifiable\n", job_cnt, depth,
+	   100*(job_cnt - fail_cnt)/job_cnt);
+    printf("    sequential:           %10.3lg s %10.3lg s/job\n",
+	   _seconds(t), _seconds(t)/job_cnt);
+
+    for (k = 0; k < sizeof(worker_cnts)/sizeof(worker_cnts[0]); ++k) {
+	cuflow_workers_spawn(worker_cnts[k]);
+	for (i = 0; i < job_cnt; ++i)
+	    job_arr[i].subst = NULL;
+	t = -cuflow_walltime();
+	cuex_subst_unify_batch(job_cnt, job_arr, cuex_qcset_uw);
+	t += cuflow_walltime();
+	printf("    batch, %d workers:    %10.3lg s %10.3lg s/job\n",
+	       worker_cnts[k], _seconds(t), _seconds(t)/job_cnt);
+	for (i = 0; i < job_cnt; ++i)
+	    cu_test_assert_ptr_eq(job_arr[i].result, ref_arr[i]);
+    }
+    cuflow_workers_spawn(0);
+}
+
+int
+main()
+{
+    int i, j;
+    cuex_init();
+    for (j = 0; j < 2; ++j)
+	for (i = 0; i < VAR_CNT; ++i)
+	    var_arr[j][i] = cuex_var_new_u();
+    for (i = 0; i < CONST_CNT; ++i) {
+	char name[8];
+	sprintf(name, "c%d", i);
+	const_arr[i] = cu_idr_by_cstr(name);
+    }
+    bench(1000, 4);
+    bench(10000, 4);
+    bench(10000, 8);
+    bench(2000, 12);
+    return 2*!!cu_test_bug_count();
+}
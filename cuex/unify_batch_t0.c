@@ -0,0 +1,149 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cuex/unify_batch.h>
+#include <cuex/subst.h>
+#include <cuex/algo.h>
+#include <cuex/oprdefs.h>
+#include <cuex/opn.h>
+#include <cuex/var.h>
+#include <cuflow/workers.h>
+#include <cu/idr.h>
+#include <cu/test.h>
+#include <stdio.h>
+
+#define VAR_CNT 16
+#define CONST_CNT 4
+#define JOB_CNT 1000
+#define DEPTH 5
+
+static cuex_t var_arr[2][VAR_CNT];
+static cuex_t const_arr[CONST_CNT];
+
+static cuex_t
+_random_ex(int depth, int side)
+{
+    if (depth == 0 || lrand48() % 6 == 0) {
+	if (lrand48() % 3 == 0)
+	    return var_arr[side][lrand48() % VAR_CNT];
+	else
+	    return const_arr[lrand48() % CONST_CNT];
+    }
+    return cuex_o2_apply(_random_ex(depth - 1, side),
+			 _random_ex(depth - 1, side));
+}
+
+/* Return e with some subexpressions replaced by variables of the other side,
+ * so that most pairs are unifiable. */
+static cuex_t
+_perturb(cuex_t e)
+{
+    if (lrand48() % 8 == 0)
+	return var_arr[1][lrand48() % VAR_CNT];
+    if (cuex_meta(e) == CUEX_O2_APPLY)
+	return cuex_o2_apply(_perturb(cuex_opn_at(e, 0)),
+			     _perturb(cuex_opn_at(e, 1)));
+    return e;
+}
+
+cu_clop_def(_mismatch, cuex_t, cuex_t e0, cuex_t e1)
+{
+    return cuex_o2_apply(e0, e1);
+}
+
+static struct cuex_unify_job job_arr[JOB_CNT];
+static cuex_t ex0_arr[JOB_CNT], ex1_arr[JOB_CNT];
+static cuex_t ref_arr[JOB_CNT], msg_ref_arr[JOB_CNT], msg_arr[JOB_CNT];
+static cuex_subst_t ref_subst_arr[JOB_CNT];
+
+/* Solve the problems sequentially with cuex_subst_unify and cuex_msg_unify
+ * to get the reference results.  Odd jobs are solved in a substitution
+ * owned by the job, even jobs in a scratch substitution. */
+static void
+_make_jobs(void)
+{
+    size_t i;
+    for (i = 0; i < JOB_CNT; ++i) {
+	cuex_subst_t subst = cuex_subst_new_uw();
+	ex0_arr[i] = _random_ex(DEPTH, 0);
+	ex1_arr[i] = _perturb(ex0_arr[i]);
+	if (lrand48() % 4 == 0)
+	    ex1_arr[i] = _perturb(_random_ex(DEPTH, 0));
+	if (!cuex_subst_unify(subst, ex0_arr[i], ex1_arr[i]))
+	    ref_arr[i] = NULL;
+	else if (i % 2 == 0 || subst->is_idem)
+	    ref_arr[i] = cuex_subst_apply(subst, ex0_arr[i]);
+	else
+	    ref_arr[i] = ex0_arr[i];
+	ref_subst_arr[i] = subst;
+	msg_ref_arr[i] = cuex_msg_unify(ex0_arr[i], ex1_arr[i], _mismatch);
+    }
+}
+
+static void
+_test(int worker_cnt, size_t job_cnt)
+{
+    size_t i;
+
+    cuflow_workers_spawn(worker_cnt);
+
+    for (i = 0; i < job_cnt; ++i) {
+	job_arr[i].subst = i % 2? cuex_subst_new_uw() : NULL;
+	job_arr[i].ex0 = ex0_arr[i];
+	job_arr[i].ex1 = ex1_arr[i];
+	job_arr[i].result = ex0_arr[i];
+    }
+    cuex_subst_unify_batch(job_cnt, job_arr, cuex_qcset_uw);
+    for (i = 0; i < job_cnt; ++i) {
+	cu_test_assert_ptr_eq(job_arr[i].result, ref_arr[i]);
+	if (job_arr[i].subst && ref_arr[i])
+	    cu_test_assert_ptr_eq(
+		cuex_subst_apply(job_arr[i].subst, ex1_arr[i]),
+		cuex_subst_apply(ref_subst_arr[i], ex1_arr[i]));
+    }
+
+    for (i = 0; i < job_cnt; ++i)
+	msg_arr[i] = NULL;
+    cuex_msg_unify_batch(job_cnt, ex0_arr, ex1_arr, msg_arr, _mismatch);
+    for (i = 0; i < job_cnt; ++i)
+	cu_test_assert_ptr_eq(msg_arr[i], msg_ref_arr[i]);
+
+    cuflow_workers_spawn(0);
+}
+
+int
+main()
+{
+    int i, j;
+    cuex_init();
+    for (j = 0; j < 2; ++j)
+	for (i = 0; i < VAR_CNT; ++i)
+	    var_arr[j][i] = cuex_var_new_u();
+    for (i = 0; i < CONST_CNT; ++i) {
+	char name[8];
+	sprintf(name, "c%d", i);
+	const_arr[i] = cu_idr_by_cstr(name);
+    }
+    _make_jobs();
+
+    _test(0, JOB_CNT);
+    _test(4, 0);
+    _test(4, 1);
+    _test(4, 17);
+    _test(4, JOB_CNT);
+    return 2*!!cu_test_bug_count();
+}
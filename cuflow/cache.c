@@ -23,6 +23,7 @@
 #include <cu/hash.h>
 #include <cu/memory.h>
 #include <math.h>
+#include <limits.h>
 
 #define FILL_MIN_NOM 1
 #define FILL_MIN_DENOM 2
@@ -39,6 +40,27 @@
 #define CACHEOBJ_KEY_SIZEW(obj) \
     CUFLOW_FNCODE_KEY_SIZEW(CUFLOW_CACHEOBJ_FNCODE(obj))
 
+static cuflowP_cachetab_t
+_cachetab_new(size_t cap)
+{
+    cuflowP_cachetab_t tab;
+    tab = cu_gallocz(sizeof(struct cuflowP_cachetab) + (cap - 1)*sizeof(AO_t));
+    tab->cap = cap;
+    return tab;
+}
+
+CU_SINLINE cuflowP_cachetab_t
+_bin_tab(cuflowP_cachebin_t bin)
+{ return (cuflowP_cachetab_t)AO_load_acquire_read(&bin->tab); }
+
+CU_SINLINE cuflow_cacheobj_t
+_link_load(AO_t *link)
+{ return (cuflow_cacheobj_t)AO_load_acquire_read(link); }
+
+CU_SINLINE void
+_link_store(AO_t *link, cuflow_cacheobj_t obj)
+{ AO_store_release_write(link, (AO_t)obj); }
+
 void
 cuflow_cache_init(cuflow_cache_t cache, cuflow_cacheconf_t conf,
 		  cuflow_cacheobj_t (**fn_arr)(cuflow_cacheobj_t key))
@@ -49,26 +71,33 @@ cuflow_cache_init(cuflow_cache_t cache, cuflow_cacheconf_t conf,
     for (i = 0; i < CUFLOWP_CACHE_BIN_COUNT; ++i) {
 	cuflowP_cachebin_t bin = &cache->bin_arr[i];
 	cu_mutex_init(&bin->mutex);
-	bin->cap = MIN_CAP;
+	AO_store(&bin->tab, (AO_t)_cachetab_new(MIN_CAP));
 	bin->size = 0;
-	bin->access_since_pruned = 0;
-	bin->link_arr = cu_gallocz(MIN_CAP*sizeof(struct cuflowP_cachebin));
+	AO_store(&bin->byte_count, 0);
+	bin->prune_pos = 0;
+	AO_store(&bin->access_since_pruned, 0);
     }
-#if 0
     cu_mutex_lock(&conf->cache_link_mutex);
     cu_dlink_insert_before(&conf->cache_link, cu_to(cu_dlink, cache));
     cu_mutex_unlock(&conf->cache_link_mutex);
-#endif
 }
 
 void
-cuflow_cache_dct(cuflow_cache_t cache)
+cuflow_cache_deinit(cuflow_cache_t cache)
 {
-#if 0
     cu_mutex_lock(&cache->conf->cache_link_mutex);
     cu_dlink_erase(cu_to(cu_dlink, cache));
     cu_mutex_unlock(&cache->conf->cache_link_mutex);
-#endif
+}
+
+size_t
+cuflow_cache_byte_count(cuflow_cache_t cache)
+{
+    int i;
+    size_t count = 0;
+    for (i = 0; i < CUFLOWP_CACHE_BIN_COUNT; ++i)
+	count += AO_load(&cache->bin_arr[i].byte_count);
+    return count;
 }
 
 cuflow_cacheobj_t
@@ -79,6 +108,7 @@ cuflow_cacheobj_alloc(size_t full_size, cuflow_cacheobj_t key)
     size_t key_sizew = CACHEOBJ_KEY_SIZEW(key);
     full_size += sizeof(struct cuflowP_cacheobjhdr);
     base = cu_galloc(full_size);
+    base->byte_size = full_size;
     obj = (cuflow_cacheobj_t)(base + 1);
     cu_wordarr_copy(key_sizew, (cu_word_t *)obj, (cu_word_t *)key);
     return obj;
@@ -98,78 +128,127 @@ _cacheobj_hash(cu_word_t fncode, cuflow_cacheobj_t obj)
     return cu_wordarr_hash(key_sizew - 1, (cu_word_t *)obj + 1, fncode);
 }
 
+/* Move the objects of bin to a new bucket array of capacity new_cap.  Lookups
+ * may proceed concurrently.  Since each object is relinked only after its
+ * successor in the old chain has been read, and new chains only link to
+ * already moved objects, a concurrent reader always reaches the end of a
+ * chain, though it may miss its object and fall back to the locked path. */
 static void
 _resize_lck(cuflowP_cachebin_t bin, size_t new_cap)
 {
-    cuflow_cacheobj_t *old_link_arr = bin->link_arr;
-    cuflow_cacheobj_t *old_link_arr_end = old_link_arr + bin->cap;
-    bin->cap = new_cap;
-    bin->link_arr = cu_gallocz(sizeof(struct cuflowP_cachebin)*new_cap);
-    while (old_link_arr != old_link_arr_end) {
-	cuflow_cacheobj_t obj = *old_link_arr;
+    cuflowP_cachetab_t old_tab = _bin_tab(bin);
+    cuflowP_cachetab_t new_tab = _cachetab_new(new_cap);
+    size_t i;
+    for (i = 0; i < old_tab->cap; ++i) {
+	cuflow_cacheobj_t obj = _link_load(&old_tab->link_arr[i]);
 	while (obj) {
-	    cuflow_cacheobj_t next_obj = HDR(obj)->next;
+	    cuflow_cacheobj_t next_obj = _link_load(&HDR(obj)->next);
 	    cu_word_t fncode = CUFLOW_CACHEOBJ_FNCODE(obj);
 	    cu_hash_t hash = _cacheobj_hash(fncode, obj);
-	    cuflow_cacheobj_t *slot;
-	    slot = &bin->link_arr[HASH_SLOT(hash, new_cap)];
-	    HDR(obj)->next = *slot;
-	    *slot = obj;
+	    AO_t *slot = &new_tab->link_arr[HASH_SLOT(hash, new_cap)];
+	    _link_store(&HDR(obj)->next, _link_load(slot));
+	    _link_store(slot, obj);
 	    obj = next_obj;
 	}
-	++old_link_arr;
     }
+    AO_store_release_write(&bin->tab, (AO_t)new_tab);
 }
 
 CU_SINLINE cu_bool_t
 _drop_condition(cuflow_cacheconf_t conf, cuflow_cacheobj_t obj)
 {
     return (unsigned long)conf->byte_cost_per_tick
-	 > (unsigned long)HDR(obj)->access_function;
+	 > (unsigned long)AO_load(&HDR(obj)->access_function);
 }
 
+/* Decay the access function according to the ticks passed since the last
+ * update.  This is called without locking from hits as well as from the
+ * pruner, so the caller which advances access_ticks applies the decay.
+ * Hits may add to the access function concurrently, hence the CAS.  A gain
+ * added between the two CASes is decayed along with the rest, which only
+ * costs a little accuracy. */
 CU_SINLINE void
 _update(cuflow_cacheconf_t conf, cuflow_cacheobj_t obj)
 {
-    unsigned int current_ticks = conf->current_ticks;
-    unsigned int delta_ticks = current_ticks - HDR(obj)->access_ticks;
-    HDR(obj)->access_ticks = current_ticks;
-    if (delta_ticks >= sizeof(HDR(obj)->access_function)*8)
-	HDR(obj)->access_function = 0;
-    else
-	HDR(obj)->access_function >>= delta_ticks;
+    AO_t current_ticks = AO_load(&conf->current_ticks);
+    AO_t access_ticks = AO_load(&HDR(obj)->access_ticks);
+    AO_t delta_ticks = current_ticks - access_ticks;
+    AO_t old_af, new_af;
+    if (delta_ticks == 0 ||
+	!AO_compare_and_swap(&HDR(obj)->access_ticks,
+			     access_ticks, current_ticks))
+	return;
+    do {
+	old_af = AO_load(&HDR(obj)->access_function);
+	if (delta_ticks >= sizeof(AO_t)*8)
+	    new_af = 0;
+	else
+	    new_af = old_af >> delta_ticks;
+    } while (!AO_compare_and_swap(&HDR(obj)->access_function,
+				  old_af, new_af));
 }
 
+/* Account a hit on obj. */
+CU_SINLINE void
+_hit(cuflow_cacheconf_t conf, cuflow_cacheobj_t obj)
+{
+    _update(conf, obj);
+    AO_fetch_and_add(&HDR(obj)->access_function, HDR(obj)->gain);
+}
+
+/* Prune up to CUFLOWP_CACHE_PRUNE_STEP buckets from the prune position, and
+ * adjust the capacity each time the position wraps around. */
 static void
-_prune_and_adjust_lck(cuflow_cache_t cache, cuflowP_cachebin_t bin)
+_prune_step_lck(cuflow_cache_t cache, cuflowP_cachebin_t bin)
 {
-    cuflow_cacheobj_t *link_arr = bin->link_arr;
-    cuflow_cacheobj_t *link_arr_end = bin->link_arr + bin->cap;
+    cuflowP_cachetab_t tab = _bin_tab(bin);
     cuflow_cacheconf_t conf = cache->conf;
+    size_t i = bin->prune_pos;
+    size_t i_end = i + CUFLOWP_CACHE_PRUNE_STEP;
 
-    /* Go through bin and prune recently unused objects */
-    while (link_arr != link_arr_end) {
-	cuflow_cacheobj_t *obj_slot = link_arr;
+    if (i_end > tab->cap)
+	i_end = tab->cap;
+    for (; i < i_end; ++i) {
+	AO_t *obj_slot = &tab->link_arr[i];
 	cuflow_cacheobj_t obj;
-	while ((obj = *obj_slot)) {
+	while ((obj = _link_load(obj_slot))) {
 	    _update(conf, obj);
 	    if (_drop_condition(conf, obj)) {
 		--bin->size;
-		*obj_slot = HDR(obj)->next;
+		AO_store(&bin->byte_count,
+			 AO_load(&bin->byte_count) - HDR(obj)->byte_size);
+		_link_store(obj_slot, _link_load(&HDR(obj)->next));
 	    }
 	    else
 		obj_slot = &HDR(obj)->next;
 	}
-	++link_arr;
     }
 
-    /* Adjust capacity if necessary. */
-    if (bin->size*FILL_MAX_DENOM > bin->cap*FILL_MAX_NOM)
-	_resize_lck(bin, bin->cap*2);
-    else if (bin->size*FILL_MIN_DENOM < bin->cap*FILL_MIN_NOM
-	     && bin->cap/2 >= MIN_CAP)
-	_resize_lck(bin, bin->cap/2);
-    bin->access_since_pruned = 0;
+    if (i_end < tab->cap)
+	bin->prune_pos = i_end;
+    else {
+	bin->prune_pos = 0;
+	if (bin->size*FILL_MAX_DENOM > tab->cap*FILL_MAX_NOM)
+	    _resize_lck(bin, tab->cap*2);
+	else if (bin->size*FILL_MIN_DENOM < tab->cap*FILL_MIN_NOM
+		 && tab->cap/2 >= MIN_CAP)
+	    _resize_lck(bin, tab->cap/2);
+    }
+    AO_store(&bin->access_since_pruned, 0);
+}
+
+CU_SINLINE cuflow_cacheobj_t
+_lookup(cuflowP_cachetab_t tab, cu_hash_t hash, cu_word_t fncode,
+	cuflow_cacheobj_t key)
+{
+    cuflow_cacheobj_t obj;
+    obj = _link_load(&tab->link_arr[HASH_SLOT(hash, tab->cap)]);
+    while (obj) {
+	if (_cacheobj_eq(fncode, key, obj))
+	    return obj;
+	obj = _link_load(&HDR(obj)->next);
+    }
+    return NULL;
 }
 
 cuflow_cacheobj_t
@@ -178,43 +257,57 @@ cuflow_cache_call(cuflow_cache_t cache, cu_word_t fncode,
 {
     cu_hash_t hash;
     cuflowP_cachebin_t bin;
-    cuflow_cacheobj_t *slot;
+    cuflowP_cachetab_t tab;
+    AO_t *slot;
     cuflow_cacheobj_t obj;
 
     key->fncode = fncode;
 
-    /* Lookup key, return if found. */
+    /* Lookup key without locking, return if found. */
     hash = _cacheobj_hash(fncode, key);
     bin = &cache->bin_arr[HASH_BIN(hash)];
-    cu_mutex_lock(&bin->mutex);
-    slot = &bin->link_arr[HASH_SLOT(hash, bin->cap)];
-    obj = *slot;
-    while (obj) {
-	if (_cacheobj_eq(fncode, key, obj)) {
-	    _update(cache->conf, obj);
-	    HDR(obj)->access_function += HDR(obj)->gain;
-	    if (++bin->access_since_pruned == bin->cap)
-		_prune_and_adjust_lck(cache, bin);
+    obj = _lookup(_bin_tab(bin), hash, fncode, key);
+    if (obj) {
+	_hit(cache->conf, obj);
+	if (AO_fetch_and_add1(&bin->access_since_pruned) + 1
+		>= CUFLOWP_CACHE_PRUNE_STEP
+	    && cu_mutex_trylock(&bin->mutex)) {
+	    _prune_step_lck(cache, bin);
 	    cu_mutex_unlock(&bin->mutex);
-	    return obj;
 	}
-	obj = HDR(obj)->next;
+	return obj;
+    }
+
+    /* Not found.  Check again while holding the lock, since another thread
+     * may be computing the same object. */
+    cu_mutex_lock(&bin->mutex);
+    obj = _lookup(_bin_tab(bin), hash, fncode, key);
+    if (obj) {
+	_hit(cache->conf, obj);
+	cu_mutex_unlock(&bin->mutex);
+	return obj;
     }
 
-    /* Not found, prune and adjust if needed, cache computation. */
-    if (bin->size*FILL_MAX_DENOM > bin->cap*FILL_MAX_NOM)
-	_prune_and_adjust_lck(cache, bin);
+    /* Prune a step or grow as needed, then cache computation. */
+    tab = _bin_tab(bin);
+    if (bin->size*FILL_MAX_DENOM > tab->cap*FILL_MAX_NOM)
+	_resize_lck(bin, tab->cap*2);
+    else
+	_prune_step_lck(cache, bin);
     obj = cache->fn_arr[CUFLOW_FNCODE_SLOT(fncode)](key);
 
     /* Insert new object. */
-    HDR(obj)->next = *slot;
     if (HDR(obj)->gain == 0)
 	cu_bugf("Callback %d for cache object did not set gain.",
 		CUFLOW_FNCODE_SLOT(fncode));
-    HDR(obj)->access_ticks = cache->conf->current_ticks;
-    HDR(obj)->access_function = HDR(obj)->gain;
-    *slot = obj;
+    AO_store(&HDR(obj)->access_ticks, AO_load(&cache->conf->current_ticks));
+    AO_store(&HDR(obj)->access_function, HDR(obj)->gain);
+    tab = _bin_tab(bin);
+    slot = &tab->link_arr[HASH_SLOT(hash, tab->cap)];
+    AO_store(&HDR(obj)->next, AO_load(slot));
+    _link_store(slot, obj);
     ++bin->size;
+    AO_store(&bin->byte_count, AO_load(&bin->byte_count) + HDR(obj)->byte_size);
     cu_mutex_unlock(&bin->mutex);
     return obj;
 }
@@ -223,6 +316,43 @@ cuflow_cache_call(cuflow_cache_t cache, cu_word_t fncode,
 /* Cache Configuration
  * =================== */
 
+/* Prune a step of each bin of each cache of conf, so that memory is
+ * reclaimed also from caches which see no traffic.  Bins which are busy are
+ * skipped. */
+static void
+_cacheconf_prune(cuflow_cacheconf_t conf)
+{
+    cuflow_cache_t cache;
+    cuflow_cacheconf_lock_cache_range(conf);
+    for (cache = cuflow_cacheconf_first_cache(conf);
+	 cache != cuflow_cacheconf_end_cache(conf);
+	 cache = cuflow_cacheconf_next_cache(cache)) {
+	int i;
+	for (i = 0; i < CUFLOWP_CACHE_BIN_COUNT; ++i) {
+	    cuflowP_cachebin_t bin = &cache->bin_arr[i];
+	    if (cu_mutex_trylock(&bin->mutex)) {
+		_prune_step_lck(cache, bin);
+		cu_mutex_unlock(&bin->mutex);
+	    }
+	}
+    }
+    cuflow_cacheconf_unlock_cache_range(conf);
+}
+
+size_t
+cuflow_cacheconf_byte_count(cuflow_cacheconf_t conf)
+{
+    cuflow_cache_t cache;
+    size_t count = 0;
+    cuflow_cacheconf_lock_cache_range(conf);
+    for (cache = cuflow_cacheconf_first_cache(conf);
+	 cache != cuflow_cacheconf_end_cache(conf);
+	 cache = cuflow_cacheconf_next_cache(cache))
+	count += cuflow_cache_byte_count(cache);
+    cuflow_cacheconf_unlock_cache_range(conf);
+    return count;
+}
+
 cu_clos_def(_cacheconf_update,
 	    cu_prot(void, struct timespec *t_now),
 	    ( cuflow_cacheconf_t conf; ))
@@ -231,6 +361,7 @@ cu_clos_def(_cacheconf_update,
     cuflow_cacheconf_t conf = self->conf;
     if (!(*conf->manager)(conf, t_now))
 	return;
+    _cacheconf_prune(conf);
     do {
 	cuflow_timespec_add(&conf->target_time, &conf->tick_period);
 	++conf->current_ticks;
@@ -245,10 +376,8 @@ cuflow_cacheconf_init(cuflow_cacheconf_t conf,
 {
     _cacheconf_update_t *confupdate;
     struct timespec t_now;
-#if 0
     cu_mutex_init(&conf->cache_link_mutex);
     cu_dlink_init_singleton(&conf->cache_link);
-#endif
     clock_gettime(CLOCK_REALTIME, &t_now);
     if (!(*manager)(conf, &t_now))
 	return;
@@ -262,6 +391,31 @@ cuflow_cacheconf_init(cuflow_cacheconf_t conf,
 			   &conf->target_time);
 }
 
+cu_bool_t
+cuflow_budget_cachemanager(cuflow_cacheconf_t conf, struct timespec *t_now)
+{
+    size_t count;
+    unsigned int cost;
+
+    if (conf->tick_period.tv_sec == 0 && conf->tick_period.tv_nsec == 0)
+	conf->tick_period.tv_nsec = 10000000; /* 10 ms */
+    if (conf->byte_cost_per_tick == 0)
+	conf->byte_cost_per_tick = 100;
+    if (conf->byte_budget == 0)
+	return cu_true;
+
+    count = cuflow_cacheconf_byte_count(conf);
+    cost = conf->byte_cost_per_tick;
+    if (count > conf->byte_budget) {
+	unsigned int delta = cost/4 + 1;
+	conf->byte_cost_per_tick = cost > UINT_MAX - delta? UINT_MAX
+							   : cost + delta;
+    }
+    else if (count < conf->byte_budget/4*3 && cost > 1)
+	conf->byte_cost_per_tick = cost - (cost/8 > 0? cost/8 : 1);
+    return cu_true;
+}
+
 static struct cuflow_cacheconf _default_cacheconf;
 
 static cu_bool_t
@@ -270,15 +424,20 @@ _default_manager(cuflow_cacheconf_t conf, struct timespec *t_now)
     return cu_true;
 }
 
+static pthread_once_t _default_cacheconf_once = PTHREAD_ONCE_INIT;
+
+static void
+_default_cacheconf_init(void)
+{
+    _default_cacheconf.tick_period.tv_sec = 0;
+    _default_cacheconf.tick_period.tv_nsec = 10000000; /* 10 ms */
+    _default_cacheconf.byte_cost_per_tick = 100;
+    cuflow_cacheconf_init(&_default_cacheconf, _default_manager);
+}
+
 cuflow_cacheconf_t
 cuflow_default_cacheconf()
 {
-    static int done_init = 0;
-    if (!done_init) {
-	_default_cacheconf.tick_period.tv_sec = 0;
-	_default_cacheconf.tick_period.tv_nsec = 10000000; /* 10 ms */
-	_default_cacheconf.byte_cost_per_tick = 100;
-	cuflow_cacheconf_init(&_default_cacheconf, _default_manager);
-    }
+    pthread_once(&_default_cacheconf_once, _default_cacheconf_init);
     return &_default_cacheconf;
 }
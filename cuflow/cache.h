@@ -23,6 +23,7 @@
 #include <cu/clos.h>
 #include <cu/inherit.h>
 #include <cu/dlink.h>
+#include <atomic_ops.h>
 
 CU_BEGIN_DECLARATIONS
 /** \defgroup cuflow_cache_h cuflow/cache.h: Function Call Cache (unfinished)
@@ -31,6 +32,7 @@ CU_BEGIN_DECLARATIONS
 
 #define CUFLOWP_CACHE_LOG2_BIN_COUNT 5
 #define CUFLOWP_CACHE_BIN_COUNT (1 << CUFLOWP_CACHE_LOG2_BIN_COUNT)
+#define CUFLOWP_CACHE_PRUNE_STEP 16
 
 /** Returns a function code identifying slot number \a index in a cache which
  ** takes a key of \a key_wsize words size. */
@@ -44,17 +46,32 @@ CU_BEGIN_DECLARATIONS
 #define CUFLOWP_CACHEOBJ_HDR(obj) ((cuflowP_cacheobjhdr_t)(obj) - 1)
 
 typedef struct cuflowP_cachebin *cuflowP_cachebin_t;
+typedef struct cuflowP_cachetab *cuflowP_cachetab_t;
 typedef struct cuflow_cache *cuflow_cache_t;
 typedef struct cuflowP_cacheobjhdr *cuflowP_cacheobjhdr_t;
 typedef struct cuflow_cacheobj *cuflow_cacheobj_t;
 
+/* The bucket array of a bin.  It is replaced as a whole on resize, so that
+ * lock-free readers always see a consistent capacity. */
+struct cuflowP_cachetab
+{
+    size_t cap;
+    AO_t link_arr[1];		/* cuflow_cacheobj_t */
+};
+
+/* Lookups hit without locking.  The mutex serialises insertion and pruning
+ * of the bin.  Pruning is done incrementally, a few buckets at a time from
+ * prune_pos, and is triggered by misses, by the configuration tick, and by
+ * every CUFLOWP_CACHE_PRUNE_STEP hits if the mutex can be taken without
+ * waiting. */
 struct cuflowP_cachebin
 {
     cu_mutex_t mutex;
-    size_t cap;
+    AO_t tab;			/* cuflowP_cachetab_t */
     size_t size;
-    size_t access_since_pruned;
-    cuflow_cacheobj_t *link_arr;
+    AO_t byte_count;		/* updated under the mutex */
+    size_t prune_pos;
+    AO_t access_since_pruned;
 };
 
 struct cuflow_cache
@@ -65,12 +82,16 @@ struct cuflow_cache
     cuflow_cacheobj_t (**fn_arr)(cuflow_cacheobj_t key);
 };
 
+/* The access function is incremented atomically by hits.  It is decayed
+ * by hits and by the pruner, whichever first sees that access_ticks is
+ * behind the current tick and advances it. */
 struct cuflowP_cacheobjhdr
 {
-    cuflow_cacheobj_t next;
-    unsigned int access_ticks;
-    unsigned long access_function;
+    AO_t next;			/* cuflow_cacheobj_t */
+    AO_t access_ticks;
+    AO_t access_function;
     unsigned long gain;
+    size_t byte_size;		/* allocated size, including this header */
 };
 
 /** The base struct for both cache keys and cache objects. Typically use is to
@@ -96,6 +117,12 @@ cuflow_cache_init(cuflow_cache_t cache, cuflow_cacheconf_t conf,
 /** Unlink \a cache from it's configuration. */
 void cuflow_cache_deinit(cuflow_cache_t cache);
 
+/** The number of bytes held by \a cache, counted as the sizes passed to \ref
+ ** cuflow_cacheobj_alloc plus the object headers.  Memory shared between
+ ** objects or referred to indirectly is not included.  The result is a
+ ** snapshot which may be slightly stale under concurrent modification. */
+size_t cuflow_cache_byte_count(cuflow_cache_t cache);
+
 /** Return a pointer into the data area of a newly allocated cache object.  The
  ** cache callbacks must use this to allocate objects and must call \ref
  ** cuflow_cacheobj_set_gain before returning them. */
@@ -132,7 +159,8 @@ cuflow_cacheobj_set_gain(cuflow_cacheobj_t obj, float gain)
 /** Return the computed object with key-part equal to \a key.  \a key may be a
  ** stack object or static storage.  The callback and key size is determined
  ** from \e fncode.  The callback is only called if \a cache does not already
- ** contain the requested object. */
+ ** contain the requested object.  Calls which find the object in the cache
+ ** do not block. */
 cuflow_cacheobj_t
 cuflow_cache_call(cuflow_cache_t cache, cu_word_t fncode,
 		  cuflow_cacheobj_t key);
@@ -19,6 +19,11 @@
 #include <cuflow/cacheconf.h>
 #include <cuflow/cache_b0_tab.h>
 #include <cuflow/time.h>
+#include <cu/thread.h>
+#include <cu/memory.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
 
 cuflow_cached_edcl(fn1,
     ( int i; ),
@@ -32,7 +37,23 @@ cuflow_cached_edef(fn1)
     return obj;
 }
 
+/* Same as fn1, but with a gain which keeps the objects cached through the
+ * multi-threaded hit benchmark. */
+cuflow_cached_edcl(fn2,
+    ( int i; ),
+    ( int j; ));
+
+cuflow_cached_edef(fn2)
+{
+    fn2_obj_t *obj = cuflow_cached_new(fn2, 0);
+    obj->j = key->i;
+    cuflow_cacheobj_set_gain((cuflow_cacheobj_t)obj, 1e6);
+    return obj;
+}
+
 #define CALL_CNT 4000000
+#define HOT_CNT 1024
+#define SAMPLE_CNT 200000
 
 void test()
 {
@@ -57,10 +78,90 @@ void test()
     printf("%lg s per cached call\n", t/((double)CLOCKS_PER_SEC*CALL_CNT));
 }
 
-int main()
+struct _mt_carg
+{
+    pthread_t thread;
+    int thread_index;
+    uint32_t *lat_arr;
+};
+
+static void *
+_mt_thread_main(void *carg)
+{
+#define carg ((struct _mt_carg *)carg)
+    int i;
+    for (i = 0; i < SAMPLE_CNT; ++i) {
+	struct fn2_key key;
+	fn2_obj_t *obj;
+	struct timespec t0, t1;
+	key.i = (i + carg->thread_index*(HOT_CNT/8)) % HOT_CNT;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	obj = testcache_call(fn2, &key);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	if (obj->j != key.i)
+	    cu_bugf("Wrong cache object returned.");
+	carg->lat_arr[i] = (t1.tv_sec - t0.tv_sec)*1000000000
+			 + (t1.tv_nsec - t0.tv_nsec);
+    }
+    return NULL;
+#undef carg
+}
+
+static int
+_uint32_cmp(void const *x0, void const *x1)
+{
+    uint32_t y0 = *(uint32_t const *)x0, y1 = *(uint32_t const *)x1;
+    return y0 < y1? -1 : y0 > y1? 1 : 0;
+}
+
+/* Measure the latency of cache hits from 1 to max_thread_count concurrent
+ * threads.  The latencies include the overhead of clock_gettime. */
+static void
+test_mt(int max_thread_count)
+{
+    static double const pct_arr[] = {50.0, 90.0, 99.0, 99.9, 100.0};
+    int const pct_cnt = sizeof(pct_arr)/sizeof(pct_arr[0]);
+    struct _mt_carg *carg_arr;
+    uint32_t *lat_arr;
+    int thread_count, i;
+
+    for (i = 0; i < HOT_CNT; ++i) {
+	struct fn2_key key;
+	key.i = i;
+	testcache_call(fn2, &key);
+    }
+    carg_arr = cu_galloc(max_thread_count*sizeof(struct _mt_carg));
+    lat_arr = cu_galloc_atomic(max_thread_count*SAMPLE_CNT*sizeof(uint32_t));
+
+    printf("\nHit latency in ns by percentile:\n%7s", "threads");
+    for (i = 0; i < pct_cnt; ++i)
+	printf("  %7.1lf%%", pct_arr[i]);
+    printf("\n");
+    for (thread_count = 1; thread_count <= max_thread_count; ++thread_count) {
+	size_t n = thread_count*SAMPLE_CNT;
+	for (i = 0; i < thread_count; ++i) {
+	    carg_arr[i].thread_index = i;
+	    carg_arr[i].lat_arr = lat_arr + i*SAMPLE_CNT;
+	    cu_thread_create(&carg_arr[i].thread, NULL,
+			     _mt_thread_main, &carg_arr[i]);
+	}
+	for (i = 0; i < thread_count; ++i)
+	    cu_thread_join(carg_arr[i].thread, NULL);
+	qsort(lat_arr, n, sizeof(uint32_t), _uint32_cmp);
+	printf("%7d", thread_count);
+	for (i = 0; i < pct_cnt; ++i) {
+	    size_t k = (size_t)(pct_arr[i]/100.0*(n - 1) + 0.5);
+	    printf("  %8lu", (unsigned long)lat_arr[k]);
+	}
+	printf("\n");
+    }
+}
+
+int main(int argc, char **argv)
 {
     cuflow_init();
     testcache_init(cuflow_default_cacheconf());
     test();
+    test_mt(argc > 1? atoi(argv[1]) : 4);
     return 0;
 }
@@ -20,7 +20,9 @@
 #include <cuflow/cacheconf.h>
 #include <cuflow/cache_t0_tab.h>
 #include <cuflow/time.h>
+#include <cu/test.h>
 #include <math.h>
+#include <string.h>
 #include <time.h>
 
 #define FN_ARR_SIZE 1
@@ -69,6 +71,149 @@ test(cu_bool_t do_print)
     }
 }
 
+
+/* A cache used directly through cuflow_cache_call, with its own
+ * configuration, so that ticks and costs are under control of the test. */
+
+struct _blob_key
+{
+    cu_inherit (cuflow_cacheobj);
+    cu_word_t id;
+};
+
+struct _blob_obj
+{
+    struct _blob_key key;
+    char data[1000];
+};
+
+#define BLOB_FNCODE \
+    CUFLOW_FNCODE(0, sizeof(struct _blob_key)/sizeof(cu_word_t))
+
+static AO_t _blob_compute_count;
+static float _blob_gain;
+
+static cuflow_cacheobj_t
+_blob_fn(cuflow_cacheobj_t key)
+{
+    cuflow_cacheobj_t obj;
+    obj = cuflow_cacheobj_alloc(sizeof(struct _blob_obj), key);
+    cuflow_cacheobj_set_gain(obj, _blob_gain);
+    AO_fetch_and_add1(&_blob_compute_count);
+    return obj;
+}
+
+static cuflow_cacheobj_t (*_blob_fn_arr[])(cuflow_cacheobj_t) = {_blob_fn};
+
+static void
+_blob_call(cuflow_cache_t cache, cu_word_t id)
+{
+    struct _blob_key key;
+    struct _blob_obj *obj;
+    key.id = id;
+    obj = (struct _blob_obj *)cuflow_cache_call(cache, BLOB_FNCODE,
+						 (cuflow_cacheobj_t)&key);
+    cu_test_assert(obj->key.id == id);
+}
+
+static cu_bool_t
+_manual_manager(cuflow_cacheconf_t conf, struct timespec *t_now)
+{
+    return cu_false; /* no clock, ticks are advanced by the test */
+}
+
+/* A hit must first decay the access function for the ticks which passed
+ * since the last access, otherwise the next prune decays the fresh hits along
+ * with the old value and drops the entry. */
+static void
+test_hot_entry()
+{
+    struct cuflow_cacheconf conf;
+    struct cuflow_cache cache;
+    int i;
+
+    memset(&conf, 0, sizeof(conf));
+    conf.byte_cost_per_tick = 100;
+    cuflow_cacheconf_init(&conf, _manual_manager);
+    cuflow_cache_init(&cache, &conf, _blob_fn_arr);
+
+    _blob_gain = 1000;
+    AO_store(&_blob_compute_count, 0);
+    _blob_call(&cache, 1);
+    cu_test_assert(AO_load(&_blob_compute_count) == 1);
+
+    AO_store(&conf.current_ticks, 100);
+    for (i = 0; i < 4*CUFLOWP_CACHE_PRUNE_STEP; ++i)
+	_blob_call(&cache, 1);
+    cu_test_assert(AO_load(&_blob_compute_count) == 1);
+
+    cuflow_cache_deinit(&cache);
+}
+
+/* The configuration and cache are static, since the clock of the
+ * configuration keeps running after the test. */
+static struct cuflow_cacheconf _budget_conf;
+static struct cuflow_cache _budget_cache;
+#define BUDGET_OBJ_COUNT 32
+
+static unsigned int
+_budget_cost()
+{
+    return *(unsigned int volatile *)&_budget_conf.byte_cost_per_tick;
+}
+
+static cu_bool_t _budget_cost_raised()
+{ return _budget_cost() > 100; }
+
+static cu_bool_t _budget_respected()
+{ return cuflow_cache_byte_count(&_budget_cache) <= _budget_conf.byte_budget; }
+
+static unsigned int _budget_peak_cost;
+
+static cu_bool_t _budget_cost_lowered()
+{ return _budget_cost() < _budget_peak_cost; }
+
+/* Waits up to 10 s for cond to become true. */
+static cu_bool_t
+_wait_for(cu_bool_t (*cond)(void))
+{
+    struct timespec tv;
+    int i;
+    tv.tv_sec = 0;
+    tv.tv_nsec = 1000000;
+    for (i = 0; i < 10000; ++i) {
+	if ((*cond)())
+	    return cu_true;
+	nanosleep(&tv, NULL);
+    }
+    return cu_false;
+}
+
+/* Filling the cache past the budget must raise the cost until the excess is
+ * evicted, and the cost must go down again when the usage falls below three
+ * quarters of the budget. */
+static void
+test_budget()
+{
+    int i;
+
+    _budget_conf.byte_budget = BUDGET_OBJ_COUNT*sizeof(struct _blob_obj);
+    _budget_conf.tick_period.tv_sec = 0;
+    _budget_conf.tick_period.tv_nsec = 2000000;
+    _budget_conf.byte_cost_per_tick = 100;
+    cuflow_cacheconf_init(&_budget_conf, cuflow_budget_cachemanager);
+    cuflow_cache_init(&_budget_cache, &_budget_conf, _blob_fn_arr);
+
+    _blob_gain = 1 << 20;
+    for (i = 0; i < 2*BUDGET_OBJ_COUNT; ++i)
+	_blob_call(&_budget_cache, 100 + i);
+
+    cu_test_assert(_wait_for(_budget_cost_raised));
+    cu_test_assert(_wait_for(_budget_respected));
+    _budget_peak_cost = _budget_cost();
+    cu_test_assert(_wait_for(_budget_cost_lowered));
+}
+
 int main()
 {
     struct timespec tv;
@@ -77,11 +222,17 @@ int main()
     testcache_init(cuflow_default_cacheconf());
     tv.tv_sec = 0;
     test(cu_true);
+    cu_test_assert(cuflow_cache_byte_count(&testcache_cache)
+		   >= sizeof(fn0_obj_t));
+    cu_test_assert(cuflow_cacheconf_byte_count(cuflow_default_cacheconf())
+		   >= cuflow_cache_byte_count(&testcache_cache));
     for (i = 5; i < 15; ++i) {
 	tv.tv_nsec = 1L << i*2;
 	printf("Sleeping for %lu ns.\n", (unsigned long)tv.tv_nsec);
 	nanosleep(&tv, NULL);
 	test(cu_false);
     }
-    return 0;
+    test_hot_entry();
+    test_budget();
+    return 2*!!cu_test_bug_count();
 }
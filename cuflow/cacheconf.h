@@ -18,9 +18,7 @@
 #ifndef CUFLOW_CACHECONF_H
 #define CUFLOW_CACHECONF_H
 
-#if 0
 #include <cuflow/cache.h>
-#endif
 #include <cu/inherit.h>
 #include <cu/dlink.h>
 #include <time.h>
@@ -36,10 +34,8 @@ CU_BEGIN_DECLARATIONS
 struct cuflow_cacheconf
 {
     /* Set by this library. */
-#if 0
     pthread_mutex_t cache_link_mutex;
     struct cu_dlink cache_link;
-#endif
     AO_t current_ticks;
     struct timespec target_time;
 
@@ -47,6 +43,9 @@ struct cuflow_cacheconf
     unsigned int byte_cost_per_tick;
     struct timespec tick_period;
 
+    /* Used by \ref cuflow_budget_cachemanager. */
+    size_t byte_budget;
+
     cu_bool_t (*manager)(cuflow_cacheconf_t conf, struct timespec *t_now);
 };
 
@@ -70,22 +69,40 @@ void cuflow_cacheconf_init(cuflow_cacheconf_t conf,
  ** cuflow_workers_h. */
 cuflow_cacheconf_t cuflow_default_cacheconf(void);
 
-#if 0
+/** Lock the list of caches of \a conf for iteration. */
 CU_SINLINE void cuflow_cacheconf_lock_cache_range(cuflow_cacheconf_t conf)
 { cu_mutex_lock(&conf->cache_link_mutex); }
 
+/** Unlock the list of caches of \a conf. */
 CU_SINLINE void cuflow_cacheconf_unlock_cache_range(cuflow_cacheconf_t conf)
 { cu_mutex_unlock(&conf->cache_link_mutex); }
 
+/** The first cache registered with \a conf.  The range must be locked. */
 CU_SINLINE cuflow_cache_t cuflow_cacheconf_first_cache(cuflow_cacheconf_t conf)
 { return cu_from(cuflow_cache, cu_dlink, conf->cache_link.next); }
 
+/** The end of the caches registered with \a conf. */
 CU_SINLINE cuflow_cache_t cuflow_cacheconf_end_cache(cuflow_cacheconf_t conf)
 { return cu_from(cuflow_cache, cu_dlink, &conf->cache_link); }
 
+/** The cache following \a cache in its configuration. */
 CU_SINLINE cuflow_cache_t cuflow_cacheconf_next_cache(cuflow_cache_t cache)
 { return cu_from(cuflow_cache, cu_dlink, cu_to(cu_dlink, cache)->next); }
-#endif
+
+/** The number of bytes held by all caches registered with \a conf, as
+ ** accounted by \ref cuflow_cache_byte_count. */
+size_t cuflow_cacheconf_byte_count(cuflow_cacheconf_t conf);
+
+/** A manager which adjusts \e byte_cost_per_tick to keep the bytes held by
+ ** the caches of \a conf within \e byte_budget.  The cost is raised by a
+ ** quarter on each tick where the budget is exceeded and lowered by an eighth
+ ** when less than three quarters of the budget is used.  The client should
+ ** set \e byte_budget and may set \e tick_period and \e byte_cost_per_tick
+ ** before passing this to \ref cuflow_cacheconf_init, otherwise the tick
+ ** period defaults to 10 ms and the initial cost to 100.  A zero budget means
+ ** unlimited. */
+cu_bool_t cuflow_budget_cachemanager(cuflow_cacheconf_t conf,
+				     struct timespec *t_now);
 
 /** @} */
 CU_END_DECLARATIONS
@@ -17,6 +17,7 @@
 
 #include <cuflow/cdisj.h>
 #include <cuflow/workers.h>
+#include <cuflow/sched.h>
 #include <cu/hash.h>
 #include <cu/thread.h>
 
@@ -55,7 +56,17 @@ void
 cuflowP_cdisj_wait_while(cuflow_cdisj_t *cdisj, cu_bool_t cond_val)
 {
     cdisj_stripe_t stripe;
-    cuflow_yield();
+
+    /* The work we are waiting for is likely scheduled on our own queue or
+     * has spawned subtasks on other queues.  Run one job at a time, so that
+     * we stop as soon as the condition is fulfilled, and only turn to other
+     * schedulers and finally block when there is nothing left to do. */
+    while (!!AO_load_acquire_read(cdisj) != cond_val)
+	if (!cuflowP_sched_help()) {
+	    cuflow_yield();
+	    break;
+	}
+
     stripe = cdisj_stripe(cdisj);
     cu_mutex_lock(&stripe->mutex);
     AO_fetch_and_add1(&stripe->waiting_count);
@@ -0,0 +1,110 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cuflow/future.h>
+#include <cu/debug.h>
+#include <sched.h>
+
+/* The chain of a future is 0 while empty, a pointer to the most recently
+ * chained future, or CHAIN_DONE after the result has been stored.  The
+ * chained futures are linked by their chain_next fields. */
+#define CHAIN_DONE ((AO_t)1)
+
+/* The scheduler decrements the cdisj of a job after it returns, but the job
+ * may run inline from the job it is chained to, and a waiter may release the
+ * future as soon as it is done.  Therefore jobs are scheduled on this private
+ * cdisj, and the job itself clears the pending field of its future after
+ * storing the result and before walking the chain. */
+cuflow_cdisj_t cuflowP_future_job_cdisj;
+
+cu_clof_fun0(_future_job, void)
+{
+    cu_clof_self(cuflow_future, job);
+    AO_t chain;
+
+    (*self->compute)(self);
+
+    do
+	chain = AO_load(&self->chain);
+    while (!AO_compare_and_swap_full(&self->chain, chain, CHAIN_DONE));
+    cuflow_cdisj_sub1_release_write(&self->pending);
+    while (chain) {
+	cuflow_future_t next = (cuflow_future_t)chain;
+	chain = (AO_t)next->chain_next;
+	cuflow_sched_call(cu_clof_ref(next, job), &cuflowP_future_job_cdisj);
+    }
+}
+
+void
+cuflowP_future_init(cuflow_future_t fut, void (*compute)(cuflow_future_t))
+{
+    cu_clof_init(fut, job, _future_job);
+    fut->compute = compute;
+    fut->pending = 0;
+    fut->chain = 0;
+}
+
+void
+cuflow_future_then(cuflow_future_t fut, cuflow_future_t next)
+{
+    AO_t chain;
+    AO_fetch_and_add1(&next->pending);
+    do {
+	chain = AO_load(&fut->chain);
+	if (chain == CHAIN_DONE) {
+	    cuflow_sched_call(cu_clof_ref(next, job),
+			      &cuflowP_future_job_cdisj);
+	    return;
+	}
+	next->chain_next = (cuflow_future_t)chain;
+    } while (!AO_compare_and_swap_full(&fut->chain, chain, (AO_t)next));
+}
+
+void
+cuflowP_future_wait(cuflow_future_t fut)
+{
+    while (AO_load_acquire_read(&fut->pending))
+	if (!cuflowP_sched_help()) {
+	    cuflowP_cdisj_wait_while(&fut->pending, cu_false);
+	    return;
+	}
+}
+
+void
+cuflow_future_wait_all(cuflow_future_t *fut_arr, size_t count)
+{
+    size_t i;
+    for (i = 0; i < count; ++i)
+	cuflow_future_wait(fut_arr[i]);
+}
+
+size_t
+cuflow_future_wait_any(cuflow_future_t *fut_arr, size_t count)
+{
+    cu_debug_assert(count > 0);
+    for (;;) {
+	size_t i;
+	for (i = 0; i < count; ++i)
+	    if (cuflow_future_is_done(fut_arr[i]))
+		return i;
+
+	/* We can't block on several conditions at once, so give up the CPU
+	 * to the threads doing the remaining work. */
+	if (!cuflowP_sched_help())
+	    sched_yield();
+    }
+}
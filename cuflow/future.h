@@ -0,0 +1,165 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CUFLOW_FUTURE_H
+#define CUFLOW_FUTURE_H
+
+#include <cuflow/fwd.h>
+#include <cuflow/sched.h>
+#include <cuflow/cdisj.h>
+#include <cu/clos.h>
+#include <atomic_ops.h>
+
+CU_BEGIN_DECLARATIONS
+/** \defgroup cuflow_future_h cuflow/future.h: Futures of Scheduled Work
+ ** @{ \ingroup cuflow_smp_mod
+ **
+ ** A future holds the result of a closure which is scheduled with \ref
+ ** cuflow_sched_h "cuflow/sched.h", so that it may be run by another thread.
+ ** This replaces the deprecated \ref cuflow_promise_h "cuflow/promise.h" and
+ ** \ref cuflow_gworkq_h "cuflow/gworkq.h".
+ **
+ ** Futures are typed by declaring them with \ref cuflow_future_def, e.g.
+ ** \code
+ ** cuflow_future_def(long_future, long);
+ **
+ ** long_future_t fut;
+ ** long_future_spawn(&fut, fib_prep(&fib_clos));
+ ** ... do other work ...
+ ** x = long_future_get(&fut);
+ ** \endcode
+ ** The result is stored inside the future struct, which is typically
+ ** allocated on the stack along with the closure, so that no allocation is
+ ** needed.  Both must stay alive until the future is done.
+ **
+ ** Waiting for a future runs scheduled work, starting with the newest work
+ ** of the current thread, which is usually the future itself if it has not
+ ** been picked up by another thread.  The thread only blocks when no work
+ ** can be found. */
+
+/** The untyped part of a future, which is the first member \c base of the
+ ** typed futures. */
+struct cuflow_future
+{
+    cu_clof_decl0(job, void);
+    void (*compute)(cuflow_future_t);
+    cuflow_cdisj_t pending;	/* cleared when the result is stored */
+    AO_t chain;			/* futures to spawn when done */
+    cuflow_future_t chain_next;
+};
+
+#ifndef CU_IN_DOXYGEN
+extern cuflow_cdisj_t cuflowP_future_job_cdisj;
+void cuflowP_future_init(cuflow_future_t fut,
+			 void (*compute)(cuflow_future_t));
+void cuflowP_future_wait(cuflow_future_t fut);
+#endif
+
+/** True iff the result of \a fut is available. */
+CU_SINLINE cu_bool_t
+cuflow_future_is_done(cuflow_future_t fut)
+{
+    return !AO_load_acquire_read(&fut->pending);
+}
+
+/** Schedules the computation of \a fut.  This is called by the typed \e
+ ** NAME_spawn functions, after storing the closure. */
+CU_SINLINE void
+cuflow_future_spawn(cuflow_future_t fut)
+{
+    AO_store(&fut->pending, 1);
+    cuflow_sched_call(cu_clof_ref(fut, job), &cuflowP_future_job_cdisj);
+}
+
+/** Makes \a next pending at once, and schedules it when \a fut is done.  If
+ ** \a fut is already done, \a next is scheduled immediately.  Any number of
+ ** futures may be chained onto \a fut. */
+void cuflow_future_then(cuflow_future_t fut, cuflow_future_t next);
+
+/** Waits until \a fut is done, running scheduled work in the meantime. */
+CU_SINLINE void
+cuflow_future_wait(cuflow_future_t fut)
+{
+    if (AO_load_acquire_read(&fut->pending))
+	cuflowP_future_wait(fut);
+}
+
+/** Waits until all of the \a count futures in \a fut_arr are done. */
+void cuflow_future_wait_all(cuflow_future_t *fut_arr, size_t count);
+
+/** Waits until at least one of the \a count futures in \a fut_arr is done,
+ ** and returns the index of one which is done.
+ ** \pre \a count > 0. */
+size_t cuflow_future_wait_any(cuflow_future_t *fut_arr, size_t count);
+
+/** Defines a future type \e NAME_t holding a result of type \a res_t, with
+ ** the following static functions:
+ **
+ ** - <tt>void \e NAME_spawn(NAME_t *fut, cu_clop0(fn, res_t))</tt> schedules
+ **   \a fn and arranges for its result to be stored in \a fut.
+ ** - <tt>void \e NAME_spawn_after(NAME_t *fut, cu_clop0(fn, res_t),
+ **   cuflow_future_t dep)</tt> is similar, but \a fn is only scheduled when
+ **   \a dep is done, cf \ref cuflow_future_then.
+ ** - <tt>res_t \e NAME_get(NAME_t *fut)</tt> waits for \a fut and returns the
+ **   result.
+ **
+ ** The generic functions of this header take <tt>&fut->base</tt>. */
+#define cuflow_future_def(NAME, res_t)					\
+    typedef struct NAME##_s NAME##_t;					\
+    struct NAME##_s							\
+    {									\
+	struct cuflow_future base;					\
+	cu_clop0(fn, res_t);						\
+	res_t value;							\
+    };									\
+									\
+    static void								\
+    NAME##_compute(cuflow_future_t base)				\
+    {									\
+	NAME##_t *fut = (NAME##_t *)base;				\
+	fut->value = cu_call0(fut->fn);					\
+    }									\
+									\
+    CU_SINLINE void							\
+    NAME##_spawn(NAME##_t *fut, cu_clop0(fn, res_t))			\
+    {									\
+	fut->fn = fn;							\
+	cuflowP_future_init(&fut->base, NAME##_compute);		\
+	cuflow_future_spawn(&fut->base);				\
+    }									\
+									\
+    CU_SINLINE void							\
+    NAME##_spawn_after(NAME##_t *fut, cu_clop0(fn, res_t),		\
+		       cuflow_future_t dep)				\
+    {									\
+	fut->fn = fn;							\
+	cuflowP_future_init(&fut->base, NAME##_compute);		\
+	cuflow_future_then(dep, &fut->base);				\
+    }									\
+									\
+    CU_SINLINE res_t							\
+    NAME##_get(NAME##_t *fut)						\
+    {									\
+	cuflow_future_wait(&fut->base);					\
+	return fut->value;						\
+    }									\
+    CU_END_BOILERPLATE
+
+/** @} */
+CU_END_DECLARATIONS
+
+#endif
@@ -0,0 +1,169 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Fork-join benchmarks of futures for 1 to MAX_THREADS threads, comparing a
+ * parallel Fibonacci and a reduction over a binary tree with the sequential
+ * versions.  Usage: future_b0 [MAX_THREADS [FIB_N [TREE_DEPTH]]] */
+
+#include <cuflow/future.h>
+#include <cuflow/workers.h>
+#include <cuflow/time.h>
+#include <cu/memory.h>
+#include <cu/test.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define FIB_CUTOFF 16
+#define TREE_CUTOFF 10
+
+cuflow_future_def(long_future, long);
+
+static long
+fib_seq(int n)
+{
+    return n < 2? n : fib_seq(n - 1) + fib_seq(n - 2);
+}
+
+cu_clos_def(fib, cu_prot0(long), (int n;))
+{
+    cu_clos_self(fib);
+    fib_t sub[2];
+    long_future_t fut;
+
+    if (self->n < FIB_CUTOFF)
+	return fib_seq(self->n);
+    sub[0].n = self->n - 1;
+    sub[1].n = self->n - 2;
+    long_future_spawn(&fut, fib_prep(&sub[0]));
+    return cu_call0(fib_prep(&sub[1])) + long_future_get(&fut);
+}
+
+typedef struct tree_s *tree_t;
+struct tree_s
+{
+    tree_t left, right;
+    long value;
+};
+
+static tree_t
+tree_new(int depth, long *seed)
+{
+    tree_t node = cu_gnew(struct tree_s);
+    *seed = *seed*1103515245 + 12345;
+    node->value = (*seed >> 16) & 0xff;
+    if (depth > 0) {
+	node->left = tree_new(depth - 1, seed);
+	node->right = tree_new(depth - 1, seed);
+    }
+    else
+	node->left = node->right = NULL;
+    return node;
+}
+
+static long
+tree_sum_seq(tree_t node)
+{
+    long sum = 0;
+    while (node) {
+	sum += node->value + tree_sum_seq(node->left);
+	node = node->right;
+    }
+    return sum;
+}
+
+cu_clos_def(tree_sum, cu_prot0(long), (tree_t node; int depth;))
+{
+    cu_clos_self(tree_sum);
+    tree_sum_t sub[2];
+    long_future_t fut;
+
+    if (self->depth < TREE_CUTOFF)
+	return tree_sum_seq(self->node);
+    sub[0].node = self->node->left;
+    sub[1].node = self->node->right;
+    sub[0].depth = sub[1].depth = self->depth - 1;
+    long_future_spawn(&fut, tree_sum_prep(&sub[0]));
+    return self->node->value + cu_call0(tree_sum_prep(&sub[1]))
+	 + long_future_get(&fut);
+}
+
+static void
+report(char const *name, int thread_count, cuflow_walltime_t wt,
+       cuflow_walltime_t wt_seq)
+{
+    printf("%-10s %8d %12.3lg %10.2lf\n", name, thread_count,
+	   wt/(double)CUFLOW_WALLTIME_SECOND, wt_seq/(double)wt);
+}
+
+int
+main(int argc, char **argv)
+{
+    int max_thread_count = sysconf(_SC_NPROCESSORS_ONLN);
+    int fib_n = 38;
+    int tree_depth = 22;
+    int thread_count;
+    long seed = 1;
+    long fib_r, tree_r;
+    tree_t tree;
+    cuflow_walltime_t wt_fib_seq, wt_tree_seq;
+
+    cuflow_init();
+    if (argc > 1)
+	max_thread_count = atoi(argv[1]);
+    if (argc > 2)
+	fib_n = atoi(argv[2]);
+    if (argc > 3)
+	tree_depth = atoi(argv[3]);
+    if (max_thread_count < 1)
+	max_thread_count = 1;
+    tree = tree_new(tree_depth, &seed);
+
+    wt_fib_seq = -cuflow_walltime();
+    fib_r = fib_seq(fib_n);
+    wt_fib_seq += cuflow_walltime();
+    wt_tree_seq = -cuflow_walltime();
+    tree_r = tree_sum_seq(tree);
+    wt_tree_seq += cuflow_walltime();
+
+    printf("%-10s %8s %12s %10s\n", "bench", "threads", "WT total",
+	   "speedup");
+    report("fib seq", 1, wt_fib_seq, wt_fib_seq);
+    report("tree seq", 1, wt_tree_seq, wt_tree_seq);
+    for (thread_count = 1; thread_count <= max_thread_count; ++thread_count) {
+	fib_t fib_clos;
+	tree_sum_t tree_clos;
+	cuflow_walltime_t wt;
+
+	/* The main thread takes part in the work, so spawn one less. */
+	cuflow_workers_spawn(thread_count - 1);
+
+	wt = -cuflow_walltime();
+	fib_clos.n = fib_n;
+	cu_test_assert(cu_call0(fib_prep(&fib_clos)) == fib_r);
+	wt += cuflow_walltime();
+	report("fib", thread_count, wt, wt_fib_seq);
+
+	wt = -cuflow_walltime();
+	tree_clos.node = tree;
+	tree_clos.depth = tree_depth;
+	cu_test_assert(cu_call0(tree_sum_prep(&tree_clos)) == tree_r);
+	wt += cuflow_walltime();
+	report("tree", thread_count, wt, wt_tree_seq);
+    }
+    cuflow_workers_spawn(0);
+    return 2*!!cu_test_bug_count();
+}
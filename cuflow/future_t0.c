@@ -0,0 +1,135 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cuflow/future.h>
+#include <cuflow/workers.h>
+#include <cu/test.h>
+
+cuflow_future_def(long_future, long);
+
+static long
+fib_seq(int n)
+{
+    return n < 2? n : fib_seq(n - 1) + fib_seq(n - 2);
+}
+
+cu_clos_def(fib, cu_prot0(long), (int n;))
+{
+    cu_clos_self(fib);
+    fib_t sub[2];
+    long_future_t fut;
+    long r;
+
+    if (self->n < 12)
+	return fib_seq(self->n);
+    sub[0].n = self->n - 1;
+    sub[1].n = self->n - 2;
+    long_future_spawn(&fut, fib_prep(&sub[0]));
+    r = cu_call0(fib_prep(&sub[1]));
+    return long_future_get(&fut) + r;
+}
+
+/* Chained futures get the value of the future they depend on.  They may run
+ * inline from the job of dep, before its scheduler slot is released. */
+cu_clos_def(twice, cu_prot0(long), (long_future_t *dep;))
+{
+    cu_clos_self(twice);
+    cu_test_assert(cuflow_future_is_done(&self->dep->base));
+    return 2*long_future_get(self->dep);
+}
+
+static void
+test_fib(void)
+{
+    int n;
+    for (n = 0; n < 28; n += 3) {
+	fib_t clos;
+	long_future_t fut;
+	clos.n = n;
+	long_future_spawn(&fut, fib_prep(&clos));
+	cu_test_assert(long_future_get(&fut) == fib_seq(n));
+	cu_test_assert(cuflow_future_is_done(&fut.base));
+    }
+}
+
+#define CHAIN_CNT 8
+
+static void
+test_then(void)
+{
+    fib_t clos;
+    long_future_t fut, chained[CHAIN_CNT], late;
+    twice_t twice_clos[CHAIN_CNT], late_clos;
+    cuflow_future_t fut_arr[CHAIN_CNT];
+    int i;
+
+    clos.n = 25;
+    long_future_spawn(&fut, fib_prep(&clos));
+    for (i = 0; i < CHAIN_CNT; ++i) {
+	twice_clos[i].dep = &fut;
+	long_future_spawn_after(&chained[i], twice_prep(&twice_clos[i]),
+				&fut.base);
+	fut_arr[i] = &chained[i].base;
+    }
+    cuflow_future_wait_all(fut_arr, CHAIN_CNT);
+    for (i = 0; i < CHAIN_CNT; ++i)
+	cu_test_assert(chained[i].value == 2*fib_seq(25));
+
+    /* Chaining onto a future which is already done. */
+    late_clos.dep = &fut;
+    long_future_spawn_after(&late, twice_prep(&late_clos), &fut.base);
+    cu_test_assert(long_future_get(&late) == 2*fib_seq(25));
+}
+
+static void
+test_wait_any(void)
+{
+    fib_t clos[3];
+    long_future_t fut[3];
+    cuflow_future_t fut_arr[3];
+    size_t i;
+
+    for (i = 0; i < 3; ++i) {
+	clos[i].n = 30 - 6*i;
+	long_future_spawn(&fut[i], fib_prep(&clos[i]));
+	fut_arr[i] = &fut[i].base;
+    }
+    i = cuflow_future_wait_any(fut_arr, 3);
+    cu_test_assert(i < 3);
+    cu_test_assert(cuflow_future_is_done(fut_arr[i]));
+    cu_test_assert(fut[i].value == fib_seq(clos[i].n));
+    cuflow_future_wait_all(fut_arr, 3);
+}
+
+int
+main()
+{
+    cuflow_init();
+
+    /* Without workers, everything is run by the waiting thread. */
+    test_fib();
+    test_then();
+    test_wait_any();
+
+    cuflow_workers_spawn(4);
+    test_fib();
+    test_then();
+    test_wait_any();
+    cuflow_workers_spawn(0);
+
+    return 2*!!cu_test_bug_count();
+}
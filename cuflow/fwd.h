@@ -32,6 +32,7 @@ typedef struct cuflow_continuation *cuflow_continuation_t;
 typedef struct cuflow_tstate	*cuflow_tstate_t;
 
 typedef struct cuflow_cacheconf *cuflow_cacheconf_t;
+typedef struct cuflow_future	*cuflow_future_t;	/* future.h */
 typedef struct cuflow_gflexq	*cuflow_gflexq_t;	/* gworkq.h */
 typedef struct cuflow_promise	*cuflow_promise_t;	/* promise.h*/
 typedef struct cuflow_workq	*cuflow_workq_t;	/* workq.h */
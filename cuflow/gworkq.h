@@ -32,7 +32,8 @@ CU_BEGIN_DECLARATIONS
  * @{\ingroup cuflow_oldsmp_mod
  *
  * \deprecated \ref cuflow_sched_h "cuflow/sched.h" provides a simpler and more
- * efficient alternative.
+ * efficient alternative, and \ref cuflow_future_h "cuflow/future.h" provides
+ * results of scheduled work on top of it.
  *
  * The global work queue is a way for threads to co-operate to performed
  * scheduled function calls in order of priority and in FIFO order within
@@ -26,9 +26,9 @@ CU_BEGIN_DECLARATIONS
 /*!\defgroup cuflow_promise_h cuflow/promise.h: Delayed Fulfillment of Computations
  * @{\ingroup cuflow_oldsmp_mod
  *
- * \deprecated Similar functionality is provided by \ref cuflow_sched_h
- * "cuflow/sched.h" using \ref cuflow_cdisj_h "cuflow/cdisj.h" for guarding the
- * result of a computation.
+ * \deprecated Use \ref cuflow_future_h "cuflow/future.h", which schedules
+ * the computation with \ref cuflow_sched_h "cuflow/sched.h" and stores the
+ * result in the future itself.
  *
  * A promise is a handle which contains a task to be performed at a later
  * time, and a state of the computation.  The computation may schedule
@@ -19,23 +19,116 @@
 #include <cuflow/tstate.h>
 #include <cuflow/workers.h>
 #include <cuflow/cdisj.h>
+#include <cu/memory.h>
 
 cu_dlog_def(_file, "dtag=cuflow.sched");
 
-void
-cuflowP_sched_call(cuflow_exeq_t exeq, cu_clop0(fn, void),
-		   AO_t *cdisj)
+/* The execution queues are Chase-Lev work-stealing deques.  The owner pushes
+ * and pops at the bottom, and only needs a full barrier when it may compete
+ * with a thief for the last entry.  Thieves take entries from the top by
+ * compare-and-swap.  When the owner grows the buffer, the old one is left
+ * intact for thieves which may still be reading it, and is reclaimed by the
+ * collector once unreferenced. */
+
+#define EXEQ_BUFFER(exeq) \
+    ((struct cuflowP_exeq_buffer *)AO_load_acquire_read(&(exeq)->buffer))
+
+static struct cuflowP_exeq_buffer *
+_exeq_buffer_new(size_t size)
+{
+    struct cuflowP_exeq_buffer *buf;
+    buf = cu_galloc(sizeof(struct cuflowP_exeq_buffer)
+		    + (size - 1)*sizeof(struct cuflow_exeq_entry));
+    buf->mask = size - 1;
+    return buf;
+}
+
+static struct cuflowP_exeq_buffer *
+_exeq_grow(cuflow_exeq_t exeq, struct cuflowP_exeq_buffer *buf,
+	   AO_t top, AO_t bottom)
+{
+    struct cuflowP_exeq_buffer *new_buf;
+    AO_t i;
+    new_buf = _exeq_buffer_new(2*(buf->mask + 1));
+    for (i = top; i != bottom; ++i)
+	new_buf->arr[i & new_buf->mask] = buf->arr[i & buf->mask];
+    cu_dlogf(_file, "GROW %p: size=%ld", exeq, (long)new_buf->mask + 1);
+    AO_store_release_write(&exeq->buffer, (AO_t)new_buf);
+    return new_buf;
+}
+
+CU_SINLINE void
+_exeq_push(cuflow_exeq_t exeq, cu_clop0(fn, void), AO_t *cdisj)
 {
-    cuflow_exeq_entry_t ent = &exeq->call_arr[exeq->head];
+    AO_t bottom = exeq->bottom;
+    AO_t top = AO_load_acquire_read(&exeq->top);
+    struct cuflowP_exeq_buffer *buf = EXEQ_BUFFER(exeq);
+    cuflow_exeq_entry_t ent;
     cu_dlogf(_file,
-	     "ENQUEUE %p %ld %ld: fn=%p qsize=%ld; thread=0x%lx; tstate=%p",
-	     exeq, exeq->head, exeq->tail, fn,
-	     ((exeq->head - exeq->tail - 1) & CUFLOW_EXEQ_MASK),
+	     "ENQUEUE %p %ld %ld: fn=%p; thread=0x%lx; tstate=%p",
+	     exeq, (long)top, (long)bottom, fn,
 	     (long)pthread_self(), cuflow_tstate());
+    if (cu_expect_false(bottom - top > buf->mask))
+	buf = _exeq_grow(exeq, buf, top, bottom);
+    ent = &buf->arr[bottom & buf->mask];
     ent->fn = fn;
     ent->cdisj = cdisj;
+    AO_store_release_write(&exeq->bottom, bottom + 1);
+}
+
+/* Pops the most recently pushed entry of the current thread's queue into
+ * *ent_out, and returns true on success. */
+static cu_bool_t
+_exeq_pop(cuflow_exeq_t exeq, cuflow_exeq_entry_t ent_out)
+{
+    AO_t bottom = exeq->bottom - 1;
+    AO_t top;
+    struct cuflowP_exeq_buffer *buf = EXEQ_BUFFER(exeq);
+
+    AO_store(&exeq->bottom, bottom);
+    AO_nop_full();
+    top = AO_load(&exeq->top);
+    if ((long)(bottom - top) < 0) {
+	AO_store(&exeq->bottom, top);
+	return cu_false;
+    }
+    *ent_out = buf->arr[bottom & buf->mask];
+    if (bottom == top) {
+	/* This is the last entry, race any thieves for it. */
+	cu_bool_t got_it;
+	got_it = AO_compare_and_swap_full(&exeq->top, top, top + 1);
+	AO_store(&exeq->bottom, top + 1);
+	return got_it;
+    }
+    return cu_true;
+}
+
+/* Steals the oldest entry from the queue of another thread into *ent_out,
+ * and returns true on success or false if the queue is empty. */
+static cu_bool_t
+_exeq_steal(cuflow_exeq_t exeq, cuflow_exeq_entry_t ent_out)
+{
+    for (;;) {
+	AO_t top = AO_load_acquire(&exeq->top);
+	AO_t bottom;
+	struct cuflowP_exeq_buffer *buf;
+	AO_nop_full();
+	bottom = AO_load_acquire_read(&exeq->bottom);
+	if ((long)(bottom - top) <= 0)
+	    return cu_false;
+	buf = EXEQ_BUFFER(exeq);
+	*ent_out = buf->arr[top & buf->mask];
+	if (AO_compare_and_swap_full(&exeq->top, top, top + 1))
+	    return cu_true;
+    }
+}
+
+void
+cuflowP_sched_call(cuflow_exeq_t exeq, cu_clop0(fn, void),
+		   AO_t *cdisj)
+{
     AO_fetch_and_add1(cdisj);
-    AO_store_release_write(&exeq->head, (exeq->head + 1) & CUFLOW_EXEQ_MASK);
+    _exeq_push(exeq, fn, cdisj);
 
     cuflow_workers_incr_pending();
 #if CUFLOW_PROFILE_SCHED
@@ -47,15 +140,7 @@ void
 cuflowP_sched_call_sub1(cuflow_exeq_t exeq, cu_clop0(fn, void),
 			AO_t *cdisj)
 {
-    cuflow_exeq_entry_t ent = &exeq->call_arr[exeq->head];
-    cu_dlogf(_file,
-	     "ENQUEUE %p %ld %ld: fn=%p qsize=%ld; thread=0x%lx; tstate=%p",
-	     exeq, exeq->head, exeq->tail, fn,
-	     ((exeq->head - exeq->tail - 1) & CUFLOW_EXEQ_MASK),
-	     (long)pthread_self(), cuflow_tstate());
-    ent->fn = fn;
-    ent->cdisj = cdisj;
-    AO_store_release_write(&exeq->head, (exeq->head + 1) & CUFLOW_EXEQ_MASK);
+    _exeq_push(exeq, fn, cdisj);
 
     cuflow_workers_incr_pending();
 #if CUFLOW_PROFILE_SCHED
@@ -83,6 +168,17 @@ cuflow_sched_call_sub1_at(cu_clop0(f, void), AO_t *cdisj, cuflow_exeqpri_t pri)
     tstate->exeqpri = old_pri;
 }
 
+static void
+_exeq_run(cuflow_tstate_t ts0, cuflow_exeqpri_t pri, cuflow_exeq_entry_t ent)
+{
+    cuflow_workers_decr_pending();
+    cu_dlogf(_file, "DEQUEUE %p: fn=%p", &ts0->exeq[pri], ent->fn);
+    ts0->exeqpri = pri;
+    cu_call0(ent->fn);
+    cu_dlogf(_file, "Done job %p, decrementing %p.", ent->fn, ent->cdisj);
+    cuflow_cdisj_sub1_release_write(ent->cdisj);
+}
+
 cu_clop_edef(cuflowP_schedule, void, cu_bool_t is_global)
 {
     cuflow_tstate_t ts0 = cuflow_tstate();
@@ -91,45 +187,49 @@ cu_clop_edef(cuflowP_schedule, void, cu_bool_t is_global)
     for (pri = cuflow_exeqpri_begin; cuflow_exeqpri_prioreq(pri, caller_pri);
 	 pri = cuflow_exeqpri_succ(pri)) {
 	cuflow_tstate_t ts = ts0;
-	do {
-	    cuflow_exeq_t exeq = &ts->exeq[pri];
-	    /* The pickup_mutex atomise picking up the entry at exeq->tail and
-	     * incrementing exeq->tail. */
-	    cu_mutex_lock(&exeq->pickup_mutex);
-	    cu_dlogf(_file, "CHECKQUEUE %p %ld %ld; cnt=%ld",
-		     exeq, exeq->head, exeq->tail,
-		     ((exeq->head - exeq->tail - 1) & CUFLOW_EXEQ_MASK));
-	    while (((AO_load_acquire_read(&exeq->head) - exeq->tail - 1)
-		    & CUFLOW_EXEQ_MASK) > 0) {
-		cu_clop0(fn, void);
-		AO_t *cdisj;
-		cuflow_exeq_entry_t ent;
-		AO_t new_tail = (exeq->tail + 1) & CUFLOW_EXEQ_MASK;
-		ent = &exeq->call_arr[new_tail];
-		fn = ent->fn;
-		cdisj = ent->cdisj;
-		cu_dlogf(_file, "DEQUEUE %p %ld %ld: fn=%p",
-			 exeq, exeq->head, exeq->tail, fn);
-		/* Atomically update tail to the benefit of
-		 * cuflow_try_sched_call. Release fence to make sure we have
-		 * read the entry before it gets overwritten by the same
-		 * function. */
-		AO_store_release(&exeq->tail, new_tail);
-		cuflow_workers_decr_pending();
-		cu_mutex_unlock(&exeq->pickup_mutex);
-		ts0->exeqpri = pri;
-		cu_call0(fn);
-		cu_dlogf(_file, "Done job %p, decrementing %p.", fn, cdisj);
-		cuflow_cdisj_sub1_release_write(cdisj);
-		cu_mutex_lock(&exeq->pickup_mutex);
+	struct cuflow_exeq_entry ent;
+	for (;;) {
+	    /* Run our own work newest first, as it would have been run without
+	     * parallelisation, before stealing the oldest work of others. */
+	    if (_exeq_pop(&ts0->exeq[pri], &ent)) {
+		_exeq_run(ts0, pri, &ent);
+		continue;
 	    }
-	    cu_mutex_unlock(&exeq->pickup_mutex);
 	    if (!is_global)
 		break;
-	    ts = cuflow_tstate_next(ts);
-	} while (ts != ts0);
+	    do
+		ts = cuflow_tstate_next(ts);
+	    while (ts != ts0 && !_exeq_steal(&ts->exeq[pri], &ent));
+	    if (ts == ts0)
+		break;
+	    _exeq_run(ts0, pri, &ent);
+	}
+    }
+    ts0->exeqpri = caller_pri;
+}
+
+cu_bool_t
+cuflowP_sched_help(void)
+{
+    cuflow_tstate_t ts0 = cuflow_tstate();
+    cuflow_exeqpri_t pri;
+    cuflow_exeqpri_t caller_pri = ts0->exeqpri;
+    struct cuflow_exeq_entry ent;
+    for (pri = cuflow_exeqpri_begin; cuflow_exeqpri_prioreq(pri, caller_pri);
+	 pri = cuflow_exeqpri_succ(pri)) {
+	cuflow_tstate_t ts;
+	if (_exeq_pop(&ts0->exeq[pri], &ent))
+	    goto found;
+	for (ts = cuflow_tstate_next(ts0); ts != ts0;
+	     ts = cuflow_tstate_next(ts))
+	    if (_exeq_steal(&ts->exeq[pri], &ent))
+		goto found;
     }
+    return cu_false;
+found:
+    _exeq_run(ts0, pri, &ent);
     ts0->exeqpri = caller_pri;
+    return cu_true;
 }
 
 #if CUFLOW_PROFILE_SCHED
@@ -155,10 +255,10 @@ cuflowP_exeq_init_tstate(cuflow_tstate_t ts)
 	 pri != cuflow_exeqpri_end;
 	 pri = cuflow_exeqpri_succ(pri)) {
 	cuflow_exeq_t exeq = &ts->exeq[pri];
-	cu_mutex_init(&exeq->pickup_mutex);
 	exeq->priority = pri;
-	exeq->head = 0;
-	exeq->tail = CUFLOW_EXEQ_MASK;
+	exeq->top = 0;
+	exeq->bottom = 0;
+	exeq->buffer = (AO_t)_exeq_buffer_new(CUFLOW_EXEQ_SIZE);
 #if CUFLOW_CALLS_BETWEEN_SCHED > 1
 	exeq->calls_till_sched = CUFLOW_CALLS_BETWEEN_SCHED;
 #endif
@@ -30,6 +30,7 @@ CU_BEGIN_DECLARATIONS
 void cuflowP_sched_call(cuflow_exeq_t exeq, cu_clop0(f, void), AO_t *cdisj);
 void cuflowP_sched_call_sub1(cuflow_exeq_t exeq, cu_clop0(f, void),
 			     AO_t *cdisj);
+cu_bool_t cuflowP_sched_help(void);
 
 #if CUFLOW_PROFILE_SCHED
 extern AO_t cuflowP_profile_sched_count;
@@ -45,6 +46,8 @@ extern AO_t cuflowP_profile_nonsched_count;
  ** a task, initialise a local \ref cuflow_cdisj_t \e guard to zero and request
  ** the subtasks with \ref cuflow_sched_call passing a reference to \e guard.
  ** Then use \ref cuflow_cdisj_wait_while to wait for the subtasks to finish.
+ ** For subtasks which compute a value, \ref cuflow_future_h
+ ** "cuflow/future.h" wraps this pattern.
  **/
 
 /** The priority at which to run work scheduled by the current thread. */
@@ -73,10 +76,10 @@ cuflow_sched_exeq(void)
     return &tstate->exeq[tstate->exeqpri];
 }
 
-/** If \a exeq queue is full, calls \a f and exits, else increments <code>\a
- ** cdisj</code> and schedules \a f for later execution, possibly by another
- ** thread.  In the latter case, <code>*\a cdisj</code> is decremented after \a
- ** f has been called.
+/** Increments <code>*\a cdisj</code> and schedules \a f for later execution,
+ ** possibly by another thread, then <code>*\a cdisj</code> is decremented
+ ** after \a f has been called.  The queue grows as needed, but if it already
+ ** holds CUFLOW_EXEQ_MAX_SIZE entries, \a f is called directly instead.
  **
  ** This function does not alter the priority of the current thread.  It's main
  ** purpose is as an optimisation of successive calls to \ref cuflow_sched_call
@@ -89,7 +92,8 @@ cuflow_sched_call_on(cu_clop0(f, void), AO_t *cdisj, cuflow_exeq_t exeq)
     if (cu_expect(!--exeq->calls_till_sched, 0)) {
 	exeq->calls_till_sched = CUFLOW_CALLS_BETWEEN_SCHED;
 #endif
-	if (cu_expect_false(exeq->head != AO_load(&exeq->tail))) {
+	if (cu_expect_true(exeq->bottom - AO_load(&exeq->top)
+			   < CUFLOW_EXEQ_MAX_SIZE)) {
 	    cuflowP_sched_call(exeq, f, cdisj);
 	    return;
 	}
@@ -125,7 +129,8 @@ cuflow_sched_call_sub1_on(cu_clop0(f, void), AO_t *cdisj, cuflow_exeq_t exeq)
     if (cu_expect(!--exeq->calls_till_sched, 0)) {
 	exeq->calls_till_sched = CUFLOW_CALLS_BETWEEN_SCHED;
 #endif
-	if (cu_expect_false(exeq->head != AO_load(&exeq->tail))) {
+	if (cu_expect_true(exeq->bottom - AO_load(&exeq->top)
+			   < CUFLOW_EXEQ_MAX_SIZE)) {
 	    cuflowP_sched_call_sub1(exeq, f, cdisj);
 	    return;
 	}
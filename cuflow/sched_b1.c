@@ -0,0 +1,101 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Measures how a fork-join workload scales with the number of threads taking
+ * part in the work-stealing scheduler.  Usage: sched_b1 [MAX_THREADS [N]] */
+
+#include <cu/test.h>
+#include <cuflow/sched.h>
+#include <cuflow/workers.h>
+#include <cuflow/time.h>
+#include <cuflow/cdisj.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define LEAF_SPIN 200
+
+static int
+_leaf_work(int n)
+{
+    int i, acc = n;
+    for (i = 0; i < LEAF_SPIN; ++i)
+	acc = acc*1103515245 + 12345;
+    return acc & 1;
+}
+
+cu_clos_def(jobS, cu_prot0(void), (int n; int r;))
+{
+    cu_clos_self(jobS);
+    jobS_t job[2];
+    AO_t cdisj = 0;
+
+    if (self->n == 0) {
+	self->r = 1 + _leaf_work(self->n);
+	return;
+    }
+    job[0].n = self->n / 2;
+    job[1].n = (self->n - 1) / 2;
+    cuflow_sched_call(jobS_prep(&job[0]), &cdisj);
+    cu_call0(jobS_prep(&job[1]));
+    cuflow_cdisj_wait_while(&cdisj);
+    self->r = job[0].r + job[1].r + 1;
+}
+
+int
+main(int argc, char **argv)
+{
+    int max_thread_count = sysconf(_SC_NPROCESSORS_ONLN);
+    int n = 0x400000;
+    int thread_count;
+    int r = -1;
+    double wt1 = 0.0;
+
+    cuflow_init();
+    if (argc > 1)
+	max_thread_count = atoi(argv[1]);
+    if (argc > 2)
+	n = atoi(argv[2]);
+    if (max_thread_count < 1)
+	max_thread_count = 1;
+
+    printf("%8s %12s %12s %10s\n", "threads", "WT total", "per call",
+	   "speedup");
+    for (thread_count = 1; thread_count <= max_thread_count; ++thread_count) {
+	jobS_t jobS;
+	cuflow_walltime_t wt;
+
+	/* The main thread takes part in the work, so spawn one less. */
+	cuflow_workers_spawn(thread_count - 1);
+
+	wt = -cuflow_walltime();
+	jobS.n = n;
+	cu_call0(jobS_prep(&jobS));
+	wt += cuflow_walltime();
+	if (thread_count == 1) {
+	    r = jobS.r;
+	    wt1 = wt;
+	}
+	cu_test_assert(jobS.r == r);
+
+	printf("%8d %12.3lg %12.3lg %10.2lf\n", thread_count,
+	       wt/(double)CUFLOW_WALLTIME_SECOND,
+	       wt/(r*(double)CUFLOW_WALLTIME_SECOND),
+	       wt1/(double)wt);
+    }
+    cuflow_workers_spawn(0);
+    return 0;
+}
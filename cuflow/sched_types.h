@@ -26,10 +26,12 @@ CU_BEGIN_DECLARATIONS
 /** \addtogroup cuflow_sched_h
  ** @{ */
 
-/* The number of entries in each thread-local execution queue.  This must be
- * a power of 2. */
-#define CUFLOW_EXEQ_SIZE 8
-#define CUFLOW_EXEQ_MASK (CUFLOW_EXEQ_SIZE - 1)
+/* The initial number of entries in each thread-local execution queue.  The
+ * queue doubles its capacity when full, up to CUFLOW_EXEQ_MAX_SIZE entries,
+ * after which further calls are run synchronously.  Both must be powers of
+ * 2. */
+#define CUFLOW_EXEQ_SIZE 32
+#define CUFLOW_EXEQ_MAX_SIZE 0x10000
 #define CUFLOW_PROFILE_SCHED 0
 #define CUFLOW_CALLS_BETWEEN_SCHED 1
 
@@ -62,16 +64,24 @@ struct cuflow_exeq_entry
     AO_t *cdisj;
 };
 
-/** An SMP workloading queue.  This is a short queue used to float work between
- ** threads.  The internal structure is private, you only need to pass it
- ** around to \ref cuflow_sched_call_on etc. as an optimisation to avoid the
- ** individual thread-local lookup of \ref cuflow_sched_call etc. */
+struct cuflowP_exeq_buffer
+{
+    AO_t mask;
+    struct cuflow_exeq_entry arr[1];
+};
+
+/** An SMP workloading queue.  This is a work-stealing deque used to float
+ ** work between threads.  The owning thread pushes and pops entries at the
+ ** bottom without locking, while other threads steal from the top.  The
+ ** internal structure is private, you only need to pass it around to \ref
+ ** cuflow_sched_call_on etc. as an optimisation to avoid the individual
+ ** thread-local lookup of \ref cuflow_sched_call etc. */
 struct cuflow_exeq
 {
-    pthread_mutex_t pickup_mutex;
+    AO_t top;		/* index of the oldest entry, advanced by thieves */
+    AO_t bottom;	/* index of the next free entry, owned by the thread */
+    AO_t buffer;	/* struct cuflowP_exeq_buffer *, replaced on growth */
     cuflow_exeqpri_t priority;
-    struct cuflow_exeq_entry call_arr[CUFLOW_EXEQ_SIZE];
-    AO_t head, tail;
 #if CUFLOW_CALLS_BETWEEN_SCHED > 1
     int calls_till_sched;
 #endif
@@ -0,0 +1,1070 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cufo/asynclog.h>
+#include <cufo/stream.h>
+#include <cufo/tagdefs.h>
+#include <cufo/attrdefs.h>
+#include <cu/logging.h>
+#include <cu/thread.h>
+#include <cu/memory.h>
+#include <cu/buffer.h>
+#include <cu/str.h>
+#include <cu/diag.h>
+#include <atomic_ops.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define DEFAULT_RING_SIZE 65536
+#define MIN_RING_SIZE 1024
+
+/* Spec text longer than this is left to the caller-side formatter. */
+#define MAX_SPEC_LEN 24
+
+#define SLOT_ALIGN(n) (((n) + sizeof(union _slot) - 1) \
+		       & ~(size_t)(sizeof(union _slot) - 1))
+
+
+/* Records
+ * ======= */
+
+typedef struct _ring *_ring_t;
+typedef struct _rec *_rec_t;
+
+/* Record kinds.  A captured record holds the format string followed by the
+ * argument slots, a text record holds the output of a caller-side format, and
+ * padding fills up the end of a ring where the next record does not fit. */
+#define REC_PAD 0
+#define REC_CAPTURED 1
+#define REC_TEXT 2
+#define REC_FLAG_FILELINE 0x100
+
+struct _rec
+{
+    uint32_t size;		/* including header, a multiple of 8 */
+    uint32_t kind;
+    AO_t seq;
+    struct _asynclog_vlogf_s *vlogf;
+    /* followed by the payload */
+};
+
+/* Each captured argument occupies one slot.  Strings use a length slot
+ * followed by the NUL-terminated characters padded to whole slots. */
+union _slot
+{
+    intmax_t i;
+    uintmax_t u;
+    double d;
+    void *p;
+    size_t n;
+    char align[8];
+};
+
+typedef enum {
+    ARG_BAD,
+    ARG_SINT,
+    ARG_UINT,
+    ARG_DOUBLE,
+    ARG_CHAR,
+    ARG_STR,
+    ARG_PTR,
+} _argtype_t;
+
+typedef enum {
+    LEN_NONE, LEN_HH, LEN_H, LEN_L, LEN_LL, LEN_J, LEN_Z, LEN_T, LEN_BIG_L,
+} _length_t;
+
+struct _spec
+{
+    char const *start;		/* the flags */
+    char const *width;
+    char const *prec;		/* NULL if absent */
+    char const *length;
+    _length_t length_mod;
+    char conv;
+    _argtype_t argtype;
+};
+
+
+/* Rings
+ * ===== */
+
+/* A single-producer single-consumer byte queue.  The owning thread advances
+ * tail and the background thread advances head.  Both are free-running
+ * offsets, masked on access. */
+struct _ring
+{
+    AO_t head;
+    char pad0[64 - sizeof(AO_t)];
+    AO_t tail;
+    AO_t orphaned;
+    char pad1[64 - 2*sizeof(AO_t)];
+
+    size_t mask;
+    char *data;
+    _ring_t next;
+
+    /* Private to the producer. */
+    struct cu_buffer scratch;
+
+    /* Private to the background thread. */
+    AO_t rd;
+    AO_t rd_end;
+};
+
+CU_SINLINE _rec_t
+_ring_at(_ring_t ring, AO_t pos)
+{
+    return (_rec_t)(ring->data + (pos & ring->mask));
+}
+
+/* Returns room for a record of size bytes at the tail of ring, or NULL if the
+ * ring is too full.  Inserts padding if the record would straddle the end. */
+static _rec_t
+_ring_reserve(_ring_t ring, size_t size)
+{
+    AO_t tail = AO_load(&ring->tail);
+    AO_t head = AO_load_acquire_read(&ring->head);
+    size_t cap = ring->mask + 1;
+    size_t off = tail & ring->mask;
+    size_t pad = off + size > cap? cap - off : 0;
+    if (tail + pad + size - head > cap)
+	return NULL;
+    if (pad) {
+	_rec_t rec = _ring_at(ring, tail);
+	rec->size = pad;
+	rec->kind = REC_PAD;
+	AO_store_release(&ring->tail, tail + pad);
+	tail += pad;
+    }
+    return _ring_at(ring, tail);
+}
+
+CU_SINLINE void
+_ring_commit(_ring_t ring, _rec_t rec)
+{
+    AO_store_release(&ring->tail, AO_load(&ring->tail) + rec->size);
+}
+
+/* Returns the first unread record in the snapshot of ring taken by the
+ * background thread, skipping padding. */
+static _rec_t
+_ring_front(_ring_t ring)
+{
+    while (ring->rd != ring->rd_end) {
+	_rec_t rec = _ring_at(ring, ring->rd);
+	if (rec->kind != REC_PAD)
+	    return rec;
+	ring->rd += rec->size;
+    }
+    return NULL;
+}
+
+
+/* The Log
+ * ======= */
+
+cu_clos_dec(_asynclog_vlogf,
+	    cu_prot(void, cu_log_facility_t facility, cu_location_t loc,
+		    char const *fmt, va_list va),
+    ( cufo_asynclog_t alog;
+      cu_log_facility_t facility;
+      AO_t queued_count;
+      AO_t dropped_count;
+      AO_t blocked_count;
+      AO_t preformatted_count;
+      AO_t sync_count;
+      _asynclog_vlogf_t *next; ));
+
+cu_clos_dec(_asynclog_binder,
+	    cu_prot(cu_bool_t, cu_log_facility_t facility),
+    ( cufo_asynclog_t alog; ));
+
+struct cufo_asynclog
+{
+    cufo_stream_t fos;
+    size_t ring_size;
+    AO_t overflow;
+    AO_t seq;
+    AO_t queued_count;
+    AO_t written_count;
+    AO_t drainer_sleeping;
+    AO_t is_closed;
+    AO_t drainer_done;
+
+    pthread_key_t ring_key;
+    _ring_t ring_chain;
+
+    /* The following are protected by mutex. */
+    pthread_mutex_t mutex;
+    pthread_cond_t wake_cond;
+    pthread_cond_t progress_cond;
+    int waiting_count;
+    cu_bool_t do_stop;
+    _asynclog_vlogf_t *vlogf_chain;
+
+    pthread_t drainer;
+    pthread_t drainer_self;
+    _asynclog_binder_t binder;
+    cufo_asynclog_t next;
+};
+
+static pthread_mutex_t _live_mutex = CU_MUTEX_INITIALISER;
+static cufo_asynclog_t _live_chain = NULL;
+
+static cu_bool_t
+_is_drainer(cufo_asynclog_t alog)
+{
+    return !AO_load(&alog->drainer_done)
+	&& pthread_equal(pthread_self(), alog->drainer_self);
+}
+
+static void
+_wake_drainer(cufo_asynclog_t alog)
+{
+    AO_nop_full();
+    if (AO_load(&alog->drainer_sleeping)) {
+	cu_mutex_lock(&alog->mutex);
+	pthread_cond_signal(&alog->wake_cond);
+	cu_mutex_unlock(&alog->mutex);
+    }
+}
+
+static void
+_ring_orphan(void *ring)
+{
+    AO_store_release(&((_ring_t)ring)->orphaned, 1);
+}
+
+static _ring_t
+_ring_for_thread(cufo_asynclog_t alog)
+{
+    _ring_t ring = pthread_getspecific(alog->ring_key);
+    if (ring)
+	return ring;
+    ring = cu_gnewz(struct _ring);
+    ring->mask = alog->ring_size - 1;
+    ring->data = cu_galloc_atomic(alog->ring_size);
+    cu_buffer_init(&ring->scratch, 256);
+    cu_mutex_lock(&alog->mutex);
+    ring->next = alog->ring_chain;
+    AO_store_release((AO_t *)&alog->ring_chain, (AO_t)ring);
+    cu_mutex_unlock(&alog->mutex);
+    cu_pthread_setspecific(alog->ring_key, ring);
+    return ring;
+}
+
+
+/* Capturing Arguments
+ * =================== */
+
+/* Parses a conversion specification starting after the '%' and returns a
+ * pointer past it.  Sets spec->argtype to ARG_BAD for anything which is not
+ * a plain printf conversion. */
+static char const *
+_parse_spec(char const *fmt, struct _spec *spec)
+{
+    spec->start = fmt;
+    while (*fmt == '-' || *fmt == '+' || *fmt == ' ' || *fmt == '#'
+	   || *fmt == '0')
+	++fmt;
+    spec->width = fmt;
+    if (*fmt == '*')
+	++fmt;
+    else
+	while (isdigit(*fmt))
+	    ++fmt;
+    if (*fmt == '.') {
+	spec->prec = ++fmt;
+	if (*fmt == '*')
+	    ++fmt;
+	else
+	    while (isdigit(*fmt))
+		++fmt;
+    }
+    else
+	spec->prec = NULL;
+    spec->length = fmt;
+    switch (*fmt) {
+	case 'h':
+	    if (*++fmt == 'h') {
+		++fmt;
+		spec->length_mod = LEN_HH;
+	    } else
+		spec->length_mod = LEN_H;
+	    break;
+	case 'l':
+	    if (*++fmt == 'l') {
+		++fmt;
+		spec->length_mod = LEN_LL;
+	    } else
+		spec->length_mod = LEN_L;
+	    break;
+	case 'j': ++fmt; spec->length_mod = LEN_J; break;
+	case 'z': ++fmt; spec->length_mod = LEN_Z; break;
+	case 't': ++fmt; spec->length_mod = LEN_T; break;
+	case 'L': ++fmt; spec->length_mod = LEN_BIG_L; break;
+	default: spec->length_mod = LEN_NONE; break;
+    }
+    spec->conv = *fmt;
+    switch (*fmt) {
+	case 'd': case 'i':
+	    spec->argtype = spec->length_mod == LEN_BIG_L? ARG_BAD : ARG_SINT;
+	    break;
+	case 'o': case 'u': case 'x': case 'X':
+	    spec->argtype = spec->length_mod == LEN_BIG_L? ARG_BAD : ARG_UINT;
+	    break;
+	case 'e': case 'E': case 'f': case 'F':
+	case 'g': case 'G': case 'a': case 'A':
+	    spec->argtype = spec->length_mod == LEN_NONE
+			 || spec->length_mod == LEN_L? ARG_DOUBLE : ARG_BAD;
+	    break;
+	case 'c':
+	    spec->argtype = spec->length_mod == LEN_NONE? ARG_CHAR : ARG_BAD;
+	    break;
+	case 's':
+	    spec->argtype = spec->length_mod == LEN_NONE? ARG_STR : ARG_BAD;
+	    break;
+	case 'p':
+	    spec->argtype = spec->length_mod == LEN_NONE? ARG_PTR : ARG_BAD;
+	    break;
+	default:
+	    spec->argtype = ARG_BAD;
+	    return fmt;
+    }
+    if (fmt - spec->start > MAX_SPEC_LEN)
+	spec->argtype = ARG_BAD;
+    return fmt + 1;
+}
+
+CU_SINLINE void
+_put_slot(cu_buffer_t buf, union _slot slot)
+{
+    memcpy(cu_buffer_produce(buf, sizeof(union _slot)), &slot,
+	   sizeof(union _slot));
+}
+
+CU_SINLINE void
+_put_int(cu_buffer_t buf, intmax_t i)
+{
+    union _slot slot;
+    slot.i = i;
+    _put_slot(buf, slot);
+}
+
+/* Copies s, or its first prec characters if prec is non-negative, since
+ * the caller may pass an array which is not NUL-terminated. */
+static void
+_put_str(cu_buffer_t buf, char const *s, int prec)
+{
+    union _slot slot;
+    size_t size;
+    char *dst;
+    if (!s)
+	s = "(null)";
+    slot.n = prec >= 0? strnlen(s, prec) : strlen(s);
+    size = SLOT_ALIGN(slot.n + 1);
+    _put_slot(buf, slot);
+    dst = cu_buffer_produce(buf, size);
+    memcpy(dst, s, slot.n);
+    memset(dst + slot.n, 0, size - slot.n);
+}
+
+/* Copies fmt and the arguments it refers to into buf.  Returns false if fmt
+ * contains a conversion which must be handled by libcufo. */
+static cu_bool_t
+_capture(cu_buffer_t buf, char const *fmt, va_list va)
+{
+    struct _spec spec;
+    union _slot slot;
+    char const *s;
+    int prec;
+
+    for (s = fmt; *s; ) {
+	if (*s++ != '%')
+	    continue;
+	if (*s == '%') {
+	    ++s;
+	    continue;
+	}
+	s = _parse_spec(s, &spec);
+	if (spec.argtype == ARG_BAD)
+	    return cu_false;
+	if (*spec.width == '*')
+	    _put_int(buf, va_arg(va, int));
+	if (!spec.prec)
+	    prec = -1;
+	else if (*spec.prec == '*') {
+	    prec = va_arg(va, int);
+	    _put_int(buf, prec);
+	}
+	else
+	    prec = atoi(spec.prec);
+	switch (spec.argtype) {
+	    case ARG_SINT:
+		switch (spec.length_mod) {
+		    case LEN_HH: slot.i = (signed char)va_arg(va, int); break;
+		    case LEN_H:	 slot.i = (short)va_arg(va, int); break;
+		    case LEN_L:	 slot.i = va_arg(va, long); break;
+		    case LEN_LL: slot.i = va_arg(va, long long); break;
+		    case LEN_J:	 slot.i = va_arg(va, intmax_t); break;
+		    case LEN_Z:	 slot.i = (ssize_t)va_arg(va, size_t); break;
+		    case LEN_T:	 slot.i = va_arg(va, ptrdiff_t); break;
+		    default:	 slot.i = va_arg(va, int); break;
+		}
+		break;
+	    case ARG_UINT:
+		switch (spec.length_mod) {
+		    case LEN_HH:
+			slot.u = (unsigned char)va_arg(va, unsigned int);
+			break;
+		    case LEN_H:
+			slot.u = (unsigned short)va_arg(va, unsigned int);
+			break;
+		    case LEN_L:	 slot.u = va_arg(va, unsigned long); break;
+		    case LEN_LL:
+			slot.u = va_arg(va, unsigned long long);
+			break;
+		    case LEN_J:	 slot.u = va_arg(va, uintmax_t); break;
+		    case LEN_Z:	 slot.u = va_arg(va, size_t); break;
+		    case LEN_T:	 slot.u = (size_t)va_arg(va, ptrdiff_t); break;
+		    default:	 slot.u = va_arg(va, unsigned int); break;
+		}
+		break;
+	    case ARG_DOUBLE:
+		slot.d = va_arg(va, double);
+		break;
+	    case ARG_CHAR:
+		slot.i = va_arg(va, int);
+		break;
+	    case ARG_PTR:
+		slot.p = va_arg(va, void *);
+		break;
+	    case ARG_STR:
+		_put_str(buf, va_arg(va, char const *), prec);
+		continue;
+	    default:
+		cu_debug_unreachable();
+	}
+	_put_slot(buf, slot);
+    }
+    return cu_true;
+}
+
+/* Captures a complete entry into buf, including the source location of
+ * debug facilities.  The format string comes first, so that the background
+ * thread can find the slots. */
+static cu_bool_t
+_capture_entry(cu_buffer_t buf, cu_log_facility_t facility,
+	       char const *fmt, va_list va, uint32_t *kind_out)
+{
+    char const *file = NULL;
+    int line = 0;
+    size_t fmt_len, fmt_size;
+    char *dst;
+
+    *kind_out = REC_CAPTURED;
+    if (facility->flags & CU_LOG_FLAG_DEBUG_FACILITY) {
+	file = va_arg(va, char const *);
+	line = va_arg(va, int);
+	if (fmt[0] == '%' && fmt[1] == '~' && fmt[2] == ':')
+	    fmt += 3;
+	else
+	    *kind_out |= REC_FLAG_FILELINE;
+    }
+    if (fmt[0] == '%' && (fmt[1] == ':' || (fmt[1] == 'h' && fmt[2] == ':')))
+	return cu_false;
+
+    fmt_len = strlen(fmt);
+    fmt_size = SLOT_ALIGN(fmt_len + 1);
+    dst = cu_buffer_produce(buf, fmt_size);
+    memcpy(dst, fmt, fmt_len);
+    memset(dst + fmt_len, 0, fmt_size - fmt_len);
+    if (*kind_out & REC_FLAG_FILELINE) {
+	_put_str(buf, file, -1);
+	_put_int(buf, line);
+    }
+    return _capture(buf, fmt, va);
+}
+
+/* Formats an entry on the calling thread, leaving out the markup. */
+static void
+_preformat_entry(cu_buffer_t buf, cu_log_facility_t facility,
+		 cu_location_t loc, char const *fmt, va_list va)
+{
+    cufo_stream_t fos;
+    cu_str_t str;
+    size_t len, size;
+    char *dst;
+
+    fos = cufo_open_strip_str();
+    cufo_vlogf_at(fos, facility, loc, fmt, va);
+    str = cu_unbox_ptr(cu_str_t, cufo_close(fos));
+    len = cu_str_size(str);
+    if (len > 0 && cu_str_charr(str)[len - 1] == '\n')
+	--len;
+    size = SLOT_ALIGN(len + 1);
+    dst = cu_buffer_produce(buf, size);
+    memcpy(dst, cu_str_charr(str), len);
+    memset(dst + len, 0, size - len);
+}
+
+
+/* Writing Records
+ * =============== */
+
+/* Reconstructs the conversion spec with any '*' replaced by the captured
+ * values and integers widened to intmax_t. */
+static union _slot const *
+_build_spec(char *out, struct _spec *spec, union _slot const *arg)
+{
+    char const *s = spec->start;
+    *out++ = '%';
+    while (s < spec->width)
+	*out++ = *s++;
+    if (*s == '*') {
+	out += sprintf(out, "%d", (int)arg++->i);
+	++s;
+    }
+    while (s < (spec->prec? spec->prec : spec->length))
+	*out++ = *s++;
+    if (spec->prec) {
+	if (*s == '*') {
+	    int prec = (int)arg++->i;
+	    if (prec >= 0)
+		out += sprintf(out, "%d", prec);
+	    else
+		--out; /* negative precision is taken as omitted */
+	}
+	else
+	    while (s < spec->length)
+		*out++ = *s++;
+    }
+    if (spec->argtype == ARG_SINT || spec->argtype == ARG_UINT)
+	*out++ = 'j';
+    *out++ = spec->conv;
+    *out = 0;
+    return arg;
+}
+
+static void
+_replay(cufo_stream_t fos, char const *fmt, union _slot const *arg)
+{
+    char spec_fmt[MAX_SPEC_LEN + 32];
+    struct _spec spec;
+    char const *s;
+
+    while (*fmt) {
+	for (s = fmt; *fmt && *fmt != '%'; ++fmt);
+	if (fmt != s)
+	    cufo_print_charr(fos, s, fmt - s);
+	if (!*fmt)
+	    break;
+	if (fmt[1] == '%') {
+	    cufo_putc(fos, '%');
+	    fmt += 2;
+	    continue;
+	}
+	fmt = _parse_spec(fmt + 1, &spec);
+	arg = _build_spec(spec_fmt, &spec, arg);
+	switch (spec.argtype) {
+	    case ARG_SINT:
+		cufo_printf(fos, spec_fmt, arg->i);
+		break;
+	    case ARG_UINT:
+		cufo_printf(fos, spec_fmt, arg->u);
+		break;
+	    case ARG_DOUBLE:
+		cufo_printf(fos, spec_fmt, arg->d);
+		break;
+	    case ARG_CHAR:
+		cufo_printf(fos, spec_fmt, (int)arg->i);
+		break;
+	    case ARG_PTR:
+		cufo_printf(fos, spec_fmt, arg->p);
+		break;
+	    case ARG_STR:
+		cufo_printf(fos, spec_fmt, (char const *)(arg + 1));
+		arg += SLOT_ALIGN(arg->n + 1)/sizeof(union _slot);
+		break;
+	    default:
+		cu_debug_unreachable();
+	}
+	++arg;
+    }
+}
+
+static void
+_write_rec(cufo_stream_t fos, _rec_t rec)
+{
+    cu_log_facility_t facility = rec->vlogf->facility;
+    char const *payload = (char const *)(rec + 1);
+
+    cufo_entera(fos, cufoT_logentry,
+		cufoA_logorigin(cu_log_facility_origin(facility)),
+		cufoA_logseverity(cu_log_facility_severity(facility)));
+    if ((rec->kind & 0xff) == REC_TEXT)
+	cufo_puts(fos, payload);
+    else {
+	union _slot const *arg;
+	arg = (union _slot const *)(payload + SLOT_ALIGN(strlen(payload) + 1));
+	if (rec->kind & REC_FLAG_FILELINE) {
+	    char const *file = (char const *)(arg + 1);
+	    arg += 1 + SLOT_ALIGN(arg->n + 1)/sizeof(union _slot);
+	    cufo_printf(fos, "%<%s:%d: %>", cufoT_location, file, (int)arg->i);
+	    ++arg;
+	}
+	cufo_enter(fos, cufoT_message);
+	_replay(fos, payload, arg);
+	cufo_leave(fos, cufoT_message);
+    }
+    cufo_leaveln(fos, cufoT_logentry);
+}
+
+
+/* The Background Thread
+ * ===================== */
+
+/* Writes the records which are committed to the rings at the time of the
+ * call, interleaved by sequence number. */
+static void
+_drain(cufo_asynclog_t alog)
+{
+    _ring_t ring_chain, ring, best_ring = NULL;
+    AO_t written = AO_load(&alog->written_count);
+    cu_bool_t have_lock = cu_false;
+
+    ring_chain = (_ring_t)AO_load_acquire_read((AO_t *)&alog->ring_chain);
+    for (ring = ring_chain; ring; ring = ring->next)
+	ring->rd_end = AO_load_acquire_read(&ring->tail);
+    for (;;) {
+	_rec_t best = NULL;
+	for (ring = ring_chain; ring; ring = ring->next) {
+	    _rec_t rec = _ring_front(ring);
+	    if (rec && (!best || (long)(rec->seq - best->seq) < 0)) {
+		best = rec;
+		best_ring = ring;
+	    }
+	}
+	if (!best)
+	    break;
+	if (!have_lock) {
+	    cufo_lock(alog->fos);
+	    have_lock = cu_true;
+	}
+	_write_rec(alog->fos, best);
+	best_ring->rd += best->size;
+	AO_store_release(&best_ring->head, best_ring->rd);
+	++written;
+    }
+    for (ring = ring_chain; ring; ring = ring->next)
+	AO_store_release(&ring->head, ring->rd);
+    if (have_lock) {
+	cufo_flush(alog->fos);
+	cufo_unlock(alog->fos);
+	AO_store_release(&alog->written_count, written);
+    }
+}
+
+static cu_bool_t
+_is_empty(cufo_asynclog_t alog)
+{
+    _ring_t ring;
+    for (ring = alog->ring_chain; ring; ring = ring->next)
+	if (AO_load(&ring->tail) != ring->rd)
+	    return cu_false;
+    return cu_true;
+}
+
+/* Unlinks the rings of terminated threads once they are drained.  Called
+ * with the mutex held. */
+static void
+_collect_orphans(cufo_asynclog_t alog)
+{
+    _ring_t *ring_ref = &alog->ring_chain;
+    while (*ring_ref) {
+	_ring_t ring = *ring_ref;
+	if (AO_load_acquire_read(&ring->orphaned)
+		&& AO_load(&ring->tail) == ring->rd)
+	    *ring_ref = ring->next;
+	else
+	    ring_ref = &ring->next;
+    }
+}
+
+/* Writes records committed by a producer which passed the is_closed check
+ * before the log was closed, but committed after the final drain.  Drains
+ * after the drainer is joined are serialised by the mutex. */
+static void
+_drain_closed(cufo_asynclog_t alog)
+{
+    cu_mutex_lock(&alog->mutex);
+    while (!AO_load(&alog->drainer_done))
+	pthread_cond_wait(&alog->progress_cond, &alog->mutex);
+    _drain(alog);
+    cu_mutex_unlock(&alog->mutex);
+}
+
+static void *
+_drainer_main(void *alog_ptr)
+{
+    cufo_asynclog_t alog = alog_ptr;
+    alog->drainer_self = pthread_self();
+    for (;;) {
+	_drain(alog);
+	cu_mutex_lock(&alog->mutex);
+	if (alog->waiting_count)
+	    pthread_cond_broadcast(&alog->progress_cond);
+	_collect_orphans(alog);
+	AO_store(&alog->drainer_sleeping, 1);
+	AO_nop_full();
+	if (_is_empty(alog)) {
+	    if (alog->do_stop) {
+		cu_mutex_unlock(&alog->mutex);
+		break;
+	    }
+	    pthread_cond_wait(&alog->wake_cond, &alog->mutex);
+	}
+	AO_store(&alog->drainer_sleeping, 0);
+	cu_mutex_unlock(&alog->mutex);
+    }
+    return NULL;
+}
+
+
+/* The Facility Callback
+ * ===================== */
+
+/* Writes a record directly to the stream after the queue.  The bug-facility
+ * and the background thread itself must not wait for the stream lock, cf.
+ * _default_vlogf_bug in init.c. */
+static void
+_vlogf_sync(_asynclog_vlogf_t *self, cu_log_facility_t facility,
+	    cu_location_t loc, char const *fmt, va_list va)
+{
+    cufo_asynclog_t alog = self->alog;
+    cu_bool_t on_drainer = _is_drainer(alog);
+
+    if (!on_drainer)
+	cufo_asynclog_flush(alog);
+    AO_fetch_and_add1(&self->sync_count);
+    if (on_drainer
+	    || (cu_log_facility_severity(facility) == CU_LOG_FAILURE &&
+		cu_log_facility_origin(facility) == CU_LOG_LOGIC)) {
+	if (pthread_mutex_trylock(&alog->fos->mutex) == 0) {
+	    cufo_vlogf_at(alog->fos, facility, loc, fmt, va);
+	    cufo_unlock(alog->fos);
+	} else {
+	    vfprintf(stderr, fmt, va);
+	    fputc('\n', stderr);
+	}
+    }
+    else {
+	cufo_lock(alog->fos);
+	cufo_vlogf_at(alog->fos, facility, loc, fmt, va);
+	cufo_unlock(alog->fos);
+    }
+}
+
+/* Reserves space for a record of the given size, or returns NULL if the
+ * record is dropped or the log is closed while waiting.  In the latter case
+ * *closed_out is set, and the caller must write the record directly. */
+static _rec_t
+_reserve_or_wait(_asynclog_vlogf_t *self, _ring_t ring, size_t size,
+		 cu_bool_t *closed_out)
+{
+    cufo_asynclog_t alog = self->alog;
+    _rec_t rec = _ring_reserve(ring, size);
+    *closed_out = cu_false;
+    if (rec)
+	return rec;
+    if (AO_load(&alog->overflow) == CUFO_ASYNCLOG_DROP) {
+	AO_fetch_and_add1(&self->dropped_count);
+	return NULL;
+    }
+    AO_fetch_and_add1(&self->blocked_count);
+    cu_mutex_lock(&alog->mutex);
+    ++alog->waiting_count;
+    while (!(rec = _ring_reserve(ring, size))
+	   && !AO_load(&alog->is_closed)) {
+	pthread_cond_signal(&alog->wake_cond);
+	pthread_cond_wait(&alog->progress_cond, &alog->mutex);
+    }
+    --alog->waiting_count;
+    cu_mutex_unlock(&alog->mutex);
+    *closed_out = !rec;
+    return rec;
+}
+
+/* Writes the record in the scratch buffer of ring directly to the stream,
+ * after the records already queued. */
+static void
+_write_direct(_asynclog_vlogf_t *self, _ring_t ring, uint32_t kind,
+	      size_t size)
+{
+    cufo_asynclog_t alog = self->alog;
+    _rec_t rec = cu_galloc_atomic(size);
+    rec->size = size;
+    rec->kind = kind;
+    rec->vlogf = self;
+    memcpy(rec + 1, cu_buffer_content_start(&ring->scratch),
+	   size - sizeof(struct _rec));
+    cufo_asynclog_flush(alog);
+    AO_fetch_and_add1(&self->sync_count);
+    cufo_lock(alog->fos);
+    _write_rec(alog->fos, rec);
+    cufo_flush(alog->fos);
+    cufo_unlock(alog->fos);
+}
+
+cu_clos_fun(_asynclog_vlogf,
+	    cu_prot(void, cu_log_facility_t facility, cu_location_t loc,
+		    char const *fmt, va_list va))
+{
+    cu_clos_self(_asynclog_vlogf);
+    cufo_asynclog_t alog = self->alog;
+    _ring_t ring;
+    _rec_t rec;
+    va_list va_fmt;
+    uint32_t kind;
+    size_t size;
+    cu_bool_t captured, closed;
+
+    if (cu_log_facility_severity(facility) == CU_LOG_FAILURE
+	    || AO_load(&alog->is_closed) || _is_drainer(alog)) {
+	_vlogf_sync(self, facility, loc, fmt, va);
+	return;
+    }
+
+    ring = _ring_for_thread(alog);
+    cu_buffer_clear(&ring->scratch);
+    va_copy(va_fmt, va);
+    captured = !loc && _capture_entry(&ring->scratch, facility, fmt, va,
+				      &kind);
+    if (!captured) {
+	cu_buffer_clear(&ring->scratch);
+	_preformat_entry(&ring->scratch, facility, loc, fmt, va_fmt);
+	kind = REC_TEXT;
+    }
+    va_end(va_fmt);
+
+    size = sizeof(struct _rec) + cu_buffer_content_size(&ring->scratch);
+    if (size > (ring->mask + 1)/2) {
+	/* Too large to queue; write the captured copy in order instead. */
+	_write_direct(self, ring, kind, size);
+	return;
+    }
+
+    rec = _reserve_or_wait(self, ring, size, &closed);
+    if (!rec) {
+	if (closed)
+	    _write_direct(self, ring, kind, size);
+	return;
+    }
+    rec->size = size;
+    rec->kind = kind;
+    rec->vlogf = self;
+    memcpy(rec + 1, cu_buffer_content_start(&ring->scratch),
+	   size - sizeof(struct _rec));
+    rec->seq = AO_fetch_and_add1(&alog->seq);
+    _ring_commit(ring, rec);
+    AO_fetch_and_add1(&alog->queued_count);
+    AO_fetch_and_add1(&self->queued_count);
+    if (!captured)
+	AO_fetch_and_add1(&self->preformatted_count);
+    _wake_drainer(alog);
+
+    /* If the log was closed after our is_closed check above, the final drain
+     * may have missed the record.  Pairs with the barrier in close. */
+    AO_nop_full();
+    if (AO_load(&alog->is_closed))
+	_drain_closed(alog);
+}
+
+cu_clos_fun(_asynclog_binder, cu_prot(cu_bool_t, cu_log_facility_t facility))
+{
+    cu_clos_self(_asynclog_binder);
+    cufo_asynclog_t alog = self->alog;
+    _asynclog_vlogf_t *vlogf = cu_gnewz(_asynclog_vlogf_t);
+    vlogf->alog = alog;
+    vlogf->facility = facility;
+    cu_mutex_lock(&alog->mutex);
+    vlogf->next = alog->vlogf_chain;
+    alog->vlogf_chain = vlogf;
+    cu_mutex_unlock(&alog->mutex);
+    facility->vlogf = _asynclog_vlogf_prep(vlogf);
+    return cu_true;
+}
+
+
+/* Public Interface
+ * ================ */
+
+static void
+_close_all_live(void)
+{
+    for (;;) {
+	cufo_asynclog_t alog;
+	cu_mutex_lock(&_live_mutex);
+	alog = _live_chain;
+	cu_mutex_unlock(&_live_mutex);
+	if (!alog)
+	    break;
+	cufo_asynclog_close(alog);
+    }
+}
+
+cufo_asynclog_t
+cufo_asynclog_new(cufo_stream_t fos, size_t ring_size,
+		  cufo_asynclog_overflow_t overflow)
+{
+    static cu_bool_t done_atexit = cu_false;
+    cufo_asynclog_t alog = cu_gnewz(struct cufo_asynclog);
+    size_t size;
+
+    if (ring_size == 0)
+	ring_size = DEFAULT_RING_SIZE;
+    for (size = MIN_RING_SIZE; size < ring_size; size *= 2);
+    alog->fos = fos;
+    alog->ring_size = size;
+    alog->overflow = overflow;
+    cu_pthread_key_create(&alog->ring_key, _ring_orphan);
+    cu_mutex_init(&alog->mutex);
+    pthread_cond_init(&alog->wake_cond, NULL);
+    pthread_cond_init(&alog->progress_cond, NULL);
+    alog->binder.alog = alog;
+
+    cu_mutex_lock(&_live_mutex);
+    alog->next = _live_chain;
+    _live_chain = alog;
+    if (!done_atexit) {
+	atexit(_close_all_live);
+	done_atexit = cu_true;
+    }
+    cu_mutex_unlock(&_live_mutex);
+
+    if (cu_pthread_create(&alog->drainer, NULL, _drainer_main, alog) != 0)
+	cu_bugf("Failed to create the thread of an asynchronous log.");
+    return alog;
+}
+
+cu_log_binder_t
+cufo_asynclog_binder(cufo_asynclog_t alog)
+{
+    return _asynclog_binder_prep(&alog->binder);
+}
+
+cufo_asynclog_overflow_t
+cufo_asynclog_overflow(cufo_asynclog_t alog)
+{
+    return (cufo_asynclog_overflow_t)AO_load(&alog->overflow);
+}
+
+void
+cufo_asynclog_set_overflow(cufo_asynclog_t alog,
+			   cufo_asynclog_overflow_t overflow)
+{
+    AO_store(&alog->overflow, overflow);
+}
+
+void
+cufo_asynclog_flush(cufo_asynclog_t alog)
+{
+    AO_t target = AO_load_acquire_read(&alog->queued_count);
+    if (_is_drainer(alog))
+	return;
+    cu_mutex_lock(&alog->mutex);
+    ++alog->waiting_count;
+    while ((long)(AO_load_acquire_read(&alog->written_count) - target) < 0
+	   && !AO_load(&alog->drainer_done)) {
+	pthread_cond_signal(&alog->wake_cond);
+	pthread_cond_wait(&alog->progress_cond, &alog->mutex);
+    }
+    --alog->waiting_count;
+    cu_mutex_unlock(&alog->mutex);
+}
+
+void
+cufo_asynclog_close(cufo_asynclog_t alog)
+{
+    cufo_asynclog_t *alog_ref;
+
+    cu_mutex_lock(&_live_mutex);
+    for (alog_ref = &_live_chain; *alog_ref; alog_ref = &(*alog_ref)->next)
+	if (*alog_ref == alog) {
+	    *alog_ref = alog->next;
+	    break;
+	}
+    cu_mutex_unlock(&_live_mutex);
+    if (!AO_compare_and_swap_full(&alog->is_closed, 0, 1))
+	return;
+
+    /* From here new records are written directly.  Records committed by
+     * producers which passed the is_closed check earlier are written by the
+     * drainer, by the final drain below, or by the producer itself. */
+    cu_mutex_lock(&alog->mutex);
+    alog->do_stop = cu_true;
+    pthread_cond_signal(&alog->wake_cond);
+    cu_mutex_unlock(&alog->mutex);
+    cu_pthread_join(alog->drainer, NULL);
+
+    cu_mutex_lock(&alog->mutex);
+    _drain(alog);
+    AO_store(&alog->drainer_done, 1);
+    pthread_cond_broadcast(&alog->progress_cond);
+    cu_mutex_unlock(&alog->mutex);
+    pthread_key_delete(alog->ring_key);
+}
+
+cu_bool_t
+cufo_asynclog_facility_stats(cu_log_facility_t facility,
+			     struct cufo_asynclog_stats *stats_out)
+{
+    _asynclog_vlogf_t *vlogf, probe;
+    _asynclog_vlogf_init(&probe);
+    if (!facility->vlogf || *facility->vlogf != probe.cuL_fn)
+	return cu_false;
+    vlogf = (_asynclog_vlogf_t *)facility->vlogf;
+    stats_out->queued_count = AO_load(&vlogf->queued_count);
+    stats_out->dropped_count = AO_load(&vlogf->dropped_count);
+    stats_out->blocked_count = AO_load(&vlogf->blocked_count);
+    stats_out->preformatted_count = AO_load(&vlogf->preformatted_count);
+    stats_out->sync_count = AO_load(&vlogf->sync_count);
+    return cu_true;
+}
+
+void
+cufo_asynclog_stats(cufo_asynclog_t alog,
+		    struct cufo_asynclog_stats *stats_out)
+{
+    _asynclog_vlogf_t *vlogf;
+    memset(stats_out, 0, sizeof(struct cufo_asynclog_stats));
+    cu_mutex_lock(&alog->mutex);
+    for (vlogf = alog->vlogf_chain; vlogf; vlogf = vlogf->next) {
+	stats_out->queued_count += AO_load(&vlogf->queued_count);
+	stats_out->dropped_count += AO_load(&vlogf->dropped_count);
+	stats_out->blocked_count += AO_load(&vlogf->blocked_count);
+	stats_out->preformatted_count += AO_load(&vlogf->preformatted_count);
+	stats_out->sync_count += AO_load(&vlogf->sync_count);
+    }
+    cu_mutex_unlock(&alog->mutex);
+}
@@ -0,0 +1,124 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CUFO_ASYNCLOG_H
+#define CUFO_ASYNCLOG_H
+
+#include <cufo/fwd.h>
+#include <cu/logging.h>
+
+CU_BEGIN_DECLARATIONS
+/** \defgroup cufo_asynclog_h cufo/asynclog.h: Asynchronous Logging
+ ** @{ \ingroup cufo_mod
+ **
+ ** An asynchronous log moves the formatting and output of log records off
+ ** the calling threads.  Each thread which logs gets a private lock-free
+ ** ring buffer, into which it copies the format string and the arguments of
+ ** each record.  A background thread drains the rings, merging them in the
+ ** order the records were committed, and formats the records on the
+ ** underlying \ref cufo_stream_t.
+ **
+ ** Conversions handled by \c printf are captured as raw arguments and
+ ** formatted later.  Records which use \c libcufo specific conversions, or
+ ** which are given an explicit location, are formatted to a string on the
+ ** calling thread before they are queued.  Records of \ref CU_LOG_FAILURE
+ ** facilities are written synchronously after the queue is flushed, since
+ ** the program may not survive long enough for the background thread to
+ ** pick them up.
+ **
+ ** Typical use is
+ ** \code
+ ** cufo_asynclog_t alog;
+ ** alog = cufo_asynclog_new(cufo_stderr, 0, CUFO_ASYNCLOG_BLOCK);
+ ** cu_register_log_binder(cufo_asynclog_binder(alog));
+ ** \endcode
+ ** Pending records are written when \ref cufo_asynclog_close is called, or
+ ** at the latest on normal program exit. */
+
+/** What to do when a ring buffer is full. */
+typedef enum {
+    CUFO_ASYNCLOG_DROP,	 /**< Discard the record and count it. */
+    CUFO_ASYNCLOG_BLOCK, /**< Wait for the background thread to make room. */
+} cufo_asynclog_overflow_t;
+
+/** Counters for the records passed to a facility bound to an asynchronous
+ ** log, or for all such facilities. */
+struct cufo_asynclog_stats
+{
+    /** The number of records queued for the background thread. */
+    unsigned long queued_count;
+
+    /** The number of records discarded due to a full ring buffer. */
+    unsigned long dropped_count;
+
+    /** The number of times a caller had to wait for free space. */
+    unsigned long blocked_count;
+
+    /** The number of queued records which were formatted by the caller. */
+    unsigned long preformatted_count;
+
+    /** The number of records written synchronously by the caller. */
+    unsigned long sync_count;
+};
+
+/** Creates an asynchronous log writing to \a fos, and starts its background
+ ** thread.  Each logging thread will allocate a ring buffer of \a ring_size
+ ** bytes, rounded up to a power of 2, or 64 KiB if \a ring_size is 0.
+ ** Records larger than half the ring are written synchronously.  \a overflow
+ ** determines what happens when a ring buffer is full.
+ **
+ ** \a fos is not closed by the log.  If other code writes to it directly,
+ ** it must hold \ref cufo_lock to avoid interleaving with the background
+ ** thread. */
+cufo_asynclog_t cufo_asynclog_new(cufo_stream_t fos, size_t ring_size,
+				  cufo_asynclog_overflow_t overflow);
+
+/** Returns a log binder which directs all facilities to \a alog.  Pass it
+ ** to \ref cu_register_log_binder. */
+cu_log_binder_t cufo_asynclog_binder(cufo_asynclog_t alog);
+
+/** Returns the current overflow policy of \a alog. */
+cufo_asynclog_overflow_t cufo_asynclog_overflow(cufo_asynclog_t alog);
+
+/** Changes the overflow policy of \a alog. */
+void cufo_asynclog_set_overflow(cufo_asynclog_t alog,
+				cufo_asynclog_overflow_t overflow);
+
+/** Waits until all records which were queued when this function was called
+ ** have been written to the underlying stream. */
+void cufo_asynclog_flush(cufo_asynclog_t alog);
+
+/** Writes all pending records and stops the background thread.  Facilities
+ ** which are still bound to \a alog will write synchronously to its stream
+ ** afterwards.  No thread may log to \a alog while this function runs.  Open
+ ** logs are closed automatically on normal program exit. */
+void cufo_asynclog_close(cufo_asynclog_t alog);
+
+/** If \a facility is bound to an asynchronous log, stores its counters in
+ ** \a stats_out and returns true, otherwise returns false. */
+cu_bool_t cufo_asynclog_facility_stats(cu_log_facility_t facility,
+				       struct cufo_asynclog_stats *stats_out);
+
+/** Stores the sum of the counters of all facilities which have been bound
+ ** to \a alog in \a stats_out. */
+void cufo_asynclog_stats(cufo_asynclog_t alog,
+			 struct cufo_asynclog_stats *stats_out);
+
+/** @} */
+CU_END_DECLARATIONS
+
+#endif
@@ -0,0 +1,269 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cufo/asynclog.h>
+#include <cufo/stream.h>
+#include <cufo/tagdefs.h>
+#include <cu/logging.h>
+#include <cu/thread.h>
+#include <cu/test.h>
+#include <cu/str.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define THREAD_COUNT 4
+#define RECORD_COUNT 5000
+
+static struct cu_log_facility _info_facility = {
+    .origin = CU_LOG_USER,
+    .severity = CU_LOG_INFO,
+};
+static struct cu_log_facility _debug_facility = {
+    .origin = CU_LOG_LOGIC,
+    .severity = CU_LOG_DEBUG,
+    .flags = CU_LOG_FLAG_DEBUG_FACILITY,
+};
+static struct cu_log_facility _failure_facility = {
+    .origin = CU_LOG_SYSTEM,
+    .severity = CU_LOG_FAILURE,
+};
+
+static void
+_bind(cufo_asynclog_t alog, cu_log_facility_t facility)
+{
+    cu_call(cufo_asynclog_binder(alog), facility);
+}
+
+static char *
+_close_str(cufo_stream_t fos)
+{
+    cu_str_t str = cu_unbox_ptr(cu_str_t, cufo_close(fos));
+    char *s = malloc(cu_str_size(str) + 1);
+    memcpy(s, cu_str_charr(str), cu_str_size(str));
+    s[cu_str_size(str)] = 0;
+    return s;
+}
+
+/* Log the same record asynchronously and directly to a reference stream. */
+#define LOGF_BOTH(facility, ...)					\
+    do {								\
+	cu_logf(facility, __VA_ARGS__);					\
+	cufo_logf(fos_ref, facility, __VA_ARGS__);			\
+    } while (0)
+
+static void
+_test_formats(void)
+{
+    cufo_stream_t fos = cufo_open_strip_str();
+    cufo_stream_t fos_ref = cufo_open_strip_str();
+    cufo_asynclog_t alog;
+    struct cufo_asynclog_stats stats;
+    char *out, *out_ref;
+    char unterminated[4] = {'w', 'x', 'y', 'z'};
+    int line = __LINE__;
+
+    alog = cufo_asynclog_new(fos, 0, CUFO_ASYNCLOG_BLOCK);
+    _bind(alog, &_info_facility);
+    _bind(alog, &_debug_facility);
+
+    LOGF_BOTH(&_info_facility, "Plain text.");
+    LOGF_BOTH(&_info_facility, "%d %i %5d|%-5d|%05d %+d % d",
+	      -17, 42, 7, 7, 7, 7, 7);
+    LOGF_BOTH(&_info_facility, "%hhd %hhu %hd %hu", 300, 300, 70000, 70000);
+    LOGF_BOTH(&_info_facility, "%ld %lu %lld %llx %jd %zu %td",
+	      -1L, 3000000000UL, -5000000000LL, 0xfedcba9876ULL,
+	      (intmax_t)-3, (size_t)99, (ptrdiff_t)-4);
+    LOGF_BOTH(&_info_facility, "%x %X %#o %#x %o", 255, 255, 8, 8, 8);
+    LOGF_BOTH(&_info_facility, "%*d|%-*d|%.*f|%*.*s|%*d|",
+	      6, 1, 6, 1, 3, 3.14159, 8, 3, "abcdef", -4, 2);
+    LOGF_BOTH(&_info_facility, "%.*f %.3e %g %G %10.3f",
+	      -1, 2.5, 12345.678, 0.0001, 1e20, -1.5);
+    LOGF_BOTH(&_info_facility, "%c%c%c %5c|%-3c|", 'a', 'b', 'c', 'd', 'e');
+    LOGF_BOTH(&_info_facility, "%s|%10s|%-10s|%.2s|%s|",
+	      "x", "right", "left", "truncate", "");
+    LOGF_BOTH(&_info_facility, "%.*s|%.3s|%.0s|",
+	      4, unterminated, unterminated, unterminated);
+    LOGF_BOTH(&_info_facility, "%p", (void *)&line);
+    LOGF_BOTH(&_info_facility, "%% literal %%%d%%", 5);
+    LOGF_BOTH(&_info_facility, "%<emphasised%> text", cufoT_emph);
+    LOGF_BOTH(&_debug_facility, "Debug record %d.", __FILE__, line, 1);
+    LOGF_BOTH(&_debug_facility, "%~:Debug record %d.", __FILE__, line, 2);
+
+    cufo_asynclog_close(alog);
+    cu_test_assert(cufo_asynclog_facility_stats(&_info_facility, &stats));
+    cu_test_assert(stats.queued_count == 13);
+    cu_test_assert(stats.preformatted_count == 1);
+    cu_test_assert(stats.dropped_count == 0);
+    cu_test_assert(stats.sync_count == 0);
+    cu_test_assert(!cufo_asynclog_facility_stats(&_failure_facility,
+						 &stats));
+
+    out = _close_str(fos);
+    out_ref = _close_str(fos_ref);
+    if (strcmp(out, out_ref) != 0) {
+	fprintf(stderr, "Asynchronous output:\n%s\nExpected:\n%s\n",
+		out, out_ref);
+	cu_test_assert(0);
+    }
+    free(out);
+    free(out_ref);
+}
+
+static void *
+_logger_main(void *thread_no_ptr)
+{
+    int thread_no = (int)(long)thread_no_ptr;
+    int i;
+    for (i = 0; i < RECORD_COUNT; ++i)
+	cu_logf(&_info_facility, "%s %d record %d",
+		"thread", thread_no, i);
+    return NULL;
+}
+
+/* Checks that the records of each thread come out in order, and returns the
+ * number of records. */
+static unsigned long
+_check_threaded_output(char const *out, cu_bool_t expect_all)
+{
+    int next[THREAD_COUNT];
+    unsigned long count = 0;
+    memset(next, 0, sizeof(next));
+    while (*out) {
+	int thread_no, i;
+	cu_test_assert(sscanf(out, "thread %d record %d", &thread_no, &i)
+		       == 2);
+	cu_test_assert(0 <= thread_no && thread_no < THREAD_COUNT);
+	if (expect_all)
+	    cu_test_assert(i == next[thread_no]);
+	else
+	    cu_test_assert(i >= next[thread_no]);
+	next[thread_no] = i + 1;
+	++count;
+	out = strchr(out, '\n');
+	cu_test_assert(out);
+	++out;
+    }
+    return count;
+}
+
+static void
+_test_threads(cufo_asynclog_overflow_t overflow)
+{
+    cufo_stream_t fos = cufo_open_strip_str();
+    cufo_asynclog_t alog;
+    pthread_t threads[THREAD_COUNT];
+    struct cufo_asynclog_stats stats;
+    unsigned long count;
+    char *out;
+    int i;
+
+    alog = cufo_asynclog_new(fos, 1024, overflow);
+    cu_test_assert(cufo_asynclog_overflow(alog) == overflow);
+    _bind(alog, &_info_facility);
+    for (i = 0; i < THREAD_COUNT; ++i)
+	cu_pthread_create(&threads[i], NULL, _logger_main, (void *)(long)i);
+    for (i = 0; i < THREAD_COUNT; ++i)
+	cu_pthread_join(threads[i], NULL);
+    cufo_asynclog_close(alog);
+
+    cufo_asynclog_stats(alog, &stats);
+    out = _close_str(fos);
+    count = _check_threaded_output(out, overflow == CUFO_ASYNCLOG_BLOCK);
+    cu_test_assert(count == stats.queued_count);
+    cu_test_assert(stats.queued_count + stats.dropped_count
+		   == THREAD_COUNT*RECORD_COUNT);
+    if (overflow == CUFO_ASYNCLOG_BLOCK)
+	cu_test_assert(stats.dropped_count == 0);
+    else
+	cu_test_assert(stats.blocked_count == 0);
+    free(out);
+}
+
+/* Closes the log while threads are logging.  Records committed around the
+ * close must not be lost, and blocked threads must not hang. */
+static void
+_test_close_race(void)
+{
+    cufo_stream_t fos = cufo_open_strip_str();
+    cufo_asynclog_t alog;
+    pthread_t threads[THREAD_COUNT];
+    struct cufo_asynclog_stats stats;
+    char *out;
+    int i;
+
+    alog = cufo_asynclog_new(fos, 256, CUFO_ASYNCLOG_BLOCK);
+    _bind(alog, &_info_facility);
+    for (i = 0; i < THREAD_COUNT; ++i)
+	cu_pthread_create(&threads[i], NULL, _logger_main, (void *)(long)i);
+    cufo_asynclog_close(alog);
+    for (i = 0; i < THREAD_COUNT; ++i)
+	cu_pthread_join(threads[i], NULL);
+
+    cu_test_assert(cufo_asynclog_facility_stats(&_info_facility, &stats));
+    cu_test_assert(stats.dropped_count == 0);
+    out = _close_str(fos);
+    cu_test_assert(_check_threaded_output(out, cu_true)
+		   == THREAD_COUNT*RECORD_COUNT);
+    cu_test_assert(stats.queued_count + stats.sync_count
+		   == THREAD_COUNT*RECORD_COUNT);
+    free(out);
+}
+
+static void
+_test_failure_order(void)
+{
+    cufo_stream_t fos = cufo_open_strip_str();
+    cufo_asynclog_t alog;
+    struct cufo_asynclog_stats stats;
+    char *out;
+
+    alog = cufo_asynclog_new(fos, 0, CUFO_ASYNCLOG_BLOCK);
+    _bind(alog, &_info_facility);
+    _bind(alog, &_failure_facility);
+    cu_logf(&_info_facility, "first");
+    cu_logf(&_info_facility, "second");
+    cu_logf(&_failure_facility, "third");
+    cu_logf(&_info_facility, "fourth");
+    cufo_asynclog_flush(alog);
+    cu_logf(&_info_facility, "fifth");
+    cufo_asynclog_close(alog);
+
+    /* After closing, records are written synchronously. */
+    cu_logf(&_info_facility, "sixth");
+    cu_test_assert(cufo_asynclog_facility_stats(&_failure_facility, &stats));
+    cu_test_assert(stats.sync_count == 1 && stats.queued_count == 0);
+    cu_test_assert(cufo_asynclog_facility_stats(&_info_facility, &stats));
+    cu_test_assert(stats.sync_count == 1 && stats.queued_count == 4);
+
+    out = _close_str(fos);
+    cu_test_assert(strcmp(out, "first\nsecond\nthird\nfourth\nfifth\nsixth\n")
+		   == 0);
+    free(out);
+}
+
+int
+main()
+{
+    cufo_init();
+    _test_formats();
+    _test_threads(CUFO_ASYNCLOG_BLOCK);
+    _test_threads(CUFO_ASYNCLOG_DROP);
+    _test_close_race();
+    _test_failure_order();
+    return 2*!!cu_test_bug_count();
+}
@@ -39,6 +39,8 @@ typedef struct cufo_textsink *cufo_textsink_t;
 typedef struct cufo_textstyle *cufo_textstyle_t;
 typedef struct cufo_textstyler *cufo_textstyler_t;
 
+typedef struct cufo_asynclog *cufo_asynclog_t;
+
 /** Initialises \c libcufo, as is mandatory before before using the library.
  ** You may also want to call this function even if you don't use \c libcufo
  ** functions directly, because it installs a more powerful formatting engine
@@ -87,6 +87,7 @@ detect_SCC(detect_SCC_state_t state, cugra_vertex_t tail)
 		v = cucon_pmap_node_key(cu_to(cucon_pmap_node, vinfo));
 		(*pass_vertex)(walk_struct, cpt, v);
 		vinfo->cpt = cpt;
+		vinfo->index = INT_MAX;
 	    } while (v != tail);
 	    (*walk_vt->leave_component)(walk_struct, cpt);
 
@@ -97,7 +98,6 @@ detect_SCC(detect_SCC_state_t state, cugra_vertex_t tail)
 	    }
 	    cucon_stack_push_ptr(&state->cpt_stack, cpt);
 	}
-	tail_info->index = INT_MAX;
 	return tail_min_reach;
     } else {
 	if (tail_info->cpt)
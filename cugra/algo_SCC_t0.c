@@ -19,6 +19,7 @@
 #include <cugra/graph.h>
 #include <cucon/uset.h>
 #include <cu/test.h>
+#include <string.h>
 
 typedef struct _my_vertex *_my_vertex_t;
 typedef struct _my_subvertex *_my_subvertex_t;
@@ -117,10 +118,127 @@ test()
     cugra_walk_SCC(cu_to(cugra_walk_SCC, &cb), G, cugra_direction_out);
 }
 
+/* Check that cugra_walk_SCC partitions random graphs into the same
+ * components as a brute-force transitive closure.  Vertices must not be
+ * taken as finished before they are popped into a component, otherwise a
+ * later arc into a component under construction is ignored and the
+ * component is split. */
+
+#define CHK_VERTEX_CNT 12
+
+typedef struct _chk_vertex *_chk_vertex_t;
+struct _chk_vertex
+{
+    cu_inherit (cugra_vertex);
+    int label;
+    int cpt_label;
+};
+
+struct _chk_cb
+{
+    cu_inherit (cugra_walk_SCC);
+    int cpt_cnt;
+    int pass_cnt;
+};
+
+static void *
+_chk_enter_component(cugra_walk_SCC_t self)
+{
+    struct _chk_cb *cb = cu_from(_chk_cb, cugra_walk_SCC, self);
+    return (void *)(uintptr_t)++cb->cpt_cnt;
+}
+
+static void
+_chk_pass_vertex(cugra_walk_SCC_t self, void *cpt, cugra_vertex_t v)
+{
+    struct _chk_cb *cb = cu_from(_chk_cb, cugra_walk_SCC, self);
+    cu_from(_chk_vertex, cugra_vertex, v)->cpt_label = (uintptr_t)cpt;
+    ++cb->pass_cnt;
+}
+
+static void _chk_leave_component(cugra_walk_SCC_t self, void *cpt) {}
+static void _chk_connect_components(cugra_walk_SCC_t self,
+				    void *tail, void *head) {}
+
+static struct cugra_walk_SCC_vt _chk_walk_vt = {
+    .enter_component = _chk_enter_component,
+    .pass_vertex = _chk_pass_vertex,
+    .leave_component = _chk_leave_component,
+    .connect_components = _chk_connect_components,
+};
+
+static void
+_test_partition(int arc_cnt, cu_bool_t *adj)
+{
+    cugra_graph_t G = cugra_graph_new(0);
+    struct _chk_vertex *v_arr[CHK_VERTEX_CNT];
+    struct _chk_cb cb;
+    cu_bool_t reach[CHK_VERTEX_CNT][CHK_VERTEX_CNT];
+    int i, j, k;
+
+    for (i = 0; i < CHK_VERTEX_CNT; ++i) {
+	v_arr[i] = cu_gnew(struct _chk_vertex);
+	v_arr[i]->label = i;
+	v_arr[i]->cpt_label = 0;
+	cugra_graph_vertex_init(G, cu_to(cugra_vertex, v_arr[i]));
+    }
+    for (i = 0; i < CHK_VERTEX_CNT; ++i)
+	for (j = 0; j < CHK_VERTEX_CNT; ++j) {
+	    reach[i][j] = i == j || adj[i*CHK_VERTEX_CNT + j];
+	    if (adj[i*CHK_VERTEX_CNT + j])
+		cugra_connect(G, cu_to(cugra_vertex, v_arr[i]),
+			      cu_to(cugra_vertex, v_arr[j]));
+	}
+    for (k = 0; k < CHK_VERTEX_CNT; ++k)
+	for (i = 0; i < CHK_VERTEX_CNT; ++i)
+	    for (j = 0; j < CHK_VERTEX_CNT; ++j)
+		if (reach[i][k] && reach[k][j])
+		    reach[i][j] = cu_true;
+
+    cu_to(cugra_walk_SCC, &cb)->vt = &_chk_walk_vt;
+    cb.cpt_cnt = 0;
+    cb.pass_cnt = 0;
+    cugra_walk_SCC(cu_to(cugra_walk_SCC, &cb), G, cugra_direction_out);
+
+    cu_test_assert_int_eq(cb.pass_cnt, CHK_VERTEX_CNT);
+    for (i = 0; i < CHK_VERTEX_CNT; ++i)
+	for (j = 0; j < CHK_VERTEX_CNT; ++j) {
+	    cu_bool_t same_exp = reach[i][j] && reach[j][i];
+	    cu_bool_t same = v_arr[i]->cpt_label == v_arr[j]->cpt_label;
+	    if (same != same_exp)
+		cu_test_bugf("Vertices %d and %d are %s the same component "
+			     "with %d arcs.", i, j,
+			     same? "wrongly in" : "not in", arc_cnt);
+	}
+}
+
+static void
+test_partition()
+{
+    cu_bool_t adj[CHK_VERTEX_CNT*CHK_VERTEX_CNT];
+    int round, i, arc_cnt;
+
+    /* 0 -> 1 -> 0 and 0 -> 2 -> 1.  If 1 is visited before 2, then 2
+     * reaches the open component only through the returned vertex 1. */
+    memset(adj, 0, sizeof(adj));
+    adj[0*CHK_VERTEX_CNT + 1] = adj[1*CHK_VERTEX_CNT + 0] = cu_true;
+    adj[0*CHK_VERTEX_CNT + 2] = adj[2*CHK_VERTEX_CNT + 1] = cu_true;
+    _test_partition(4, adj);
+
+    for (round = 0; round < 1000; ++round) {
+	arc_cnt = lrand48() % (3*CHK_VERTEX_CNT);
+	memset(adj, 0, sizeof(adj));
+	for (i = 0; i < arc_cnt; ++i)
+	    adj[lrand48() % (CHK_VERTEX_CNT*CHK_VERTEX_CNT)] = cu_true;
+	_test_partition(arc_cnt, adj);
+    }
+}
+
 int
 main()
 {
     cu_init();
     test();
+    test_partition();
     return 2*!!cu_test_bug_count();
 }
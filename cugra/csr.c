@@ -0,0 +1,329 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cugra/csr.h>
+#include <cu/memory.h>
+#include <stdint.h>
+
+#define DONE SIZE_MAX
+
+
+/* Construction
+ * ------------ */
+
+void
+cugra_csr_init(cugra_csr_t csr, cugra_graph_t G, unsigned int csr_flags,
+	       size_t arc_payload_size,
+	       cu_clop(arc_payload, void, cugra_arc_t, void *))
+{
+    cugra_vertex_t v;
+    cugra_arc_t a;
+    size_t vi, pos, n = 0, m = 0;
+    size_t *out_offset_arr, *out_adjacent_arr;
+
+    csr->gflags = G->gflags;
+    csr->csr_flags = csr_flags;
+    cucon_pmap_init(&csr->vertex_index_map);
+    cugra_graph_for_vertices(v, G) {
+	size_t *index;
+	cucon_pmap_insert_mem(&csr->vertex_index_map, v, sizeof(size_t),
+			      &index);
+	*index = n++;
+	cugra_vertex_for_outarcs(a, v)
+	    ++m;
+    }
+    csr->vertex_cnt = n;
+    csr->arc_cnt = m;
+
+    /* Out-arcs, in the order of the source graph. */
+    csr->vertex_arr = cu_gnewarr(cugra_vertex_t, n);
+    out_offset_arr = cu_gnewarr_atomic(size_t, n + 1);
+    out_adjacent_arr = cu_gnewarr_atomic(size_t, m);
+    csr->arc_arr = (csr_flags & CUGRA_CSR_KEEP_ARCS)
+		 ? cu_gnewarr(cugra_arc_t, m) : NULL;
+    csr->arc_payload_size = arc_payload_size;
+    csr->arc_payload_arr = arc_payload_size
+			 ? cu_galloc(arc_payload_size*m) : NULL;
+    vi = pos = 0;
+    cugra_graph_for_vertices(v, G) {
+	csr->vertex_arr[vi] = v;
+	out_offset_arr[vi] = pos;
+	cugra_vertex_for_outarcs(a, v) {
+	    size_t *head_index
+		= cucon_pmap_find_mem(&csr->vertex_index_map,
+				      cugra_arc_head(a));
+	    out_adjacent_arr[pos] = *head_index;
+	    if (csr->arc_arr)
+		csr->arc_arr[pos] = a;
+	    if (arc_payload_size)
+		cu_call(arc_payload, a, cugra_csr_arc_payload(csr, pos));
+	    ++pos;
+	}
+	++vi;
+    }
+    out_offset_arr[n] = m;
+    csr->offset_arr[cugra_direction_out] = out_offset_arr;
+    csr->adjacent_arr[cugra_direction_out] = out_adjacent_arr;
+
+    /* In-arcs, by a counting sort of the out-arcs on their heads. */
+    if (csr_flags & CUGRA_CSR_NO_INARCS) {
+	csr->offset_arr[cugra_direction_in] = NULL;
+	csr->adjacent_arr[cugra_direction_in] = NULL;
+	csr->inarc_index_arr = NULL;
+    }
+    else {
+	size_t *in_offset_arr = cu_gnewarrz_atomic(size_t, n + 1);
+	size_t *in_adjacent_arr = cu_gnewarr_atomic(size_t, m);
+	size_t *inarc_index_arr = cu_gnewarr_atomic(size_t, m);
+	size_t *cursor_arr = cu_gnewarr_atomic(size_t, n);
+	for (pos = 0; pos < m; ++pos)
+	    ++in_offset_arr[out_adjacent_arr[pos] + 1];
+	for (vi = 0; vi < n; ++vi) {
+	    in_offset_arr[vi + 1] += in_offset_arr[vi];
+	    cursor_arr[vi] = in_offset_arr[vi];
+	}
+	for (vi = 0; vi < n; ++vi)
+	    for (pos = out_offset_arr[vi]; pos < out_offset_arr[vi + 1];
+		 ++pos) {
+		size_t k = cursor_arr[out_adjacent_arr[pos]]++;
+		in_adjacent_arr[k] = vi;
+		inarc_index_arr[k] = pos;
+	    }
+	cu_gfree_atomic(cursor_arr);
+	csr->offset_arr[cugra_direction_in] = in_offset_arr;
+	csr->adjacent_arr[cugra_direction_in] = in_adjacent_arr;
+	csr->inarc_index_arr = inarc_index_arr;
+    }
+}
+
+cugra_csr_t
+cugra_csr_new(cugra_graph_t G, unsigned int csr_flags,
+	      size_t arc_payload_size,
+	      cu_clop(arc_payload, void, cugra_arc_t, void *))
+{
+    cugra_csr_t csr = cu_gnew(struct cugra_csr);
+    cugra_csr_init(csr, G, csr_flags, arc_payload_size, arc_payload);
+    return csr;
+}
+
+size_t
+cugra_csr_vertex_index(cugra_csr_t csr, cugra_vertex_t v)
+{
+    size_t *index = cucon_pmap_find_mem(&csr->vertex_index_map, v);
+    return index? *index : (size_t)-1;
+}
+
+size_t
+cugra_csr_arc_tail(cugra_csr_t csr, size_t ai)
+{
+    size_t *offset_arr = csr->offset_arr[cugra_direction_out];
+    size_t lo = 0, hi = csr->vertex_cnt;
+
+    /* Find the last vertex whose arcs start at or before ai. */
+    while (hi - lo > 1) {
+	size_t mid = lo + (hi - lo)/2;
+	if (offset_arr[mid] <= ai)
+	    lo = mid;
+	else
+	    hi = mid;
+    }
+    return lo;
+}
+
+
+/* Strongly Connected Components
+ * ----------------------------- */
+
+struct _SCC_frame
+{
+    size_t vi;
+    size_t pos;
+};
+
+/* Tarjan's algorithm without recursion.  On return, cpt_arr maps vertices to
+ * component numbers, which are assigned as components are completed.  If
+ * member_arr is non-NULL, it receives the vertices ordered by component, and
+ * cpt_end_arr the end position in member_arr of each component. */
+static size_t
+_SCC(cugra_csr_t csr, cugra_direction_t dir, size_t *cpt_arr,
+     size_t *member_arr, size_t *cpt_end_arr)
+{
+    size_t n = csr->vertex_cnt;
+    size_t *offset_arr = csr->offset_arr[dir];
+    size_t *adjacent_arr = csr->adjacent_arr[dir];
+    size_t *index_arr = cu_gnewarrz_atomic(size_t, n);
+    size_t *low_arr = cu_gnewarr_atomic(size_t, n);
+    size_t *vstack = cu_gnewarr_atomic(size_t, n);
+    struct _SCC_frame *fstack = cu_gnewarr_atomic(struct _SCC_frame, n);
+    size_t vsp = 0, fsp = 0;
+    size_t index_pool = 0, cpt_cnt = 0, member_cnt = 0;
+    size_t vi_root;
+
+#define PUSH_VERTEX(vk)							\
+    do {								\
+	index_arr[vk] = low_arr[vk] = ++index_pool;			\
+	vstack[vsp++] = vk;						\
+	fstack[fsp].vi = vk;						\
+	fstack[fsp].pos = offset_arr[vk];				\
+	++fsp;								\
+    } while (0)
+
+    for (vi_root = 0; vi_root < n; ++vi_root) {
+	if (index_arr[vi_root])
+	    continue;
+	PUSH_VERTEX(vi_root);
+	while (fsp) {
+	    struct _SCC_frame *frame = &fstack[fsp - 1];
+	    size_t vi = frame->vi;
+	    size_t vj;
+
+	    if (frame->pos < offset_arr[vi + 1]) {
+		vj = adjacent_arr[frame->pos++];
+		if (!index_arr[vj])
+		    PUSH_VERTEX(vj);
+		else if (index_arr[vj] != DONE && index_arr[vj] < low_arr[vi])
+		    low_arr[vi] = index_arr[vj];
+		continue;
+	    }
+
+	    --fsp;
+	    if (low_arr[vi] == index_arr[vi]) {
+		do {
+		    vj = vstack[--vsp];
+		    index_arr[vj] = DONE;
+		    cpt_arr[vj] = cpt_cnt;
+		    if (member_arr)
+			member_arr[member_cnt++] = vj;
+		} while (vj != vi);
+		if (cpt_end_arr)
+		    cpt_end_arr[cpt_cnt] = member_cnt;
+		++cpt_cnt;
+	    }
+	    if (fsp) {
+		size_t vi_parent = fstack[fsp - 1].vi;
+		if (low_arr[vi] < low_arr[vi_parent])
+		    low_arr[vi_parent] = low_arr[vi];
+	    }
+	}
+    }
+#undef PUSH_VERTEX
+
+    cu_gfree_atomic(fstack);
+    cu_gfree_atomic(vstack);
+    cu_gfree_atomic(low_arr);
+    cu_gfree_atomic(index_arr);
+    return cpt_cnt;
+}
+
+size_t
+cugra_csr_SCC_index(cugra_csr_t csr, size_t *cpt_arr)
+{
+    size_t cpt_cnt;
+    cu_bool_t own_arr = cpt_arr == NULL;
+    if (own_arr)
+	cpt_arr = cu_gnewarr_atomic(size_t, csr->vertex_cnt);
+    cpt_cnt = _SCC(csr, cugra_direction_out, cpt_arr, NULL, NULL);
+    if (own_arr)
+	cu_gfree_atomic(cpt_arr);
+    return cpt_cnt;
+}
+
+void
+cugra_csr_walk_SCC(cugra_walk_SCC_t walk_struct,
+		   cugra_csr_t csr, cugra_direction_t dir)
+{
+    cugra_walk_SCC_vt_t walk_vt = walk_struct->vt;
+    size_t n = csr->vertex_cnt;
+    size_t *offset_arr = csr->offset_arr[dir];
+    size_t *adjacent_arr = csr->adjacent_arr[dir];
+    size_t *cpt_arr = cu_gnewarr_atomic(size_t, n);
+    size_t *member_arr = cu_gnewarr_atomic(size_t, n);
+    size_t *cpt_end_arr = cu_gnewarr_atomic(size_t, n);
+    size_t *cpt_seen_arr;
+    void **cpt_ptr_arr;
+    size_t cpt_cnt, c, k, k_begin;
+
+    cpt_cnt = _SCC(csr, dir, cpt_arr, member_arr, cpt_end_arr);
+    cpt_ptr_arr = cu_gnewarr(void *, cpt_cnt);
+    cpt_seen_arr = cu_gnewarr_atomic(size_t, cpt_cnt);
+
+    /* Components are completed after all components reachable from them, so
+     * sub-components are available when connecting. */
+    k_begin = 0;
+    for (c = 0; c < cpt_cnt; ++c) {
+	void *cpt = (*walk_vt->enter_component)(walk_struct);
+	for (k = k_begin; k < cpt_end_arr[c]; ++k)
+	    (*walk_vt->pass_vertex)(walk_struct, cpt,
+				    csr->vertex_arr[member_arr[k]]);
+	(*walk_vt->leave_component)(walk_struct, cpt);
+	cpt_ptr_arr[c] = cpt;
+	cpt_seen_arr[c] = c;
+	for (k = k_begin; k < cpt_end_arr[c]; ++k) {
+	    size_t vi = member_arr[k];
+	    size_t pos;
+	    for (pos = offset_arr[vi]; pos < offset_arr[vi + 1]; ++pos) {
+		size_t c_sub = cpt_arr[adjacent_arr[pos]];
+		if (cpt_seen_arr[c_sub] != c) {
+		    cpt_seen_arr[c_sub] = c;
+		    (*walk_vt->connect_components)(walk_struct, cpt,
+						   cpt_ptr_arr[c_sub]);
+		}
+	    }
+	}
+	k_begin = cpt_end_arr[c];
+    }
+
+    cu_gfree_atomic(cpt_seen_arr);
+    cu_gfree(cpt_ptr_arr);
+    cu_gfree_atomic(cpt_end_arr);
+    cu_gfree_atomic(member_arr);
+    cu_gfree_atomic(cpt_arr);
+}
+
+
+/* Acyclicity
+ * ---------- */
+
+cu_bool_t
+cugra_csr_is_acyclic(cugra_csr_t csr)
+{
+    size_t n = csr->vertex_cnt;
+    size_t *offset_arr = csr->offset_arr[cugra_direction_out];
+    size_t *adjacent_arr = csr->adjacent_arr[cugra_direction_out];
+    size_t *indegree_arr = cu_gnewarrz_atomic(size_t, n);
+    size_t *queue = cu_gnewarr_atomic(size_t, n);
+    size_t q_begin = 0, q_end = 0;
+    size_t vi, pos;
+
+    /* Kahn's algorithm: repeatedly strip vertices without in-arcs.  The graph
+     * is acyclic iff all vertices are stripped. */
+    for (pos = 0; pos < csr->arc_cnt; ++pos)
+	++indegree_arr[adjacent_arr[pos]];
+    for (vi = 0; vi < n; ++vi)
+	if (indegree_arr[vi] == 0)
+	    queue[q_end++] = vi;
+    while (q_begin < q_end) {
+	vi = queue[q_begin++];
+	for (pos = offset_arr[vi]; pos < offset_arr[vi + 1]; ++pos)
+	    if (--indegree_arr[adjacent_arr[pos]] == 0)
+		queue[q_end++] = adjacent_arr[pos];
+    }
+
+    cu_gfree_atomic(queue);
+    cu_gfree_atomic(indegree_arr);
+    return q_end == n;
+}
@@ -0,0 +1,234 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CUGRA_CSR_H
+#define CUGRA_CSR_H
+
+#include <cugra/fwd.h>
+#include <cugra/graph.h>
+#include <cugra/algo_SCC.h>
+#include <cucon/pmap.h>
+
+CU_BEGIN_DECLARATIONS
+/*!\defgroup cugra_csr_h cugra/csr.h: Compressed Sparse Row Snapshots
+ * @{\ingroup cugra_mod
+ *
+ * A \ref cugra_csr_t is a frozen copy of the structure of a \ref
+ * cugra_graph_t, where vertices are numbered densely from 0 and the arcs of
+ * each direction are stored contiguously per vertex.  Traversals only touch
+ * a few flat arrays instead of chasing one pointer per arc, which makes
+ * read-only passes over large graphs considerably faster.  Later changes to
+ * the source graph are not reflected in the snapshot.
+ *
+ * Arcs are identified by an <em>arc index</em>, which is their position in
+ * the out-arc array.  The in-arc array refers back to arc indices, so that
+ * the original arcs and the arc payloads are stored once, in arc index
+ * order. */
+
+#define CUGRA_CSR_KEEP_ARCS	1  /*!< Record the original arcs. */
+#define CUGRA_CSR_NO_INARCS	2  /*!< Do not build in-arc arrays. */
+
+/*!A compressed sparse row representation of a graph. */
+struct cugra_csr
+{
+    unsigned int gflags;
+    unsigned int csr_flags;
+    size_t vertex_cnt;
+    size_t arc_cnt;
+    cugra_vertex_t *vertex_arr;
+    struct cucon_pmap vertex_index_map;
+    size_t *offset_arr[2];
+    size_t *adjacent_arr[2];
+    size_t *inarc_index_arr;
+    cugra_arc_t *arc_arr;
+    size_t arc_payload_size;
+    void *arc_payload_arr;
+};
+
+/*!Construct \a csr as a snapshot of \a G.  \a csr_flags is a combination of
+ * \ref CUGRA_CSR_KEEP_ARCS and \ref CUGRA_CSR_NO_INARCS.  If \a
+ * arc_payload_size is non-zero, \a arc_payload is called for each arc with a
+ * pointer to \a arc_payload_size bytes of storage to initialise. */
+void cugra_csr_init(cugra_csr_t csr, cugra_graph_t G, unsigned int csr_flags,
+		    size_t arc_payload_size,
+		    cu_clop(arc_payload, void, cugra_arc_t, void *));
+
+/*!Return a snapshot of \a G, see \ref cugra_csr_init. */
+cugra_csr_t cugra_csr_new(cugra_graph_t G, unsigned int csr_flags,
+			  size_t arc_payload_size,
+			  cu_clop(arc_payload, void, cugra_arc_t, void *));
+
+/*!The number of vertices of \a csr. */
+CU_SINLINE size_t cugra_csr_vertex_count(cugra_csr_t csr)
+{ return csr->vertex_cnt; }
+
+/*!The number of arcs of \a csr. */
+CU_SINLINE size_t cugra_csr_arc_count(cugra_csr_t csr)
+{ return csr->arc_cnt; }
+
+/*!The original vertex with index \a vi. */
+CU_SINLINE cugra_vertex_t cugra_csr_vertex(cugra_csr_t csr, size_t vi)
+{ return csr->vertex_arr[vi]; }
+
+/*!The index of \a v in \a csr, or <code>(size_t)-1</code> if \a v was not
+ * part of the graph when \a csr was created. */
+size_t cugra_csr_vertex_index(cugra_csr_t csr, cugra_vertex_t v);
+
+/*!True iff \a csr contains arcs in direction \a dir. */
+CU_SINLINE cu_bool_t
+cugra_csr_has_direction(cugra_csr_t csr, cugra_direction_t dir)
+{ return csr->offset_arr[dir] != NULL; }
+
+/*!The first position of the arcs in direction \a dir from vertex \a vi. */
+CU_SINLINE size_t
+cugra_csr_arcs_begin(cugra_csr_t csr, cugra_direction_t dir, size_t vi)
+{ return csr->offset_arr[dir][vi]; }
+
+/*!The position past the arcs in direction \a dir from vertex \a vi. */
+CU_SINLINE size_t
+cugra_csr_arcs_end(cugra_csr_t csr, cugra_direction_t dir, size_t vi)
+{ return csr->offset_arr[dir][vi + 1]; }
+
+/*!The number of arcs in direction \a dir from vertex \a vi. */
+CU_SINLINE size_t
+cugra_csr_degree(cugra_csr_t csr, cugra_direction_t dir, size_t vi)
+{ return csr->offset_arr[dir][vi + 1] - csr->offset_arr[dir][vi]; }
+
+/*!The index of the vertex adjacent through the arc at position \a pos of
+ * direction \a dir. */
+CU_SINLINE size_t
+cugra_csr_adjacent(cugra_csr_t csr, cugra_direction_t dir, size_t pos)
+{ return csr->adjacent_arr[dir][pos]; }
+
+/*!The arc index of the arc at position \a pos of direction \a dir. */
+CU_SINLINE size_t
+cugra_csr_arc_index(cugra_csr_t csr, cugra_direction_t dir, size_t pos)
+{ return dir == cugra_direction_out? pos : csr->inarc_index_arr[pos]; }
+
+/*!The original arc with index \a ai.  \a csr must have been created with
+ * \ref CUGRA_CSR_KEEP_ARCS. */
+CU_SINLINE cugra_arc_t cugra_csr_arc(cugra_csr_t csr, size_t ai)
+{ return csr->arc_arr[ai]; }
+
+/*!The index of the tail vertex of arc \a ai. */
+size_t cugra_csr_arc_tail(cugra_csr_t csr, size_t ai);
+
+/*!The index of the head vertex of arc \a ai. */
+CU_SINLINE size_t cugra_csr_arc_head(cugra_csr_t csr, size_t ai)
+{ return csr->adjacent_arr[cugra_direction_out][ai]; }
+
+/*!A pointer to the payload of arc \a ai. */
+CU_SINLINE void *cugra_csr_arc_payload(cugra_csr_t csr, size_t ai)
+{ return (char *)csr->arc_payload_arr + ai*csr->arc_payload_size; }
+
+#define cugra_csr_for_arcs(dir, pos, csr, vi)				\
+    for (pos = cugra_csr_arcs_begin(csr, dir, vi);			\
+	 pos != cugra_csr_arcs_end(csr, dir, vi); ++pos)
+
+/*!Variant of \ref cugra_walk_SCC operating on \a csr.  Vertices are passed
+ * as the original \ref cugra_vertex_t objects. */
+void cugra_csr_walk_SCC(cugra_walk_SCC_t walk_struct,
+			cugra_csr_t csr, cugra_direction_t dir);
+
+/*!Stores in \a cpt_arr, if non-\c NULL, a component number for each vertex
+ * and returns the number of strongly connected components of \a csr.
+ * Components are numbered in reverse topological order. */
+size_t cugra_csr_SCC_index(cugra_csr_t csr, size_t *cpt_arr);
+
+/*!A parallel variant of \ref cugra_csr_SCC_index which runs on the \ref
+ * cuflow_workers_h "cuflow worker threads", falling back to the calling
+ * thread if there are none.  Vertices which are not on any cycle are trimmed
+ * off first, and the rest is split by forward-backward search.  The
+ * component numbers are not topologically ordered.  \a csr must have in-arc
+ * arrays. */
+size_t cugra_csr_SCC_index_par(cugra_csr_t csr, size_t *cpt_arr);
+
+/*!Does a level-synchronous breadth-first search in direction \a dir from the
+ * \a src_cnt vertex indices of \a src_arr, expanding large levels in
+ * parallel on the \ref cuflow_workers_h "cuflow worker threads".  Returns
+ * the number of reached vertices, including the sources.  If non-\c NULL, \a
+ * reached_arr receives the indices of the reached vertices by increasing
+ * distance, and \a level_arr receives the number of arcs from the nearest
+ * source for each vertex, or <code>(size_t)-1</code> for unreached vertices.
+ * Both arrays must have room for all vertices. */
+size_t cugra_csr_reach(cugra_csr_t csr, cugra_direction_t dir,
+		       size_t src_cnt, size_t const *src_arr,
+		       size_t *reached_arr, size_t *level_arr);
+
+/*!True iff \a csr is acyclic. */
+cu_bool_t cugra_csr_is_acyclic(cugra_csr_t csr);
+
+/*!The priority queue used by the shortest path searches. */
+typedef enum {
+    /*!An indexed 4-ary heap with decrease-key, for any non-negative arc
+     * distances. */
+    cugra_shortpath_heap4,
+
+    /*!A radix heap, which is faster when all arc distances and heuristic
+     * values are integers, and incorrect otherwise. */
+    cugra_shortpath_radix
+} cugra_shortpath_engine_t;
+
+/*!Dijkstra's algorithm on \a csr, using \a engine as the priority queue.
+ * Searches a shortest path in direction \a dir from vertex index \a
+ * vi_start to a vertex index for which \a vertex_test returns true.  \a
+ * arc_distance_arr gives non-negative distances by arc index, where \c
+ * INFINITY excludes the arc, or is \c NULL to count arcs.  If found, calls
+ * \a notify_path_unwind with the arc indices of the path in reverse order
+ * and returns the path's distance, otherwise returns \c INFINITY. */
+double
+cugra_csr_dijkstra(cugra_csr_t csr, cugra_direction_t dir,
+		   cugra_shortpath_engine_t engine, size_t vi_start,
+		   cu_clop(vertex_test, cu_bool_t, size_t),
+		   double const *arc_distance_arr,
+		   cu_clop(notify_path_unwind, void, size_t));
+
+/*!Variant of \ref cugra_shortest_path operating on \a csr.  This is \ref
+ * cugra_csr_dijkstra with \ref cugra_shortpath_heap4. */
+double
+cugra_csr_shortest_path(cugra_csr_t csr, cugra_direction_t dir,
+			size_t vi_start,
+			cu_clop(vertex_test, cu_bool_t, size_t),
+			double const *arc_distance_arr,
+			cu_clop(notify_path_unwind, void, size_t));
+
+/*!A* search from \a vi_start to \a vi_goal, otherwise as \ref
+ * cugra_csr_dijkstra.  \a heuristic must return a lower bound of the
+ * distance from the given vertex to \a vi_goal, and must be consistent, that
+ * is, it must not decrease by more than the distance of any arc traversed. */
+double
+cugra_csr_astar(cugra_csr_t csr, cugra_direction_t dir,
+		cugra_shortpath_engine_t engine,
+		size_t vi_start, size_t vi_goal,
+		cu_clop(heuristic, double, size_t),
+		double const *arc_distance_arr,
+		cu_clop(notify_path_unwind, void, size_t));
+
+/*!Bidirectional Dijkstra search for a shortest path along out-arcs from \a
+ * vi_start to \a vi_goal, alternately expanding from both ends.  \a csr
+ * must have in-arc arrays.  The arguments and result are otherwise as for
+ * \ref cugra_csr_dijkstra. */
+double
+cugra_csr_shortest_path_bidir(cugra_csr_t csr,
+			      size_t vi_start, size_t vi_goal,
+			      double const *arc_distance_arr,
+			      cu_clop(notify_path_unwind, void, size_t));
+
+/*!@}*/
+CU_END_DECLARATIONS
+
+#endif
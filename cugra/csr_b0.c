@@ -0,0 +1,189 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cugra/csr.h>
+#include <cugra/algo_SCC.h>
+#include <cuflow/workers.h>
+#include <cuflow/time.h>
+#include <cu/test.h>
+#include <cu/memory.h>
+#include <stdio.h>
+
+static int const worker_cnts[] = {0, 1, 2, 4, 8};
+
+/* Uniformly random arcs. */
+static cugra_graph_t
+_random_graph(size_t n, size_t m)
+{
+    cugra_graph_t G = cugra_graph_new(0);
+    cugra_vertex_t *v_arr = cu_gnewarr(cugra_vertex_t, n);
+    size_t i;
+    for (i = 0; i < n; ++i)
+	v_arr[i] = cugra_graph_vertex_new(G);
+    for (i = 0; i < m; ++i)
+	cugra_connect(G, v_arr[lrand48() % n], v_arr[lrand48() % n]);
+    return G;
+}
+
+/* An R-MAT graph with 2^scale vertices, which has power-law degree
+ * distributions. */
+static cugra_graph_t
+_rmat_graph(int scale, size_t m)
+{
+    size_t n = (size_t)1 << scale;
+    cugra_graph_t G = cugra_graph_new(0);
+    cugra_vertex_t *v_arr = cu_gnewarr(cugra_vertex_t, n);
+    size_t i;
+    int l;
+    for (i = 0; i < n; ++i)
+	v_arr[i] = cugra_graph_vertex_new(G);
+    for (i = 0; i < m; ++i) {
+	size_t tail = 0, head = 0;
+	for (l = 0; l < scale; ++l) {
+	    double r = drand48();
+	    tail <<= 1;
+	    head <<= 1;
+	    if (r < 0.57)
+		;
+	    else if (r < 0.76)
+		head |= 1;
+	    else if (r < 0.95)
+		tail |= 1;
+	    else {
+		tail |= 1;
+		head |= 1;
+	    }
+	}
+	cugra_connect(G, v_arr[tail], v_arr[head]);
+    }
+    return G;
+}
+
+/* A single cycle through n vertices, which is too deep for the recursive
+ * walker. */
+static cugra_graph_t
+_cycle_graph(size_t n)
+{
+    cugra_graph_t G = cugra_graph_new(0);
+    cugra_vertex_t v0, v, v_prev;
+    size_t i;
+    v0 = v_prev = cugra_graph_vertex_new(G);
+    for (i = 1; i < n; ++i) {
+	v = cugra_graph_vertex_new(G);
+	cugra_connect(G, v_prev, v);
+	v_prev = v;
+    }
+    cugra_connect(G, v_prev, v0);
+    return G;
+}
+
+struct _count_walk
+{
+    cu_inherit (cugra_walk_SCC);
+    size_t cpt_cnt;
+};
+
+static void *
+_count_enter_component(cugra_walk_SCC_t self)
+{
+    ++cu_from(_count_walk, cugra_walk_SCC, self)->cpt_cnt;
+    return self;
+}
+
+static void
+_count_pass_vertex(cugra_walk_SCC_t self, void *cpt, cugra_vertex_t v) {}
+
+static void
+_count_leave_component(cugra_walk_SCC_t self, void *cpt) {}
+
+static void
+_count_connect_components(cugra_walk_SCC_t self, void *tail, void *head) {}
+
+static struct cugra_walk_SCC_vt _count_walk_vt = {
+    .enter_component = _count_enter_component,
+    .pass_vertex = _count_pass_vertex,
+    .leave_component = _count_leave_component,
+    .connect_components = _count_connect_components,
+};
+
+static double
+_seconds(cuflow_walltime_t t)
+{
+    return t/(double)CUFLOW_WALLTIME_SECOND;
+}
+
+static void
+bench(char const *name, cugra_graph_t G, cu_bool_t run_walker)
+{
+    cuflow_walltime_t t;
+    cugra_csr_t csr;
+    size_t cpt_cnt, src = 0, reached_cnt;
+    int k;
+
+    printf("%s\n", name);
+    if (run_walker) {
+	struct _count_walk walk;
+	cu_to(cugra_walk_SCC, &walk)->vt = &_count_walk_vt;
+	walk.cpt_cnt = 0;
+	t = -cuflow_walltime();
+	cugra_walk_SCC(cu_to(cugra_walk_SCC, &walk), G, cugra_direction_out);
+	t += cuflow_walltime();
+	printf("    cugra_walk_SCC:            %8.3lf s (%zd components)\n",
+	       _seconds(t), walk.cpt_cnt);
+    }
+
+    t = -cuflow_walltime();
+    csr = cugra_csr_new(G, 0, 0, cu_clop_null);
+    t += cuflow_walltime();
+    printf("    CSR build:                 %8.3lf s (%zd vertices, %zd arcs)\n",
+	   _seconds(t), cugra_csr_vertex_count(csr), cugra_csr_arc_count(csr));
+
+    t = -cuflow_walltime();
+    cpt_cnt = cugra_csr_SCC_index(csr, NULL);
+    t += cuflow_walltime();
+    printf("    cugra_csr_SCC_index:       %8.3lf s (%zd components)\n",
+	   _seconds(t), cpt_cnt);
+
+    for (k = 0; k < sizeof(worker_cnts)/sizeof(worker_cnts[0]); ++k) {
+	cuflow_workers_spawn(worker_cnts[k]);
+	t = -cuflow_walltime();
+	cu_test_assert_size_eq(cugra_csr_SCC_index_par(csr, NULL), cpt_cnt);
+	t += cuflow_walltime();
+	printf("    SCC_index_par, %d workers:  %8.3lf s\n",
+	       worker_cnts[k], _seconds(t));
+	t = -cuflow_walltime();
+	reached_cnt = cugra_csr_reach(csr, cugra_direction_out, 1, &src,
+				      NULL, NULL);
+	t += cuflow_walltime();
+	printf("    reach, %d workers:          %8.3lf s (%zd reached)\n",
+	       worker_cnts[k], _seconds(t), reached_cnt);
+    }
+    cuflow_workers_spawn(0);
+}
+
+int
+main()
+{
+    cugra_init();
+    bench("Random, 2^20 vertices, 2^22 arcs",
+	  _random_graph(1 << 20, 1 << 22), cu_true);
+    bench("R-MAT, 2^20 vertices, 2^23 arcs",
+	  _rmat_graph(20, 1 << 23), cu_true);
+    bench("Cycle, 2^22 vertices",
+	  _cycle_graph(1 << 22), cu_false);
+    return 2*!!cu_test_bug_count();
+}
@@ -0,0 +1,468 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cugra/csr.h>
+#include <cuflow/sched.h>
+#include <cuflow/cdisj.h>
+#include <cuflow/workers.h>
+#include <cu/memory.h>
+#include <atomic_ops.h>
+#include <string.h>
+
+/* Frontier vertices per BFS task, and the maximum number of tasks per
+ * level. */
+#define BFS_GRAIN 512
+#define BFS_MAX_TASKS 64
+
+/* Newly reached vertices are collected locally before reserving space in the
+ * shared queue. */
+#define BFS_BUF_SIZE 256
+
+/* Vertex sets of at most this size are split into components by a
+ * sequential Tarjan pass instead of forward-backward search. */
+#define SCC_SEQ_LIMIT 2048
+
+/* The colour of vertices which have been assigned a component. */
+#define DONE ((AO_t)-1)
+
+
+/* Parallel Breadth-First Search
+ * -----------------------------
+ *
+ * Vertices are claimed by atomically changing their colour from one of the
+ * claim_cnt from_colour entries to the corresponding to_colour.  The queue
+ * receives each vertex once, so the levels are consecutive ranges of it. */
+
+struct _bfs
+{
+    size_t *offset_arr;
+    size_t *adjacent_arr;
+    AO_t *colour_arr;
+    int claim_cnt;
+    AO_t from_colour[2];
+    AO_t to_colour[2];
+    size_t *queue;
+    AO_t queue_end;
+};
+
+static void
+_bfs_init(struct _bfs *bfs, cugra_csr_t csr, cugra_direction_t dir,
+	  AO_t *colour_arr, size_t *queue)
+{
+    bfs->offset_arr = csr->offset_arr[dir];
+    bfs->adjacent_arr = csr->adjacent_arr[dir];
+    bfs->colour_arr = colour_arr;
+    bfs->claim_cnt = 0;
+    bfs->queue = queue;
+    AO_store(&bfs->queue_end, 0);
+}
+
+static void
+_bfs_add_claim(struct _bfs *bfs, AO_t from_colour, AO_t to_colour)
+{
+    bfs->from_colour[bfs->claim_cnt] = from_colour;
+    bfs->to_colour[bfs->claim_cnt] = to_colour;
+    ++bfs->claim_cnt;
+}
+
+CU_SINLINE cu_bool_t
+_bfs_claim(struct _bfs *bfs, size_t vi)
+{
+    AO_t colour = AO_load(&bfs->colour_arr[vi]);
+    int k;
+    for (k = 0; k < bfs->claim_cnt; ++k)
+	if (colour == bfs->from_colour[k])
+	    return AO_compare_and_swap(&bfs->colour_arr[vi],
+				       colour, bfs->to_colour[k]);
+    return cu_false;
+}
+
+static void
+_bfs_add_source(struct _bfs *bfs, size_t vi)
+{
+    if (_bfs_claim(bfs, vi)) {
+	size_t k = AO_load(&bfs->queue_end);
+	bfs->queue[k] = vi;
+	AO_store(&bfs->queue_end, k + 1);
+    }
+}
+
+static void
+_bfs_flush(struct _bfs *bfs, size_t *buf, size_t buf_cnt)
+{
+    size_t k = AO_fetch_and_add(&bfs->queue_end, buf_cnt);
+    memcpy(bfs->queue + k, buf, buf_cnt*sizeof(size_t));
+}
+
+cu_clos_def(_bfs_task, cu_prot0(void),
+    ( struct _bfs *bfs;
+      size_t begin, end; ))
+{
+    cu_clos_self(_bfs_task);
+    struct _bfs *bfs = self->bfs;
+    size_t buf[BFS_BUF_SIZE];
+    size_t buf_cnt = 0;
+    size_t i, pos;
+
+    for (i = self->begin; i < self->end; ++i) {
+	size_t vi = bfs->queue[i];
+	for (pos = bfs->offset_arr[vi]; pos < bfs->offset_arr[vi + 1]; ++pos) {
+	    size_t vj = bfs->adjacent_arr[pos];
+	    if (_bfs_claim(bfs, vj)) {
+		if (buf_cnt == BFS_BUF_SIZE) {
+		    _bfs_flush(bfs, buf, buf_cnt);
+		    buf_cnt = 0;
+		}
+		buf[buf_cnt++] = vj;
+	    }
+	}
+    }
+    _bfs_flush(bfs, buf, buf_cnt);
+}
+
+static void
+_bfs_run(struct _bfs *bfs, size_t *level_arr)
+{
+    int worker_cnt = cuflow_workers_count();
+    size_t level_begin = 0, level_end, level = 0;
+    size_t i;
+
+    while (level_begin < (level_end = AO_load(&bfs->queue_end))) {
+	size_t cnt = level_end - level_begin;
+	if (level_arr)
+	    for (i = level_begin; i < level_end; ++i)
+		level_arr[bfs->queue[i]] = level;
+	if (worker_cnt == 0 || cnt < 2*BFS_GRAIN) {
+	    _bfs_task_t task;
+	    task.bfs = bfs;
+	    task.begin = level_begin;
+	    task.end = level_end;
+	    cu_call0(_bfs_task_prep(&task));
+	}
+	else {
+	    _bfs_task_t task_arr[BFS_MAX_TASKS];
+	    size_t task_cnt = cnt/BFS_GRAIN, k;
+	    AO_t cdisj = 0;
+	    if (task_cnt > BFS_MAX_TASKS)
+		task_cnt = BFS_MAX_TASKS;
+	    for (k = 0; k < task_cnt; ++k) {
+		task_arr[k].bfs = bfs;
+		task_arr[k].begin = level_begin + cnt*k/task_cnt;
+		task_arr[k].end = level_begin + cnt*(k + 1)/task_cnt;
+		if (k + 1 < task_cnt)
+		    cuflow_sched_call(_bfs_task_prep(&task_arr[k]), &cdisj);
+		else
+		    cu_call0(_bfs_task_prep(&task_arr[k]));
+	    }
+	    cuflow_cdisj_wait_while(&cdisj);
+	}
+	level_begin = level_end;
+	++level;
+    }
+}
+
+size_t
+cugra_csr_reach(cugra_csr_t csr, cugra_direction_t dir,
+		size_t src_cnt, size_t const *src_arr,
+		size_t *reached_arr, size_t *level_arr)
+{
+    size_t n = csr->vertex_cnt;
+    AO_t *colour_arr = cu_gnewarrz_atomic(AO_t, n);
+    size_t *queue = reached_arr? reached_arr : cu_gnewarr_atomic(size_t, n);
+    struct _bfs bfs;
+    size_t i, reached_cnt;
+
+    if (level_arr)
+	for (i = 0; i < n; ++i)
+	    level_arr[i] = (size_t)-1;
+    _bfs_init(&bfs, csr, dir, colour_arr, queue);
+    _bfs_add_claim(&bfs, 0, 1);
+    for (i = 0; i < src_cnt; ++i)
+	_bfs_add_source(&bfs, src_arr[i]);
+    _bfs_run(&bfs, level_arr);
+    reached_cnt = AO_load(&bfs.queue_end);
+
+    if (!reached_arr)
+	cu_gfree_atomic(queue);
+    cu_gfree_atomic(colour_arr);
+    return reached_cnt;
+}
+
+
+/* Parallel Strongly Connected Components
+ * --------------------------------------
+ *
+ * Vertices which can not be part of a cycle are first trimmed off as
+ * singleton components.  The rest is split by forward-backward search: the
+ * vertices both reachable from and reaching a pivot form its component, and
+ * the vertices only reachable from, only reaching, or unrelated to the pivot
+ * are disjoint sets which contain whole components.  Each set carries its
+ * own colour, and is processed as a separate task. */
+
+struct _scc
+{
+    cugra_csr_t csr;
+    AO_t *colour_arr;
+    AO_t colour_pool;
+    AO_t cpt_pool;
+    size_t *cpt_arr;
+
+    /* Scratch for the sequential pass.  Each vertex is handled by one task
+     * only, so the tasks share these. */
+    size_t *index_arr;
+    size_t *low_arr;
+};
+
+struct _scc_frame
+{
+    size_t vi;
+    size_t pos;
+};
+
+/* Tarjan's algorithm on the vertices of vertex_arr which have colour. */
+static void
+_scc_seq(struct _scc *scc, size_t vertex_cnt, size_t *vertex_arr,
+	 AO_t colour)
+{
+    size_t *offset_arr = scc->csr->offset_arr[cugra_direction_out];
+    size_t *adjacent_arr = scc->csr->adjacent_arr[cugra_direction_out];
+    AO_t *colour_arr = scc->colour_arr;
+    size_t *index_arr = scc->index_arr;
+    size_t *low_arr = scc->low_arr;
+    size_t *vstack = cu_gnewarr_atomic(size_t, vertex_cnt);
+    struct _scc_frame *fstack
+	= cu_gnewarr_atomic(struct _scc_frame, vertex_cnt);
+    size_t vsp = 0, fsp = 0, index_pool = 0;
+    size_t k;
+
+#define PUSH_VERTEX(vk)							\
+    do {								\
+	index_arr[vk] = low_arr[vk] = ++index_pool;			\
+	vstack[vsp++] = vk;						\
+	fstack[fsp].vi = vk;						\
+	fstack[fsp].pos = offset_arr[vk];				\
+	++fsp;								\
+    } while (0)
+
+    for (k = 0; k < vertex_cnt; ++k) {
+	size_t vi_root = vertex_arr[k];
+	if (AO_load(&colour_arr[vi_root]) != colour || index_arr[vi_root])
+	    continue;
+	PUSH_VERTEX(vi_root);
+	while (fsp) {
+	    struct _scc_frame *frame = &fstack[fsp - 1];
+	    size_t vi = frame->vi;
+	    size_t vj;
+
+	    if (frame->pos < offset_arr[vi + 1]) {
+		vj = adjacent_arr[frame->pos++];
+		if (AO_load(&colour_arr[vj]) != colour)
+		    continue;
+		if (!index_arr[vj])
+		    PUSH_VERTEX(vj);
+		else if (index_arr[vj] < low_arr[vi])
+		    low_arr[vi] = index_arr[vj];
+		continue;
+	    }
+
+	    --fsp;
+	    if (low_arr[vi] == index_arr[vi]) {
+		size_t cpt = AO_fetch_and_add1(&scc->cpt_pool);
+		do {
+		    vj = vstack[--vsp];
+		    AO_store(&colour_arr[vj], DONE);
+		    scc->cpt_arr[vj] = cpt;
+		} while (vj != vi);
+	    }
+	    if (fsp) {
+		size_t vi_parent = fstack[fsp - 1].vi;
+		if (low_arr[vi] < low_arr[vi_parent])
+		    low_arr[vi_parent] = low_arr[vi];
+	    }
+	}
+    }
+#undef PUSH_VERTEX
+
+    cu_gfree_atomic(fstack);
+    cu_gfree_atomic(vstack);
+}
+
+cu_clos_def(_scc_task, cu_prot0(void),
+    ( struct _scc *scc;
+      size_t vertex_cnt;
+      size_t *vertex_arr;
+      AO_t colour; ))
+{
+    cu_clos_self(_scc_task);
+    struct _scc *scc = self->scc;
+    AO_t *colour_arr = scc->colour_arr;
+    size_t *vertex_arr = self->vertex_arr;
+    size_t vertex_cnt = self->vertex_cnt;
+    AO_t colour = self->colour;
+    AO_t cdisj = 0;
+
+    /* Split off the forward-only and backward-only sets as subtasks, and
+     * continue with the unrelated set in this task. */
+    while (vertex_cnt > SCC_SEQ_LIMIT) {
+	AO_t colour_fw = AO_fetch_and_add1(&scc->colour_pool);
+	AO_t colour_bw = AO_fetch_and_add1(&scc->colour_pool);
+	size_t *fw_arr = cu_gnewarr_atomic(size_t, vertex_cnt);
+	size_t *bw_arr = cu_gnewarr_atomic(size_t, vertex_cnt);
+	size_t vi_pivot = vertex_arr[vertex_cnt/2];
+	size_t fw_cnt, bw_cnt, i, j, cpt;
+	struct _bfs bfs;
+
+	_bfs_init(&bfs, scc->csr, cugra_direction_out, colour_arr, fw_arr);
+	_bfs_add_claim(&bfs, colour, colour_fw);
+	_bfs_add_source(&bfs, vi_pivot);
+	_bfs_run(&bfs, NULL);
+	fw_cnt = AO_load(&bfs.queue_end);
+
+	_bfs_init(&bfs, scc->csr, cugra_direction_in, colour_arr, bw_arr);
+	_bfs_add_claim(&bfs, colour_fw, DONE);
+	_bfs_add_claim(&bfs, colour, colour_bw);
+	_bfs_add_source(&bfs, vi_pivot);
+	_bfs_run(&bfs, NULL);
+	bw_cnt = AO_load(&bfs.queue_end);
+
+	/* The vertices claimed twice form the component of the pivot. */
+	cpt = AO_fetch_and_add1(&scc->cpt_pool);
+	for (i = j = 0; i < bw_cnt; ++i) {
+	    size_t vi = bw_arr[i];
+	    if (colour_arr[vi] == DONE)
+		scc->cpt_arr[vi] = cpt;
+	    else
+		bw_arr[j++] = vi;
+	}
+	bw_cnt = j;
+	for (i = j = 0; i < fw_cnt; ++i)
+	    if (colour_arr[fw_arr[i]] == colour_fw)
+		fw_arr[j++] = fw_arr[i];
+	fw_cnt = j;
+	for (i = j = 0; i < vertex_cnt; ++i)
+	    if (colour_arr[vertex_arr[i]] == colour)
+		vertex_arr[j++] = vertex_arr[i];
+	vertex_cnt = j;
+
+	if (fw_cnt) {
+	    _scc_task_t *sub = cu_gnew(_scc_task_t);
+	    sub->scc = scc;
+	    sub->vertex_cnt = fw_cnt;
+	    sub->vertex_arr = fw_arr;
+	    sub->colour = colour_fw;
+	    cuflow_sched_call(_scc_task_prep(sub), &cdisj);
+	}
+	if (bw_cnt) {
+	    _scc_task_t *sub = cu_gnew(_scc_task_t);
+	    sub->scc = scc;
+	    sub->vertex_cnt = bw_cnt;
+	    sub->vertex_arr = bw_arr;
+	    sub->colour = colour_bw;
+	    cuflow_sched_call(_scc_task_prep(sub), &cdisj);
+	}
+    }
+    _scc_seq(scc, vertex_cnt, vertex_arr, colour);
+    cuflow_cdisj_wait_while(&cdisj);
+}
+
+/* Assigns singleton components to vertices which have no in-arcs or no
+ * out-arcs after repeatedly removing such vertices.  Returns the number of
+ * remaining vertices, which are stored in vertex_arr. */
+static size_t
+_scc_trim(struct _scc *scc, size_t *vertex_arr)
+{
+    cugra_csr_t csr = scc->csr;
+    size_t n = csr->vertex_cnt;
+    size_t *degree_arr[2];
+    size_t *queue = cu_gnewarr_atomic(size_t, n);
+    size_t q_begin = 0, q_end = 0;
+    size_t vi, pos, k;
+    cugra_direction_t dir;
+
+    for (dir = 0; dir < 2; ++dir) {
+	degree_arr[dir] = cu_gnewarr_atomic(size_t, n);
+	for (vi = 0; vi < n; ++vi)
+	    degree_arr[dir][vi] = cugra_csr_degree(csr, dir, vi);
+    }
+    for (vi = 0; vi < n; ++vi)
+	if (!degree_arr[0][vi] || !degree_arr[1][vi]) {
+	    scc->colour_arr[vi] = DONE;
+	    queue[q_end++] = vi;
+	}
+    while (q_begin < q_end) {
+	vi = queue[q_begin++];
+	scc->cpt_arr[vi] = scc->cpt_pool++;
+
+	/* Removing vi removes an in-arc from each out-neighbour, and an
+	 * out-arc from each in-neighbour. */
+	for (dir = 0; dir < 2; ++dir) {
+	    size_t *degree_rev_arr = degree_arr[!dir];
+	    cugra_csr_for_arcs(dir, pos, csr, vi) {
+		size_t vj = cugra_csr_adjacent(csr, dir, pos);
+		if (scc->colour_arr[vj] != DONE && !--degree_rev_arr[vj]) {
+		    scc->colour_arr[vj] = DONE;
+		    queue[q_end++] = vj;
+		}
+	    }
+	}
+    }
+
+    k = 0;
+    for (vi = 0; vi < n; ++vi)
+	if (scc->colour_arr[vi] != DONE)
+	    vertex_arr[k++] = vi;
+
+    cu_gfree_atomic(degree_arr[1]);
+    cu_gfree_atomic(degree_arr[0]);
+    cu_gfree_atomic(queue);
+    return k;
+}
+
+size_t
+cugra_csr_SCC_index_par(cugra_csr_t csr, size_t *cpt_arr)
+{
+    size_t n = csr->vertex_cnt;
+    size_t *vertex_arr = cu_gnewarr_atomic(size_t, n);
+    struct _scc scc;
+    _scc_task_t task;
+    cu_bool_t own_arr = cpt_arr == NULL;
+
+    cu_debug_assert(cugra_csr_has_direction(csr, cugra_direction_in));
+    if (own_arr)
+	cpt_arr = cu_gnewarr_atomic(size_t, n);
+    scc.csr = csr;
+    scc.colour_arr = cu_gnewarrz_atomic(AO_t, n);
+    scc.colour_pool = 1;
+    scc.cpt_pool = 0;
+    scc.cpt_arr = cpt_arr;
+    scc.index_arr = cu_gnewarrz_atomic(size_t, n);
+    scc.low_arr = cu_gnewarr_atomic(size_t, n);
+
+    task.scc = &scc;
+    task.vertex_cnt = _scc_trim(&scc, vertex_arr);
+    task.vertex_arr = vertex_arr;
+    task.colour = 0;
+    cu_call0(_scc_task_prep(&task));
+
+    cu_gfree_atomic(scc.low_arr);
+    cu_gfree_atomic(scc.index_arr);
+    cu_gfree_atomic(scc.colour_arr);
+    cu_gfree_atomic(vertex_arr);
+    if (own_arr)
+	cu_gfree_atomic(cpt_arr);
+    return AO_load(&scc.cpt_pool);
+}
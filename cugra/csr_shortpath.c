@@ -0,0 +1,531 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cugra/csr.h>
+#include <cu/memory.h>
+#include <cu/diag.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#define NONE SIZE_MAX
+
+
+/* Indexed 4-ary Heap
+ * ------------------
+ *
+ * A min-heap of vertex indices with a position index, so that the key of a
+ * queued vertex can be decreased in place.  A 4-ary heap is shallower than a
+ * binary heap, and the children of a node share a cache line. */
+
+struct _heap4_entry
+{
+    double key;
+    size_t vi;
+};
+
+struct _heap4
+{
+    size_t size;
+    struct _heap4_entry *arr;
+    size_t *pos_arr;
+};
+
+static void
+_heap4_init(struct _heap4 *heap, size_t vertex_cnt)
+{
+    heap->size = 0;
+    heap->arr = cu_gnewarr_atomic(struct _heap4_entry, vertex_cnt);
+    heap->pos_arr = cu_gnewarr_atomic(size_t, vertex_cnt);
+    memset(heap->pos_arr, 0xff, vertex_cnt*sizeof(size_t));
+}
+
+static void
+_heap4_destruct(struct _heap4 *heap)
+{
+    cu_gfree_atomic(heap->pos_arr);
+    cu_gfree_atomic(heap->arr);
+}
+
+static void
+_heap4_sift_up(struct _heap4 *heap, size_t i, double key, size_t vi)
+{
+    while (i > 0) {
+	size_t i_parent = (i - 1)/4;
+	if (heap->arr[i_parent].key <= key)
+	    break;
+	heap->arr[i] = heap->arr[i_parent];
+	heap->pos_arr[heap->arr[i].vi] = i;
+	i = i_parent;
+    }
+    heap->arr[i].key = key;
+    heap->arr[i].vi = vi;
+    heap->pos_arr[vi] = i;
+}
+
+/* Inserts vi with key, or decreases its key if already queued. */
+CU_SINLINE void
+_heap4_update(struct _heap4 *heap, size_t vi, double key)
+{
+    size_t i = heap->pos_arr[vi];
+    if (i == NONE)
+	i = heap->size++;
+    _heap4_sift_up(heap, i, key, vi);
+}
+
+CU_SINLINE double
+_heap4_front_key(struct _heap4 *heap)
+{
+    return heap->size? heap->arr[0].key : INFINITY;
+}
+
+static size_t
+_heap4_pop(struct _heap4 *heap)
+{
+    size_t vi_top = heap->arr[0].vi;
+    struct _heap4_entry last = heap->arr[--heap->size];
+    size_t n = heap->size;
+    size_t i = 0;
+
+    heap->pos_arr[vi_top] = NONE;
+    if (n == 0)
+	return vi_top;
+    for (;;) {
+	size_t i_child = 4*i + 1, i_min, i_end;
+	if (i_child >= n)
+	    break;
+	i_end = i_child + 4 < n? i_child + 4 : n;
+	i_min = i_child;
+	for (++i_child; i_child < i_end; ++i_child)
+	    if (heap->arr[i_child].key < heap->arr[i_min].key)
+		i_min = i_child;
+	if (last.key <= heap->arr[i_min].key)
+	    break;
+	heap->arr[i] = heap->arr[i_min];
+	heap->pos_arr[heap->arr[i].vi] = i;
+	i = i_min;
+    }
+    heap->arr[i] = last;
+    heap->pos_arr[last.vi] = i;
+    return vi_top;
+}
+
+
+/* Radix Heap
+ * ----------
+ *
+ * A monotone priority queue for integer keys.  Bucket 0 holds keys equal to
+ * the last extracted key, and bucket b > 0 holds keys which first differ from
+ * it at bit b - 1.  When bucket 0 runs empty, the lowest non-empty bucket is
+ * redistributed relative to its minimum.  Each entry moves to lower buckets
+ * only, so operations are amortised O(log C) for the maximum key C.  Keys
+ * are not decreased in place; stale entries are skipped by the caller. */
+
+#define RADIX_BUCKET_CNT 65
+
+struct _radix_entry
+{
+    uint64_t key;
+    size_t vi;
+};
+
+struct _radix_bucket
+{
+    size_t size;
+    size_t capacity;
+    struct _radix_entry *arr;
+};
+
+struct _radix
+{
+    uint64_t last_key;
+    size_t size;
+    struct _radix_bucket bucket_arr[RADIX_BUCKET_CNT];
+};
+
+static void
+_radix_init(struct _radix *heap)
+{
+    heap->last_key = 0;
+    heap->size = 0;
+    memset(heap->bucket_arr, 0, sizeof(heap->bucket_arr));
+}
+
+static void
+_radix_destruct(struct _radix *heap)
+{
+    int b;
+    for (b = 0; b < RADIX_BUCKET_CNT; ++b)
+	if (heap->bucket_arr[b].arr)
+	    cu_gfree_atomic(heap->bucket_arr[b].arr);
+}
+
+CU_SINLINE int
+_radix_bucket_index(uint64_t last_key, uint64_t key)
+{
+    return key == last_key? 0 : 64 - __builtin_clzll(key ^ last_key);
+}
+
+static void
+_radix_bucket_push(struct _radix_bucket *bucket, uint64_t key, size_t vi)
+{
+    if (bucket->size == bucket->capacity) {
+	struct _radix_entry *arr;
+	bucket->capacity = bucket->capacity? 2*bucket->capacity : 16;
+	arr = cu_gnewarr_atomic(struct _radix_entry, bucket->capacity);
+	if (bucket->arr) {
+	    memcpy(arr, bucket->arr, bucket->size*sizeof(struct _radix_entry));
+	    cu_gfree_atomic(bucket->arr);
+	}
+	bucket->arr = arr;
+    }
+    bucket->arr[bucket->size].key = key;
+    bucket->arr[bucket->size].vi = vi;
+    ++bucket->size;
+}
+
+CU_SINLINE void
+_radix_push(struct _radix *heap, uint64_t key, size_t vi)
+{
+    cu_debug_assert(key >= heap->last_key);
+    _radix_bucket_push(&heap->bucket_arr[_radix_bucket_index(heap->last_key,
+							      key)],
+		       key, vi);
+    ++heap->size;
+}
+
+static struct _radix_entry
+_radix_pop(struct _radix *heap)
+{
+    struct _radix_bucket *bucket0 = &heap->bucket_arr[0];
+    if (bucket0->size == 0) {
+	struct _radix_bucket *bucket;
+	uint64_t key_min;
+	size_t i;
+	int b = 1;
+	while (heap->bucket_arr[b].size == 0)
+	    ++b;
+	bucket = &heap->bucket_arr[b];
+	key_min = bucket->arr[0].key;
+	for (i = 1; i < bucket->size; ++i)
+	    if (bucket->arr[i].key < key_min)
+		key_min = bucket->arr[i].key;
+	heap->last_key = key_min;
+	for (i = 0; i < bucket->size; ++i)
+	    _radix_bucket_push(
+		&heap->bucket_arr[_radix_bucket_index(key_min,
+						      bucket->arr[i].key)],
+		bucket->arr[i].key, bucket->arr[i].vi);
+	bucket->size = 0;
+    }
+    --heap->size;
+    return bucket0->arr[--bucket0->size];
+}
+
+
+/* Unidirectional Search
+ * --------------------- */
+
+struct _search
+{
+    cugra_csr_t csr;
+    cugra_direction_t dir;
+    double const *arc_distance_arr;
+    double *distance_arr;
+    size_t *pred_arr;
+    size_t *pred_pos_arr;
+    unsigned char *closed_arr;
+};
+
+static void
+_search_init(struct _search *search, cugra_csr_t csr, cugra_direction_t dir,
+	     double const *arc_distance_arr)
+{
+    size_t n = csr->vertex_cnt;
+    size_t vi;
+    search->csr = csr;
+    search->dir = dir;
+    search->arc_distance_arr = arc_distance_arr;
+    search->distance_arr = cu_gnewarr_atomic(double, n);
+    search->pred_arr = cu_gnewarr_atomic(size_t, n);
+    search->pred_pos_arr = cu_gnewarr_atomic(size_t, n);
+    search->closed_arr = cu_gnewarrz_atomic(unsigned char, n);
+    for (vi = 0; vi < n; ++vi)
+	search->distance_arr[vi] = INFINITY;
+}
+
+static void
+_search_destruct(struct _search *search)
+{
+    cu_gfree_atomic(search->closed_arr);
+    cu_gfree_atomic(search->pred_pos_arr);
+    cu_gfree_atomic(search->pred_arr);
+    cu_gfree_atomic(search->distance_arr);
+}
+
+CU_SINLINE double
+_arc_distance(struct _search *search, size_t pos)
+{
+    if (search->arc_distance_arr)
+	return search->arc_distance_arr[
+	    cugra_csr_arc_index(search->csr, search->dir, pos)];
+    else
+	return 1.0;
+}
+
+/* Calls notify_path_unwind on the arcs from vi back to the start. */
+static void
+_search_unwind(struct _search *search, size_t vi,
+	       cu_clop(notify_path_unwind, void, size_t))
+{
+    while (search->pred_arr[vi] != NONE) {
+	cu_call(notify_path_unwind,
+		cugra_csr_arc_index(search->csr, search->dir,
+				    search->pred_pos_arr[vi]));
+	vi = search->pred_arr[vi];
+    }
+}
+
+static double
+_search_run(cugra_csr_t csr, cugra_direction_t dir,
+	    cugra_shortpath_engine_t engine, size_t vi_start,
+	    cu_clop(vertex_test, cu_bool_t, size_t),
+	    cu_clop(heuristic, double, size_t),
+	    double const *arc_distance_arr,
+	    cu_clop(notify_path_unwind, void, size_t))
+{
+    size_t *offset_arr = csr->offset_arr[dir];
+    size_t *adjacent_arr = csr->adjacent_arr[dir];
+    struct _search search;
+    struct _heap4 heap4;
+    struct _radix radix;
+    double result = INFINITY;
+    double key;
+    size_t vi;
+
+    _search_init(&search, csr, dir, arc_distance_arr);
+    if (engine == cugra_shortpath_radix)
+	_radix_init(&radix);
+    else
+	_heap4_init(&heap4, csr->vertex_cnt);
+
+    search.distance_arr[vi_start] = 0.0;
+    search.pred_arr[vi_start] = NONE;
+    key = cu_clop_is_null(heuristic)? 0.0 : cu_call(heuristic, vi_start);
+    if (engine == cugra_shortpath_radix)
+	_radix_push(&radix, (uint64_t)key, vi_start);
+    else
+	_heap4_update(&heap4, vi_start, key);
+
+    for (;;) {
+	size_t pos;
+
+	/* Pop the next open vertex. */
+	if (engine == cugra_shortpath_radix) {
+	    if (radix.size == 0)
+		break;
+	    vi = _radix_pop(&radix).vi;
+	    if (search.closed_arr[vi])
+		continue;
+	}
+	else {
+	    if (heap4.size == 0)
+		break;
+	    vi = _heap4_pop(&heap4);
+	}
+	search.closed_arr[vi] = 1;
+
+	if (cu_call(vertex_test, vi)) {
+	    result = search.distance_arr[vi];
+	    _search_unwind(&search, vi, notify_path_unwind);
+	    break;
+	}
+
+	/* Relax vi */
+	for (pos = offset_arr[vi]; pos < offset_arr[vi + 1]; ++pos) {
+	    size_t vj = adjacent_arr[pos];
+	    double d_arc = _arc_distance(&search, pos);
+	    double d;
+	    if (search.closed_arr[vj] || isinf(d_arc))
+		continue;
+	    d = search.distance_arr[vi] + d_arc;
+	    if (d < search.distance_arr[vj]) {
+		search.distance_arr[vj] = d;
+		search.pred_arr[vj] = vi;
+		search.pred_pos_arr[vj] = pos;
+		key = cu_clop_is_null(heuristic)? d
+		    : d + cu_call(heuristic, vj);
+		if (engine == cugra_shortpath_radix)
+		    _radix_push(&radix, (uint64_t)key, vj);
+		else
+		    _heap4_update(&heap4, vj, key);
+	    }
+	}
+    }
+
+    if (engine == cugra_shortpath_radix)
+	_radix_destruct(&radix);
+    else
+	_heap4_destruct(&heap4);
+    _search_destruct(&search);
+    return result;
+}
+
+double
+cugra_csr_dijkstra(cugra_csr_t csr, cugra_direction_t dir,
+		   cugra_shortpath_engine_t engine, size_t vi_start,
+		   cu_clop(vertex_test, cu_bool_t, size_t),
+		   double const *arc_distance_arr,
+		   cu_clop(notify_path_unwind, void, size_t))
+{
+    return _search_run(csr, dir, engine, vi_start, vertex_test, cu_clop_null,
+		       arc_distance_arr, notify_path_unwind);
+}
+
+double
+cugra_csr_shortest_path(cugra_csr_t csr, cugra_direction_t dir,
+			size_t vi_start,
+			cu_clop(vertex_test, cu_bool_t, size_t),
+			double const *arc_distance_arr,
+			cu_clop(notify_path_unwind, void, size_t))
+{
+    return _search_run(csr, dir, cugra_shortpath_heap4, vi_start,
+		       vertex_test, cu_clop_null,
+		       arc_distance_arr, notify_path_unwind);
+}
+
+cu_clos_def(_is_goal, cu_prot(cu_bool_t, size_t vi), (size_t vi_goal;))
+{
+    cu_clos_self(_is_goal);
+    return vi == self->vi_goal;
+}
+
+double
+cugra_csr_astar(cugra_csr_t csr, cugra_direction_t dir,
+		cugra_shortpath_engine_t engine,
+		size_t vi_start, size_t vi_goal,
+		cu_clop(heuristic, double, size_t),
+		double const *arc_distance_arr,
+		cu_clop(notify_path_unwind, void, size_t))
+{
+    _is_goal_t is_goal;
+    is_goal.vi_goal = vi_goal;
+    return _search_run(csr, dir, engine, vi_start, _is_goal_prep(&is_goal),
+		       heuristic, arc_distance_arr, notify_path_unwind);
+}
+
+
+/* Bidirectional Search
+ * -------------------- */
+
+double
+cugra_csr_shortest_path_bidir(cugra_csr_t csr,
+			      size_t vi_start, size_t vi_goal,
+			      double const *arc_distance_arr,
+			      cu_clop(notify_path_unwind, void, size_t))
+{
+    struct _search search[2];
+    struct _heap4 heap[2];
+    double mu = INFINITY;
+    size_t vi_meet = NONE;
+    cugra_direction_t dir;
+
+    cu_debug_assert(cugra_csr_has_direction(csr, cugra_direction_in));
+    for (dir = 0; dir < 2; ++dir) {
+	_search_init(&search[dir], csr, dir, arc_distance_arr);
+	_heap4_init(&heap[dir], csr->vertex_cnt);
+    }
+    search[cugra_direction_out].distance_arr[vi_start] = 0.0;
+    search[cugra_direction_out].pred_arr[vi_start] = NONE;
+    _heap4_update(&heap[cugra_direction_out], vi_start, 0.0);
+    search[cugra_direction_in].distance_arr[vi_goal] = 0.0;
+    search[cugra_direction_in].pred_arr[vi_goal] = NONE;
+    _heap4_update(&heap[cugra_direction_in], vi_goal, 0.0);
+    if (vi_start == vi_goal) {
+	mu = 0.0;
+	vi_meet = vi_start;
+    }
+
+    /* Expand the side with the smaller front until no shorter path can be
+     * found through the unexplored vertices. */
+    while (heap[0].size && heap[1].size &&
+	   _heap4_front_key(&heap[0]) + _heap4_front_key(&heap[1]) < mu) {
+	struct _search *s;
+	size_t *offset_arr, *adjacent_arr;
+	double *other_distance_arr;
+	size_t vi, pos;
+
+	dir = _heap4_front_key(&heap[0]) <= _heap4_front_key(&heap[1])
+	    ? cugra_direction_out : cugra_direction_in;
+	s = &search[dir];
+	offset_arr = csr->offset_arr[dir];
+	adjacent_arr = csr->adjacent_arr[dir];
+	other_distance_arr = search[!dir].distance_arr;
+	vi = _heap4_pop(&heap[dir]);
+	s->closed_arr[vi] = 1;
+
+	for (pos = offset_arr[vi]; pos < offset_arr[vi + 1]; ++pos) {
+	    size_t vj = adjacent_arr[pos];
+	    double d_arc = _arc_distance(s, pos);
+	    double d;
+	    if (s->closed_arr[vj] || isinf(d_arc))
+		continue;
+	    d = s->distance_arr[vi] + d_arc;
+	    if (d < s->distance_arr[vj]) {
+		s->distance_arr[vj] = d;
+		s->pred_arr[vj] = vi;
+		s->pred_pos_arr[vj] = pos;
+		_heap4_update(&heap[dir], vj, d);
+	    }
+	    if (s->distance_arr[vj] + other_distance_arr[vj] < mu) {
+		mu = s->distance_arr[vj] + other_distance_arr[vj];
+		vi_meet = vj;
+	    }
+	}
+    }
+
+    if (vi_meet != NONE) {
+	/* The backward search has the arcs from vi_meet to vi_goal in forward
+	 * order, so reverse them before continuing towards vi_start. */
+	struct _search *s = &search[cugra_direction_in];
+	size_t cnt = 0, vi = vi_meet;
+	size_t *ai_arr;
+	while (s->pred_arr[vi] != NONE) {
+	    ++cnt;
+	    vi = s->pred_arr[vi];
+	}
+	ai_arr = cu_gnewarr_atomic(size_t, cnt);
+	cnt = 0;
+	vi = vi_meet;
+	while (s->pred_arr[vi] != NONE) {
+	    ai_arr[cnt++] = cugra_csr_arc_index(csr, cugra_direction_in,
+						s->pred_pos_arr[vi]);
+	    vi = s->pred_arr[vi];
+	}
+	while (cnt)
+	    cu_call(notify_path_unwind, ai_arr[--cnt]);
+	cu_gfree_atomic(ai_arr);
+	_search_unwind(&search[cugra_direction_out], vi_meet,
+		       notify_path_unwind);
+    }
+
+    for (dir = 0; dir < 2; ++dir) {
+	_heap4_destruct(&heap[dir]);
+	_search_destruct(&search[dir]);
+    }
+    return mu;
+}
@@ -0,0 +1,425 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cugra/csr.h>
+#include <cugra/graph_algo.h>
+#include <cu/test.h>
+#include <cu/memory.h>
+#include <cuflow/workers.h>
+#include <math.h>
+#include <string.h>
+
+#define nV 200
+
+cu_clop_def(_random_distance, void, cugra_arc_t a, void *dst)
+{
+    *(double *)dst = (lrand48() % 16 == 0)? INFINITY : lrand48() % 100;
+}
+
+static cugra_graph_t
+_random_graph(int nA, cu_bool_t acyclic, cugra_vertex_t *v_arr)
+{
+    cugra_graph_t G = cugra_graph_new(0);
+    int i;
+    for (i = 0; i < nV; ++i)
+	v_arr[i] = cugra_graph_vertex_new(G);
+    for (i = 0; i < nA; ++i) {
+	int k = lrand48() % nV;
+	int l = lrand48() % nV;
+	if (acyclic && k >= l)
+	    continue;
+	cugra_connect(G, v_arr[k], v_arr[l]);
+    }
+    return G;
+}
+
+static void
+_check_structure(cugra_graph_t G, cugra_csr_t csr)
+{
+    size_t vi, ai, pos, n_in;
+    cu_test_assert_size_eq(cugra_csr_vertex_count(csr), nV);
+    for (vi = 0; vi < nV; ++vi) {
+	cugra_vertex_t v = cugra_csr_vertex(csr, vi);
+	cugra_arc_t a;
+	cu_test_assert_size_eq(cugra_csr_vertex_index(csr, v), vi);
+
+	/* Out-arcs are in the order of the graph. */
+	pos = cugra_csr_arcs_begin(csr, cugra_direction_out, vi);
+	cugra_vertex_for_outarcs(a, v) {
+	    cu_test_assert(pos < cugra_csr_arcs_end(csr, cugra_direction_out,
+						     vi));
+	    cu_test_assert_ptr_eq(cugra_csr_arc(csr, pos), a);
+	    cu_test_assert_ptr_eq(
+		cugra_csr_vertex(csr, cugra_csr_adjacent(csr,
+					cugra_direction_out, pos)),
+		cugra_arc_head(a));
+	    ++pos;
+	}
+	cu_test_assert_size_eq(pos,
+			       cugra_csr_arcs_end(csr, cugra_direction_out, vi));
+
+	/* In-arcs are ordered by tail index. */
+	n_in = 0;
+	cugra_vertex_for_inarcs(a, v)
+	    ++n_in;
+	cu_test_assert_size_eq(cugra_csr_degree(csr, cugra_direction_in, vi),
+			       n_in);
+	cugra_csr_for_arcs(cugra_direction_in, pos, csr, vi) {
+	    ai = cugra_csr_arc_index(csr, cugra_direction_in, pos);
+	    cu_test_assert_ptr_eq(cugra_arc_head(cugra_csr_arc(csr, ai)), v);
+	    cu_test_assert_size_eq(cugra_csr_arc_tail(csr, ai),
+				   cugra_csr_adjacent(csr, cugra_direction_in,
+						      pos));
+	}
+    }
+    for (ai = 0; ai < cugra_csr_arc_count(csr); ++ai) {
+	cugra_arc_t a = cugra_csr_arc(csr, ai);
+	cu_test_assert_ptr_eq(cugra_csr_vertex(csr, cugra_csr_arc_tail(csr, ai)),
+			      cugra_arc_tail(a));
+	cu_test_assert_ptr_eq(cugra_csr_vertex(csr, cugra_csr_arc_head(csr, ai)),
+			      cugra_arc_head(a));
+    }
+}
+
+static void
+_reach(cugra_csr_t csr, size_t vi, char *reached)
+{
+    size_t pos;
+    if (reached[vi])
+	return;
+    reached[vi] = 1;
+    cugra_csr_for_arcs(cugra_direction_out, pos, csr, vi)
+	_reach(csr, cugra_csr_adjacent(csr, cugra_direction_out, pos), reached);
+}
+
+static void
+_check_SCC(cugra_csr_t csr)
+{
+    static char reach[nV][nV];
+    size_t cpt_arr[nV];
+    size_t vi, vj, pos;
+
+    cugra_csr_SCC_index(csr, cpt_arr);
+    memset(reach, 0, sizeof(reach));
+    for (vi = 0; vi < nV; ++vi)
+	_reach(csr, vi, reach[vi]);
+    for (vi = 0; vi < nV; ++vi) {
+	for (vj = 0; vj < nV; ++vj)
+	    cu_test_assert(!(reach[vi][vj] && reach[vj][vi])
+			   == (cpt_arr[vi] != cpt_arr[vj]));
+	cugra_csr_for_arcs(cugra_direction_out, pos, csr, vi)
+	    cu_test_assert(cpt_arr[vi] >=
+		cpt_arr[cugra_csr_adjacent(csr, cugra_direction_out, pos)]);
+    }
+}
+
+struct _count_walk
+{
+    cu_inherit (cugra_walk_SCC);
+    size_t cpt_cnt, vertex_cnt, connect_cnt;
+};
+
+static void *
+_count_enter_component(cugra_walk_SCC_t self)
+{
+    return (void *)++cu_from(_count_walk, cugra_walk_SCC, self)->cpt_cnt;
+}
+
+static void
+_count_pass_vertex(cugra_walk_SCC_t self, void *cpt, cugra_vertex_t v)
+{
+    ++cu_from(_count_walk, cugra_walk_SCC, self)->vertex_cnt;
+}
+
+static void
+_count_leave_component(cugra_walk_SCC_t self, void *cpt) {}
+
+static void
+_count_connect_components(cugra_walk_SCC_t self, void *tail, void *head)
+{
+    /* Sub-components are entered first. */
+    cu_test_assert((uintptr_t)tail > (uintptr_t)head);
+    ++cu_from(_count_walk, cugra_walk_SCC, self)->connect_cnt;
+}
+
+static struct cugra_walk_SCC_vt _count_walk_vt = {
+    .enter_component = _count_enter_component,
+    .pass_vertex = _count_pass_vertex,
+    .leave_component = _count_leave_component,
+    .connect_components = _count_connect_components,
+};
+
+static void
+_check_walk_SCC(cugra_csr_t csr)
+{
+    struct _count_walk walk;
+    cu_to(cugra_walk_SCC, &walk)->vt = &_count_walk_vt;
+    walk.cpt_cnt = walk.vertex_cnt = walk.connect_cnt = 0;
+    cugra_csr_walk_SCC(cu_to(cugra_walk_SCC, &walk), csr,
+		       cugra_direction_out);
+    cu_test_assert_size_eq(walk.cpt_cnt, cugra_csr_SCC_index(csr, NULL));
+    cu_test_assert_size_eq(walk.vertex_cnt, nV);
+    cu_test_assert(walk.connect_cnt <= cugra_csr_arc_count(csr));
+}
+
+cu_clos_def(_is_target, cu_prot(cu_bool_t, size_t vi), (size_t vi_target;))
+{
+    cu_clos_self(_is_target);
+    return vi == self->vi_target;
+}
+
+cu_clos_def(_unwind, cu_prot(void, size_t ai),
+    ( cugra_csr_t csr;
+      size_t vi_cur;
+      double distance; ))
+{
+    cu_clos_self(_unwind);
+    cu_test_assert_size_eq(cugra_csr_arc_head(self->csr, ai), self->vi_cur);
+    self->vi_cur = cugra_csr_arc_tail(self->csr, ai);
+    self->distance += *(double *)cugra_csr_arc_payload(self->csr, ai);
+}
+
+static size_t _exact_call_cnt, _zero_call_cnt;
+
+/* Returns h_arr[vi], or 0 if h_arr is NULL, and counts the calls. */
+cu_clos_def(_heuristic, cu_prot(double, size_t vi),
+    ( double const *h_arr;
+      size_t call_cnt; ))
+{
+    cu_clos_self(_heuristic);
+    ++self->call_cnt;
+    return self->h_arr? self->h_arr[vi] : 0.0;
+}
+
+/* Sets h_arr to the distances to vi_goal, capped to a bound above any
+ * finite distance.  These are the best possible consistent heuristic. */
+static void
+_reverse_distances(cugra_csr_t csr, size_t vi_goal, double *h_arr)
+{
+    size_t vi, ai;
+    cu_bool_t changed;
+    for (vi = 0; vi < nV; ++vi)
+	h_arr[vi] = INFINITY;
+    h_arr[vi_goal] = 0.0;
+    do {
+	changed = cu_false;
+	for (ai = 0; ai < cugra_csr_arc_count(csr); ++ai) {
+	    size_t vT = cugra_csr_arc_tail(csr, ai);
+	    size_t vH = cugra_csr_arc_head(csr, ai);
+	    double d = h_arr[vH] + *(double *)cugra_csr_arc_payload(csr, ai);
+	    if (d < h_arr[vT]) {
+		h_arr[vT] = d;
+		changed = cu_true;
+	    }
+	}
+    } while (changed);
+    for (vi = 0; vi < nV; ++vi)
+	if (isinf(h_arr[vi]))
+	    h_arr[vi] = 100.0*nV;
+}
+
+static void
+_check_shortest_path(cugra_csr_t csr)
+{
+    double dist[nV], h_arr[nV];
+    size_t vi, ai, vi_start = lrand48() % nV;
+    cu_bool_t changed;
+    _heuristic_t zero, exact;
+
+    /* Bellman-Ford */
+    for (vi = 0; vi < nV; ++vi)
+	dist[vi] = INFINITY;
+    dist[vi_start] = 0.0;
+    do {
+	changed = cu_false;
+	for (ai = 0; ai < cugra_csr_arc_count(csr); ++ai) {
+	    size_t vT = cugra_csr_arc_tail(csr, ai);
+	    size_t vH = cugra_csr_arc_head(csr, ai);
+	    double d = dist[vT] + *(double *)cugra_csr_arc_payload(csr, ai);
+	    if (d < dist[vH]) {
+		dist[vH] = d;
+		changed = cu_true;
+	    }
+	}
+    } while (changed);
+
+    zero.h_arr = NULL;
+    zero.call_cnt = 0;
+    exact.h_arr = h_arr;
+    exact.call_cnt = 0;
+    for (vi = 0; vi < nV; ++vi) {
+	int k;
+	_reverse_distances(csr, vi, h_arr);
+	for (k = 0; k < 7; ++k) {
+	    _is_target_t is_target;
+	    _unwind_t unwind;
+	    double d;
+	    is_target.vi_target = vi;
+	    unwind.csr = csr;
+	    unwind.vi_cur = vi;
+	    unwind.distance = 0.0;
+	    switch (k) {
+		case 0:
+		    d = cugra_csr_shortest_path(csr, cugra_direction_out,
+						vi_start,
+						_is_target_prep(&is_target),
+						csr->arc_payload_arr,
+						_unwind_prep(&unwind));
+		    break;
+		case 1:
+		    d = cugra_csr_dijkstra(csr, cugra_direction_out,
+					   cugra_shortpath_radix, vi_start,
+					   _is_target_prep(&is_target),
+					   csr->arc_payload_arr,
+					   _unwind_prep(&unwind));
+		    break;
+		case 2:
+		case 3:
+		    d = cugra_csr_astar(csr, cugra_direction_out,
+					k == 2? cugra_shortpath_heap4
+					      : cugra_shortpath_radix,
+					vi_start, vi, _heuristic_prep(&zero),
+					csr->arc_payload_arr,
+					_unwind_prep(&unwind));
+		    break;
+		case 4:
+		case 5:
+		    d = cugra_csr_astar(csr, cugra_direction_out,
+					k == 4? cugra_shortpath_heap4
+					      : cugra_shortpath_radix,
+					vi_start, vi, _heuristic_prep(&exact),
+					csr->arc_payload_arr,
+					_unwind_prep(&unwind));
+		    break;
+		default:
+		    d = cugra_csr_shortest_path_bidir(csr, vi_start, vi,
+						      csr->arc_payload_arr,
+						      _unwind_prep(&unwind));
+		    break;
+	    }
+	    cu_test_assert(d == dist[vi]);
+	    if (!isinf(d)) {
+		cu_test_assert(unwind.distance == d);
+		cu_test_assert_size_eq(unwind.vi_cur, vi_start);
+	    }
+	}
+    }
+
+    /* With exact distances, A* only expands vertices on shortest paths, so
+     * it must not reach more vertices than without a heuristic.  Over all
+     * tests it must reach clearly fewer, which is checked in main. */
+    cu_test_assert(exact.call_cnt <= zero.call_cnt);
+    _exact_call_cnt += exact.call_cnt;
+    _zero_call_cnt += zero.call_cnt;
+}
+
+/* Check that cpt_arr0 and cpt_arr1 define the same partition. */
+static void
+_check_same_partition(size_t n, size_t cpt_cnt,
+		      size_t *cpt_arr0, size_t *cpt_arr1)
+{
+    size_t *map01 = cu_gnewarr_atomic(size_t, cpt_cnt);
+    size_t *map10 = cu_gnewarr_atomic(size_t, cpt_cnt);
+    size_t vi;
+    memset(map01, 0xff, cpt_cnt*sizeof(size_t));
+    memset(map10, 0xff, cpt_cnt*sizeof(size_t));
+    for (vi = 0; vi < n; ++vi) {
+	size_t c0 = cpt_arr0[vi], c1 = cpt_arr1[vi];
+	cu_test_assert(c0 < cpt_cnt && c1 < cpt_cnt);
+	if (map01[c0] == (size_t)-1 && map10[c1] == (size_t)-1) {
+	    map01[c0] = c1;
+	    map10[c1] = c0;
+	}
+	cu_test_assert_size_eq(map01[c0], c1);
+	cu_test_assert_size_eq(map10[c1], c0);
+    }
+}
+
+static void
+test_par(size_t n, size_t m)
+{
+    cugra_graph_t G = cugra_graph_new(0);
+    cugra_vertex_t *v_arr = cu_gnewarr(cugra_vertex_t, n);
+    size_t *cpt_arr0 = cu_gnewarr_atomic(size_t, n);
+    size_t *cpt_arr1 = cu_gnewarr_atomic(size_t, n);
+    size_t *level_arr = cu_gnewarr_atomic(size_t, n);
+    size_t *reached_arr = cu_gnewarr_atomic(size_t, n);
+    size_t cpt_cnt, reached_cnt, vi, pos, src = 0;
+    cugra_csr_t csr;
+
+    for (vi = 0; vi < n; ++vi)
+	v_arr[vi] = cugra_graph_vertex_new(G);
+    for (vi = 0; vi < m; ++vi)
+	cugra_connect(G, v_arr[lrand48() % n], v_arr[lrand48() % n]);
+    csr = cugra_csr_new(G, 0, 0, cu_clop_null);
+
+    cpt_cnt = cugra_csr_SCC_index(csr, cpt_arr0);
+    cu_test_assert_size_eq(cugra_csr_SCC_index_par(csr, cpt_arr1), cpt_cnt);
+    _check_same_partition(n, cpt_cnt, cpt_arr0, cpt_arr1);
+
+    /* The levels must be consistent with the arcs. */
+    reached_cnt = cugra_csr_reach(csr, cugra_direction_out, 1, &src,
+				  reached_arr, level_arr);
+    cu_test_assert_size_eq(level_arr[src], 0);
+    for (vi = 0; vi < reached_cnt; ++vi)
+	cu_test_assert(level_arr[reached_arr[vi]] != (size_t)-1);
+    for (vi = 0; vi < n; ++vi) {
+	if (level_arr[vi] == (size_t)-1)
+	    continue;
+	--reached_cnt;
+	cugra_csr_for_arcs(cugra_direction_out, pos, csr, vi) {
+	    size_t vj = cugra_csr_adjacent(csr, cugra_direction_out, pos);
+	    cu_test_assert(level_arr[vj] <= level_arr[vi] + 1);
+	}
+    }
+    cu_test_assert_size_eq(reached_cnt, 0);
+}
+
+static void
+test(int nA, cu_bool_t acyclic)
+{
+    cugra_vertex_t v_arr[nV];
+    cugra_graph_t G = _random_graph(nA, acyclic, v_arr);
+    cugra_csr_t csr = cugra_csr_new(G, CUGRA_CSR_KEEP_ARCS, sizeof(double),
+				    _random_distance);
+    _check_structure(G, csr);
+    _check_SCC(csr);
+    _check_walk_SCC(csr);
+    cu_test_assert(cugra_csr_is_acyclic(csr) == cugra_graph_is_acyclic(G));
+    if (acyclic)
+	cu_test_assert(cugra_csr_is_acyclic(csr));
+    _check_shortest_path(csr);
+}
+
+int
+main()
+{
+    int i;
+    cugra_init();
+    for (i = 0; i < 10; ++i) {
+	test(100 + 40*i, cu_false);
+	test(100 + 40*i, cu_true);
+    }
+    cu_test_assert(4*_exact_call_cnt < 3*_zero_call_cnt);
+    for (i = 0; i < 3; ++i) {
+	cuflow_workers_spawn(2*i);
+	test_par(20000, 24000);
+	test_par(20000, 60000);
+    }
+    cuflow_workers_spawn(0);
+    return 2*!!cu_test_bug_count();
+}
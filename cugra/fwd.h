@@ -25,6 +25,7 @@ CU_BEGIN_DECLARATIONS
 typedef struct cugra_graph *cugra_graph_t;
 typedef struct cugra_vertex *cugra_vertex_t;
 typedef struct cugra_arc *cugra_arc_t;
+typedef struct cugra_csr *cugra_csr_t;
 
 void cugra_init(void);
 
@@ -33,9 +33,24 @@ struct dij_vertex_s
     dij_vertex_t prev;
 };
 
-cu_clop_def(dij_vertex_prior, cu_bool_t, dij_vertex_t v0, dij_vertex_t v1)
+/* A queue entry.  A vertex is re-queued when its distance decreases, and
+ * entries whose distance no longer matches are skipped. */
+struct dij_entry_s
 {
-    return v0->distance < v1->distance;
+    double distance;
+    dij_vertex_t dij_v;
+};
+
+#define DIJ_ENTRY_PRIOR(e0, e1) ((e0).distance < (e1).distance)
+CUCON_PRIQ_TEMPLATE(dij_queue, struct dij_entry_s, 4, DIJ_ENTRY_PRIOR)
+
+CU_SINLINE void
+dij_enqueue(dij_queue_t q, dij_vertex_t dij_v)
+{
+    struct dij_entry_s e;
+    e.distance = dij_v->distance;
+    e.dij_v = dij_v;
+    dij_queue_insert(q, e);
 }
 
 double
@@ -44,7 +59,7 @@ cugra_shortest_path(cugra_direction_t dir, cugra_vertex_t v_start,
 		    cu_clop(arc_distance, double, cugra_arc_t),
 		    cu_clop(path_unwind, void, cugra_arc_t))
 {
-    struct cucon_priq q;
+    struct dij_queue q;
     struct cucon_pmap vprop;
     dij_vertex_t dij_v;
     cucon_pmap_init(&vprop);
@@ -54,18 +69,21 @@ cugra_shortest_path(cugra_direction_t dir, cugra_vertex_t v_start,
     dij_v->vertex = v_start;
     dij_v->arc = NULL;
     dij_v->prev = NULL;
-    cucon_priq_init(&q, (cu_clop(, cu_bool_t, void*, void*))dij_vertex_prior);
-    cucon_priq_insert(&q, dij_v);
-    while (!cucon_priq_is_empty(&q)) {
+    dij_queue_init(&q);
+    dij_enqueue(&q, dij_v);
+    while (!dij_queue_is_empty(&q)) {
 	cugra_vertex_t v;
 	cugra_arc_t a;
-	dij_v = cucon_priq_pop_front(&q);
+	struct dij_entry_s e = dij_queue_pop_front(&q);
+	dij_v = e.dij_v;
+	if (dij_v->colour == cucon_algo_colour_black ||
+	    e.distance > dij_v->distance)
+	    continue;
 	v = dij_v->vertex;
 	if (cu_call(vertex_test, v)) {
-	    double distance = 0.0;
+	    double distance = dij_v->distance;
 	    while (dij_v->arc != NULL) {
 		cu_call(path_unwind, dij_v->arc);
-		distance += dij_v->distance;
 		dij_v = dij_v->prev;
 	    }
 	    return distance;
@@ -89,14 +107,14 @@ cugra_shortest_path(cugra_direction_t dir, cugra_vertex_t v_start,
 		dij_u->arc = a;
 		dij_u->prev = dij_v;
 		dij_u->distance = s_u_try;
-		cucon_priq_insert(&q, dij_u);
+		dij_enqueue(&q, dij_u);
 	    }
 	    else if (dij_u->colour == cucon_algo_colour_grey &&
-		     dij_u->distance < s_u_try) {
+		     s_u_try < dij_u->distance) {
 		dij_u->arc = a;
 		dij_u->distance = s_u_try;
 		dij_u->prev = dij_v;
-		cucon_priq_insert(&q, dij_u);
+		dij_enqueue(&q, dij_u);
 	    }
 	}
 	dij_v->colour = cucon_algo_colour_black;
@@ -16,6 +16,7 @@
  */
 
 #include <cugra/fwd.h>
+#include <cuflow/fwd.h>
 #include <cu/diag.h>
 #ifdef CUCONF_HAVE_BUDDY
 #include <bdd.h>
@@ -38,6 +39,7 @@ cugra_init(void)
     done_init = 1;
 
     cu_init();
+    cuflow_init();
 
 #ifdef CUCONF_HAVE_BUDDY
     bdd_init(10000, 1000);
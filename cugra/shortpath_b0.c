@@ -0,0 +1,218 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cugra/csr.h>
+#include <cugra/graph_algo.h>
+#include <cuflow/time.h>
+#include <cu/test.h>
+#include <cu/memory.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define QUERY_CNT 20
+
+/* Arcs carry an integer distance in their slot, so that the same weights are
+ * seen by the pointer-based search and, via the CSR payload, by all the
+ * engines. */
+static cugra_arc_t
+_connect(cugra_graph_t G, cugra_vertex_t tail, cugra_vertex_t head, double d)
+{
+    cugra_arc_t a;
+    cugra_connect_custom(G, tail, head,
+			 sizeof(struct cugra_arc) + sizeof(double), &a);
+    *(double *)cugra_arc_mem(a) = d;
+    return a;
+}
+
+/* Uniformly random arcs with distances in [0, 1000). */
+static cugra_graph_t
+_random_graph(size_t n, size_t m)
+{
+    cugra_graph_t G = cugra_graph_new(0);
+    cugra_vertex_t *v_arr = cu_gnewarr(cugra_vertex_t, n);
+    size_t i;
+    for (i = 0; i < n; ++i)
+	v_arr[i] = cugra_graph_vertex_new_mem(G, 2*sizeof(int));
+    for (i = 0; i < m; ++i)
+	_connect(G, v_arr[lrand48() % n], v_arr[lrand48() % n],
+		 lrand48() % 1000);
+    return G;
+}
+
+/* A w by w grid with arcs in both directions between neighbours.  Distances
+ * are at least 10, so that 10 times the Manhattan distance is a consistent
+ * heuristic. */
+static cugra_graph_t
+_grid_graph(int w)
+{
+    cugra_graph_t G = cugra_graph_new(0);
+    cugra_vertex_t *v_arr = cu_gnewarr(cugra_vertex_t, w*w);
+    int x, y;
+    for (y = 0; y < w; ++y)
+	for (x = 0; x < w; ++x) {
+	    cugra_vertex_t v = cugra_graph_vertex_new_mem(G, 2*sizeof(int));
+	    ((int *)cugra_vertex_mem(v))[0] = x;
+	    ((int *)cugra_vertex_mem(v))[1] = y;
+	    v_arr[y*w + x] = v;
+	}
+    for (y = 0; y < w; ++y)
+	for (x = 0; x < w; ++x) {
+	    cugra_vertex_t v = v_arr[y*w + x];
+	    if (x + 1 < w) {
+		_connect(G, v, v_arr[y*w + x + 1], 10 + lrand48() % 20);
+		_connect(G, v_arr[y*w + x + 1], v, 10 + lrand48() % 20);
+	    }
+	    if (y + 1 < w) {
+		_connect(G, v, v_arr[(y + 1)*w + x], 10 + lrand48() % 20);
+		_connect(G, v_arr[(y + 1)*w + x], v, 10 + lrand48() % 20);
+	    }
+	}
+    return G;
+}
+
+cu_clop_def(_copy_distance, void, cugra_arc_t a, void *dst)
+{
+    *(double *)dst = *(double *)cugra_arc_mem(a);
+}
+
+cu_clop_def(_arc_distance, double, cugra_arc_t a)
+{
+    return *(double *)cugra_arc_mem(a);
+}
+
+cu_clos_def(_is_vertex, cu_prot(cu_bool_t, cugra_vertex_t v),
+    ( cugra_vertex_t v_goal; ))
+{
+    cu_clos_self(_is_vertex);
+    return v == self->v_goal;
+}
+
+cu_clos_def(_is_index, cu_prot(cu_bool_t, size_t vi),
+    ( size_t vi_goal; ))
+{
+    cu_clos_self(_is_index);
+    return vi == self->vi_goal;
+}
+
+cu_clop_def(_ignore_arc, void, cugra_arc_t a) {}
+cu_clop_def(_ignore_index, void, size_t ai) {}
+
+cu_clos_def(_manhattan, cu_prot(double, size_t vi),
+    ( cugra_csr_t csr;
+      int x_goal, y_goal; ))
+{
+    cu_clos_self(_manhattan);
+    int *xy = cugra_vertex_mem(cugra_csr_vertex(self->csr, vi));
+    return 10.0*(abs(xy[0] - self->x_goal) + abs(xy[1] - self->y_goal));
+}
+
+static double
+_seconds(cuflow_walltime_t t)
+{
+    return t/(double)CUFLOW_WALLTIME_SECOND;
+}
+
+static void
+bench(char const *name, cugra_graph_t G, cu_bool_t is_grid)
+{
+    size_t n;
+    size_t start_arr[QUERY_CNT], goal_arr[QUERY_CNT];
+    double dist_arr[QUERY_CNT];
+    cuflow_walltime_t t;
+    cugra_csr_t csr;
+    double const *arc_distance_arr;
+    int i, k;
+
+    printf("%s\n", name);
+    t = -cuflow_walltime();
+    csr = cugra_csr_new(G, 0, sizeof(double), _copy_distance);
+    t += cuflow_walltime();
+    printf("    CSR build:              %8.3lf s\n", _seconds(t));
+    n = cugra_csr_vertex_count(csr);
+    arc_distance_arr = csr->arc_payload_arr;
+    for (i = 0; i < QUERY_CNT; ++i) {
+	start_arr[i] = lrand48() % n;
+	goal_arr[i] = lrand48() % n;
+    }
+
+    t = -cuflow_walltime();
+    for (i = 0; i < QUERY_CNT; ++i) {
+	_is_vertex_t is_vertex;
+	is_vertex.v_goal = cugra_csr_vertex(csr, goal_arr[i]);
+	dist_arr[i] = cugra_shortest_path(
+		cugra_direction_out, cugra_csr_vertex(csr, start_arr[i]),
+		_is_vertex_prep(&is_vertex), _arc_distance, _ignore_arc);
+    }
+    t += cuflow_walltime();
+    printf("    cugra_shortest_path:    %8.3lf s\n", _seconds(t));
+
+    for (k = 0; k < 2; ++k) {
+	cugra_shortpath_engine_t engine
+	    = k == 0? cugra_shortpath_heap4 : cugra_shortpath_radix;
+	char const *engine_name = k == 0? "heap4" : "radix";
+
+	t = -cuflow_walltime();
+	for (i = 0; i < QUERY_CNT; ++i) {
+	    _is_index_t is_index;
+	    is_index.vi_goal = goal_arr[i];
+	    cu_test_assert(dist_arr[i] ==
+		cugra_csr_dijkstra(csr, cugra_direction_out, engine,
+				   start_arr[i], _is_index_prep(&is_index),
+				   arc_distance_arr, _ignore_index));
+	}
+	t += cuflow_walltime();
+	printf("    Dijkstra, %s:        %8.3lf s\n", engine_name, _seconds(t));
+
+	if (is_grid) {
+	    t = -cuflow_walltime();
+	    for (i = 0; i < QUERY_CNT; ++i) {
+		_manhattan_t manhattan;
+		int *xy = cugra_vertex_mem(cugra_csr_vertex(csr, goal_arr[i]));
+		manhattan.csr = csr;
+		manhattan.x_goal = xy[0];
+		manhattan.y_goal = xy[1];
+		cu_test_assert(dist_arr[i] ==
+		    cugra_csr_astar(csr, cugra_direction_out, engine,
+				    start_arr[i], goal_arr[i],
+				    _manhattan_prep(&manhattan),
+				    arc_distance_arr, _ignore_index));
+	    }
+	    t += cuflow_walltime();
+	    printf("    A*, %s:              %8.3lf s\n",
+		   engine_name, _seconds(t));
+	}
+    }
+
+    t = -cuflow_walltime();
+    for (i = 0; i < QUERY_CNT; ++i)
+	cu_test_assert(dist_arr[i] ==
+	    cugra_csr_shortest_path_bidir(csr, start_arr[i], goal_arr[i],
+					  arc_distance_arr, _ignore_index));
+    t += cuflow_walltime();
+    printf("    bidirectional, heap4:   %8.3lf s\n", _seconds(t));
+}
+
+int
+main()
+{
+    cugra_init();
+    bench("Random, 2^18 vertices, 2^20 arcs",
+	  _random_graph(1 << 18, 1 << 20), cu_false);
+    bench("Grid, 512 x 512", _grid_graph(512), cu_true);
+    return 2*!!cu_test_bug_count();
+}
@@ -0,0 +1,163 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cugra/graph.h>
+#include <cugra/graph_algo.h>
+#include <cu/test.h>
+#include <cu/memory.h>
+#include <math.h>
+
+#define nV 100
+
+/* Arcs carry their distance in their slot. */
+static cugra_arc_t
+_connect(cugra_graph_t G, cugra_vertex_t tail, cugra_vertex_t head, double d)
+{
+    cugra_arc_t a;
+    cugra_connect_custom(G, tail, head,
+			 sizeof(struct cugra_arc) + sizeof(double), &a);
+    *(double *)cugra_arc_mem(a) = d;
+    return a;
+}
+
+cu_clop_def(_arc_distance, double, cugra_arc_t a)
+{
+    return *(double *)cugra_arc_mem(a);
+}
+
+cu_clos_def(_is_vertex, cu_prot(cu_bool_t, cugra_vertex_t v),
+    ( cugra_vertex_t v_goal; ))
+{
+    cu_clos_self(_is_vertex);
+    return v == self->v_goal;
+}
+
+/* Follows the path backwards from the goal and sums up its distance. */
+cu_clos_def(_unwind, cu_prot(void, cugra_arc_t a),
+    ( cugra_vertex_t v_cur;
+      double distance; ))
+{
+    cu_clos_self(_unwind);
+    cu_test_assert_ptr_eq(cugra_arc_head(a), self->v_cur);
+    self->v_cur = cugra_arc_tail(a);
+    self->distance += *(double *)cugra_arc_mem(a);
+}
+
+static void
+_check(cugra_vertex_t v_start, cugra_vertex_t v_goal, double d_expected)
+{
+    _is_vertex_t is_goal;
+    _unwind_t unwind;
+    double d;
+
+    is_goal.v_goal = v_goal;
+    unwind.v_cur = v_goal;
+    unwind.distance = 0.0;
+    d = cugra_shortest_path(cugra_direction_out, v_start,
+			    _is_vertex_prep(&is_goal), _arc_distance,
+			    _unwind_prep(&unwind));
+    if (d != d_expected)
+	cu_test_bugf("Got distance %lg, expected %lg.", d, d_expected);
+    if (!isinf(d)) {
+	cu_test_assert(unwind.distance == d);
+	cu_test_assert_ptr_eq(unwind.v_cur, v_start);
+    }
+}
+
+/* A small graph where the first path found to vertices 4 and 5 is not the
+ * shortest, and where the distances are sums over several arcs. */
+static void
+test_known()
+{
+    cugra_graph_t G = cugra_graph_new(0);
+    cugra_vertex_t v[7];
+    int i;
+
+    for (i = 0; i < 7; ++i)
+	v[i] = cugra_graph_vertex_new(G);
+    _connect(G, v[0], v[1], 7);
+    _connect(G, v[0], v[2], 9);
+    _connect(G, v[0], v[5], 14);
+    _connect(G, v[1], v[2], 10);
+    _connect(G, v[1], v[3], 15);
+    _connect(G, v[2], v[3], 11);
+    _connect(G, v[2], v[5], 2);
+    _connect(G, v[3], v[4], 6);
+    _connect(G, v[5], v[4], 9);
+    _connect(G, v[0], v[6], INFINITY);
+
+    _check(v[0], v[0], 0);
+    _check(v[0], v[1], 7);
+    _check(v[0], v[2], 9);
+    _check(v[0], v[3], 20);
+    _check(v[0], v[4], 20);
+    _check(v[0], v[5], 11);
+    _check(v[0], v[6], INFINITY);
+    _check(v[1], v[4], 21);
+    _check(v[4], v[0], INFINITY);
+}
+
+/* Random graphs, checked against Bellman-Ford. */
+static void
+test_random(int nA)
+{
+    cugra_graph_t G = cugra_graph_new(0);
+    cugra_vertex_t v_arr[nV];
+    int *tail_arr = cu_gnewarr_atomic(int, nA);
+    int *head_arr = cu_gnewarr_atomic(int, nA);
+    double *d_arr = cu_gnewarr_atomic(double, nA);
+    double dist[nV];
+    int i, j, vi_start = lrand48() % nV;
+    cu_bool_t changed;
+
+    for (i = 0; i < nV; ++i)
+	v_arr[i] = cugra_graph_vertex_new(G);
+    for (j = 0; j < nA; ++j) {
+	tail_arr[j] = lrand48() % nV;
+	head_arr[j] = lrand48() % nV;
+	d_arr[j] = lrand48() % 8 == 0? INFINITY : lrand48() % 100;
+	_connect(G, v_arr[tail_arr[j]], v_arr[head_arr[j]], d_arr[j]);
+    }
+
+    for (i = 0; i < nV; ++i)
+	dist[i] = INFINITY;
+    dist[vi_start] = 0.0;
+    do {
+	changed = cu_false;
+	for (j = 0; j < nA; ++j) {
+	    double d = dist[tail_arr[j]] + d_arr[j];
+	    if (d < dist[head_arr[j]]) {
+		dist[head_arr[j]] = d;
+		changed = cu_true;
+	    }
+	}
+    } while (changed);
+
+    for (i = 0; i < nV; ++i)
+	_check(v_arr[vi_start], v_arr[i], dist[i]);
+}
+
+int
+main()
+{
+    int i;
+    cu_init();
+    test_known();
+    for (i = 0; i < 20; ++i)
+	test_random(50 + 25*i);
+    return 2*!!cu_test_bug_count();
+}
@@ -20,6 +20,8 @@
 #include <cuoo/intf.h>
 #include <cu/test.h>
 #include <cu/diag.h>
+#include <cu/thread.h>
+#include <sys/time.h>
 
 #define REPEAT 20
 #define MAX_LOG_NODE_COUNT 20
@@ -27,6 +29,10 @@
 #define RETAIN_COUNT 1
 #define N_CONST (1 << 10)
 
+/* Parameters for the multi-threaded hit/miss benchmark. */
+#define MT_ALLOC_COUNT 0x400000
+#define MT_HOT_COUNT 0x1000
+
 typedef struct _const  *_const_t;
 typedef struct _tuple1 *_tuple1_t;
 typedef struct _tuple2 *_tuple2_t;
@@ -141,8 +147,83 @@ _test()
     printf("%16s %#6.3lg s\n", "Avg.", t/((double)CLOCKS_PER_SEC*tot_count));
 }
 
+static _tuple2_t _hot_arr[MT_HOT_COUNT];
+
+struct _mt_carg
+{
+    pthread_t thread;
+    int thread_index;
+    int hit_percent;
+    size_t alloc_count;
+};
+
+static void *
+_mt_thread_main(void *carg)
+{
+#define carg ((struct _mt_carg *)carg)
+    size_t k;
+    _const_t c0 = _const_new(0);
+    cu_word_t miss_base = (cu_word_t)(carg->thread_index + 1) << 40;
+    for (k = 0; k < carg->alloc_count; ++k) {
+	if (k % 100 < carg->hit_percent) {
+	    _tuple2_t hot = _hot_arr[k % MT_HOT_COUNT];
+	    cu_test_assert(_tuple2_new(hot->arr[0], hot->arr[1]) == hot);
+	}
+	else
+	    _tuple2_new(c0, _const_new(miss_base + k));
+    }
+    return NULL;
+#undef carg
+}
+
+static double
+_wall_seconds(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec*1e-6;
+}
+
+/* Allocate from several threads concurrently with a given percentage of the
+ * allocations hitting existing objects. */
+static void
+_test_mt(int max_thread_count)
+{
+    static int const hit_percent_arr[] = {0, 50, 90, 99, 100};
+    int thread_count, i, j;
+    struct _mt_carg *carg_arr;
+
+    for (i = 0; i < MT_HOT_COUNT; ++i)
+	_hot_arr[i] = _tuple2_new(_const_new(i), _const_new(i + 1));
+    carg_arr = cu_salloc(max_thread_count*sizeof(struct _mt_carg));
+
+    printf("%7s", "threads");
+    for (j = 0; j < sizeof(hit_percent_arr)/sizeof(int); ++j)
+	printf("   %3d%% hit", hit_percent_arr[j]);
+    printf("\n");
+    for (thread_count = 1; thread_count <= max_thread_count; ++thread_count) {
+	printf("%7d", thread_count);
+	for (j = 0; j < sizeof(hit_percent_arr)/sizeof(int); ++j) {
+	    double t = -_wall_seconds();
+	    for (i = 0; i < thread_count; ++i) {
+		carg_arr[i].thread_index = i;
+		carg_arr[i].hit_percent = hit_percent_arr[j];
+		carg_arr[i].alloc_count = MT_ALLOC_COUNT/thread_count;
+		cu_thread_create(&carg_arr[i].thread, NULL,
+				 _mt_thread_main, &carg_arr[i]);
+	    }
+	    for (i = 0; i < thread_count; ++i)
+		cu_thread_join(carg_arr[i].thread, NULL);
+	    t += _wall_seconds();
+	    printf("  %#6.3lg s", t/MT_ALLOC_COUNT);
+	}
+	printf("\n");
+    }
+    printf("Times are wall-clock per allocation over all threads.\n");
+}
+
 int
-main()
+main(int argc, char **argv)
 {
     cu_init();
     _the_const_type = cuoo_type_new_opaque_hcs(
@@ -153,6 +234,9 @@ main()
 	cuoo_impl_none, sizeof(struct _tuple2) - CUOO_HCOBJ_SHIFT);
     _the_tuple3_type = cuoo_type_new_opaque_hcs(
 	cuoo_impl_none, sizeof(struct _tuple3) - CUOO_HCOBJ_SHIFT);
-    _test();
+    if (argc > 1)
+	_test_mt(atoi(argv[1]));
+    else
+	_test();
     return 2*!!cu_test_bug_count();
 }
@@ -19,6 +19,7 @@
 #include <cuoo/intf.h>
 #include <cu/wordarr.h>
 #include <cu/size.h>
+#include <atomic_ops.h>
 
 /* To reduce lock contention, several independent hash-consing sets are used,
  * indexed by the upper bits of the object hash.  CUOO_HSET_COUNT is the number
@@ -41,6 +42,7 @@
 /* Don't change these for production builds. */
 #define VALIDATE_HSET	0  /* Very expensive, use only for debugging. */
 #define USE_MALLOC	1  /* Don't use GC for internals due to locking. */
+#define USE_NOLOCK_LOOKUP 1 /* Try a lock-free lookup before locking. */
 #define ENABLE_STATS	0
 
 
@@ -69,8 +71,10 @@ _mallocz(size_t size)
 # define IF_STATS(stmt) (stmt)
 static size_t _stat_alloc_insert = 0;
 static size_t _stat_alloc_found = 0;
+static size_t _stat_alloc_found_nolock = 0;
 static size_t _stat_xalloc_insert = 0;
 static size_t _stat_xalloc_found = 0;
+static size_t _stat_xalloc_found_nolock = 0;
 static size_t _stat_erase = 0;
 static size_t _stat_missed_erase = 0;
 #else
@@ -155,20 +159,31 @@ CU_SINLINE _link_t _link_of_obj(_obj_t p)   { return _tag(p, OBJ_LINK); }
 CU_SINLINE _link_t _link_of_pair(_pair_t p) { return _tag(p, PAIR_LINK); }
 CU_SINLINE _link_t _link_of_quad(_quad_t p) { return _tag(p, QUAD_LINK); }
 
+/* Lookups are first attempted without locking.  The lock-free reader uses
+ * seq as a sequence lock, which is odd while a writer holds the mutex, and
+ * retries under the mutex if it changed during the lookup.  Since readers may
+ * still traverse links which a writer removes, memory is not freed while
+ * reader_count is non-zero, but kept on the retired list. */
 struct _hset
 {
     cu_mutex_t mutex;
+    AO_t seq;
+    AO_t reader_count;
     size_t size, mask;
     _link_t *arr;
     unsigned short free_pair_count, free_quad_count;
     _freelist_t free_pairs;
     _freelist_t free_quads;
+    _freelist_t retired;
 };
 
 static void
 _hset_init(_hset_t hset)
 {
     cu_mutex_init(&hset->mutex);
+    hset->seq = 0;
+    hset->reader_count = 0;
+    hset->retired = NULL;
     hset->size = 0;
     hset->mask = MIN_CAPACITY - 1;
     hset->arr = _unewarrz_atomic(_link_t, MIN_CAPACITY);
@@ -220,6 +235,26 @@ next_link:
 # define _hset_validate(hset) ((void)0)
 #endif
 
+/* Free ptr as soon as no lock-free readers may be accessing it. */
+CU_SINLINE void
+_hset_retire(_hset_t hset, void *ptr)
+{
+    ((_freelist_t)ptr)->next = hset->retired;
+    hset->retired = ptr;
+}
+
+static void
+_hset_free_retired(_hset_t hset)
+{
+    _freelist_t fl = hset->retired;
+    hset->retired = NULL;
+    while (fl) {
+	void *ptr = fl;
+	fl = fl->next;
+	_ufree_atomic(ptr);
+    }
+}
+
 CU_SINLINE _pair_t
 _alloc_pair(_hset_t hset)
 {
@@ -276,7 +311,7 @@ _free_pair(_hset_t hset, _pair_t pair)
     if (hset->free_pair_count < MAX_FREE_PAIR_COUNT)
 	_stash_pair(hset, pair);
     else
-	_ufree_atomic(pair);
+	_hset_retire(hset, pair);
 }
 
 CU_SINLINE void
@@ -285,7 +320,7 @@ _free_quad(_hset_t hset, _quad_t quad)
     if (hset->free_quad_count < MAX_FREE_QUAD_COUNT)
 	_stash_quad(hset, quad);
     else
-	_ufree_atomic(quad);
+	_hset_retire(hset, quad);
 }
 
 /* Remove excess entries in the pair and quad freelists, which may have been
@@ -302,7 +337,7 @@ _hset_prune_freelists(_hset_t hset)
 	do {
 	    void *top = fl;
 	    fl = fl->next;
-	    _ufree_atomic(top);
+	    _hset_retire(hset, top);
 	} while (--count > MAX_FREE_PAIR_COUNT);
 	hset->free_pairs = fl;
 	hset->free_pair_count = MAX_FREE_PAIR_COUNT;
@@ -313,24 +348,47 @@ _hset_prune_freelists(_hset_t hset)
 	do {
 	    void *top = fl;
 	    fl = fl->next;
-	    _ufree_atomic(top);
+	    _hset_retire(hset, top);
 	} while (--count > MAX_FREE_QUAD_COUNT);
 	hset->free_quads = fl;
 	hset->free_quad_count = MAX_FREE_QUAD_COUNT;
     }
 }
 
+CU_SINLINE void
+_hset_begin_write(_hset_t hset)
+{
+    AO_store(&hset->seq, hset->seq + 1);
+    AO_nop_write();
+}
+
 CU_SINLINE void
 _hset_lock(_hset_t hset)
-{ cu_mutex_lock(&hset->mutex); }
+{
+    cu_mutex_lock(&hset->mutex);
+    _hset_begin_write(hset);
+}
 
 CU_SINLINE void
 _hset_unlock(_hset_t hset)
-{ cu_mutex_unlock(&hset->mutex); }
+{
+    AO_store_release_write(&hset->seq, hset->seq + 1);
+    if (hset->retired) {
+	AO_nop_full();
+	if (!AO_load(&hset->reader_count))
+	    _hset_free_retired(hset);
+    }
+    cu_mutex_unlock(&hset->mutex);
+}
 
 CU_SINLINE cu_bool_t
 _hset_trylock(_hset_t hset)
-{ return cu_mutex_trylock(&hset->mutex); }
+{
+    if (!cu_mutex_trylock(&hset->mutex))
+	return cu_false;
+    _hset_begin_write(hset);
+    return cu_true;
+}
 
 /* Insert obj into *dst_slot. */
 static void
@@ -482,7 +540,7 @@ _hset_shrink(_hset_t hset, size_t dst_cap)
 
     hset->arr = dst_arr;
     hset->mask = dst_cap - 1;
-    _ufree_atomic(src_arr);
+    _hset_retire(hset, src_arr);
     _hset_prune_freelists(hset);
 }
 
@@ -534,7 +592,7 @@ next_slot:
 	++src_slot;
     }
     _hset_prune_freelists(hset);
-    _ufree_atomic(src_arr);
+    _hset_retire(hset, src_arr);
 }
 
 static _obj_t
@@ -645,6 +703,98 @@ _hset_for_hash(cu_hash_t hash)
 #endif
 }
 
+#if USE_NOLOCK_LOOKUP
+CU_SINLINE cu_bool_t
+_hset_seq_changed(_hset_t hset, AO_t seq)
+{
+    AO_nop_read();
+    return AO_load(&hset->seq) != seq;
+}
+
+/* Look up the object matching meta and key without locking.  Returns the
+ * object if found, after securing it against a concurrent disclaim.  Returns
+ * NULL if not found or if a writer interfered, in which case the caller must
+ * fall back to the locked path. */
+static _obj_t
+_hset_find_nolock(_hset_t hset, cu_hash_t hash,
+		  cuex_meta_t meta, size_t key_sizew, void *key)
+{
+    int i, cand_count;
+    AO_t seq;
+    size_t mask;
+    _link_t *arr, link;
+    _pair_t pair;
+    _quad_t quad;
+    _obj_t cand[3];
+    _obj_t obj = NULL;
+
+    AO_fetch_and_add1_full(&hset->reader_count);
+    seq = AO_load_acquire_read(&hset->seq);
+    if (seq & 1)
+	goto fail;
+    mask = hset->mask;
+    arr = hset->arr;
+    if (_hset_seq_changed(hset, seq))
+	goto fail;
+
+    /* Until seq is verified, the data we read may be inconsistent, but it
+     * remains allocated as long as we are counted in reader_count.  An
+     * unlinked pair or quad may already be recycled, and its first word
+     * holds a freelist pointer, so we copy out the candidates of each node
+     * and verify seq before dereferencing them or following the link. */
+    link = arr[hash & mask];
+    while (link) {
+	switch (_link_type(link)) {
+	    case OBJ_LINK:
+		cand[0] = _link_as_obj(link);
+		cand_count = 1;
+		link = NULL;
+		break;
+	    case PAIR_LINK:
+		pair = _link_as_pair(link);
+		cand[0] = pair->obj[0];
+		cand[1] = pair->obj[1];
+		cand_count = 2;
+		link = NULL;
+		break;
+	    case QUAD_LINK:
+		quad = _link_as_quad(link);
+		cand[0] = quad->obj[0];
+		cand[1] = quad->obj[1];
+		cand[2] = quad->obj[2];
+		cand_count = 3;
+		link = quad->link;
+		break;
+	    default:
+		goto fail;
+	}
+	if (_hset_seq_changed(hset, seq))
+	    goto fail;
+	for (i = 0; i < cand_count; ++i)
+	    if (_obj_eq(meta, key_sizew, key, cand[i])) {
+		obj = cand[i];
+		goto break_loop;
+	    }
+    }
+break_loop:
+    if (!obj || _hset_seq_changed(hset, seq))
+	goto fail;
+
+    /* The object may be pending disclaim.  Marking it prevents that, unless
+     * the disclaim already happened, which we detect by re-checking seq. */
+    _obj_mark(obj);
+    if (_hset_seq_changed(hset, seq))
+	goto fail;
+    AO_fetch_and_sub1_release(&hset->reader_count);
+    cu_debug_assert(hash == cuex_key_hash(obj));
+    return obj;
+
+fail:
+    AO_fetch_and_sub1_release(&hset->reader_count);
+    return NULL;
+}
+#endif
+
 void *
 cuexP_halloc_raw(cuex_meta_t meta, size_t key_sizew, void *key)
 {
@@ -659,6 +809,13 @@ cuexP_halloc_raw(cuex_meta_t meta, size_t key_sizew, void *key)
 
     hash = cu_wordarr_hash(key_sizew, key, meta);
     hset = _hset_for_hash(hash);
+#if USE_NOLOCK_LOOKUP
+    ret_obj = _hset_find_nolock(hset, hash, meta, key_sizew, key);
+    if (ret_obj) {
+	IF_STATS(++_stat_alloc_found_nolock);
+	return ret_obj;
+    }
+#endif
     _hset_lock(hset);
 
     mask = hset->mask;
@@ -752,6 +909,13 @@ cuexP_hxalloc_raw(cuex_meta_t meta, size_t sizeg, size_t key_sizew,
 
     hash = cu_wordarr_hash(key_sizew, key, meta);
     hset = _hset_for_hash(hash);
+#if USE_NOLOCK_LOOKUP
+    ret_obj = _hset_find_nolock(hset, hash, meta, key_sizew, key);
+    if (ret_obj) {
+	IF_STATS(++_stat_xalloc_found_nolock);
+	return ret_obj;
+    }
+#endif
     _hset_lock(hset);
 
     mask = hset->mask;
@@ -880,9 +1044,13 @@ _dump_stats(void)
     printf("\nHash-consing statistics:\n");
     SHOW(_stat_alloc_insert,	"unique  allocations");
     SHOW(_stat_alloc_found,	"matched allocations");
-    if (_stat_xalloc_insert || _stat_xalloc_found) {
+    SHOW(_stat_alloc_found_nolock, "matched allocations without locking");
+    if (_stat_xalloc_insert || _stat_xalloc_found
+	    || _stat_xalloc_found_nolock) {
 	SHOW(_stat_xalloc_insert, "unique  allocations with aux data");
 	SHOW(_stat_xalloc_found,  "matched allocations with aux data");
+	SHOW(_stat_xalloc_found_nolock,
+	     "matched allocations with aux data without locking");
     }
     SHOW(_stat_erase,		"disclaims successful");
     SHOW(_stat_missed_erase,	"disclaims missed due to locking");
@@ -0,0 +1,112 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Concurrent stress test of the hash-consing set.  Several threads look up
+ * objects which are kept alive, and churn through a small range of
+ * short-lived keys, while another thread collects continuously so that
+ * the short-lived objects are disclaimed and erased.  This keeps buckets
+ * changing under the lock-free lookup, and any object returned for the
+ * wrong key or a duplicate of a live object is caught. */
+
+#include <cuoo/halloc.h>
+#include <cu/test.h>
+#include <errno.h>
+
+#define THREAD_COUNT 4
+#define ALLOC_COUNT 2000000
+#define HOT_COUNT 0x400
+#define COLD_COUNT 0x4000
+
+static cuoo_type_t _obj_type;
+static AO_t _pending = THREAD_COUNT;
+static cu_word_t *_hot_arr[HOT_COUNT];
+
+static cu_word_t *
+_obj_new(cu_word_t k)
+{
+    cu_word_t tpl[2];
+    tpl[0] = k;
+    tpl[1] = ~k;
+    return cu_ptr_add(cuoo_halloc(_obj_type, 2*sizeof(cu_word_t), tpl),
+		      CUOO_HCOBJ_SHIFT);
+}
+
+static void *
+_alloc_proc(void *arg)
+{
+    int i;
+    cu_word_t seed = (uintptr_t)arg;
+    for (i = 0; i < ALLOC_COUNT; ++i) {
+	cu_word_t k, *obj;
+	seed = seed*1103515245 + 12345;
+	k = (seed >> 8) % (HOT_COUNT + COLD_COUNT);
+	obj = _obj_new(k);
+	cu_test_assert(obj[0] == k && obj[1] == ~k);
+	if (k < HOT_COUNT)
+	    cu_test_assert(obj == _hot_arr[k]);
+    }
+    AO_fetch_and_sub1(&_pending);
+    return NULL;
+}
+
+static void *
+_gcollect_proc(void *arg)
+{
+    while (AO_load(&_pending))
+	GC_gcollect();
+    return NULL;
+}
+
+static void
+_fail(int err, char const *func_name)
+{
+    fprintf(stderr, "%s failed: %s", func_name, strerror(err));
+    exit(2);
+}
+
+int
+main()
+{
+    pthread_t alloc_pth[THREAD_COUNT], gcollect_pth;
+    int i, err;
+
+    cuoo_init();
+    _obj_type = cuoo_type_new_opaque_hcs(NULL, 2*sizeof(cu_word_t));
+    for (i = 0; i < HOT_COUNT; ++i)
+	_hot_arr[i] = _obj_new(i);
+
+    err = GC_pthread_create(&gcollect_pth, NULL, _gcollect_proc, NULL);
+    if (err) _fail(err, "GC_pthread_create");
+
+    for (i = 0; i < THREAD_COUNT; ++i) {
+	err = GC_pthread_create(&alloc_pth[i], NULL, _alloc_proc,
+				(void *)(uintptr_t)(i + 1));
+	if (err) _fail(err, "GC_pthread_create");
+    }
+    for (i = 0; i < THREAD_COUNT; ++i) {
+	err = GC_pthread_join(alloc_pth[i], NULL);
+	if (err) _fail(err, "GC_pthread_join");
+    }
+
+    err = GC_pthread_join(gcollect_pth, NULL);
+    if (err) _fail(err, "GC_pthread_join");
+
+    for (i = 0; i < HOT_COUNT; ++i)
+	cu_test_assert(_obj_new(i) == _hot_arr[i]);
+
+    return 2*!!cu_test_bug_count();
+}
@@ -17,12 +17,108 @@
 
 #include <cuoo/prop.h>
 #include <cu/diag.h>
+#include <cu/memory.h>
+
+#define INIT_CAPACITY 16
+
+/* The Lookup Table
+ * ================
+ *
+ * An insert-only open-addressing table with linear probing.  A binding is
+ * published by first storing the slot pointer and then the key with release
+ * semantics, so a reader which sees the key also sees the slot.  The table
+ * is grown to twice the size when half full, and the new table is published
+ * after it is fully populated.  Readers may still be probing the old table,
+ * which is therefore left to the collector. */
+
+struct cuooP_prop_entry
+{
+    AO_t key;
+    AO_t slot;
+};
+
+struct cuooP_prop_table
+{
+    size_t mask;
+    size_t count;
+    struct cuooP_prop_entry arr[1];
+};
+
+static struct cuooP_prop_table *
+_table_new(size_t cap)
+{
+    struct cuooP_prop_table *tab;
+    tab = cu_galloc(sizeof(struct cuooP_prop_table)
+		    + (cap - 1)*sizeof(struct cuooP_prop_entry));
+    tab->mask = cap - 1;
+    tab->count = 0;
+    return tab;
+}
+
+/* Lock-free lookup.  Returns the slot of ex or NULL. */
+static void *
+_find(cuoo_prop_t prop, cuex_t ex)
+{
+    struct cuooP_prop_table *tab;
+    size_t i;
+    tab = (struct cuooP_prop_table *)AO_load_acquire_read(&prop->table);
+    i = cu_hash_mix((cu_hash_t)ex) & tab->mask;
+    for (;;) {
+	AO_t key = AO_load_acquire_read(&tab->arr[i].key);
+	if (key == (AO_t)ex)
+	    return (void *)AO_load(&tab->arr[i].slot);
+	if (key == 0)
+	    return NULL;
+	i = (i + 1) & tab->mask;
+    }
+}
+
+/* Adds key to tab, assuming it is not present and that tab is not full. */
+static void
+_table_add(struct cuooP_prop_table *tab, AO_t key, AO_t slot)
+{
+    size_t i = cu_hash_mix((cu_hash_t)key) & tab->mask;
+    while (AO_load(&tab->arr[i].key))
+	i = (i + 1) & tab->mask;
+    AO_store(&tab->arr[i].slot, slot);
+    AO_store_release_write(&tab->arr[i].key, key);
+    ++tab->count;
+}
+
+/* Binds ex to slot, assuming the caller holds the stripe lock of ex for
+ * writing and that ex is not bound. */
+static void
+_insert(cuoo_prop_t prop, cuex_t ex, void *slot)
+{
+    struct cuooP_prop_table *tab;
+    cu_mutex_lock(&prop->table_mutex);
+    tab = (struct cuooP_prop_table *)AO_load(&prop->table);
+    if ((tab->count + 1)*2 > tab->mask + 1) {
+	struct cuooP_prop_table *new_tab;
+	size_t i;
+	new_tab = _table_new((tab->mask + 1)*2);
+	for (i = 0; i <= tab->mask; ++i)
+	    if (tab->arr[i].key)
+		_table_add(new_tab, tab->arr[i].key, tab->arr[i].slot);
+	AO_store_release_write(&prop->table, (AO_t)new_tab);
+	tab = new_tab;
+    }
+    _table_add(tab, (AO_t)ex, (AO_t)slot);
+    cu_mutex_unlock(&prop->table_mutex);
+}
+
+
+/* Properties
+ * ========== */
 
 void
 cuoo_prop_cct(cuoo_prop_t prop)
 {
-    cucon_pmap_init(&prop->pmap);
-    cu_rarex_init(&prop->rarex);
+    int i;
+    AO_store(&prop->table, (AO_t)_table_new(INIT_CAPACITY));
+    cu_mutex_init(&prop->table_mutex);
+    for (i = 0; i < CUOO_PROP_STRIPE_CNT; ++i)
+	cu_rarex_init(&prop->stripe_rarex[i]);
 }
 
 cuoo_prop_t
@@ -37,11 +133,21 @@ cu_bool_t
 cuoo_prop_replace_ptr(cuoo_prop_t key, cuex_t ex, void *value)
 {
     cu_bool_t res;
+    cu_rarex_t *rarex = cuooP_prop_rarex(key, ex);
     void **slot;
-    cu_rarex_lock_write(&key->rarex);
-    res = cucon_pmap_insert_mem(&key->pmap, ex, sizeof(void *), &slot);
-    *slot = value;
-    cu_rarex_unlock_write(&key->rarex);
+    cu_rarex_lock_write(rarex);
+    slot = _find(key, ex);
+    if (slot) {
+	AO_store_release_write((AO_t *)slot, (AO_t)value);
+	res = cu_false;
+    }
+    else {
+	slot = cu_gnew(void *);
+	*slot = value;
+	_insert(key, ex, slot);
+	res = cu_true;
+    }
+    cu_rarex_unlock_write(rarex);
     return res;
 }
 
@@ -49,12 +155,21 @@ cu_bool_t
 cuoo_prop_condset_ptr(cuoo_prop_t key, cuex_t ex, void *value)
 {
     cu_bool_t res;
+    cu_rarex_t *rarex;
     void **slot;
-    cu_rarex_lock_write(&key->rarex);
-    res = cucon_pmap_insert_mem(&key->pmap, ex, sizeof(void *), &slot);
-    if (res)
+    if (_find(key, ex))
+	return cu_false;
+    rarex = cuooP_prop_rarex(key, ex);
+    cu_rarex_lock_write(rarex);
+    if (_find(key, ex))
+	res = cu_false;
+    else {
+	slot = cu_gnew(void *);
 	*slot = value;
-    cu_rarex_unlock_write(&key->rarex);
+	_insert(key, ex, slot);
+	res = cu_true;
+    }
+    cu_rarex_unlock_write(rarex);
     return res;
 }
 
@@ -68,30 +183,37 @@ cuoo_prop_define_ptr(cuoo_prop_t key, cuex_t ex, void *value)
 void *
 cuoo_prop_get_ptr(cuoo_prop_t key, cuex_t ex)
 {
-    void *res;
-    cu_rarex_lock_read(&key->rarex);
-    res = cucon_pmap_find_ptr(&key->pmap, ex);
-    cu_rarex_unlock_read(&key->rarex);
-    return res;
+    void **slot = _find(key, ex);
+    return slot? (void *)AO_load_acquire_read((AO_t *)slot) : NULL;
 }
 
 cu_bool_t
 cuoo_prop_set_mem_lock(cuoo_prop_t key, cuex_t ex,
 		       size_t size, cu_ptr_ptr_t slot)
 {
-    cu_rarex_lock_write(&key->rarex);
-    return cucon_pmap_insert_mem(&key->pmap, ex, size, slot);
+    void *found;
+    cu_rarex_lock_write(cuooP_prop_rarex(key, ex));
+    found = _find(key, ex);
+    if (found) {
+	*(void **)slot = found;
+	return cu_false;
+    }
+    else {
+	found = cu_galloc(size);
+	_insert(key, ex, found);
+	*(void **)slot = found;
+	return cu_true;
+    }
 }
 
 cu_bool_t
 cuoo_prop_set_mem_condlock(cuoo_prop_t key, cuex_t ex,
 			   size_t size, cu_ptr_ptr_t slot)
 {
-    cu_rarex_lock_write(&key->rarex);
-    if (cucon_pmap_insert_mem(&key->pmap, ex, size, slot))
+    if (cuoo_prop_set_mem_lock(key, ex, size, slot))
 	return cu_true;
     else {
-	cu_rarex_unlock_write(&key->rarex);
+	cu_rarex_unlock_write(cuooP_prop_rarex(key, ex));
 	return cu_false;
     }
 }
@@ -99,18 +221,18 @@ cuoo_prop_set_mem_condlock(cuoo_prop_t key, cuex_t ex,
 void *
 cuoo_prop_get_mem_lock(cuoo_prop_t key, cuex_t ex)
 {
-    cu_rarex_lock_read(&key->rarex);
-    return cucon_pmap_find_mem(&key->pmap, ex);
+    cu_rarex_lock_read(cuooP_prop_rarex(key, ex));
+    return _find(key, ex);
 }
 
 void *
 cuoo_prop_get_mem_condlock(cuoo_prop_t key, cuex_t ex)
 {
     void *res;
-    cu_rarex_lock_read(&key->rarex);
-    res = cucon_pmap_find_mem(&key->pmap, ex);
+    cu_rarex_t *rarex = cuooP_prop_rarex(key, ex);
+    cu_rarex_lock_read(rarex);
+    res = _find(key, ex);
     if (!res)
-	cu_rarex_unlock_read(&key->rarex);
+	cu_rarex_unlock_read(rarex);
     return res;
 }
-
@@ -19,8 +19,9 @@
 #define CUOO_PROP_H
 
 #include <cuoo/fwd.h>
-#include <cucon/pmap.h>
 #include <cu/rarex.h>
+#include <cu/thread.h>
+#include <cu/hash.h>
 
 CU_BEGIN_DECLARATIONS
 /*!\defgroup cuoo_prop cuoo/prop.h: Thread-Safe Properties
@@ -30,14 +31,35 @@ CU_BEGIN_DECLARATIONS
  * and values from being recycled by the garbage collector.  For variables
  * the alternative is to use \c cuex_pvar_t which has internally stored
  * properties.  Local properties which is used within a single thread are
- * more efficiently stored in a \c cucon_pmap_t.  */
+ * more efficiently stored in a \c cucon_pmap_t.
+ *
+ * Lookups through \ref cuoo_prop_get_ptr do not lock.  Bindings are never
+ * removed and slots never move, so readers only need to follow a published
+ * open-addressing table, which is replaced by a larger copy when it fills up
+ * and left to the garbage collector.  Writers serialise on a mutex while
+ * modifying the table, and the locks of the property-slot interface are
+ * striped over \c CUOO_PROP_STRIPE_CNT read-write locks selected by the
+ * expression, so that slots of unrelated expressions can be used
+ * concurrently. */
+
+/* The number of slot locks per property.  Must be a power of 2. */
+#define CUOO_PROP_STRIPE_CNT 16
 
 struct cuoo_prop
 {
-    struct cucon_pmap pmap;
-    cu_rarex_t rarex;
+    AO_t table;			/* struct cuooP_prop_table * */
+    cu_mutex_t table_mutex;
+    cu_rarex_t stripe_rarex[CUOO_PROP_STRIPE_CNT];
 };
 
+/*!\private Returns the lock which protects the slot of \a ex. */
+CU_SINLINE cu_rarex_t *
+cuooP_prop_rarex(cuoo_prop_t prop, cuex_t ex)
+{
+    return &prop->stripe_rarex[cu_hash_mix((cu_hash_t)ex)
+			       & (CUOO_PROP_STRIPE_CNT - 1)];
+}
+
 /* Construct a property. */
 void cuoo_prop_cct(cuoo_prop_t prop);
 cuoo_prop_t cuoo_prop_new(void);
@@ -63,7 +85,7 @@ cu_bool_t cuoo_prop_condset_ptr(cuoo_prop_t key, cuex_t ex, void *value);
 void cuoo_prop_define_ptr(cuoo_prop_t key, cuex_t ex, void *value);
 
 /*!Returns the value for \a prop of \a ex, assuming the slot contains a
- * pointer. */
+ * pointer.  This does not lock. */
 void *cuoo_prop_get_ptr(cuoo_prop_t key, cuex_t ex);
 
 
@@ -89,7 +111,7 @@ cu_bool_t cuoo_prop_set_mem_condlock(cuoo_prop_t key, cuex_t ex,
  * \ref cuoo_prop_set_mem_lock or a true-returning call to
  * \ref cuoo_prop_set_mem_condlock. */
 CU_SINLINE void cuoo_prop_set_mem_unlock(cuoo_prop_t key, cuex_t ex)
-{ cu_rarex_unlock_write(&key->rarex); }
+{ cu_rarex_unlock_write(cuooP_prop_rarex(key, ex)); }
 
 /*!Return property \a key of \a ex and lock \a key for reading even if NULL
  * is returned. */
@@ -102,7 +124,7 @@ void *cuoo_prop_get_mem_condlock(cuoo_prop_t key, cuex_t ex);
 /*!Call this after reading a slot returned by a call to
  * \ref cuoo_prop_get_mem_condlock which returned non-NULL. */
 CU_SINLINE void cuoo_prop_get_mem_unlock(cuoo_prop_t key, cuex_t ex)
-{ cu_rarex_unlock_read(&key->rarex); }
+{ cu_rarex_unlock_read(cuooP_prop_rarex(key, ex)); }
 
 /*!@}*/
 CU_END_DECLARATIONS
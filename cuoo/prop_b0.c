@@ -0,0 +1,116 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cuoo/prop.h>
+#include <cu/test.h>
+#include <cu/thread.h>
+#include <cu/memory.h>
+#include <sys/time.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Contention benchmark for cuoo_prop.  Several threads look up a shared
+ * property on a common set of keys, with a given per mille of the accesses
+ * replacing the value instead. */
+
+#define KEY_COUNT 0x4000
+#define OP_COUNT 0x1000000
+
+static void *_key_arr[KEY_COUNT];
+static struct cuoo_prop _prop;
+
+struct _carg
+{
+    pthread_t thread;
+    int thread_index;
+    int write_permille;
+    size_t op_count;
+};
+
+static void *
+_thread_main(void *carg)
+{
+#define carg ((struct _carg *)carg)
+    size_t k;
+    size_t i = (size_t)carg->thread_index*7919;
+    for (k = 0; k < carg->op_count; ++k) {
+	void *key;
+	i = (i + 40503) % KEY_COUNT;
+	key = _key_arr[i];
+	if (k % 1000 < carg->write_permille)
+	    cuoo_prop_replace_ptr(&_prop, key, key);
+	else
+	    cu_test_assert_ptr_eq(cuoo_prop_get_ptr(&_prop, key), key);
+    }
+    return NULL;
+#undef carg
+}
+
+static double
+_wall_seconds(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec*1e-6;
+}
+
+static void
+_bench(int max_thread_count)
+{
+    static int const write_permille_arr[] = {0, 1, 10, 100};
+    int thread_count, i, j;
+    struct _carg *carg_arr;
+
+    cuoo_prop_cct(&_prop);
+    for (i = 0; i < KEY_COUNT; ++i) {
+	_key_arr[i] = cu_gnew(int);
+	cuoo_prop_define_ptr(&_prop, _key_arr[i], _key_arr[i]);
+    }
+    carg_arr = cu_galloc(max_thread_count*sizeof(struct _carg));
+
+    printf("%7s", "threads");
+    for (j = 0; j < sizeof(write_permille_arr)/sizeof(int); ++j)
+	printf("  %4.1lf%% write", write_permille_arr[j]/10.0);
+    printf("\n");
+    for (thread_count = 1; thread_count <= max_thread_count; ++thread_count) {
+	printf("%7d", thread_count);
+	for (j = 0; j < sizeof(write_permille_arr)/sizeof(int); ++j) {
+	    double t = -_wall_seconds();
+	    for (i = 0; i < thread_count; ++i) {
+		carg_arr[i].thread_index = i;
+		carg_arr[i].write_permille = write_permille_arr[j];
+		carg_arr[i].op_count = OP_COUNT/thread_count;
+		cu_thread_create(&carg_arr[i].thread, NULL,
+				 _thread_main, &carg_arr[i]);
+	    }
+	    for (i = 0; i < thread_count; ++i)
+		cu_thread_join(carg_arr[i].thread, NULL);
+	    t += _wall_seconds();
+	    printf("  %#8.3lg s", t/OP_COUNT);
+	}
+	printf("\n");
+    }
+    printf("Times are wall-clock per access over all threads.\n");
+}
+
+int
+main(int argc, char **argv)
+{
+    cu_init();
+    _bench(argc > 1? atoi(argv[1]) : 4);
+    return 2*!!cu_test_bug_count();
+}
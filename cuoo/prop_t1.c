@@ -0,0 +1,145 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Concurrent test of cuoo_prop.  Each thread repeatedly sets, checks and
+ * erases distinct values on its own objects, and sets values on objects
+ * shared by all threads.  Every value encodes the thread, object and round
+ * which wrote it, so that a lost update or a value read from the wrong
+ * object is caught. */
+
+#include <cuoo/prop.h>
+#include <cu/test.h>
+#include <cu/thread.h>
+#include <cu/memory.h>
+#include <stdint.h>
+
+#define THREAD_COUNT 4
+#define PRIVATE_COUNT 512
+#define SHARED_COUNT 64
+#define ROUND_COUNT 1000
+
+static struct cuoo_prop _prop;
+static void *_shared_arr[SHARED_COUNT];
+
+/* Values are odd, so they can not be confused with pointers or NULL. */
+static void *
+_value(int thread_index, int obj_index, int round)
+{
+    uintptr_t v = ((uintptr_t)round*THREAD_COUNT + thread_index)
+		* (PRIVATE_COUNT + SHARED_COUNT) + obj_index;
+    return (void *)(2*v + 1);
+}
+
+static void
+_decode(void *value, int *thread_index, int *obj_index, int *round)
+{
+    uintptr_t v = (uintptr_t)value/2;
+    *obj_index = v % (PRIVATE_COUNT + SHARED_COUNT);
+    v /= PRIVATE_COUNT + SHARED_COUNT;
+    *thread_index = v % THREAD_COUNT;
+    *round = v / THREAD_COUNT;
+}
+
+/* Checks that value was written to shared object i. */
+static void
+_check_shared(void *value, int i)
+{
+    int t, j, r;
+    cu_test_assert((uintptr_t)value & 1);
+    _decode(value, &t, &j, &r);
+    cu_test_assert(j == PRIVATE_COUNT + i);
+    cu_test_assert(0 <= r && r < ROUND_COUNT);
+}
+
+static void *
+_thread_main(void *thread_index_ptr)
+{
+    int t = (int)(intptr_t)thread_index_ptr;
+    void *private_arr[PRIVATE_COUNT];
+    int i, r;
+
+    /* Bind the private objects concurrently with the other threads, so
+     * that lookups run while the table grows. */
+    for (i = 0; i < PRIVATE_COUNT; ++i) {
+	private_arr[i] = cu_gnew(int);
+	cu_test_assert(cuoo_prop_get_ptr(&_prop, private_arr[i]) == NULL);
+	cu_test_assert(cuoo_prop_condset_ptr(&_prop, private_arr[i],
+					     _value(t, i, 0)));
+    }
+
+    for (r = 0; r < ROUND_COUNT; ++r) {
+	for (i = 0; i < PRIVATE_COUNT; ++i) {
+	    void *key = private_arr[i];
+	    if (r > 0)
+		cu_test_assert(!cuoo_prop_replace_ptr(&_prop, key,
+						      _value(t, i, r)));
+	    cu_test_assert(cuoo_prop_get_ptr(&_prop, key) == _value(t, i, r));
+	    cu_test_assert(!cuoo_prop_condset_ptr(&_prop, key, NULL));
+	    cu_test_assert(cuoo_prop_get_ptr(&_prop, key) == _value(t, i, r));
+	    if (i % 2) {
+		/* Erase by storing NULL. */
+		cuoo_prop_replace_ptr(&_prop, key, NULL);
+		cu_test_assert(cuoo_prop_get_ptr(&_prop, key) == NULL);
+	    }
+	}
+	for (i = 0; i < SHARED_COUNT; ++i) {
+	    /* Start at different objects, to vary the interleaving. */
+	    int j = (i + t*SHARED_COUNT/THREAD_COUNT) % SHARED_COUNT;
+	    cu_test_assert(!cuoo_prop_replace_ptr(&_prop, _shared_arr[j],
+						  _value(t, PRIVATE_COUNT + j,
+							 r)));
+	}
+	for (i = 0; i < SHARED_COUNT; ++i)
+	    _check_shared(cuoo_prop_get_ptr(&_prop, _shared_arr[i]), i);
+    }
+
+    for (i = 0; i < PRIVATE_COUNT; ++i)
+	cu_test_assert(cuoo_prop_get_ptr(&_prop, private_arr[i])
+		       == (i % 2? NULL : _value(t, i, ROUND_COUNT - 1)));
+    return NULL;
+}
+
+int
+main()
+{
+    pthread_t thread_arr[THREAD_COUNT];
+    int i;
+
+    cu_init();
+    cuoo_prop_cct(&_prop);
+    for (i = 0; i < SHARED_COUNT; ++i) {
+	_shared_arr[i] = cu_gnew(int);
+	cuoo_prop_define_ptr(&_prop, _shared_arr[i],
+			     _value(0, PRIVATE_COUNT + i, 0));
+    }
+    for (i = 0; i < THREAD_COUNT; ++i)
+	cu_thread_create(&thread_arr[i], NULL, _thread_main,
+			 (void *)(intptr_t)i);
+    for (i = 0; i < THREAD_COUNT; ++i)
+	cu_thread_join(thread_arr[i], NULL);
+
+    /* The last value written to each shared object is from the last round
+     * of some thread. */
+    for (i = 0; i < SHARED_COUNT; ++i) {
+	int t, j, r;
+	void *value = cuoo_prop_get_ptr(&_prop, _shared_arr[i]);
+	_check_shared(value, i);
+	_decode(value, &t, &j, &r);
+	cu_test_assert(r == ROUND_COUNT - 1);
+    }
+    return 2*!!cu_test_bug_count();
+}
@@ -0,0 +1,206 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cuos/dirwalk.h>
+#include <cuflow/sched.h>
+#include <cuflow/cdisj.h>
+#include <cu/memory.h>
+#include <cu/str.h>
+#include <atomic_ops.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+
+#define DIR_OFLAGS (O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC)
+
+/* Each directory is a task on the cuflow scheduler.  While reading a
+ * directory, the task opens its subdirectories relative to its own
+ * descriptor as long as the budget of descriptors allows, and passes them on
+ * to the subtasks.  This budget only covers tasks waiting in the queues;
+ * once a task starts, its descriptor is returned to the budget, since the
+ * number of running tasks is bounded by the number of threads.  Subtasks
+ * which did not get a descriptor open their directory relative to the root
+ * when they start. */
+
+struct _dirwalk
+{
+    cu_clop(cb, cu_bool_t, cuos_dirwalk_entry_t);
+    int root_fd;
+    size_t root_len;
+    AO_t fd_avail;
+    AO_t stopped;
+    AO_t cdisj;
+};
+
+cu_clos_dec(_dir_task, cu_prot0(void),
+	    ( struct _dirwalk *walk;
+	      int fd;			/* -1 if not opened ahead */
+	      cu_bool_t fd_budgeted;
+	      char *path;		/* with room for one more component */
+	      size_t path_len; ));
+
+static cu_bool_t
+_take_fd(struct _dirwalk *walk)
+{
+    AO_t n;
+    do {
+	n = AO_load(&walk->fd_avail);
+	if (n == 0)
+	    return cu_false;
+    } while (!AO_compare_and_swap(&walk->fd_avail, n, n - 1));
+    return cu_true;
+}
+
+static cuos_dentry_type_t
+_dentry_type(int dir_fd, struct dirent *dent)
+{
+    struct stat st;
+#ifdef _DIRENT_HAVE_D_TYPE
+    switch (dent->d_type) {
+	case DT_REG:  return cuos_dentry_type_file;
+	case DT_DIR:  return cuos_dentry_type_dir;
+	case DT_LNK:  return cuos_dentry_type_symlink;
+	case DT_CHR:  return cuos_dentry_type_char_dev;
+	case DT_BLK:  return cuos_dentry_type_block_dev;
+	case DT_FIFO: return cuos_dentry_type_fifo;
+	case DT_SOCK: return cuos_dentry_type_socket;
+	default:      break;
+    }
+#endif
+    if (fstatat(dir_fd, dent->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+	return cuos_dentry_type_unknown;
+    if (S_ISREG(st.st_mode))  return cuos_dentry_type_file;
+    if (S_ISDIR(st.st_mode))  return cuos_dentry_type_dir;
+    if (S_ISLNK(st.st_mode))  return cuos_dentry_type_symlink;
+    if (S_ISCHR(st.st_mode))  return cuos_dentry_type_char_dev;
+    if (S_ISBLK(st.st_mode))  return cuos_dentry_type_block_dev;
+    if (S_ISFIFO(st.st_mode)) return cuos_dentry_type_fifo;
+    if (S_ISSOCK(st.st_mode)) return cuos_dentry_type_socket;
+    return cuos_dentry_type_unknown;
+}
+
+static _dir_task_t *
+_dir_task_new(struct _dirwalk *walk, char const *path, size_t path_len)
+{
+    _dir_task_t *task = cu_gnew(_dir_task_t);
+    task->walk = walk;
+    task->fd = -1;
+    task->fd_budgeted = cu_false;
+    task->path = cu_galloc_atomic(path_len + NAME_MAX + 2);
+    memcpy(task->path, path, path_len);
+    task->path[path_len] = 0;
+    task->path_len = path_len;
+    return task;
+}
+
+static void
+_spawn_subdir(struct _dirwalk *walk, cuos_dirwalk_entry_t ent)
+{
+    _dir_task_t *task = _dir_task_new(walk, ent->path, ent->path_len);
+    if (_take_fd(walk)) {
+	task->fd = openat(ent->dir_fd, ent->name, DIR_OFLAGS);
+	if (task->fd != -1)
+	    task->fd_budgeted = cu_true;
+	else {
+	    AO_fetch_and_add1(&walk->fd_avail);
+	    if (errno != EMFILE && errno != ENFILE)
+		return;
+	}
+    }
+    cuflow_sched_call(_dir_task_prep(task), &walk->cdisj);
+}
+
+cu_clos_fun(_dir_task, cu_prot0(void))
+{
+    cu_clos_self(_dir_task);
+    struct _dirwalk *walk = self->walk;
+    struct cuos_dirwalk_entry ent;
+    struct dirent *dent;
+    DIR *dir;
+    int fd = self->fd;
+
+    if (fd == -1) {
+	if (AO_load(&walk->stopped))
+	    return;
+	fd = openat(walk->root_fd, self->path + walk->root_len + 1,
+		    DIR_OFLAGS);
+	if (fd == -1)
+	    return;
+    }
+    else if (self->fd_budgeted)
+	AO_fetch_and_add1(&walk->fd_avail);
+    if (AO_load(&walk->stopped) || !(dir = fdopendir(fd))) {
+	close(fd);
+	return;
+    }
+
+    ent.path = self->path;
+    ent.name = self->path + self->path_len + 1;
+    ent.dir_fd = fd;
+    self->path[self->path_len] = '/';
+    while ((dent = readdir(dir)) != NULL) {
+	size_t name_len;
+	if (dent->d_name[0] == '.'
+	    && (dent->d_name[1] == 0
+		|| (dent->d_name[1] == '.' && dent->d_name[2] == 0)))
+	    continue;
+	if (AO_load(&walk->stopped))
+	    break;
+	name_len = strlen(dent->d_name);
+	memcpy(self->path + self->path_len + 1, dent->d_name, name_len + 1);
+	ent.path_len = self->path_len + 1 + name_len;
+	ent.type = _dentry_type(fd, dent);
+	if (!cu_call(walk->cb, &ent)) {
+	    AO_store(&walk->stopped, 1);
+	    break;
+	}
+	if (ent.type == cuos_dentry_type_dir)
+	    _spawn_subdir(walk, &ent);
+    }
+    closedir(dir);
+}
+
+cu_bool_t
+cuos_dirwalk(cu_str_t root, unsigned int max_fds,
+	     cu_clop(cb, cu_bool_t, cuos_dirwalk_entry_t))
+{
+    struct _dirwalk walk;
+    _dir_task_t *task;
+
+    walk.root_fd = open(cu_str_to_cstr(root), DIR_OFLAGS);
+    if (walk.root_fd == -1)
+	return cu_true;
+    walk.cb = cb;
+    walk.root_len = cu_str_size(root);
+    walk.fd_avail = max_fds;
+    walk.stopped = 0;
+    walk.cdisj = 0;
+
+    task = _dir_task_new(&walk, cu_str_to_cstr(root), walk.root_len);
+    task->fd = openat(walk.root_fd, ".", DIR_OFLAGS);
+    if (task->fd != -1) {
+	cu_call0(_dir_task_prep(task));
+	cuflow_cdisj_wait_while(&walk.cdisj);
+    }
+    close(walk.root_fd);
+    return !walk.stopped;
+}
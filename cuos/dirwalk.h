@@ -0,0 +1,69 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CUOS_DIRWALK_H
+#define CUOS_DIRWALK_H
+
+#include <cuos/fwd.h>
+#include <cuos/fs.h>
+#include <stddef.h>
+
+CU_BEGIN_DECLARATIONS
+/** \defgroup cuos_dirwalk_h cuos/dirwalk.h: Parallel Directory Walker
+ ** @{\ingroup cuos_mod
+ **
+ ** This is a replacement for \ref cuos_dirrec_conj_files suitable for large
+ ** trees.  Directories are opened relative to their parent's descriptor,
+ ** entry types are taken from the directory listing where the file system
+ ** provides them, and paths are built in reusable buffers, so that there is
+ ** no per-entry allocation or \c stat.  Subdirectories are scheduled with
+ ** \ref cuflow_sched_h "cuflow/sched.h", and are thus walked in parallel when
+ ** \ref cuflow_workers_h "cuflow worker threads" are running.
+ **/
+
+/** A directory entry as passed to the callback of \ref cuos_dirwalk.  It is
+ ** only valid for the duration of the call. */
+struct cuos_dirwalk_entry
+{
+    char const *path;		/**< the root path joined with the entry */
+    size_t path_len;		/**< the length of \c path */
+    char const *name;		/**< the last component of \c path */
+    int dir_fd;			/**< the descriptor of the parent */
+    cuos_dentry_type_t type;	/**< the type, not following links */
+};
+
+/** Calls \a cb on each entry below the directory \a root, excluding \a root
+ ** itself, in no specific order.  Symbolic links are reported but not
+ ** followed.  \a cb may be called concurrently from several threads, and may
+ ** use \c dir_fd with the \c *at family of system calls to inspect the entry.
+ ** If \a cb returns false, the walk is stopped as soon as possible and false
+ ** is returned, though some calls may already be underway on other threads.
+ ** Directories which can not be read are skipped silently.
+ **
+ ** Up to \a max_fds descriptors are kept open for subdirectories which are
+ ** waiting to be walked, in addition to one for each thread which is reading
+ ** a directory and one for \a root.  Beyond that, subdirectories are later
+ ** opened by their path relative to \a root.
+ **
+ ** \pre \ref cuos_init has been called. */
+cu_bool_t cuos_dirwalk(cu_str_t root, unsigned int max_fds,
+		       cu_clop(cb, cu_bool_t, cuos_dirwalk_entry_t));
+
+/** @} */
+CU_END_DECLARATIONS
+
+#endif
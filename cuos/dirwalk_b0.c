@@ -0,0 +1,150 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Compares cuos_dirwalk with cuos_dirrec_conj_files on a generated tree, for
+ * increasing numbers of threads.  The tree is walked once by each function
+ * before timing, so this measures walks with a warm directory cache.
+ * Usage: dirwalk_b0 [MAX_THREADS [DEPTH]] */
+
+#include <cuos/dirwalk.h>
+#include <cuos/fs.h>
+#include <cuos/path.h>
+#include <cuflow/workers.h>
+#include <cuflow/time.h>
+#include <cu/test.h>
+#include <cu/str.h>
+#include <atomic_ops.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define FANOUT 8
+#define FILES_PER_DIR 24
+#define MAX_FDS 64
+
+static long _file_cnt = 0;
+
+static void
+_make_tree(char *path, size_t path_len, int depth)
+{
+    int i;
+    if (mkdir(path, 0777) != 0) {
+	perror(path);
+	exit(1);
+    }
+    for (i = 0; i < FILES_PER_DIR; ++i) {
+	int fd;
+	sprintf(path + path_len, "/file-%d.c", i);
+	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (fd == -1) {
+	    perror(path);
+	    exit(1);
+	}
+	close(fd);
+	++_file_cnt;
+    }
+    if (depth > 0)
+	for (i = 0; i < FANOUT; ++i) {
+	    int len = sprintf(path + path_len, "/dir-%d", i);
+	    _make_tree(path, path_len + len, depth - 1);
+	}
+    path[path_len] = 0;
+}
+
+cu_clos_def(_count_dirrec, cu_prot(cu_bool_t, cu_str_t path),
+	    ( long count; ))
+{
+    cu_clos_self(_count_dirrec);
+    ++self->count;
+    return cu_true;
+}
+
+cu_clos_def(_count_dirwalk, cu_prot(cu_bool_t, cuos_dirwalk_entry_t ent),
+	    ( AO_t count; ))
+{
+    cu_clos_self(_count_dirwalk);
+    if (ent->type == cuos_dentry_type_file)
+	AO_fetch_and_add1(&self->count);
+    return cu_true;
+}
+
+int
+main(int argc, char **argv)
+{
+    int max_thread_count = sysconf(_SC_NPROCESSORS_ONLN);
+    int depth = 4;
+    int thread_count;
+    char path[4096];
+    cu_str_t top;
+    cuflow_walltime_t wt, wt1 = 0;
+    _count_dirrec_t dirrec_cb;
+    _count_dirwalk_t dirwalk_cb;
+
+    cuos_init();
+    if (argc > 1)
+	max_thread_count = atoi(argv[1]);
+    if (argc > 2)
+	depth = atoi(argv[2]);
+    if (max_thread_count < 1)
+	max_thread_count = 1;
+
+    top = cuos_path_join_str_cstr(cuos_tmp_dir(), "dirwalk_b0");
+    if (cuos_have_dentry(top))
+	cuos_remove_rec(top);
+    snprintf(path, sizeof(path), "%s", cu_str_to_cstr(top));
+    wt = -cuflow_walltime();
+    _make_tree(path, cu_str_size(top), depth);
+    wt += cuflow_walltime();
+    printf("Created %ld files in %.3lg s.\n", _file_cnt,
+	   wt/(double)CUFLOW_WALLTIME_SECOND);
+
+    dirrec_cb.count = 0;
+    cuos_dirrec_conj_files(top, _count_dirrec_prep(&dirrec_cb));
+    dirrec_cb.count = 0;
+    wt = -cuflow_walltime();
+    cuos_dirrec_conj_files(top, _count_dirrec_prep(&dirrec_cb));
+    wt += cuflow_walltime();
+    cu_test_assert(dirrec_cb.count == _file_cnt);
+    printf("%-24s %12.3lg s\n\n", "cuos_dirrec_conj_files:",
+	   wt/(double)CUFLOW_WALLTIME_SECOND);
+
+    dirwalk_cb.count = 0;
+    cuos_dirwalk(top, MAX_FDS, _count_dirwalk_prep(&dirwalk_cb));
+    printf("%8s %12s %12s %10s\n", "threads", "WT total", "per file",
+	   "speedup");
+    for (thread_count = 1; thread_count <= max_thread_count; ++thread_count) {
+	/* The main thread takes part in the work, so spawn one less. */
+	cuflow_workers_spawn(thread_count - 1);
+
+	dirwalk_cb.count = 0;
+	wt = -cuflow_walltime();
+	cuos_dirwalk(top, MAX_FDS, _count_dirwalk_prep(&dirwalk_cb));
+	wt += cuflow_walltime();
+	cu_test_assert(dirwalk_cb.count == _file_cnt);
+	if (thread_count == 1)
+	    wt1 = wt;
+	printf("%8d %12.3lg %12.3lg %10.2lf\n", thread_count,
+	       wt/(double)CUFLOW_WALLTIME_SECOND,
+	       wt/(_file_cnt*(double)CUFLOW_WALLTIME_SECOND),
+	       wt1/(double)wt);
+    }
+    cuflow_workers_spawn(0);
+    cuos_remove_rec(top);
+    return 0;
+}
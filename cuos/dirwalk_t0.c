@@ -0,0 +1,162 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cuos/dirwalk.h>
+#include <cuos/fs.h>
+#include <cuos/path.h>
+#include <cuflow/workers.h>
+#include <cu/test.h>
+#include <cu/str.h>
+#include <atomic_ops.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define FANOUT 3
+#define DEPTH 3
+#define FILES_PER_DIR 4
+#define MAX_FILES 1000
+
+static AO_t _seen_arr[MAX_FILES];
+static int _file_cnt = 0;
+static int _dir_cnt = 0;
+
+static void
+_make_tree(cu_str_t dir, int depth)
+{
+    int i;
+    cu_test_assert(cuos_mkdir_rec(dir, 0777));
+    for (i = 0; i < FILES_PER_DIR; ++i) {
+	FILE *fh;
+	cu_test_assert(_file_cnt < MAX_FILES);
+	fh = fopen(cu_str_to_cstr(cu_str_new_fmt("%s/f%d",
+						cu_str_to_cstr(dir),
+						_file_cnt++)), "w");
+	cu_test_assert(fh);
+	fclose(fh);
+    }
+    if (depth > 0)
+	for (i = 0; i < FANOUT; ++i) {
+	    ++_dir_cnt;
+	    _make_tree(cu_str_new_fmt("%s/d%d", cu_str_to_cstr(dir), i),
+		       depth - 1);
+	}
+}
+
+cu_clos_def(_check_entry, cu_prot(cu_bool_t, cuos_dirwalk_entry_t ent),
+	    ( AO_t dir_cnt;
+	      AO_t link_cnt;
+	      AO_t other_cnt;
+	      AO_t stop_after; ))
+{
+    cu_clos_self(_check_entry);
+    struct stat st;
+    int k;
+    cu_test_assert(strlen(ent->path) == ent->path_len);
+    cu_test_assert(ent->name > ent->path && ent->name[-1] == '/');
+    cu_test_assert(fstatat(ent->dir_fd, ent->name, &st,
+			   AT_SYMLINK_NOFOLLOW) == 0);
+    switch (ent->type) {
+	case cuos_dentry_type_file:
+	    cu_test_assert(sscanf(ent->name, "f%d", &k) == 1);
+	    cu_test_assert(0 <= k && k < _file_cnt);
+	    AO_fetch_and_add1(&_seen_arr[k]);
+	    break;
+	case cuos_dentry_type_dir:
+	    AO_fetch_and_add1(&self->dir_cnt);
+	    break;
+	case cuos_dentry_type_symlink:
+	    AO_fetch_and_add1(&self->link_cnt);
+	    break;
+	default:
+	    AO_fetch_and_add1(&self->other_cnt);
+	    break;
+    }
+    return AO_fetch_and_sub1(&self->stop_after) != 1;
+}
+
+/* The number of open descriptors, to check that none are leaked. */
+static int
+_open_fd_count(void)
+{
+    int fd, cnt = 0;
+    for (fd = 0; fd < 1024; ++fd)
+	if (fcntl(fd, F_GETFD) != -1)
+	    ++cnt;
+    return cnt;
+}
+
+static void
+_test_walk(cu_str_t top, unsigned int max_fds)
+{
+    _check_entry_t cb;
+    AO_t seen_cnt;
+    int k, fd_cnt = _open_fd_count();
+
+    memset(_seen_arr, 0, sizeof(_seen_arr));
+    cb.dir_cnt = cb.link_cnt = cb.other_cnt = 0;
+    cb.stop_after = 0;
+    cu_test_assert(cuos_dirwalk(top, max_fds, _check_entry_prep(&cb)));
+    for (k = 0; k < _file_cnt; ++k)
+	cu_test_assert(_seen_arr[k] == 1);
+    cu_test_assert(cb.dir_cnt == _dir_cnt);
+    cu_test_assert(cb.link_cnt == 1);
+    cu_test_assert(cb.other_cnt == 0);
+
+    /* Stop early.  Entries already underway on other threads may still be
+     * reported, but at most one for each thread. */
+    memset(_seen_arr, 0, sizeof(_seen_arr));
+    cb.dir_cnt = cb.link_cnt = 0;
+    cb.stop_after = 10;
+    cu_test_assert(!cuos_dirwalk(top, max_fds, _check_entry_prep(&cb)));
+    seen_cnt = cb.dir_cnt + cb.link_cnt;
+    for (k = 0; k < _file_cnt; ++k)
+	seen_cnt += _seen_arr[k];
+    cu_test_assert(10 <= seen_cnt
+		   && seen_cnt <= 10 + cuflow_workers_count());
+    cu_test_assert(_open_fd_count() == fd_cnt);
+}
+
+int
+main()
+{
+    cu_str_t top;
+    int n_workers;
+
+    cuos_init();
+    top = cuos_path_join_str_cstr(cuos_tmp_dir(), "dirwalk_t0");
+    if (cuos_have_dentry(top))
+	cuos_remove_rec(top);
+    _make_tree(top, DEPTH);
+    cu_test_assert(symlink("..", cu_str_to_cstr(
+		cuos_path_join_str_cstr(top, "d0/up"))) == 0);
+
+    cu_test_assert(cuos_dirwalk(cu_str_new_cstr("/nonexistent/dirwalk_t0"),
+				4, NULL));
+    for (n_workers = 0; n_workers <= 4; n_workers += 4) {
+	cuflow_workers_spawn(n_workers);
+	_test_walk(top, 0);
+	_test_walk(top, 2);
+	_test_walk(top, 64);
+    }
+    cuflow_workers_spawn(0);
+    cu_test_assert(cuos_remove_rec(top));
+    return 2*!!cu_test_bug_count();
+}
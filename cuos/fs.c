@@ -123,9 +123,12 @@ cuos_dirrec_conj_files(cu_str_t dname,
 			&& ent->d_name[2] == 0)))
 		continue;
 	    subname = cuos_path_join(dname, cu_str_new_cstr(ent->d_name));
-	    if (!cuos_dirrec_conj_files(subname, cb))
+	    if (!cuos_dirrec_conj_files(subname, cb)) {
+		closedir(dir);
 		return cu_false;
+	    }
 	}
+	closedir(dir);
     }
     else if (S_ISREG(st.st_mode)) {
 	if (!cu_call(cb, dname))
@@ -169,6 +172,7 @@ cuos_dirreccoll_conj_files(cu_str_t dname,
 		    (cu_clop(, int, void *, void *))cu_str_coll_clop,
 		    &sub_bname);
 	}
+	closedir(dir);
 	subcb.cb = cb;
 	subcb.dname = dname;
 	return cucon_rbtree_conj_ptr(
@@ -79,7 +79,8 @@ cu_bool_t cuos_remove_rec(cu_str_t path);
 
 /*!Run \code cu_call(cb, path)\endcode on each \e path which is \a dname or
  * a subdirectory or file under \a dname, using depth-first with no specific
- * ordering within each directory. */
+ * ordering within each directory.
+ * \see cuos_dirwalk, which is faster for large trees. */
 cu_bool_t cuos_dirrec_conj_files(cu_str_t dname,
 				 cu_clop(cb, cu_bool_t, cu_str_t));
 
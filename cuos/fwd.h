@@ -19,15 +19,17 @@
 #define CUOS_FWD_H
 
 #include <cu/fwd.h>
+#include <cuflow/fwd.h>
 
 CU_BEGIN_DECLARATIONS
 /** \defgroup cuos_fwd_h cuos/fwd.h: Forward Declarations
  ** @{ \ingroup cuos_mod */
 
 typedef struct cuos_dirpile *cuos_dirpile_t;
+typedef struct cuos_dirwalk_entry *cuos_dirwalk_entry_t;
 typedef struct cuos_pkg_user_dirs *cuos_pkg_user_dirs_t;
 
-#define cuos_init cu_init
+#define cuos_init cuflow_init
 
 /** @} */
 CU_END_DECLARATIONS
@@ -46,6 +46,7 @@
  */
 
 #include <custo/binary_io.h>
+#include <custo/codec.h>
 #include <cu/str.h>
 #include <cu/memory.h>
 #include <assert.h>
@@ -139,31 +140,9 @@ custo_fread_intmax(intmax_t *pn, FILE *in)
 cu_bool_t
 custo_fwrite_uintmax(uintmax_t n, FILE *out)
 {
-#define BUF_SIZE (sizeof(uintmax_t) + sizeof(uintmax_t)/8 + 1)
-    unsigned char buf[BUF_SIZE];
-    size_t k = BUF_SIZE;
-    size_t l;
-    unsigned char m;
-    do {
-	buf[--k] = n & 0xff;
-	n >>= 8;
-    } while (n);
-    l = (BUF_SIZE - 1 - k) % 8;
-    m = ~(0xff >> (l + 1));
-    if (buf[k] & m) {
-	--k;
-	l = (BUF_SIZE - 1 - k) % 8;
-	buf[k] = ~(0xff >> l);
-    }
-    else
-	buf[k] |= m << 1;
-    l = (BUF_SIZE - 1 - k)/8;
-    while (l) {
-	buf[--k] = 0xff;
-	--l;
-    }
-    return fwrite(buf + k, BUF_SIZE - k, 1, out) == 1;
-#undef BUF_SIZE
+    unsigned char buf[CUSTO_UINTMAX_MAXSIZE];
+    size_t len = custoP_encode_uintmax(buf, n);
+    return fwrite(buf, len, 1, out) == 1;
 }
 
 cu_bool_t
@@ -206,36 +185,11 @@ custo_fread_uintmax(uintmax_t *pn, FILE *in)
 }
 
 cu_bool_t
-custo_fwrite_intmax(intmax_t ns, FILE *out)
+custo_fwrite_intmax(intmax_t n, FILE *out)
 {
-#define BUF_SIZE (sizeof(uintmax_t) + sizeof(uintmax_t)/8 + 1)
-    unsigned char buf[BUF_SIZE];
-    size_t k = BUF_SIZE;
-    size_t l;
-    unsigned char m;
-    uintmax_t n = ns < 0? -ns : ns;
-    do {
-	buf[--k] = n & 0xff;
-	n >>= 8;
-    } while (n);
-    l = (BUF_SIZE - k) % 8;
-    m = ~(0xff >> (l + 1));
-    if (buf[k] & m) {
-	--k;
-	l = (BUF_SIZE - k) % 8;
-	buf[k] = ~(0xff >> l);
-    }
-    else
-	buf[k] |= m << 1;
-    l = (BUF_SIZE - k)/8;
-    while (l) {
-	buf[--k] = 0xff;
-	--l;
-    }
-    if (ns >= 0)
-	buf[k] &= 0x7f;
-    return fwrite(buf + k, BUF_SIZE - k, 1, out) == 1;
-#undef BUF_SIZE
+    unsigned char buf[CUSTO_UINTMAX_MAXSIZE];
+    size_t len = custoP_encode_intmax(buf, n);
+    return fwrite(buf, len, 1, out) == 1;
 }
 
 cu_bool_t
@@ -0,0 +1,574 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <custo/codec.h>
+#include <cu/dsink.h>
+#include <cu/dsource.h>
+#include <cu/memory.h>
+#include <string.h>
+
+/* The SSSE3 group decoder is selected at run-time, so that it is used
+ * without compiling the whole library for SSSE3. */
+#if defined(__x86_64__) && defined(__GNUC__)
+#  include <immintrin.h>
+#  define USE_SSSE3 1
+#endif
+
+/* The minimum free space requested when the buffer is extended or
+ * refilled. */
+#define BLOCK_SIZE 16384
+
+/* Space needed to encode or decode a group of the group varint encoding
+ * without checking the bounds of the individual integers. */
+#define GROUP_MAXSIZE 17
+
+
+/* Integer Encoding
+ * ----------------
+ *
+ * See custo/binary_io.c for a description of the encoding.  These are also
+ * used by custo_fwrite_uintmax and custo_fwrite_intmax. */
+
+size_t
+custoP_encode_uintmax(unsigned char *p, uintmax_t n)
+{
+#define BUF_SIZE CUSTO_UINTMAX_MAXSIZE
+    unsigned char buf[BUF_SIZE];
+    size_t k = BUF_SIZE;
+    size_t l;
+    unsigned char m;
+
+    /* Common case where all length bits fit in the first byte. */
+    for (l = 0; l < 7; ++l)
+	if (n < (uintmax_t)1 << 7*(l + 1)) {
+	    p[0] = ((0xff00 >> l) & 0xff) | (n >> 8*l);
+	    for (k = 1; k <= l; ++k)
+		p[k] = n >> 8*(l - k);
+	    return l + 1;
+	}
+
+    do {
+	buf[--k] = n & 0xff;
+	n >>= 8;
+    } while (n);
+    l = (BUF_SIZE - 1 - k) % 8;
+    m = ~(0xff >> (l + 1));
+    if (buf[k] & m) {
+	--k;
+	l = (BUF_SIZE - 1 - k) % 8;
+	buf[k] = ~(0xff >> l);
+    }
+    else
+	buf[k] |= m << 1;
+    l = (BUF_SIZE - 1 - k)/8;
+    while (l) {
+	buf[--k] = 0xff;
+	--l;
+    }
+    memcpy(p, buf + k, BUF_SIZE - k);
+    return BUF_SIZE - k;
+#undef BUF_SIZE
+}
+
+size_t
+custoP_encode_intmax(unsigned char *p, intmax_t ns)
+{
+#define BUF_SIZE CUSTO_UINTMAX_MAXSIZE
+    unsigned char buf[BUF_SIZE];
+    size_t k = BUF_SIZE;
+    size_t l;
+    unsigned char m;
+    uintmax_t n = ns < 0? -ns : ns;
+    do {
+	buf[--k] = n & 0xff;
+	n >>= 8;
+    } while (n);
+    l = (BUF_SIZE - k) % 8;
+    m = ~(0xff >> (l + 1));
+    if (buf[k] & m) {
+	--k;
+	l = (BUF_SIZE - k) % 8;
+	buf[k] = ~(0xff >> l);
+    }
+    else
+	buf[k] |= m << 1;
+    l = (BUF_SIZE - k)/8;
+    while (l) {
+	buf[--k] = 0xff;
+	--l;
+    }
+    if (ns >= 0)
+	buf[k] &= 0x7f;
+    memcpy(p, buf + k, BUF_SIZE - k);
+    return BUF_SIZE - k;
+#undef BUF_SIZE
+}
+
+/* Decodes an unsigned integer from [p, end).  Returns the number of bytes
+ * consumed, or 0 if the data is incomplete or the integer overflows. */
+static size_t
+_decode_uintmax(unsigned char const *p, unsigned char const *end,
+		uintmax_t *n_out)
+{
+    unsigned char const *p0 = p;
+    size_t i, l = 0;
+    unsigned int m;
+    uintmax_t n;
+    for (;;) {
+	if (p == end)
+	    return 0;
+	if (*p == 0xff) {
+	    l += 8;
+	    ++p;
+	}
+	else
+	    break;
+    }
+    m = *p;
+    i = 0;
+    while (m & 0x80) {
+	++i;
+	m <<= 1;
+    }
+    l += i;
+    n = *p++ & (0xff >> i);
+    if (l > sizeof(uintmax_t) || (l == sizeof(uintmax_t) && n != 0))
+	return 0;
+    if (end - p < l)
+	return 0;
+    for (i = 0; i < l; ++i)
+	n = (n << 8) + *p++;
+    *n_out = n;
+    return p - p0;
+}
+
+/* As _decode_uintmax, but for signed integers. */
+static size_t
+_decode_intmax(unsigned char const *p, unsigned char const *end,
+	       intmax_t *n_out)
+{
+    unsigned char const *p0 = p;
+    size_t i, l = 0;
+    unsigned int ch0, m;
+    uintmax_t n;
+    if (p == end)
+	return 0;
+    ch0 = *p++;
+    if ((ch0 & 0x7f) == 0x7f) {
+	l += 7;
+	for (;;) {
+	    if (p == end)
+		return 0;
+	    if (*p == 0xff) {
+		l += 8;
+		++p;
+	    }
+	    else
+		break;
+	}
+	m = *p;
+	i = 0;
+	while (m & 0x80) {
+	    ++i;
+	    m <<= 1;
+	}
+	l += i;
+	n = *p++ & (0xff >> i);
+    }
+    else {
+	m = ch0;
+	i = 0;
+	while (m & 0x40) {
+	    ++i;
+	    m <<= 1;
+	}
+	l += i;
+	n = ch0 & (0x7f >> i);
+    }
+    if (l > sizeof(uintmax_t) || (l == sizeof(uintmax_t) && n != 0))
+	return 0;
+    if (end - p < l)
+	return 0;
+    for (i = 0; i < l; ++i)
+	n = (n << 8) + *p++;
+    if (n > INTMAX_MAX)
+	return 0;
+    *n_out = (ch0 & 0x80)? -n : n;
+    return p - p0;
+}
+
+
+/* Group Varint Encoding
+ * --------------------- */
+
+#define L(t, j) ((((t) >> 2*(j)) & 3) + 1)
+#define O0(t) 0
+#define O1(t) L(t, 0)
+#define O2(t) (O1(t) + L(t, 1))
+#define O3(t) (O2(t) + L(t, 2))
+#define B(t, j, i) ((i) < L(t, j)? O##j(t) + (i) : 0x80)
+#define LANE(t, j) B(t, j, 0), B(t, j, 1), B(t, j, 2), B(t, j, 3)
+#define ROW(t) {LANE(t, 0), LANE(t, 1), LANE(t, 2), LANE(t, 3)}
+#define ROW4(t) ROW(t), ROW(t + 1), ROW(t + 2), ROW(t + 3)
+#define ROW16(t) ROW4(t), ROW4(t + 4), ROW4(t + 8), ROW4(t + 12)
+#define ROW64(t) ROW16(t), ROW16(t + 16), ROW16(t + 32), ROW16(t + 48)
+
+#ifdef USE_SSSE3
+/* For each tag byte, the byte shuffle which moves the packed integers of the
+ * group into four 32 bit little-endian lanes, where 0x80 gives a zero
+ * byte. */
+static unsigned char const _group_shuffle[256][16] = {
+    ROW64(0), ROW64(64), ROW64(128), ROW64(192)
+};
+#endif
+
+#define GROUP_SIZE(t) (O3(t) + L(t, 3))
+
+static uint32_t const _len_mask[5] = {
+    0, 0xff, 0xffff, 0xffffff, 0xffffffff
+};
+
+CU_SINLINE void
+_put_le32(unsigned char *p, uint32_t x)
+{
+#ifdef CUCONF_WORDS_BIGENDIAN
+    p[0] = x;
+    p[1] = x >> 8;
+    p[2] = x >> 16;
+    p[3] = x >> 24;
+#else
+    memcpy(p, &x, 4);
+#endif
+}
+
+CU_SINLINE uint32_t
+_get_le32(unsigned char const *p)
+{
+#ifdef CUCONF_WORDS_BIGENDIAN
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+#else
+    uint32_t x;
+    memcpy(&x, p, 4);
+    return x;
+#endif
+}
+
+CU_SINLINE unsigned int
+_uint32_len(uint32_t x)
+{
+    return 1 + (x > 0xff) + (x > 0xffff) + (x > 0xffffff);
+}
+
+/* Encodes a group of up to four integers to p, which must have room for
+ * GROUP_MAXSIZE bytes, and returns the number of bytes used. */
+static size_t
+_encode_group(unsigned char *p, uint32_t const *arr, size_t cnt)
+{
+    unsigned char *q = p + 1;
+    unsigned int tag = 0;
+    size_t j;
+    for (j = 0; j < cnt; ++j) {
+	unsigned int len = _uint32_len(arr[j]);
+	tag |= (len - 1) << 2*j;
+	_put_le32(q, arr[j]);
+	q += len;
+    }
+    *p = tag;
+    return q - p;
+}
+
+/* Decodes a group of cnt integers, where cnt is 4 except for the last group,
+ * from [p, end).  Returns the number of bytes consumed or 0 if the data is
+ * incomplete. */
+static size_t
+_decode_group(unsigned char const *p, unsigned char const *end,
+	      uint32_t *arr, size_t cnt)
+{
+    unsigned int tag = *p;
+    unsigned char const *q = p + 1;
+    size_t j;
+    if (end - p >= GROUP_MAXSIZE) {
+	for (j = 0; j < cnt; ++j) {
+	    unsigned int len = L(tag, j);
+	    arr[j] = _get_le32(q) & _len_mask[len];
+	    q += len;
+	}
+    }
+    else {
+	for (j = 0; j < cnt; ++j) {
+	    unsigned int len = L(tag, j), i;
+	    uint32_t x = 0;
+	    if (end - q < len)
+		return 0;
+	    for (i = 0; i < len; ++i)
+		x |= (uint32_t)q[i] << 8*i;
+	    arr[j] = x;
+	    q += len;
+	}
+    }
+    return q - p;
+}
+
+
+#ifdef USE_SSSE3
+/* Decodes full groups from *p_ref while they are known to be buffered, and
+ * returns the number of integers decoded. */
+static __attribute__((target("ssse3"))) size_t
+_ssse3_decode_groups(unsigned char const **p_ref, unsigned char const *end,
+		     uint32_t *arr, size_t cnt)
+{
+    unsigned char const *p = *p_ref;
+    size_t done = 0;
+    while (cnt - done >= 4 && end - p >= GROUP_MAXSIZE) {
+	unsigned int tag = *p;
+	__m128i x = _mm_loadu_si128((__m128i const *)(p + 1));
+	x = _mm_shuffle_epi8(x, _mm_loadu_si128((__m128i const *)
+						 _group_shuffle[tag]));
+	_mm_storeu_si128((__m128i *)(arr + done), x);
+	p += 1 + GROUP_SIZE(tag);
+	done += 4;
+    }
+    *p_ref = p;
+    return done;
+}
+#endif
+
+
+/* Encoder
+ * ------- */
+
+void
+custo_encoder_init(custo_encoder_t enc, cu_dsink_t sink)
+{
+    if (sink)
+	cu_dsink_assert_clogfree(sink);
+    cu_buffer_init(&enc->buf, BLOCK_SIZE);
+    enc->cur = cu_buffer_content_end(&enc->buf);
+    enc->end = cu_buffer_storage_end(&enc->buf);
+    enc->sink = sink;
+}
+
+custo_encoder_t
+custo_encoder_new(cu_dsink_t sink)
+{
+    custo_encoder_t enc = cu_gnew(struct custo_encoder);
+    custo_encoder_init(enc, sink);
+    return enc;
+}
+
+void
+custo_encoder_flush(custo_encoder_t enc)
+{
+    if (!enc->sink)
+	return;
+    cu_buffer_set_content_end(&enc->buf, enc->cur);
+    cu_dsink_write(enc->sink, cu_buffer_content_start(&enc->buf),
+		   cu_buffer_content_size(&enc->buf));
+    cu_buffer_clear(&enc->buf);
+    enc->cur = cu_buffer_content_end(&enc->buf);
+    enc->end = cu_buffer_storage_end(&enc->buf);
+}
+
+void *
+custo_encoder_finish(custo_encoder_t enc)
+{
+    if (!enc->sink)
+	return NULL;
+    custo_encoder_flush(enc);
+    return cu_dsink_finish(enc->sink);
+}
+
+cu_buffer_t
+custo_encoder_buffer(custo_encoder_t enc)
+{
+    cu_buffer_set_content_end(&enc->buf, enc->cur);
+    return &enc->buf;
+}
+
+void
+custoP_encoder_reserve(custo_encoder_t enc, size_t size)
+{
+    if (enc->sink && enc->cur != cu_buffer_content_start(&enc->buf))
+	custo_encoder_flush(enc);
+    cu_buffer_set_content_end(&enc->buf, enc->cur);
+    cu_buffer_extend_freecap(&enc->buf, size < BLOCK_SIZE? BLOCK_SIZE : size);
+    enc->cur = cu_buffer_content_end(&enc->buf);
+    enc->end = cu_buffer_storage_end(&enc->buf);
+}
+
+void
+custo_encoder_put_bytes(custo_encoder_t enc, void const *data, size_t size)
+{
+    if (enc->end - enc->cur < size) {
+	if (enc->sink && size >= BLOCK_SIZE) {
+	    custo_encoder_flush(enc);
+	    cu_dsink_write(enc->sink, data, size);
+	    return;
+	}
+	custoP_encoder_reserve(enc, size);
+    }
+    memcpy(enc->cur, data, size);
+    enc->cur += size;
+}
+
+void
+custo_encoder_put_uint32_arr(custo_encoder_t enc,
+			     uint32_t const *arr, size_t cnt)
+{
+    while (cnt > 0) {
+	size_t grp_cnt = cnt < 4? cnt : 4;
+	if (enc->end - enc->cur < GROUP_MAXSIZE)
+	    custoP_encoder_reserve(enc, GROUP_MAXSIZE);
+	enc->cur += _encode_group(enc->cur, arr, grp_cnt);
+	arr += grp_cnt;
+	cnt -= grp_cnt;
+    }
+}
+
+
+/* Decoder
+ * ------- */
+
+void
+custo_decoder_init(custo_decoder_t dec, cu_dsource_t source)
+{
+    cu_buffer_init(&dec->buf, BLOCK_SIZE);
+    dec->cur = dec->end = cu_buffer_content_start(&dec->buf);
+    dec->source = source;
+}
+
+custo_decoder_t
+custo_decoder_new(cu_dsource_t source)
+{
+    custo_decoder_t dec = cu_gnew(struct custo_decoder);
+    custo_decoder_init(dec, source);
+    return dec;
+}
+
+void
+custo_decoder_init_mem(custo_decoder_t dec, void const *data, size_t size)
+{
+    dec->cur = data;
+    dec->end = dec->cur + size;
+    dec->source = NULL;
+}
+
+/* Reads from the source until at least size bytes are buffered or the
+ * source is exhausted.  Returns true iff size bytes are available. */
+static cu_bool_t
+_decoder_fill(custo_decoder_t dec, size_t size)
+{
+    cu_buffer_t buf = &dec->buf;
+    if (dec->end - dec->cur >= size)
+	return cu_true;
+    if (!dec->source)
+	return cu_false;
+    cu_buffer_set_content_start(buf, (void *)dec->cur);
+    cu_buffer_force_realign(buf);
+    cu_buffer_extend_freecap(buf, size < BLOCK_SIZE? BLOCK_SIZE : size);
+    while (cu_buffer_content_size(buf) < size) {
+	size_t read_size = cu_dsource_read(dec->source,
+					   cu_buffer_content_end(buf),
+					   cu_buffer_freecap(buf));
+	if (read_size == 0)
+	    break;
+	cu_buffer_incr_content_end(buf, read_size);
+    }
+    dec->cur = cu_buffer_content_start(buf);
+    dec->end = cu_buffer_content_end(buf);
+    return dec->end - dec->cur >= size;
+}
+
+cu_bool_t
+custo_decoder_at_end(custo_decoder_t dec)
+{
+    return !_decoder_fill(dec, 1);
+}
+
+cu_bool_t
+custoP_decoder_get_uintmax(custo_decoder_t dec, uintmax_t *n_out)
+{
+    size_t size;
+    _decoder_fill(dec, CUSTO_UINTMAX_MAXSIZE);
+    if (dec->end - dec->cur >= 2 && (dec->cur[0] & 0xc0) == 0x80) {
+	*n_out = (dec->cur[0] & 0x3f) << 8 | dec->cur[1];
+	dec->cur += 2;
+	return cu_true;
+    }
+    size = _decode_uintmax(dec->cur, dec->end, n_out);
+    dec->cur += size;
+    return size != 0;
+}
+
+cu_bool_t
+custoP_decoder_get_intmax(custo_decoder_t dec, intmax_t *n_out)
+{
+    size_t size;
+    _decoder_fill(dec, CUSTO_UINTMAX_MAXSIZE);
+    size = _decode_intmax(dec->cur, dec->end, n_out);
+    dec->cur += size;
+    return size != 0;
+}
+
+cu_bool_t
+custo_decoder_get_bytes(custo_decoder_t dec, void *data, size_t size)
+{
+    while (size > 0) {
+	size_t chunk_size;
+	if (!_decoder_fill(dec, 1))
+	    return cu_false;
+	chunk_size = dec->end - dec->cur;
+	if (chunk_size > size)
+	    chunk_size = size;
+	memcpy(data, dec->cur, chunk_size);
+	dec->cur += chunk_size;
+	data = (char *)data + chunk_size;
+	size -= chunk_size;
+    }
+    return cu_true;
+}
+
+cu_bool_t
+custo_decoder_get_uint32_arr(custo_decoder_t dec, uint32_t *arr, size_t cnt)
+{
+#ifdef USE_SSSE3
+    cu_bool_t have_ssse3 = __builtin_cpu_supports("ssse3");
+#endif
+    while (cnt > 0) {
+	size_t grp_cnt, size;
+	_decoder_fill(dec, GROUP_MAXSIZE);
+#ifdef USE_SSSE3
+	if (have_ssse3) {
+	    size_t done = _ssse3_decode_groups(&dec->cur, dec->end, arr, cnt);
+	    arr += done;
+	    cnt -= done;
+	    if (done > 0)
+		continue;
+	}
+#endif
+	grp_cnt = cnt < 4? cnt : 4;
+	if (dec->cur == dec->end)
+	    return cu_false;
+	size = _decode_group(dec->cur, dec->end, arr, grp_cnt);
+	if (size == 0)
+	    return cu_false;
+	dec->cur += size;
+	arr += grp_cnt;
+	cnt -= grp_cnt;
+    }
+    return cu_true;
+}
@@ -0,0 +1,185 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CUSTO_CODEC_H
+#define CUSTO_CODEC_H
+
+#include <cu/fwd.h>
+#include <cu/buffer.h>
+#include <stdint.h>
+
+CU_BEGIN_DECLARATIONS
+/** \defgroup custo_codec_h custo/codec.h: Buffered Encoder and Decoder
+ ** @{ \ingroup custo_mod
+ **
+ ** Encoders and decoders which keep the encoded data in a memory buffer and
+ ** only pass it to or from a \ref cu_dsink_h "cu_dsink" or \ref cu_dsource_h
+ ** "cu_dsource" in large blocks.  The single-integer functions use the same
+ ** size-independent encoding as \ref custo_fwrite_uintmax and \ref
+ ** custo_fwrite_intmax, so the two APIs can be mixed on the same data, but
+ ** the common cases are inlined and there is no stdio locking per integer.
+ **
+ ** In addition, arrays of 32 bit integers can be encoded with a group varint
+ ** encoding, where each group of four integers starts with a byte holding
+ ** the byte-lengths of the four, followed by the integers in little-endian
+ ** order with leading zero bytes dropped.  This avoids the per-byte
+ ** branching of the single-integer encoding, and where the processor
+ ** supports SSSE3, a group is decoded with a single byte shuffle.
+ **/
+
+#define CUSTO_UINTMAX_MAXSIZE (sizeof(uintmax_t) + sizeof(uintmax_t)/8 + 1)
+
+typedef struct custo_encoder *custo_encoder_t;
+typedef struct custo_decoder *custo_decoder_t;
+
+/** \name Encoder
+ ** @{ */
+
+struct custo_encoder
+{
+    unsigned char *cur;
+    unsigned char *end;
+    struct cu_buffer buf;
+    cu_dsink_t sink;
+};
+
+/** Initialise \a enc to encode to \a sink, which must be clog-free.  If
+ ** \a sink is \c NULL, the data is kept in the buffer returned by \ref
+ ** custo_encoder_buffer. */
+void custo_encoder_init(custo_encoder_t enc, cu_dsink_t sink);
+
+/** Returns an encoder for \a sink, as by \ref custo_encoder_init. */
+custo_encoder_t custo_encoder_new(cu_dsink_t sink);
+
+/** Passes the buffered data to the sink, if any.  This does not flush the
+ ** sink itself. */
+void custo_encoder_flush(custo_encoder_t enc);
+
+/** Flushes \a enc and returns the result of \ref cu_dsink_finish on the sink,
+ ** or \c NULL if there is no sink. */
+void *custo_encoder_finish(custo_encoder_t enc);
+
+/** If \a enc has no sink, returns the buffer holding the encoded data, else
+ ** returns the data which is not yet flushed. */
+cu_buffer_t custo_encoder_buffer(custo_encoder_t enc);
+
+void custoP_encoder_reserve(custo_encoder_t enc, size_t size);
+size_t custoP_encode_uintmax(unsigned char *p, uintmax_t n);
+size_t custoP_encode_intmax(unsigned char *p, intmax_t n);
+
+/** Appends the \a size bytes at \a data to the stream. */
+void custo_encoder_put_bytes(custo_encoder_t enc, void const *data,
+			     size_t size);
+
+/** Encodes the unsigned integer \a n. */
+CU_SINLINE void
+custo_encoder_put_uintmax(custo_encoder_t enc, uintmax_t n)
+{
+    if (cu_expect_false(enc->end - enc->cur < CUSTO_UINTMAX_MAXSIZE))
+	custoP_encoder_reserve(enc, CUSTO_UINTMAX_MAXSIZE);
+    if (n < 0x80)
+	*enc->cur++ = n;
+    else
+	enc->cur += custoP_encode_uintmax(enc->cur, n);
+}
+
+/** Encodes the signed integer \a n. */
+CU_SINLINE void
+custo_encoder_put_intmax(custo_encoder_t enc, intmax_t n)
+{
+    if (cu_expect_false(enc->end - enc->cur < CUSTO_UINTMAX_MAXSIZE))
+	custoP_encoder_reserve(enc, CUSTO_UINTMAX_MAXSIZE);
+    if (0 <= n && n < 0x40)
+	*enc->cur++ = n;
+    else
+	enc->cur += custoP_encode_intmax(enc->cur, n);
+}
+
+/** Encodes the \a cnt elements of \a arr with the group varint encoding.  The
+ ** count itself is not written. */
+void custo_encoder_put_uint32_arr(custo_encoder_t enc,
+				  uint32_t const *arr, size_t cnt);
+
+/** @}
+ ** \name Decoder
+ ** @{ */
+
+struct custo_decoder
+{
+    unsigned char const *cur;
+    unsigned char const *end;
+    struct cu_buffer buf;
+    cu_dsource_t source;
+};
+
+/** Initialise \a dec to decode data read from \a source. */
+void custo_decoder_init(custo_decoder_t dec, cu_dsource_t source);
+
+/** Returns a decoder for \a source, as by \ref custo_decoder_init. */
+custo_decoder_t custo_decoder_new(cu_dsource_t source);
+
+/** Initialise \a dec to decode the \a size bytes starting at \a data.  The
+ ** data is not copied. */
+void custo_decoder_init_mem(custo_decoder_t dec, void const *data,
+			    size_t size);
+
+/** True if all data has been consumed. */
+cu_bool_t custo_decoder_at_end(custo_decoder_t dec);
+
+cu_bool_t custoP_decoder_get_uintmax(custo_decoder_t dec, uintmax_t *n_out);
+cu_bool_t custoP_decoder_get_intmax(custo_decoder_t dec, intmax_t *n_out);
+
+/** Reads \a size bytes into \a data.  Returns false if the stream ends
+ ** first. */
+cu_bool_t custo_decoder_get_bytes(custo_decoder_t dec, void *data,
+				  size_t size);
+
+/** Decodes an unsigned integer into \a *n_out.  Returns false if the stream
+ ** ends in the middle of the integer or the integer does not fit in a
+ ** uintmax_t. */
+CU_SINLINE cu_bool_t
+custo_decoder_get_uintmax(custo_decoder_t dec, uintmax_t *n_out)
+{
+    if (cu_expect_true(dec->cur < dec->end && *dec->cur < 0x80)) {
+	*n_out = *dec->cur++;
+	return cu_true;
+    }
+    return custoP_decoder_get_uintmax(dec, n_out);
+}
+
+/** Decodes a signed integer into \a *n_out, as \ref
+ ** custo_decoder_get_uintmax. */
+CU_SINLINE cu_bool_t
+custo_decoder_get_intmax(custo_decoder_t dec, intmax_t *n_out)
+{
+    if (cu_expect_true(dec->cur < dec->end && *dec->cur < 0x40)) {
+	*n_out = *dec->cur++;
+	return cu_true;
+    }
+    return custoP_decoder_get_intmax(dec, n_out);
+}
+
+/** Decodes \a cnt integers written by \ref custo_encoder_put_uint32_arr into
+ ** \a arr.  Returns false if the stream ends first. */
+cu_bool_t custo_decoder_get_uint32_arr(custo_decoder_t dec,
+				       uint32_t *arr, size_t cnt);
+
+/** @}
+ ** @} */
+CU_END_DECLARATIONS
+
+#endif
@@ -0,0 +1,123 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Compares the stdio-based integer I/O of custo/binary_io.h with the
+ * buffered encoder and decoder and the group varint array encoding. */
+
+#include <custo/codec.h>
+#include <custo/binary_io.h>
+#include <cu/memory.h>
+#include <cu/test.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define INT_CNT ((size_t)1 << 22)
+
+static uint32_t int_arr[INT_CNT];
+static uint32_t out_arr[INT_CNT];
+
+static void
+_report(char const *name, clock_t t, size_t byte_cnt)
+{
+    double secs = t/(double)CLOCKS_PER_SEC;
+    printf("    %-22s %8.1lf Mint/s %8.1lf MB/s\n", name,
+	   INT_CNT/(1e6*secs), byte_cnt/(1e6*secs));
+}
+
+static void
+_bench(char const *name, int max_bits)
+{
+    struct custo_encoder enc;
+    struct custo_decoder dec;
+    cu_buffer_t buf;
+    FILE *file = tmpfile();
+    size_t i, size;
+    clock_t t;
+
+    for (i = 0; i < INT_CNT; ++i) {
+	int bit_cnt = lrand48() % max_bits + 1;
+	int_arr[i] = ((uint32_t)lrand48() << 1 ^ lrand48())
+		   >> (32 - bit_cnt);
+    }
+    printf("%s\n", name);
+
+    t = -clock();
+    for (i = 0; i < INT_CNT; ++i)
+	custo_fwrite_uintmax(int_arr[i], file);
+    fflush(file);
+    t += clock();
+    size = ftell(file);
+    _report("stdio write", t, size);
+
+    rewind(file);
+    t = -clock();
+    for (i = 0; i < INT_CNT; ++i) {
+	uintmax_t n;
+	custo_fread_uintmax(&n, file);
+	out_arr[i] = n;
+    }
+    t += clock();
+    _report("stdio read", t, size);
+    fclose(file);
+
+    t = -clock();
+    custo_encoder_init(&enc, NULL);
+    for (i = 0; i < INT_CNT; ++i)
+	custo_encoder_put_uintmax(&enc, int_arr[i]);
+    buf = custo_encoder_buffer(&enc);
+    t += clock();
+    size = cu_buffer_content_size(buf);
+    _report("encoder, per int", t, size);
+
+    t = -clock();
+    custo_decoder_init_mem(&dec, cu_buffer_content_start(buf), size);
+    for (i = 0; i < INT_CNT; ++i) {
+	uintmax_t n;
+	custo_decoder_get_uintmax(&dec, &n);
+	out_arr[i] = n;
+    }
+    t += clock();
+    _report("decoder, per int", t, size);
+    cu_test_assert(memcmp(int_arr, out_arr, sizeof(int_arr)) == 0);
+
+    t = -clock();
+    custo_encoder_init(&enc, NULL);
+    custo_encoder_put_uint32_arr(&enc, int_arr, INT_CNT);
+    buf = custo_encoder_buffer(&enc);
+    t += clock();
+    size = cu_buffer_content_size(buf);
+    _report("encoder, group varint", t, size);
+
+    t = -clock();
+    custo_decoder_init_mem(&dec, cu_buffer_content_start(buf), size);
+    custo_decoder_get_uint32_arr(&dec, out_arr, INT_CNT);
+    t += clock();
+    _report("decoder, group varint", t, size);
+    cu_test_assert(memcmp(int_arr, out_arr, sizeof(int_arr)) == 0);
+}
+
+int
+main()
+{
+    cu_init();
+    _bench("Integers below 2^7", 7);
+    _bench("Integers below 2^16", 16);
+    _bench("Integers below 2^32", 32);
+    return 0;
+}
@@ -0,0 +1,256 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <custo/codec.h>
+#include <custo/binary_io.h>
+#include <cu/dsink.h>
+#include <cu/dsource.h>
+#include <cu/inherit.h>
+#include <cu/memory.h>
+#include <cu/test.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INT_CNT 20000
+#define ARR_CNT 10000
+
+/* A clog-free sink which collects the data. */
+struct _testsink
+{
+    cu_inherit (cu_dsink);
+    struct cu_buffer buf;
+};
+
+#define TESTSINK(sink) cu_from(_testsink, cu_dsink, sink)
+
+static size_t
+_testsink_write(cu_dsink_t sink, void const *data, size_t size)
+{
+    cu_buffer_write(&TESTSINK(sink)->buf, data, size);
+    return size;
+}
+
+static cu_word_t
+_testsink_control(cu_dsink_t sink, int fn, va_list va)
+{
+    switch (fn) {
+	case CU_DSINK_FN_IS_CLOGFREE:
+	    return CU_DSINK_ST_SUCCESS;
+	case CU_DSINK_FN_FINISH:
+	    return (cu_word_t)&TESTSINK(sink)->buf;
+	default:
+	    return CU_DSINK_ST_UNIMPL;
+    }
+}
+
+/* A source which returns the data in random small chunks, to exercise the
+ * refilling of the decoder. */
+struct _testsource
+{
+    cu_inherit (cu_dsource);
+    unsigned char const *cur, *end;
+};
+
+#define TESTSOURCE(source) cu_from(_testsource, cu_dsource, source)
+
+static size_t
+_testsource_read(cu_dsource_t source, void *buf, size_t max_size)
+{
+    struct _testsource *self = TESTSOURCE(source);
+    size_t size = lrand48() % 40 + 1;
+    if (size > max_size)
+	size = max_size;
+    if (size > self->end - self->cur)
+	size = self->end - self->cur;
+    memcpy(buf, self->cur, size);
+    self->cur += size;
+    return size;
+}
+
+static cu_word_t
+_testsource_control(cu_dsource_t source, int fn, va_list va)
+{
+    return CU_DSOURCE_ST_UNIMPL;
+}
+
+static cu_dsource_t
+_testsource_new(void const *data, size_t size)
+{
+    struct _testsource *source = cu_gnew(struct _testsource);
+    cu_dsource_init(cu_to(cu_dsource, source),
+		    _testsource_control, _testsource_read);
+    source->cur = data;
+    source->end = source->cur + size;
+    return cu_to(cu_dsource, source);
+}
+
+/* A random integer with a random number of significant bits. */
+static uintmax_t
+_random_uintmax(void)
+{
+    uintmax_t n = ((uintmax_t)lrand48() << 62) ^ ((uintmax_t)lrand48() << 31)
+		^ lrand48();
+    int bit_cnt = lrand48() % (8*sizeof(uintmax_t) + 1);
+    return bit_cnt == 0? 0 : n >> (8*sizeof(uintmax_t) - bit_cnt);
+}
+
+static uint32_t
+_random_uint32(void)
+{
+    return _random_uintmax() >> (8*sizeof(uintmax_t) - 32);
+}
+
+static void
+_test_ints(void)
+{
+    static uintmax_t u_arr[INT_CNT];
+    static intmax_t s_arr[INT_CNT];
+    struct custo_encoder enc;
+    struct custo_decoder dec;
+    struct _testsink *sink;
+    cu_buffer_t buf;
+    char *file_data;
+    size_t file_size;
+    FILE *file;
+    int i, k;
+
+    u_arr[0] = 0;
+    u_arr[1] = UINTMAX_MAX;
+    s_arr[0] = INTMAX_MAX;
+    s_arr[1] = -INTMAX_MAX;
+    for (i = 2; i < INT_CNT; ++i) {
+	u_arr[i] = _random_uintmax();
+	s_arr[i] = (intmax_t)(_random_uintmax() >> 1)*(lrand48() % 2? 1 : -1);
+    }
+
+    /* The encoding must agree with the stdio functions. */
+    file = open_memstream(&file_data, &file_size);
+    custo_encoder_init(&enc, NULL);
+    for (i = 0; i < INT_CNT; ++i) {
+	custo_fwrite_uintmax(u_arr[i], file);
+	custo_fwrite_intmax(s_arr[i], file);
+	custo_encoder_put_uintmax(&enc, u_arr[i]);
+	custo_encoder_put_intmax(&enc, s_arr[i]);
+    }
+    fclose(file);
+    buf = custo_encoder_buffer(&enc);
+    cu_test_assert(cu_buffer_content_size(buf) == file_size);
+    cu_test_assert(memcmp(cu_buffer_content_start(buf), file_data,
+			  file_size) == 0);
+
+    /* The same data through a sink. */
+    sink = cu_gnew(struct _testsink);
+    cu_dsink_init(cu_to(cu_dsink, sink),
+		  _testsink_control, _testsink_write);
+    cu_buffer_init(&sink->buf, 0);
+    custo_encoder_init(&enc, cu_to(cu_dsink, sink));
+    for (i = 0; i < INT_CNT; ++i) {
+	custo_encoder_put_uintmax(&enc, u_arr[i]);
+	custo_encoder_put_intmax(&enc, s_arr[i]);
+    }
+    cu_test_assert(custo_encoder_finish(&enc) == &sink->buf);
+    cu_test_assert(cu_buffer_content_size(&sink->buf) == file_size);
+    cu_test_assert(memcmp(cu_buffer_content_start(&sink->buf), file_data,
+			  file_size) == 0);
+
+    /* Decode from memory and from a chunked source. */
+    for (k = 0; k < 2; ++k) {
+	if (k == 0)
+	    custo_decoder_init_mem(&dec, file_data, file_size);
+	else
+	    custo_decoder_init(&dec, _testsource_new(file_data, file_size));
+	for (i = 0; i < INT_CNT; ++i) {
+	    uintmax_t u;
+	    intmax_t s;
+	    cu_test_assert(custo_decoder_get_uintmax(&dec, &u));
+	    cu_test_assert(u == u_arr[i]);
+	    cu_test_assert(custo_decoder_get_intmax(&dec, &s));
+	    cu_test_assert(s == s_arr[i]);
+	}
+	cu_test_assert(custo_decoder_at_end(&dec));
+    }
+
+    /* A truncated integer is an error. */
+    for (i = 0; i < INT_CNT; ++i)
+	if (u_arr[i] > 0xffffff)
+	    break;
+    custo_encoder_init(&enc, NULL);
+    custo_encoder_put_uintmax(&enc, u_arr[i]);
+    buf = custo_encoder_buffer(&enc);
+    for (k = 0; k < cu_buffer_content_size(buf); ++k) {
+	uintmax_t u;
+	custo_decoder_init_mem(&dec, cu_buffer_content_start(buf), k);
+	cu_test_assert(!custo_decoder_get_uintmax(&dec, &u));
+    }
+    free(file_data);
+}
+
+static void
+_test_uint32_arr(void)
+{
+    static uint32_t arr[ARR_CNT], arr_out[ARR_CNT];
+    struct custo_encoder enc;
+    struct custo_decoder dec;
+    cu_buffer_t buf;
+    size_t cnt, size;
+    int i, k;
+
+    for (i = 0; i < ARR_CNT; ++i)
+	arr[i] = _random_uint32();
+    for (cnt = 0; cnt < ARR_CNT; cnt = cnt < 16? cnt + 1 : cnt*3) {
+	custo_encoder_init(&enc, NULL);
+	custo_encoder_put_uintmax(&enc, cnt);
+	custo_encoder_put_uint32_arr(&enc, arr, cnt);
+	custo_encoder_put_uintmax(&enc, 1234);
+	buf = custo_encoder_buffer(&enc);
+	size = cu_buffer_content_size(buf);
+	for (k = 0; k < 2; ++k) {
+	    uintmax_t n;
+	    if (k == 0)
+		custo_decoder_init_mem(&dec, cu_buffer_content_start(buf),
+				       size);
+	    else
+		custo_decoder_init(&dec, _testsource_new(
+					cu_buffer_content_start(buf), size));
+	    memset(arr_out, 0, sizeof(arr_out));
+	    cu_test_assert(custo_decoder_get_uintmax(&dec, &n) && n == cnt);
+	    cu_test_assert(custo_decoder_get_uint32_arr(&dec, arr_out, cnt));
+	    cu_test_assert(memcmp(arr, arr_out, cnt*sizeof(uint32_t)) == 0);
+	    cu_test_assert(custo_decoder_get_uintmax(&dec, &n) && n == 1234);
+	    cu_test_assert(custo_decoder_at_end(&dec));
+	}
+
+	/* Cut into the last group; the trailing 1234 takes two bytes. */
+	if (cnt > 0) {
+	    uintmax_t n;
+	    custo_decoder_init_mem(&dec, cu_buffer_content_start(buf),
+				   size - 3);
+	    cu_test_assert(custo_decoder_get_uintmax(&dec, &n));
+	    cu_test_assert(!custo_decoder_get_uint32_arr(&dec, arr_out, cnt));
+	}
+    }
+}
+
+int
+main()
+{
+    cu_init();
+    _test_ints();
+    _test_uint32_arr();
+    return 2*!!cu_test_bug_count();
+}
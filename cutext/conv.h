@@ -25,17 +25,42 @@
 
 CU_BEGIN_DECLARATIONS
 
-/* Convert 'src_size' UTF-8 bytes starting at 'src_arr' storing up to
- * 'dst_cap' UCS-4 characters starting at 'dst_arr', and set
- * '*dst_size' to the actual number stored.  Return 0 on success and
- * the 'errno' returned from 'iconv' on failure. */
+/* Decode UTF-8 from the '*src_cnt' bytes at '*src_arr' into at most
+ * '*dst_cnt' characters at '*dst_arr'.  The pointers are advanced and the
+ * counts decremented past the converted data.  Return 0 if all of the source
+ * was converted, otherwise EILSEQ on an invalid sequence, EINVAL on an
+ * incomplete sequence at the end of the source, or E2BIG if the destination
+ * is full, as for 'iconv'.  Overlong forms, surrogates, and code points
+ * beyond U+10FFFF are invalid.  Runs of ASCII are converted with SIMD
+ * instructions where available. */
+int cutext_utf8_to_wchar(char const **src_arr, size_t *src_cnt,
+			 cu_wchar_t **dst_arr, size_t *dst_cnt);
+
+/* Encode the '*src_cnt' characters at '*src_arr' as UTF-8 into at most
+ * '*dst_cnt' bytes at '*dst_arr', with the same conventions as
+ * 'cutext_utf8_to_wchar'. */
+int cutext_wchar_to_utf8(cu_wchar_t const **src_arr, size_t *src_cnt,
+			 char **dst_arr, size_t *dst_cnt);
+
+/* Return the length of the longest prefix of the 'cnt' bytes at 'arr' which
+ * consists of complete and valid UTF-8 sequences.  The data is valid UTF-8
+ * iff the result is 'cnt'. */
+size_t cutext_utf8_valid_prefix(char const *arr, size_t cnt);
+
+/* Private: An iconv-like converter between UTF-8 and cu_wchar_t, or NULL if
+ * the conversion from 'from_encoding' to 'to_encoding' is not built in. */
+typedef size_t (*cutextP_conv_t)(char **src_arr, size_t *src_size,
+				 char **dst_arr, size_t *dst_size);
+cutextP_conv_t cutextP_builtin_conv(char const *to_encoding,
+				    char const *from_encoding);
+
+/* Same as 'cutext_utf8_to_wchar'.  This no longer uses 'iconv', but
+ * returns the same error codes. */
 int cutext_iconv_char_to_wchar(char const **src_arr, size_t *src_cnt,
 			       cu_wchar_t **dst_arr, size_t *dst_cnt);
 
-/* Convert 'src_size' UCS-4 characters starting at 'src_arr' storing
- * up to 'dst_cap' UTF-8 characters starting at 'dst_arr', and set
- * '*dst_size' to the actual numbers stored.  Return 0 on success and
- * the 'errno' returned from 'iconv' on failure. */
+/* Same as 'cutext_wchar_to_utf8'.  This no longer uses 'iconv', but
+ * returns the same error codes. */
 int cutext_iconv_wchar_to_char(cu_wchar_t const **src_arr, size_t *src_size,
 			       char **dst_arr, size_t *dst_cap);
 
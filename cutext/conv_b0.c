@@ -0,0 +1,148 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Compares the built-in UTF-8 codec with iconv on texts of different
+ * composition, and times validation and a stacked source conversion. */
+
+#include <cutext/conv.h>
+#include <cutext/source.h>
+#include <cu/test.h>
+#include <cu/memory.h>
+#include <cu/conf.h>
+#include <iconv.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef CUCONF_WORDS_BIGENDIAN
+#  define UCS4HOST "UCS-4"
+#else
+#  define UCS4HOST "UCS-4LE"
+#endif
+
+#define TEXT_CNT ((size_t)1 << 22)
+#define REPEAT 8
+
+static double
+_mbps(clock_t t, size_t size)
+{
+    return REPEAT*size/(1048576.0*t/CLOCKS_PER_SEC);
+}
+
+/* A text where a fraction of 1/non_ascii_freq characters is drawn from
+ * [ch_min, ch_max), and the rest is ASCII. */
+static cu_wchar_t *
+_make_text(int non_ascii_freq, cu_wchar_t ch_min, cu_wchar_t ch_max)
+{
+    cu_wchar_t *arr = cu_galloc_atomic(TEXT_CNT*sizeof(cu_wchar_t));
+    size_t i;
+    for (i = 0; i < TEXT_CNT; ++i) {
+	if (non_ascii_freq && lrand48() % non_ascii_freq == 0)
+	    arr[i] = ch_min + lrand48() % (ch_max - ch_min);
+	else
+	    arr[i] = (lrand48() % 8 == 0)? ' ' : 'a' + lrand48() % 26;
+    }
+    return arr;
+}
+
+static void
+_bench(char const *name, cu_wchar_t *warr)
+{
+    char *carr = cu_galloc_atomic(TEXT_CNT*4);
+    cu_wchar_t *warr2 = cu_galloc_atomic(TEXT_CNT*sizeof(cu_wchar_t));
+    size_t clen = 0;
+    clock_t t;
+    iconv_t cd_enc = iconv_open("UTF-8", UCS4HOST);
+    iconv_t cd_dec = iconv_open(UCS4HOST, "UTF-8");
+    int r;
+
+    printf("%s\n", name);
+
+    t = -clock();
+    for (r = 0; r < REPEAT; ++r) {
+	cu_wchar_t const *src = warr;
+	char *dst = carr;
+	size_t src_cnt = TEXT_CNT, dst_cnt = TEXT_CNT*4;
+	cu_test_assert(cutext_wchar_to_utf8(&src, &src_cnt, &dst, &dst_cnt)
+		       == 0);
+	clen = dst - carr;
+    }
+    t += clock();
+    printf("    encode, built-in: %10.1lf MiB/s of UTF-8\n", _mbps(t, clen));
+
+    t = -clock();
+    for (r = 0; r < REPEAT; ++r) {
+	char *src = (char *)warr, *dst = carr;
+	size_t src_size = TEXT_CNT*sizeof(cu_wchar_t), dst_size = TEXT_CNT*4;
+	cu_test_assert(iconv(cd_enc, &src, &src_size, &dst, &dst_size)
+		       != (size_t)-1);
+    }
+    t += clock();
+    printf("    encode, iconv:    %10.1lf MiB/s of UTF-8\n", _mbps(t, clen));
+
+    t = -clock();
+    for (r = 0; r < REPEAT; ++r) {
+	char const *src = carr;
+	cu_wchar_t *dst = warr2;
+	size_t src_cnt = clen, dst_cnt = TEXT_CNT;
+	cu_test_assert(cutext_utf8_to_wchar(&src, &src_cnt, &dst, &dst_cnt)
+		       == 0);
+    }
+    t += clock();
+    printf("    decode, built-in: %10.1lf MiB/s of UTF-8\n", _mbps(t, clen));
+    cu_test_assert(memcmp(warr, warr2, TEXT_CNT*sizeof(cu_wchar_t)) == 0);
+
+    t = -clock();
+    for (r = 0; r < REPEAT; ++r) {
+	char *src = carr, *dst = (char *)warr2;
+	size_t src_size = clen, dst_size = TEXT_CNT*sizeof(cu_wchar_t);
+	cu_test_assert(iconv(cd_dec, &src, &src_size, &dst, &dst_size)
+		       != (size_t)-1);
+    }
+    t += clock();
+    printf("    decode, iconv:    %10.1lf MiB/s of UTF-8\n", _mbps(t, clen));
+
+    t = -clock();
+    for (r = 0; r < REPEAT; ++r)
+	cu_test_assert_size_eq(cutext_utf8_valid_prefix(carr, clen), clen);
+    t += clock();
+    printf("    validate:         %10.1lf MiB/s\n", _mbps(t, clen));
+
+    t = -clock();
+    for (r = 0; r < REPEAT; ++r) {
+	cutext_source_t src = cutext_source_new_mem("UTF-8", carr, clen);
+	src = cutext_source_stack_iconv(cu_wchar_encoding, src);
+	while (cutext_source_read(src, warr2, 4096*sizeof(cu_wchar_t)) > 0);
+    }
+    t += clock();
+    printf("    stacked source:   %10.1lf MiB/s of UTF-8\n", _mbps(t, clen));
+
+    iconv_close(cd_enc);
+    iconv_close(cd_dec);
+}
+
+int
+main()
+{
+    cutext_init();
+    _bench("ASCII", _make_text(0, 0, 0));
+    _bench("Mostly ASCII, 1/16 Latin and Greek",
+	   _make_text(16, 0xa0, 0x400));
+    _bench("CJK", _make_text(1, 0x4e00, 0x9fa0));
+    _bench("Mixed, 1/2 up to U+10FFFF", _make_text(2, 0x80, 0xd800));
+    return 2*!!cu_test_bug_count();
+}
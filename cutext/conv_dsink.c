@@ -20,6 +20,7 @@
 #include <cu/diag.h>
 #include <cu/debug.h>
 #include <cu/memory.h>
+#include <cutext/conv.h>
 #include <errno.h>
 #include <iconv.h>
 
@@ -30,6 +31,7 @@ struct _iconv_dsink
 {
     cu_inherit (cu_dsink);
     cu_dsink_t target_sink;
+    cutextP_conv_t builtin;
     iconv_t cd;
 };
 
@@ -50,7 +52,12 @@ _iconv_write(cu_dsink_t sink, void const *data_start, size_t data_size)
 	size_t dst_cap = IC_WRITE_BUFSIZE;
 	size_t st;
 
-	st = iconv(IC_DSINK(sink)->cd, &src_ptr, &src_size, &dst_ptr, &dst_cap);
+	if (IC_DSINK(sink)->builtin)
+	    st = (*IC_DSINK(sink)->builtin)(&src_ptr, &src_size,
+					    &dst_ptr, &dst_cap);
+	else
+	    st = iconv(IC_DSINK(sink)->cd,
+		       &src_ptr, &src_size, &dst_ptr, &dst_cap);
 	if (dst_cap < IC_WRITE_BUFSIZE) {
 	    size_t sub_st;
 	    sub_st = cu_dsink_write(IC_DSINK(sink)->target_sink,
@@ -89,7 +96,8 @@ _iconv_control(cu_dsink_t sink, int fn, va_list va)
     switch (fn) {
 	case CU_DSINK_FN_DISCARD:
 	case CU_DSINK_FN_FINISH:
-	    iconv_close(IC_DSINK(sink)->cd);
+	    if (!IC_DSINK(sink)->builtin)
+		iconv_close(IC_DSINK(sink)->cd);
 	    break;
     }
     return res;
@@ -103,6 +111,9 @@ cutext_dsink_open_iconv(char const *source_encoding,
     _iconv_dsink_t sink = cu_gnew(struct _iconv_dsink);
     cu_dsink_init(cu_to(cu_dsink, sink), _iconv_control, _iconv_write);
     sink->target_sink = target_sink;
+    sink->builtin = cutextP_builtin_conv(target_encoding, source_encoding);
+    if (sink->builtin)
+	return cu_to(cu_dsink, sink);
     sink->cd = iconv_open(target_encoding, source_encoding);
     if (sink->cd == (iconv_t)-1)
 	return NULL;
@@ -0,0 +1,210 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cutext/conv.h>
+#include <cutext/source.h>
+#include <cu/test.h>
+#include <cu/memory.h>
+#include <cu/conf.h>
+#include <errno.h>
+#include <iconv.h>
+#include <string.h>
+
+#ifdef CUCONF_WORDS_BIGENDIAN
+#  define UCS4HOST "UCS-4"
+#else
+#  define UCS4HOST "UCS-4LE"
+#endif
+
+/* Random characters with runs of ASCII, so that both the vectorised and the
+ * scalar paths are exercised. */
+static void
+_random_wstr(cu_wchar_t *arr, size_t cnt)
+{
+    size_t i = 0;
+    while (i < cnt) {
+	cu_wchar_t ch;
+	if (lrand48() % 2) {
+	    size_t run = lrand48() % 40;
+	    while (run-- && i < cnt)
+		arr[i++] = lrand48() % 0x80;
+	    continue;
+	}
+	switch (lrand48() % 3) {
+	    case 0: ch = 0x80 + lrand48() % (0x800 - 0x80); break;
+	    case 1: ch = 0x800 + lrand48() % (0x10000 - 0x800); break;
+	    default: ch = 0x10000 + lrand48() % (0x110000 - 0x10000); break;
+	}
+	if (ch >= 0xd800 && ch < 0xe000)
+	    continue;
+	arr[i++] = ch;
+    }
+}
+
+static void
+_test_roundtrip(size_t cnt)
+{
+    cu_wchar_t *warr = cu_galloc_atomic(cnt*sizeof(cu_wchar_t));
+    cu_wchar_t *warr2 = cu_galloc_atomic(cnt*sizeof(cu_wchar_t));
+    char *carr = cu_galloc_atomic(cnt*4);
+    char *carr_ic = cu_galloc_atomic(cnt*4);
+    cu_wchar_t const *wsrc = warr;
+    char const *csrc;
+    cu_wchar_t *wdst = warr2;
+    char *cdst = carr, *ic_src, *ic_dst = carr_ic;
+    size_t wcnt = cnt, ccap = cnt*4, wcap = cnt, ic_src_size, ic_dst_cap;
+    size_t clen;
+    iconv_t cd;
+
+    _random_wstr(warr, cnt);
+    cu_test_assert(cutext_wchar_to_utf8(&wsrc, &wcnt, &cdst, &ccap) == 0);
+    cu_test_assert(wcnt == 0 && wsrc == warr + cnt);
+    clen = cdst - carr;
+    cu_test_assert_size_eq(cutext_utf8_valid_prefix(carr, clen), clen);
+
+    /* Compare with iconv. */
+    cd = iconv_open("UTF-8", UCS4HOST);
+    cu_test_assert(cd != (iconv_t)-1);
+    ic_src = (char *)warr;
+    ic_src_size = cnt*sizeof(cu_wchar_t);
+    ic_dst_cap = cnt*4;
+    cu_test_assert(iconv(cd, &ic_src, &ic_src_size, &ic_dst, &ic_dst_cap)
+		   != (size_t)-1);
+    iconv_close(cd);
+    cu_test_assert_size_eq(ic_dst - carr_ic, clen);
+    cu_test_assert(memcmp(carr, carr_ic, clen) == 0);
+
+    csrc = carr;
+    cu_test_assert(cutext_utf8_to_wchar(&csrc, &clen, &wdst, &wcap) == 0);
+    cu_test_assert(clen == 0 && wcap == 0);
+    cu_test_assert(memcmp(warr, warr2, cnt*sizeof(cu_wchar_t)) == 0);
+
+    /* Short destinations stop at a character boundary. */
+    csrc = carr;
+    clen = cdst - carr;
+    wdst = warr2;
+    wcap = cnt/2;
+    cu_test_assert(cutext_utf8_to_wchar(&csrc, &clen, &wdst, &wcap) == E2BIG);
+    cu_test_assert_size_eq(wdst - warr2, cnt/2);
+    cu_test_assert_size_eq(cutext_utf8_valid_prefix(carr, csrc - carr),
+			   csrc - carr);
+
+    /* Truncation inside a multibyte character is incomplete. */
+    clen = cdst - carr;
+    if (clen && (carr[clen - 1] & 0x80)) {
+	csrc = carr;
+	--clen;
+	wdst = warr2;
+	wcap = cnt;
+	cu_test_assert(cutext_utf8_to_wchar(&csrc, &clen, &wdst, &wcap)
+		       == EINVAL);
+	cu_test_assert_size_eq(wdst - warr2, cnt - 1);
+	cu_test_assert(cutext_utf8_valid_prefix(carr, cdst - carr - 1)
+		       < cdst - carr - 1);
+    }
+}
+
+static void
+_test_invalid(char const *seq, size_t len, int err)
+{
+    char buf[64];
+    cu_wchar_t wbuf[64];
+    char const *src = buf;
+    cu_wchar_t *dst = wbuf;
+    size_t src_cnt, dst_cnt = 64, prefix = lrand48() % 32;
+    memset(buf, 'x', prefix);
+    memcpy(buf + prefix, seq, len);
+    src_cnt = prefix + len;
+    cu_test_assert(cutext_utf8_to_wchar(&src, &src_cnt, &dst, &dst_cnt)
+		   == err);
+    cu_test_assert_size_eq(src - buf, prefix);
+    cu_test_assert_size_eq(dst - wbuf, prefix);
+    cu_test_assert_size_eq(cutext_utf8_valid_prefix(buf, prefix + len),
+			   prefix);
+}
+
+static void
+_test_errors(void)
+{
+    static cu_wchar_t const bad_wchars[] = {0xd800, 0xdfff, 0x110000};
+    int i;
+
+    _test_invalid("\x80", 1, EILSEQ);		/* stray continuation */
+    _test_invalid("\xc0\x80", 2, EILSEQ);	/* overlong */
+    _test_invalid("\xc1\xbf", 2, EILSEQ);	/* overlong */
+    _test_invalid("\xe0\x80\x80", 3, EILSEQ);	/* overlong */
+    _test_invalid("\xe0\x9f\xbf", 3, EILSEQ);	/* overlong */
+    _test_invalid("\xed\xa0\x80", 3, EILSEQ);	/* surrogate */
+    _test_invalid("\xf0\x8f\xbf\xbf", 4, EILSEQ); /* overlong */
+    _test_invalid("\xf4\x90\x80\x80", 4, EILSEQ); /* beyond U+10FFFF */
+    _test_invalid("\xf5\x80\x80\x80", 4, EILSEQ);
+    _test_invalid("\xc3\x28", 2, EILSEQ);	/* bad continuation */
+    _test_invalid("\xe2\x82", 2, EINVAL);	/* truncated */
+    _test_invalid("\xf0\x9f\x98", 3, EINVAL);	/* truncated */
+    _test_invalid("\xed\xa0", 2, EILSEQ);	/* truncated surrogate */
+
+    for (i = 0; i < sizeof(bad_wchars)/sizeof(bad_wchars[0]); ++i) {
+	cu_wchar_t const *src = &bad_wchars[i];
+	size_t src_cnt = 1, dst_cnt = 8;
+	char buf[8], *dst = buf;
+	cu_test_assert(cutext_wchar_to_utf8(&src, &src_cnt, &dst, &dst_cnt)
+		       == EILSEQ);
+	cu_test_assert(src == &bad_wchars[i] && dst == buf);
+    }
+}
+
+/* Check that the built-in conversion is used and agrees with the direct one
+ * when stacked on a source. */
+static void
+_test_source(size_t cnt)
+{
+    cu_wchar_t *warr = cu_galloc_atomic(cnt*sizeof(cu_wchar_t));
+    cu_wchar_t *warr2 = cu_galloc_atomic(cnt*sizeof(cu_wchar_t));
+    char *carr = cu_galloc_atomic(cnt*4);
+    cu_wchar_t const *wsrc = warr;
+    char *cdst = carr;
+    size_t wcnt = cnt, ccap = cnt*4, got = 0;
+    cutext_source_t src;
+
+    _random_wstr(warr, cnt);
+    cu_test_assert(cutext_wchar_to_utf8(&wsrc, &wcnt, &cdst, &ccap) == 0);
+    src = cutext_source_new_mem("UTF-8", carr, cdst - carr);
+    src = cutext_source_stack_iconv(cu_wchar_encoding, src);
+    while (got < cnt) {
+	size_t m = (lrand48() % 64 + 1)*sizeof(cu_wchar_t);
+	size_t n = cutext_source_read(src, warr2 + got, m);
+	cu_test_assert(n != (size_t)-1 && n % sizeof(cu_wchar_t) == 0);
+	if (n == 0)
+	    break;
+	got += n/sizeof(cu_wchar_t);
+    }
+    cu_test_assert_size_eq(got, cnt);
+    cu_test_assert(memcmp(warr, warr2, cnt*sizeof(cu_wchar_t)) == 0);
+}
+
+int
+main()
+{
+    int i;
+    cutext_init();
+    _test_errors();
+    for (i = 0; i < 200; ++i) {
+	_test_roundtrip(lrand48() % 300 + 1);
+	_test_source(lrand48() % 300 + 1);
+    }
+    return 2*!!cu_test_bug_count();
+}
@@ -0,0 +1,375 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cutext/conv.h>
+#include <cutext/encoding.h>
+#include <cu/conf.h>
+#include <string.h>
+#include <errno.h>
+
+#if defined(__SSE2__) && CU_WCHAR_WIDTH == 32
+#  include <emmintrin.h>
+#  define USE_SSE2 1
+#endif
+
+/* The number of bytes in a UTF-8 sequence by lead byte, or 0 for bytes which
+ * can not start a sequence, including the overlong leads 0xc0 and 0xc1 and
+ * leads beyond U+10FFFF. */
+static unsigned char const _utf8_len[256] = {
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,2,2,2,2,2,2,2,2,2,2,2,2,2,2, 2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,
+    3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3, 4,4,4,4,4,0,0,0,0,0,0,0,0,0,0,0,
+};
+
+/* Decodes the multibyte sequence of length len >= 2 at src, which must be
+ * available, and returns the code point, or -1 if the sequence is invalid. */
+CU_SINLINE long
+_utf8_decode_multi(unsigned char const *src, int len)
+{
+    unsigned int c1 = src[1] ^ 0x80, c2, c3;
+    long ch;
+    if (c1 > 0x3f)
+	return -1;
+    switch (len) {
+	case 2:
+	    return ((src[0] & 0x1f) << 6) | c1;
+	case 3:
+	    c2 = src[2] ^ 0x80;
+	    if (c2 > 0x3f)
+		return -1;
+	    ch = ((src[0] & 0x0f) << 12) | (c1 << 6) | c2;
+	    if (ch < 0x800 || (ch >= 0xd800 && ch < 0xe000))
+		return -1;
+	    return ch;
+	default:
+	    c2 = src[2] ^ 0x80;
+	    c3 = src[3] ^ 0x80;
+	    if ((c2 | c3) > 0x3f)
+		return -1;
+	    ch = ((long)(src[0] & 0x07) << 18) | (c1 << 12) | (c2 << 6) | c3;
+	    if (ch < 0x10000 || ch > 0x10ffff)
+		return -1;
+	    return ch;
+    }
+}
+
+/* Checks an incomplete sequence of avail < len bytes at src, returning
+ * EILSEQ if it can already be seen to be invalid, otherwise EINVAL. */
+static int
+_utf8_check_incomplete(unsigned char const *src, size_t avail, int len)
+{
+    size_t i;
+    for (i = 1; i < avail; ++i)
+	if ((src[i] & 0xc0) != 0x80)
+	    return EILSEQ;
+    if (avail >= 2) {
+	if (src[0] == 0xe0 && src[1] < 0xa0)
+	    return EILSEQ;
+	if (src[0] == 0xed && src[1] >= 0xa0)
+	    return EILSEQ;
+	if (src[0] == 0xf0 && src[1] < 0x90)
+	    return EILSEQ;
+	if (src[0] == 0xf4 && src[1] >= 0x90)
+	    return EILSEQ;
+    }
+    return EINVAL;
+}
+
+int
+cutext_utf8_to_wchar(char const **src_arr, size_t *src_cnt,
+		     cu_wchar_t **dst_arr, size_t *dst_cnt)
+{
+    unsigned char const *src = (unsigned char const *)*src_arr;
+    unsigned char const *src_end = src + *src_cnt;
+    cu_wchar_t *dst = *dst_arr;
+    cu_wchar_t *dst_end = dst + *dst_cnt;
+    int err = 0;
+
+    while (src < src_end) {
+	int len;
+	long ch;
+#ifdef USE_SSE2
+	/* Widen ASCII 16 bytes at a time.  On hitting a non-ASCII byte, the
+	 * ASCII before it is kept and the rest of the block is overwritten
+	 * later. */
+	while (*src < 0x80 && src_end - src >= 16 && dst_end - dst >= 16) {
+	    __m128i z = _mm_setzero_si128();
+	    __m128i v = _mm_loadu_si128((__m128i const *)src);
+	    __m128i lo = _mm_unpacklo_epi8(v, z);
+	    __m128i hi = _mm_unpackhi_epi8(v, z);
+	    int mask = _mm_movemask_epi8(v);
+	    _mm_storeu_si128((__m128i *)dst + 0, _mm_unpacklo_epi16(lo, z));
+	    _mm_storeu_si128((__m128i *)dst + 1, _mm_unpackhi_epi16(lo, z));
+	    _mm_storeu_si128((__m128i *)dst + 2, _mm_unpacklo_epi16(hi, z));
+	    _mm_storeu_si128((__m128i *)dst + 3, _mm_unpackhi_epi16(hi, z));
+	    if (mask) {
+		int n = __builtin_ctz(mask);
+		src += n;
+		dst += n;
+		break;
+	    }
+	    src += 16;
+	    dst += 16;
+	}
+	if (src == src_end)
+	    break;
+#endif
+	if (dst == dst_end) {
+	    err = E2BIG;
+	    break;
+	}
+	if (*src < 0x80) {
+	    *dst++ = *src++;
+	    continue;
+	}
+	len = _utf8_len[*src];
+	if (len == 0) {
+	    err = EILSEQ;
+	    break;
+	}
+	if (src_end - src < len) {
+	    err = _utf8_check_incomplete(src, src_end - src, len);
+	    break;
+	}
+	ch = _utf8_decode_multi(src, len);
+	if (ch < 0) {
+	    err = EILSEQ;
+	    break;
+	}
+	*dst++ = ch;
+	src += len;
+    }
+    *src_cnt = src_end - src;
+    *src_arr = (char const *)src;
+    *dst_cnt = dst_end - dst;
+    *dst_arr = dst;
+    return err;
+}
+
+int
+cutext_wchar_to_utf8(cu_wchar_t const **src_arr, size_t *src_cnt,
+		     char **dst_arr, size_t *dst_cnt)
+{
+    cu_wchar_t const *src = *src_arr;
+    cu_wchar_t const *src_end = src + *src_cnt;
+    unsigned char *dst = (unsigned char *)*dst_arr;
+    unsigned char *dst_end = dst + *dst_cnt;
+    int err = 0;
+
+    while (src < src_end) {
+	unsigned long ch;
+#ifdef USE_SSE2
+	/* Narrow runs of ASCII 16 characters at a time. */
+	while (*src < 0x80 && src_end - src >= 16 && dst_end - dst >= 16) {
+	    __m128i a = _mm_loadu_si128((__m128i const *)src + 0);
+	    __m128i b = _mm_loadu_si128((__m128i const *)src + 1);
+	    __m128i c = _mm_loadu_si128((__m128i const *)src + 2);
+	    __m128i d = _mm_loadu_si128((__m128i const *)src + 3);
+	    __m128i any = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+	    any = _mm_and_si128(any, _mm_set1_epi32(~0x7f));
+	    if (_mm_movemask_epi8(_mm_cmpeq_epi32(any, _mm_setzero_si128()))
+		!= 0xffff)
+		break;
+	    _mm_storeu_si128((__m128i *)dst,
+			     _mm_packus_epi16(_mm_packs_epi32(a, b),
+					      _mm_packs_epi32(c, d)));
+	    src += 16;
+	    dst += 16;
+	}
+	if (src == src_end)
+	    break;
+#endif
+	ch = *src;
+	if (ch < 0x80) {
+	    if (dst == dst_end) {
+		err = E2BIG;
+		break;
+	    }
+	    *dst++ = ch;
+	}
+	else if (ch < 0x800) {
+	    if (dst_end - dst < 2) {
+		err = E2BIG;
+		break;
+	    }
+	    dst[0] = 0xc0 | (ch >> 6);
+	    dst[1] = 0x80 | (ch & 0x3f);
+	    dst += 2;
+	}
+	else if (ch < 0x10000) {
+	    if (ch >= 0xd800 && ch < 0xe000) {
+		err = EILSEQ;
+		break;
+	    }
+	    if (dst_end - dst < 3) {
+		err = E2BIG;
+		break;
+	    }
+	    dst[0] = 0xe0 | (ch >> 12);
+	    dst[1] = 0x80 | ((ch >> 6) & 0x3f);
+	    dst[2] = 0x80 | (ch & 0x3f);
+	    dst += 3;
+	}
+	else if (ch <= 0x10ffff) {
+	    if (dst_end - dst < 4) {
+		err = E2BIG;
+		break;
+	    }
+	    dst[0] = 0xf0 | (ch >> 18);
+	    dst[1] = 0x80 | ((ch >> 12) & 0x3f);
+	    dst[2] = 0x80 | ((ch >> 6) & 0x3f);
+	    dst[3] = 0x80 | (ch & 0x3f);
+	    dst += 4;
+	}
+	else {
+	    err = EILSEQ;
+	    break;
+	}
+	++src;
+    }
+    *src_cnt = src_end - src;
+    *src_arr = src;
+    *dst_cnt = dst_end - dst;
+    *dst_arr = (char *)dst;
+    return err;
+}
+
+size_t
+cutext_utf8_valid_prefix(char const *arr, size_t cnt)
+{
+    unsigned char const *src = (unsigned char const *)arr;
+    unsigned char const *src_end = src + cnt;
+    while (src < src_end) {
+	int len;
+#ifdef USE_SSE2
+	/* Skip runs of ASCII 64 bytes at a time, then 16. */
+	while (src_end - src >= 64) {
+	    __m128i a = _mm_loadu_si128((__m128i const *)src + 0);
+	    __m128i b = _mm_loadu_si128((__m128i const *)src + 1);
+	    __m128i c = _mm_loadu_si128((__m128i const *)src + 2);
+	    __m128i d = _mm_loadu_si128((__m128i const *)src + 3);
+	    if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(a, b),
+					       _mm_or_si128(c, d))))
+		break;
+	    src += 64;
+	}
+	while (*src < 0x80 && src_end - src >= 16) {
+	    int mask = _mm_movemask_epi8(_mm_loadu_si128((__m128i const *)src));
+	    if (mask) {
+		src += __builtin_ctz(mask);
+		break;
+	    }
+	    src += 16;
+	}
+	if (src == src_end)
+	    break;
+#endif
+	if (*src < 0x80) {
+	    ++src;
+	    continue;
+	}
+	len = _utf8_len[*src];
+	if (len == 0 || src_end - src < len || _utf8_decode_multi(src, len) < 0)
+	    break;
+	src += len;
+    }
+    return src - (unsigned char const *)arr;
+}
+
+
+/* iconv-compatible wrappers
+ * ------------------------- */
+
+static size_t
+_iconv_return(int err)
+{
+    if (err == 0)
+	return 0;
+    errno = err;
+    return (size_t)-1;
+}
+
+static size_t
+_conv_utf8_to_wchar(char **src_arr, size_t *src_size,
+		    char **dst_arr, size_t *dst_size)
+{
+    size_t dst_cnt, dst_rem;
+    int err;
+    if (src_arr == NULL || *src_arr == NULL)
+	return 0;
+    dst_cnt = *dst_size/sizeof(cu_wchar_t);
+    dst_rem = *dst_size % sizeof(cu_wchar_t);
+    err = cutext_utf8_to_wchar((char const **)src_arr, src_size,
+			       (cu_wchar_t **)dst_arr, &dst_cnt);
+    *dst_size = dst_cnt*sizeof(cu_wchar_t) + dst_rem;
+    return _iconv_return(err);
+}
+
+static size_t
+_conv_wchar_to_utf8(char **src_arr, size_t *src_size,
+		    char **dst_arr, size_t *dst_size)
+{
+    size_t src_cnt, src_rem;
+    int err;
+    if (src_arr == NULL || *src_arr == NULL)
+	return 0;
+    src_cnt = *src_size/sizeof(cu_wchar_t);
+    src_rem = *src_size % sizeof(cu_wchar_t);
+    err = cutext_wchar_to_utf8((cu_wchar_t const **)src_arr, &src_cnt,
+			       dst_arr, dst_size);
+    *src_size = src_cnt*sizeof(cu_wchar_t) + src_rem;
+    if (err == 0 && src_rem)
+	err = EINVAL;
+    return _iconv_return(err);
+}
+
+static cu_bool_t
+_is_wchar_encoding(char const *enc)
+{
+    if (strcmp(enc, cu_wchar_encoding) == 0)
+	return cu_true;
+#if CU_WCHAR_WIDTH == 32
+    if (cutext_encoding_by_name(enc) == CUTEXT_ENCODING_UCS4HOST)
+	return cu_true;
+#  ifdef CUCONF_WORDS_BIGENDIAN
+    return strcmp(enc, "UTF-32BE") == 0;
+#  else
+    return strcmp(enc, "UTF-32LE") == 0;
+#  endif
+#else
+    return cu_false;
+#endif
+}
+
+cutextP_conv_t
+cutextP_builtin_conv(char const *to_encoding, char const *from_encoding)
+{
+    if (cutext_encoding_by_name(from_encoding) == CUTEXT_ENCODING_UTF8) {
+	if (_is_wchar_encoding(to_encoding))
+	    return _conv_utf8_to_wchar;
+    }
+    else if (cutext_encoding_by_name(to_encoding) == CUTEXT_ENCODING_UTF8) {
+	if (_is_wchar_encoding(from_encoding))
+	    return _conv_wchar_to_utf8;
+    }
+    return NULL;
+}
@@ -39,7 +39,7 @@ cu_bool_t
 cutext_lsource_init_fopen(cutext_lsource_t lsrc,
 			  char const *enc, cu_str_t path)
 {
-    cutext_source_t src = cutext_source_fopen(enc, cu_str_to_cstr(path));
+    cutext_source_t src = cutext_source_mmap_fopen(enc, cu_str_to_cstr(path));
     struct cu_locbound locb;
     if (!src)
 	return cu_false;
@@ -2,109 +2,85 @@
 use strict;
 use POSIX;
 
-# IMPORTANT. If $unicode_max or $blk_size is changed, wccat.c must be updated!
-my $unicode_max = 0x1fffff;
-my $blk_size = 512;
-my $blk_cnt = ($unicode_max + 1)/$blk_size;
+# Emits a two-stage table of general categories.  The code space is split
+# into blocks of $blk_size codepoints.  The first stage maps each block
+# number to the offset of a block in the second stage, where identical blocks
+# are shared.  For the current data, the BMP part of the index and the blocks
+# it refers to stays well within a typical L1 or L2 cache.
+#
+# IMPORTANT. If $codespace or $blk_shift is changed, wccat.c must be updated!
+my $codespace = 0x110000;
+my $blk_shift = 7;
+my $blk_size = 1 << $blk_shift;
+my $blk_cnt = $codespace/$blk_size;
 
-my $unicode_data = "UnicodeData.txt";
 my @general_category_arr;
+my $range_first;
 
 while (<STDIN>) {
     my ( $codepoint,
 	 $name,
 	 $general_category,
-	 $canonical_combinding_class,
-	 $bidi_class,
-	 $decomposition,
-	 $numeric,
-	 $bidi_mirrored,
-	 $unicode_1_name,
-	 $iso_comment,
-	 $simple_uppercase_mapping,
-	 $simple_lowercase_mapping,
-	 $simple_titlecase_mapping
 	 ) = split ";";
     my $i = hex $codepoint;
-    if ($general_category) {
-	$general_category_arr[$i] = $general_category;
+    $general_category = "None" unless $general_category;
+    if ($name =~ /, First>$/) {
+	$range_first = $i;
     }
-    else {
-	$general_category_arr[$i] = "None";
+    elsif ($name =~ /, Last>$/) {
+	die "Range last line without preceding first.\n"
+	    unless defined $range_first;
+	for (my $j = $range_first; $j < $i; ++$j) {
+	    $general_category_arr[$j] = $general_category;
+	}
+	undef $range_first;
     }
+    $general_category_arr[$i] = $general_category;
 }
 
-print "#include <stdlib.h>\n";
-print "#include <cutext/wccat.h>\n";
-print "#define C(x) CUTEXT_WCCAT_##x\n";
-if (0) {
-    print "char cupriv_ucs_general_category[] = {";
-    my $i = 7;
-    foreach (@general_category_arr) {
-	if (++$i == 8) {
-	    print "\n";
-	    $i = 0;
-	}
-	if ($_) {
-	    uc;
-	    print "C($_),";
-	}
-	else {
-	    print "0,";
-	}
+my @blk_arr;		# distinct blocks, as strings of category names
+my %blk_index;		# block string => index into @blk_arr
+my @index_arr;		# block number => index into @blk_arr
+my $bmp_blk_cnt = 0;
+for (my $i_blk = 0; $i_blk < $blk_cnt; ++$i_blk) {
+    my @cats;
+    for (my $i = 0; $i < $blk_size; ++$i) {
+	my $gcat = $general_category_arr[$i_blk*$blk_size + $i];
+	push @cats, ($gcat? uc($gcat) : "NONE");
     }
-    print "\n};\n";
-}
-else {
-    my $char_cnt = $#general_category_arr + 1;
-    my $nonuniform_cnt = 0;
-    my @is_nonuniform_arr;
-    for (my $i_blk = 0; $i_blk < $blk_cnt; ++$i_blk) {
-	my $blk_cat = $general_category_arr[$i_blk*$blk_size];
-	my $i;
-	for ($i = 0; $i < $blk_size; ++$i) {
-	    my $n = $i_blk*$blk_size + $i;
-	    last unless $general_category_arr[$n] eq $blk_cat;
-	}
-	if ($i < $blk_size) {
-	    ++$nonuniform_cnt;
-	    $is_nonuniform_arr[$i_blk] = 1;
-	    print "static char b_", $i_blk, "[] = {";
-	    for ($i = 0; $i < $blk_size; ++$i) {
-		my $n = $i_blk*$blk_size + $i;
-		print "\n" if ($i % 8 == 0);
-		my $gcat = $general_category_arr[$n];
-		if ($gcat) {
-		    print "C(", uc($gcat), "),";
-		}
-		else {
-		    print "0,";
-		}
-	    }
-	    print "};\n";
-	}
+    my $key = join ",", @cats;
+    unless (exists $blk_index{$key}) {
+	$blk_index{$key} = scalar @blk_arr;
+	push @blk_arr, $key;
+	$bmp_blk_cnt = scalar @blk_arr if $i_blk*$blk_size < 0x10000;
     }
-    my $nonunif_frac = $nonuniform_cnt/$blk_cnt;
-    my $est = $blk_cnt*8 + $nonuniform_cnt*$blk_size;
-    print STDERR "Non-uniform blocks: $nonuniform_cnt/$blk_cnt = $nonunif_frac\n";
-    print STDERR "Table size est.: $est\n";
-    print STDERR "Table size unblocked: $char_cnt\n";
+    push @index_arr, $blk_index{$key};
+}
+die "Too many distinct blocks for a 16 bit index.\n"
+    if (scalar @blk_arr) << $blk_shift > 0x10000;
 
-    print "struct cutextP_wctype_table_entry_s { char cat; char *sub; };\n";
-    print "struct cutextP_wctype_table_entry_s cutextP_wctype_table[] = {\n";
-    for (my $i_blk = 0; $i_blk < $blk_cnt; ++$i_blk) {
-	if ($is_nonuniform_arr[$i_blk]) {
-	    print "{0,b_$i_blk},\n";
-	}
-	else {
-	    my $gcat = $general_category_arr[$i_blk*$blk_size];
-	    if ($gcat) {
-		print "{C(", uc($gcat), "),NULL},\n";
-	    }
-	    else {
-		print "{0,NULL},\n";
-	    }
-	}
+my $index_size = $blk_cnt*2;
+my $data_size = (scalar @blk_arr)*$blk_size;
+my $bmp_size = (0x10000 >> $blk_shift)*2 + $bmp_blk_cnt*$blk_size;
+print STDERR "Distinct blocks: ", scalar @blk_arr, "/$blk_cnt\n";
+print STDERR "Table size: $index_size + $data_size bytes\n";
+print STDERR "Table size for BMP: $bmp_size bytes\n";
+
+print "#include <cutext/wccat.h>\n";
+print "#include <stdint.h>\n";
+print "#define C(x) CUTEXT_WCCAT_##x\n";
+print "uint_least16_t const cutextP_wccat_index[] = {";
+for (my $i_blk = 0; $i_blk < $blk_cnt; ++$i_blk) {
+    print "\n" if ($i_blk % 8 == 0);
+    print $index_arr[$i_blk] << $blk_shift, ",";
+}
+print "\n};\n";
+print "unsigned char const cutextP_wccat_data[] = {";
+foreach my $key (@blk_arr) {
+    my $i = 0;
+    foreach my $gcat (split ",", $key) {
+	print "\n" if ($i++ % 8 == 0);
+	print "C($gcat),";
     }
-    print "};\n";
 }
+print "\n};\n";
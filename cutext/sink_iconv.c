@@ -16,6 +16,7 @@
  */
 
 #include <cutext/sink.h>
+#include <cutext/conv.h>
 #include <cu/diag.h>
 #include <cu/debug.h>
 #include <cu/memory.h>
@@ -30,6 +31,7 @@ struct _iconvsink
 {
     cu_inherit (cutext_sink);
     cutext_sink_t subsink;
+    cutextP_conv_t builtin;
     iconv_t cd;
     char const *encoding;
 };
@@ -51,7 +53,12 @@ _iconv_write(cutext_sink_t sink, void const *data_start, size_t data_size)
 	size_t dst_cap = IC_WRITE_BUFSIZE;
 	size_t st;
 
-	st = iconv(ICSINK(sink)->cd, &src_ptr, &src_size, &dst_ptr, &dst_cap);
+	if (ICSINK(sink)->builtin)
+	    st = (*ICSINK(sink)->builtin)(&src_ptr, &src_size,
+					  &dst_ptr, &dst_cap);
+	else
+	    st = iconv(ICSINK(sink)->cd,
+		       &src_ptr, &src_size, &dst_ptr, &dst_cap);
 	if (dst_cap < IC_WRITE_BUFSIZE) {
 	    size_t sub_st;
 	    sub_st = cutext_sink_write(ICSINK(sink)->subsink,
@@ -161,8 +168,11 @@ cutext_sink_stack_iconv(char const *new_encoding, cutext_sink_t subsink)
 		"its encoding.");
     cutext_sink_init(cu_to(cutext_sink, sink), &_iconv_descriptor);
     sink->subsink = subsink;
-    sink->cd = iconv_open(sub_encoding, new_encoding);
     sink->encoding = new_encoding;
+    sink->builtin = cutextP_builtin_conv(sub_encoding, new_encoding);
+    if (sink->builtin)
+	return cu_to(cutext_sink, sink);
+    sink->cd = iconv_open(sub_encoding, new_encoding);
     if (sink->cd == (iconv_t)-1)
 	return NULL;
     else
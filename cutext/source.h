@@ -198,6 +198,21 @@ cutext_source_t cutext_source_fdopen(char const *enc,
  ** encoding. */
 cutext_source_t cutext_source_fopen(char const *encoding, char const *path);
 
+/** Return a source over the contents of \a fd encoded as \a enc, reading
+ ** from the current file offset.  If \a fd refers to a regular file, it is
+ ** memory mapped, so that \ref cutext_source_look is available and returns
+ ** the remaining file contents without copying.  Otherwise, such as for
+ ** pipes and terminals, this falls back to \ref cutext_source_fdopen.  If \a
+ ** close_fd is true, then close \a fd when \ref cutext_source_close is
+ ** called on the returned source, which also unmaps the file. */
+cutext_source_t cutext_source_mmap_fdopen(char const *enc,
+					  int fd, cu_bool_t close_fd);
+
+/** As \ref cutext_source_fopen, but uses \ref cutext_source_mmap_fdopen
+ ** on the opened file. */
+cutext_source_t cutext_source_mmap_fopen(char const *encoding,
+					 char const *path);
+
 /** Stack a buffer on top of \a subsrc to provide lookahead.  The \ref
  ** cutext_source_look method is guaranteed to be available on the returned
  ** source. */
@@ -0,0 +1,130 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2010  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Compares the throughput of the memory mapped source with the read-based
+ * file source under a stacked buffer, scanning a file given as the first
+ * argument or a generated temporary file. */
+
+#include <cutext/source.h>
+#include <cu/test.h>
+#include <cu/memory.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TMP_SIZE ((size_t)1 << 28)
+#define LOOK_SIZE 4096
+#define READ_SIZE 65536
+
+static unsigned int _sink;
+
+/* Scans src with look and skip, as done by lexical sources. */
+static size_t
+_scan_look(cutext_source_t src)
+{
+    size_t total = 0;
+    for (;;) {
+	size_t i, size;
+	unsigned char const *data = cutext_source_look(src, LOOK_SIZE, &size);
+	if (size == 0)
+	    break;
+	if (size > LOOK_SIZE)
+	    size = LOOK_SIZE;
+	for (i = 0; i < size; ++i)
+	    _sink += data[i];
+	cu_test_assert(cutext_source_skip(src, size) == size);
+	total += size;
+    }
+    return total;
+}
+
+/* Scans src with reads into a private buffer. */
+static size_t
+_scan_read(cutext_source_t src)
+{
+    unsigned char *buf = cu_galloc_atomic(READ_SIZE);
+    size_t total = 0;
+    for (;;) {
+	size_t i, size = cutext_source_read(src, buf, READ_SIZE);
+	if (size == 0 || size == (size_t)-1)
+	    break;
+	for (i = 0; i < size; ++i)
+	    _sink += buf[i];
+	total += size;
+    }
+    return total;
+}
+
+static void
+_bench(char const *name, char const *path, cu_bool_t use_mmap,
+       cu_bool_t use_look)
+{
+    cutext_source_t src;
+    clock_t t;
+    size_t size;
+
+    t = -clock();
+    src = use_mmap? cutext_source_mmap_fopen("utf-8", path)
+		  : cutext_source_fopen("utf-8", path);
+    cu_test_assert(src);
+    if (use_look && !cutext_source_can_look(src))
+	src = cutext_source_stack_buffer(src);
+    size = use_look? _scan_look(src) : _scan_read(src);
+    cutext_source_close(src);
+    t += clock();
+    printf("%-32s %10.3lf s %10.1lf MiB/s\n", name,
+	   t/(double)CLOCKS_PER_SEC,
+	   size/(1048576.0*t/CLOCKS_PER_SEC));
+}
+
+static char const *
+_make_tmp_file(void)
+{
+    static char path[] = "/tmp/cutext_source_b0.XXXXXX";
+    size_t i, chunk_size = (size_t)1 << 20;
+    char *chunk = cu_galloc_atomic(chunk_size);
+    int fd = mkstemp(path);
+    cu_test_assert(fd != -1);
+    for (i = 0; i < chunk_size; ++i)
+	chunk[i] = (lrand48() % 8 == 0)? '\n' : 'a' + lrand48() % 26;
+    for (i = 0; i < TMP_SIZE; i += chunk_size)
+	cu_test_assert(write(fd, chunk, chunk_size) == chunk_size);
+    close(fd);
+    return path;
+}
+
+int
+main(int argc, char **argv)
+{
+    char const *path;
+    int round;
+
+    cutext_init();
+    path = argc > 1? argv[1] : _make_tmp_file();
+    for (round = 0; round < 2; ++round) {
+	_bench("fd source, buffer, look/skip", path, cu_false, cu_true);
+	_bench("mmap source, look/skip", path, cu_true, cu_true);
+	_bench("fd source, read", path, cu_false, cu_false);
+	_bench("mmap source, read", path, cu_true, cu_false);
+    }
+    if (argc <= 1)
+	unlink(path);
+    return 2*!!cu_test_bug_count();
+}
@@ -16,9 +16,12 @@
  */
 
 #include <cutext/source.h>
+#include <cutext/conv.h>
 #include <cu/inherit.h>
 #include <cu/debug.h>
 #include <cu/memory.h>
+#include <cu/size.h>
+#include <cu/wchar.h>
 #include <iconv.h>
 #include <errno.h>
 #include <string.h>
@@ -33,6 +36,7 @@ struct _iconvsource
     cu_inherit (cutext_source);
     cutext_source_t subsrc;
     char const *encoding;
+    cutextP_conv_t builtin;
     iconv_t cd;
 };
 
@@ -45,26 +49,48 @@ _iconvsource_read(cutext_source_t src, void *dst_data, size_t dst_size)
     if (dst_data == NULL)
 	dst_data = cu_salloc(dst_size);
     while (dst_size_left > 0) {
-	size_t sub_size, sub_size_left;
+	size_t st, sub_size, sub_size_left;
 	void const *sub_data;
-	sub_data = cutext_source_look(isrc->subsrc, dst_size_left, &sub_size);
+	sub_data = cutext_source_look(isrc->subsrc,
+				      cu_size_max(dst_size_left, CU_MAX_MBLEN),
+				      &sub_size);
 	if (sub_size == 0) {
 	    cu_dlogf(_file, "Source is empty, returning %zd.",
 		     dst_size - dst_size_left);
 	    return dst_size - dst_size_left;
 	}
 	sub_size_left = sub_size;
-	if (iconv(isrc->cd,
-		  (char **)&sub_data, &sub_size_left,
-		  (char **)&dst_data, &dst_size_left) == (size_t)-1)
+	if (isrc->builtin)
+	    st = (*isrc->builtin)((char **)&sub_data, &sub_size_left,
+				  (char **)&dst_data, &dst_size_left);
+	else
+	    st = iconv(isrc->cd, (char **)&sub_data, &sub_size_left,
+		       (char **)&dst_data, &dst_size_left);
+	if (st == (size_t)-1)
 	    switch (errno) {
 		case EILSEQ:
 		    cu_errf("Invalid multibyte sequence.");
 		    return (size_t)-1;
 		case EINVAL:
+		    /* Since we look ahead at least CU_MAX_MBLEN bytes, a
+		     * sequence we can't complete is cut by the end of
+		     * input. */
+		    if (sub_size_left == sub_size) {
+			cu_errf("Incomplete multibyte sequence at end of "
+				"input.");
+			return (size_t)-1;
+		    }
 		    break;
 		case E2BIG:
-		    cu_debug_assert(dst_size_left == 0);
+		    /* The next character may not fit in what's left, but
+		     * returning 0 would signal the end of input. */
+		    if (sub_size_left == sub_size) {
+			if (dst_size_left < dst_size)
+			    return dst_size - dst_size_left;
+			cu_errf("Read request of %zd bytes is too small for "
+				"the next character.", dst_size);
+			return (size_t)-1;
+		    }
 		    break;
 		default:
 		    cu_debug_unreachable();
@@ -82,7 +108,8 @@ static void
 _iconvsource_close(cutext_source_t src)
 {
     struct _iconvsource *isrc = ICONVSOURCE(src);
-    iconv_close(isrc->cd);
+    if (!isrc->builtin)
+	iconv_close(isrc->cd);
     cutext_source_close(isrc->subsrc);
 }
 
@@ -134,9 +161,12 @@ cutext_source_stack_iconv(char const *encoding, cutext_source_t subsrc)
     isrc = cu_gnew(struct _iconvsource);
     isrc->subsrc = subsrc;
     isrc->encoding = encoding;
-    isrc->cd = iconv_open(encoding, sub_encoding);
-    if (isrc->cd == NULL)
-	return NULL;
+    isrc->builtin = cutextP_builtin_conv(encoding, sub_encoding);
+    if (!isrc->builtin) {
+	isrc->cd = iconv_open(encoding, sub_encoding);
+	if (isrc->cd == (iconv_t)-1)
+	    return NULL;
+    }
     cutext_source_init(cu_to(cutext_source, isrc), &_iconvsource_descr);
     return cu_to(cutext_source, isrc);
 }
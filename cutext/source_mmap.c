@@ -0,0 +1,166 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2010  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cutext/source.h>
+#include <cu/inherit.h>
+#include <cu/memory.h>
+#include <cu/size.h>
+#include <cu/conf.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(CUCONF_HAVE_SYS_MMAN_H) && defined(CUCONF_HAVE_MMAP)
+#  include <sys/mman.h>
+#  define USE_MMAP 1
+#endif
+
+#ifdef USE_MMAP
+
+/* Consumed pages are released in chunks of this size, to keep the resident
+ * set bounded when scanning large files.  Must be a multiple of the page
+ * size. */
+#define DISCARD_SIZE ((size_t)1 << 24)
+
+#define MMAPSOURCE(src) cu_from(_mmapsource, cutext_source, src)
+
+struct _mmapsource
+{
+    cu_inherit (cutext_source);
+    char const *encoding;
+    int fd;
+    cu_bool_t close_fd;
+    char *map_start;
+    size_t map_size;
+    char const *cur;
+    char const *end;
+    char *discarded;
+};
+
+static size_t
+_mmapsource_read(cutext_source_t src, void *dst_data, size_t dst_size)
+{
+    struct _mmapsource *msrc = MMAPSOURCE(src);
+    size_t size = cu_size_min(dst_size, msrc->end - msrc->cur);
+    if (dst_data)
+	memcpy(dst_data, msrc->cur, size);
+    msrc->cur += size;
+#ifdef CUCONF_HAVE_MADVISE
+    if (msrc->cur - msrc->discarded >= DISCARD_SIZE) {
+	size_t discard_size = msrc->cur - msrc->discarded;
+	discard_size -= discard_size % DISCARD_SIZE;
+	madvise(msrc->discarded, discard_size, MADV_DONTNEED);
+	msrc->discarded += discard_size;
+    }
+#endif
+    return size;
+}
+
+static void const *
+_mmapsource_look(cutext_source_t src, size_t size, size_t *size_out)
+{
+    struct _mmapsource *msrc = MMAPSOURCE(src);
+    *size_out = msrc->end - msrc->cur;
+    return msrc->cur;
+}
+
+static void
+_mmapsource_close(cutext_source_t src)
+{
+    struct _mmapsource *msrc = MMAPSOURCE(src);
+    munmap(msrc->map_start, msrc->map_size);
+    if (msrc->close_fd)
+	close(msrc->fd);
+}
+
+static cu_box_t
+_mmapsource_info(cutext_source_t src, cutext_source_info_key_t key)
+{
+    switch (key) {
+	case CUTEXT_SOURCE_INFO_ENCODING:
+	    return cu_box_ptr(cutext_source_info_encoding_t,
+			      MMAPSOURCE(src)->encoding);
+	default:
+	    return cutext_source_default_info(src, key);
+    }
+}
+
+static struct cutext_source_descriptor _mmapsource_descr = {
+    .read = _mmapsource_read,
+    .look = _mmapsource_look,
+    .close = _mmapsource_close,
+    .subsource = cutext_source_no_subsource,
+    .info = _mmapsource_info,
+};
+
+cutext_source_t
+cutext_source_mmap_fdopen(char const *encoding, int fd, cu_bool_t close_fd)
+{
+    struct _mmapsource *msrc;
+    struct stat st;
+    off_t offset;
+    void *map;
+
+    /* Pipes, terminals, empty files (which includes many special files), and
+     * files which don't fit in the address space are read conventionally. */
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0 ||
+	(uintmax_t)st.st_size > SIZE_MAX)
+	return cutext_source_fdopen(encoding, fd, close_fd);
+    offset = lseek(fd, 0, SEEK_CUR);
+    if (offset == (off_t)-1 || offset > st.st_size)
+	return cutext_source_fdopen(encoding, fd, close_fd);
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED)
+	return cutext_source_fdopen(encoding, fd, close_fd);
+#ifdef CUCONF_HAVE_MADVISE
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+#endif
+
+    msrc = cu_gnew(struct _mmapsource);
+    msrc->encoding = encoding;
+    msrc->fd = fd;
+    msrc->close_fd = close_fd;
+    msrc->map_start = map;
+    msrc->map_size = st.st_size;
+    msrc->cur = msrc->map_start + offset;
+    msrc->end = msrc->map_start + msrc->map_size;
+    msrc->discarded = msrc->map_start;
+    cutext_source_init(cu_to(cutext_source, msrc), &_mmapsource_descr);
+    return cu_to(cutext_source, msrc);
+}
+
+#else /* !USE_MMAP */
+
+cutext_source_t
+cutext_source_mmap_fdopen(char const *encoding, int fd, cu_bool_t close_fd)
+{
+    return cutext_source_fdopen(encoding, fd, close_fd);
+}
+
+#endif /* !USE_MMAP */
+
+cutext_source_t
+cutext_source_mmap_fopen(char const *encoding, char const *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+	return NULL;
+    return cutext_source_mmap_fdopen(encoding, fd, cu_true);
+}
@@ -20,6 +20,8 @@
 #include <cu/memory.h>
 #include <cu/size.h>
 #include <cu/wstring.h>
+#include <stdlib.h>
+#include <unistd.h>
 
 static cutext_source_t
 _make_cstr_source(size_t n)
@@ -56,6 +58,38 @@ _make_wraw_source(size_t n)
     return cutext_source_new_mem(NULL, buf, n*sizeof(cu_wchar_t));
 }
 
+/* Writes n bytes to a temporary file and returns its descriptor, positioned
+ * at offset. */
+static int
+_make_tmp_file(size_t n, size_t offset)
+{
+    char path[] = "/tmp/cutext_source_t0.XXXXXX";
+    char *buf = cu_galloc(n);
+    int i, fd = mkstemp(path);
+    cu_test_assert(fd != -1);
+    unlink(path);
+    for (i = 0; i < n; ++i)
+	buf[i] = 'a' + (i + 26 - offset % 26) % 26;
+    cu_test_assert(write(fd, buf, n) == n);
+    cu_test_assert(lseek(fd, offset, SEEK_SET) == offset);
+    return fd;
+}
+
+/* Returns the read end of a pipe which delivers n bytes.  Keep n below the
+ * pipe capacity. */
+static int
+_make_pipe(size_t n)
+{
+    int i, fds[2];
+    char *buf = cu_galloc(n);
+    cu_test_assert(pipe(fds) == 0);
+    for (i = 0; i < n; ++i)
+	buf[i] = 'a' + i % 26;
+    cu_test_assert(write(fds[1], buf, n) == n);
+    close(fds[1]);
+    return fds[0];
+}
+
 static void
 _verify_read(cutext_source_t src, size_t n)
 {
@@ -87,6 +121,52 @@ _verify_look(cutext_source_t src, size_t n)
     cu_test_assert(cutext_source_read(src, NULL, 1) == 0);
 }
 
+/* As _verify_look, but for sources where the lookahead extends to the end of
+ * the data. */
+static void
+_verify_look_all(cutext_source_t src, size_t n)
+{
+    int i = 0;
+    while (i < n) {
+	size_t j, m = lrand48() % n + 1;
+	size_t k;
+	char const *buf = cutext_source_look(src, m, &k);
+	cu_test_assert_size_eq(k, n - i);
+	for (j = 0; j < k; ++j)
+	    cu_test_assert(buf[j] == 'a' + (i + j) % 26);
+	k = cu_size_min(n - i, m);
+	cu_test_assert(cutext_source_read(src, NULL, m) == k);
+	i += k;
+    }
+    cu_test_assert(cutext_source_read(src, NULL, 1) == 0);
+}
+
+static void
+_test_fd_source(size_t n)
+{
+    cutext_source_t src;
+    size_t offset = lrand48() % (n + 1);
+    int fd;
+
+    src = cutext_source_mmap_fdopen("utf-8", _make_tmp_file(n, 0), cu_true);
+    cu_test_assert(cutext_source_can_look(src));
+    _verify_read(src, n);
+    cutext_source_close(src);
+
+    fd = _make_tmp_file(n + offset, offset);
+    src = cutext_source_mmap_fdopen("utf-8", fd, cu_true);
+    _verify_look_all(src, n);
+    cutext_source_close(src);
+
+    src = cutext_source_mmap_fdopen("utf-8", _make_pipe(n), cu_true);
+    _verify_read(src, n);
+    cutext_source_close(src);
+
+    src = cutext_source_mmap_fdopen("utf-8", _make_pipe(n), cu_true);
+    _verify_look(cutext_source_stack_buffer(src), n);
+    cutext_source_close(src);
+}
+
 static void
 _test_cstr_source(size_t n)
 {
@@ -102,6 +182,15 @@ _test_cstr_source(size_t n)
     _verify_look(cutext_source_stack_buffer(_make_cstr_source(n)), n);
     _verify_read(cutext_source_stack_iconv("utf-8", _make_wstr_source(n)), n);
     _verify_read(cutext_source_stack_iconv("utf-8", _make_wraw_source(n)), n);
+
+    /* A read which can not hold a single character is an error, not the
+     * end of input. */
+    src = cutext_source_stack_iconv(cu_wchar_encoding,
+				    cutext_source_stack_iconv("utf-8",
+						_make_wstr_source(n)));
+    cu_test_assert(cutext_source_read(src, NULL, 1) == (size_t)-1);
+    cu_test_assert(cutext_source_read(src, NULL, sizeof(cu_wchar_t))
+		   == sizeof(cu_wchar_t));
 }
 
 int
@@ -111,5 +200,7 @@ main()
     cutext_init();
     for (n = 1; n < 7000; n = n*3/2 + 1)
 	_test_cstr_source(n);
+    for (n = 1; n < 7000; n = n*3/2 + 1)
+	_test_fd_source(n);
     return 2*!!cu_test_bug_count();
 }
@@ -20,34 +20,82 @@
 #include <cu/conf.h>
 #include <string.h>
 
+#if defined(__SSE2__) && CU_WCHAR_WIDTH == 32
+#  include <emmintrin.h>
+#  define USE_SSE2 1
+#endif
+
 #define UNICODE_MAX 0x1fffff
-#define BLOCK_SIZE 512
-#define BLOCK_COUNT ((UNICODE_MAX + 1)/BLOCK_SIZE)
 
 #if !defined(CUTEXT_UNIPREP_C) && !defined(CUCONF_ENABLE_WCCAT_SWITCH)
 
-struct cutextP_wctype_table_entry_s
+/* The two-stage table generated by mk_wccat_table.pl.  The index maps the
+ * block number of a codepoint below CODESPACE to the offset of its block in
+ * the data array, where identical blocks are shared.  The first block is
+ * stored first, so ASCII categories can be read directly from the data. */
+#define CODESPACE 0x110000
+#define BLOCK_SHIFT 7
+#define BLOCK_SIZE (1 << BLOCK_SHIFT)
+
+extern uint_least16_t const cutextP_wccat_index[];
+extern unsigned char const cutextP_wccat_data[];
+
+CU_SINLINE cutext_wccat_t
+_wccat_lookup(cu_wint_t ch)
 {
-    char cat;
-    char *sub;
-};
-extern struct cutextP_wctype_table_entry_s cutextP_wctype_table[];
+    if (ch >= CODESPACE)
+	return CUTEXT_WCCAT_NONE;
+    return cutextP_wccat_data[cutextP_wccat_index[ch >> BLOCK_SHIFT]
+			      + (ch & (BLOCK_SIZE - 1))];
+}
 
 cutext_wccat_t
 cutext_wchar_wccat(cu_wint_t ch)
 {
-    int block = ch / BLOCK_SIZE;
-    struct cutextP_wctype_table_entry_s *ent;
     if (ch > UNICODE_MAX)
 	cu_bugf("Unicode character number %d is out of range.", (int)ch);
-    ent = &cutextP_wctype_table[block];
-    if (ent->sub)
-	return ent->sub[ch % BLOCK_SIZE];
-    else
-	return ent->cat;
+    return _wccat_lookup(ch);
+}
+
+void
+cutext_wcs_wccat(cu_wchar_t const *arr, size_t len, unsigned char *cat_arr)
+{
+    size_t i = 0;
+#ifdef USE_SSE2
+    while (i + 4 <= len) {
+	__m128i v = _mm_loadu_si128((__m128i const *)(arr + i));
+	v = _mm_and_si128(v, _mm_set1_epi32(~0x7f));
+	if (_mm_movemask_epi8(_mm_cmpeq_epi32(v, _mm_setzero_si128()))
+		== 0xffff) {
+	    cat_arr[i + 0] = cutextP_wccat_data[arr[i + 0]];
+	    cat_arr[i + 1] = cutextP_wccat_data[arr[i + 1]];
+	    cat_arr[i + 2] = cutextP_wccat_data[arr[i + 2]];
+	    cat_arr[i + 3] = cutextP_wccat_data[arr[i + 3]];
+	}
+	else {
+	    cat_arr[i + 0] = _wccat_lookup(arr[i + 0]);
+	    cat_arr[i + 1] = _wccat_lookup(arr[i + 1]);
+	    cat_arr[i + 2] = _wccat_lookup(arr[i + 2]);
+	    cat_arr[i + 3] = _wccat_lookup(arr[i + 3]);
+	}
+	i += 4;
+    }
+#endif
+    for (; i < len; ++i)
+	cat_arr[i] = _wccat_lookup(arr[i]);
+}
+
+#elif !defined(CUTEXT_UNIPREP_C)
+
+void
+cutext_wcs_wccat(cu_wchar_t const *arr, size_t len, unsigned char *cat_arr)
+{
+    size_t i;
+    for (i = 0; i < len; ++i)
+	cat_arr[i] = cutext_wchar_wccat(arr[i]);
 }
 
-#endif /* !CUTEXT_UNIPREP_C && !CUCONF_ENABLE_WCCAT_SWITCH */
+#endif /* !CUTEXT_UNIPREP_C */
 
 cutext_wccat_t
 cutext_wccat_by_name(char *s)
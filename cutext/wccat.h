@@ -67,6 +67,12 @@ cutext_wccat_t cutext_wccat_by_name(char *name);
 /** Returns the general category of \a ch. */
 cutext_wccat_t cutext_wchar_wccat(cu_wint_t ch);
 
+/** Stores the general categories of the \a len characters at \a arr into
+ ** the corresponding elements of \a cat_arr.  This is faster than calling
+ ** \ref cutext_wchar_wccat for each character, esp. for ASCII text. */
+void cutext_wcs_wccat(cu_wchar_t const *arr, size_t len,
+		      unsigned char *cat_arr);
+
 /** True iff \a ct is in the "letter" ("L*") main category. */
 CU_SINLINE cu_bool_t
 cutext_wccat_is_letter(cutext_wccat_t ct) { return (ct >> 3) == 1; }
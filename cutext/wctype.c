@@ -18,83 +18,112 @@
 #include <cutext/wctype.h>
 #include <cutext/wccat.h>
 
-typedef uint_least64_t cutext_wctype_t;
+/* The types of the ASCII characters, including the ASCII-specific bits.
+ * Non-ASCII characters only have the bit of their general category. */
+#define S(cat) cutext_wctype_singleton(CUTEXT_WCCAT_##cat)
+#define HT CUTEXTP_WCTYPE_HT
+#define VS CUTEXTP_WCTYPE_VSPACE
+#define DI CUTEXTP_WCTYPE_DIGIT
+#define XA CUTEXTP_WCTYPE_XALPHA
+static cutext_wctype_t const _ascii_wctype[128] = {
+    /* 00 */ S(CC), S(CC), S(CC), S(CC),
+    /* 04 */ S(CC), S(CC), S(CC), S(CC),
+    /* 08 */ S(CC), S(CC)|HT, S(CC)|VS, S(CC)|VS,
+    /* 0c */ S(CC)|VS, S(CC)|VS, S(CC), S(CC),
+    /* 10 */ S(CC), S(CC), S(CC), S(CC),
+    /* 14 */ S(CC), S(CC), S(CC), S(CC),
+    /* 18 */ S(CC), S(CC), S(CC), S(CC),
+    /* 1c */ S(CC), S(CC), S(CC), S(CC),
+    /* 20 */ S(ZS), S(PO), S(PO), S(PO),
+    /* 24 */ S(SC), S(PO), S(PO), S(PO),
+    /* 28 */ S(PS), S(PE), S(PO), S(SM),
+    /* 2c */ S(PO), S(PD), S(PO), S(PO),
+    /* 30 */ S(ND)|DI, S(ND)|DI, S(ND)|DI, S(ND)|DI,
+    /* 34 */ S(ND)|DI, S(ND)|DI, S(ND)|DI, S(ND)|DI,
+    /* 38 */ S(ND)|DI, S(ND)|DI, S(PO), S(PO),
+    /* 3c */ S(SM), S(SM), S(SM), S(PO),
+    /* 40 */ S(PO), S(LU)|XA, S(LU)|XA, S(LU)|XA,
+    /* 44 */ S(LU)|XA, S(LU)|XA, S(LU)|XA, S(LU),
+    /* 48 */ S(LU), S(LU), S(LU), S(LU),
+    /* 4c */ S(LU), S(LU), S(LU), S(LU),
+    /* 50 */ S(LU), S(LU), S(LU), S(LU),
+    /* 54 */ S(LU), S(LU), S(LU), S(LU),
+    /* 58 */ S(LU), S(LU), S(LU), S(PS),
+    /* 5c */ S(PO), S(PE), S(SK), S(PC),
+    /* 60 */ S(SK), S(LL)|XA, S(LL)|XA, S(LL)|XA,
+    /* 64 */ S(LL)|XA, S(LL)|XA, S(LL)|XA, S(LL),
+    /* 68 */ S(LL), S(LL), S(LL), S(LL),
+    /* 6c */ S(LL), S(LL), S(LL), S(LL),
+    /* 70 */ S(LL), S(LL), S(LL), S(LL),
+    /* 74 */ S(LL), S(LL), S(LL), S(LL),
+    /* 78 */ S(LL), S(LL), S(LL), S(PS),
+    /* 7c */ S(SM), S(PE), S(SM), S(CC),
+};
+#undef S
+#undef HT
+#undef VS
+#undef DI
+#undef XA
 
-#define cutext_wctype_singleton(cat) (UINT64_C(1) << (cat))
-
-#define CUTEXT_WCTYPE_UPPER	( cutext_wctype_singleton(CUTEXT_WCCAT_LU) \
-				| cutext_wctype_singleton(CUTEXT_WCCAT_LT) )
-#define CUTEXT_WCTYPE_LOWER	( cutext_wctype_singleton(CUTEXT_WCCAT_LL) )
-#define CUTEXT_WCTYPE_ALPHA	( CUTEXT_WCTYPE_UPPER | CUTEXT_WCTYPE_LOWER \
-				| cutext_wctype_singleton(CUTEXT_WCCAT_LM) \
-				| cutext_wctype_singleton(CUTEXT_WCCAT_LO) )
-#define CUTEXT_WCTYPE_NUMBER	( cutext_wctype_singleton(CUTEXT_WCCAT_ND) \
-				| cutext_wctype_singleton(CUTEXT_WCCAT_NL) \
-				| cutext_wctype_singleton(CUTEXT_WCCAT_NO) )
-#define CUTEXT_WCTYPE_MARK	( cutext_wctype_singleton(CUTEXT_WCCAT_MN) \
-				| cutext_wctype_singleton(CUTEXT_WCCAT_MC) \
-				| cutext_wctype_singleton(CUTEXT_WCCAT_ME) )
-#define CUTEXT_WCTYPE_ALNUM	( CUTEXT_WCTYPE_ALPHA | CUTEXT_WCTYPE_NUMBER )
-#define CUTEXT_WCTYPE_BLANK	( cutext_wctype_singleton(CUTEXT_WCCAT_ZS) )
-#define CUTEXT_WCTYPE_SPACE	( CUTEXT_WCTYPE_BLANK \
-				| cutext_wctype_singleton(CUTEXT_WCCAT_ZL) \
-				| cutext_wctype_singleton(CUTEXT_WCCAT_ZP) )
-#define CUTEXT_WCTYPE_PUNCT	( cutext_wctype_singleton(CUTEXT_WCCAT_PC) \
-				| cutext_wctype_singleton(CUTEXT_WCCAT_PD) \
-				| cutext_wctype_singleton(CUTEXT_WCCAT_PS) \
-				| cutext_wctype_singleton(CUTEXT_WCCAT_PE) \
-				| cutext_wctype_singleton(CUTEXT_WCCAT_PI) \
-				| cutext_wctype_singleton(CUTEXT_WCCAT_PF) \
-				| cutext_wctype_singleton(CUTEXT_WCCAT_PO) \
-				| cutext_wctype_singleton(CUTEXT_WCCAT_SM) \
-				| cutext_wctype_singleton(CUTEXT_WCCAT_SC) \
-				| cutext_wctype_singleton(CUTEXT_WCCAT_SK) \
-				| cutext_wctype_singleton(CUTEXT_WCCAT_SO) )
-
-#define CUTEXT_WCTYPE_GRAPH	( CUTEXT_WCTYPE_ALNUM | CUTEXT_WCTYPE_PUNCT )
-#define CUTEXT_WCTYPE_PRINT	( CUTEXT_WCTYPE_GRAPH | CUTEXT_WCTYPE_SPACE )
-#define CUTEXT_WCTYPE_CNTRL	( cutext_wctype_singleton(CUTEXT_WCCAT_CC) )
-
-/* NOTE. The "mark" and some of the "other" categories are not included in
- * either cntrl or print. */
+CU_SINLINE cu_bool_t
+_wc_has_wctype(cu_wint_t wc, cutext_wctype_t wctype)
+{
+    if (wc < 0x80)
+	return !!(_ascii_wctype[wc] & wctype);
+    else
+	return !!(cutext_wctype_singleton(cutext_wchar_wccat(wc)) & wctype);
+}
 
 cu_bool_t
-cutext_iswxdigit(cu_wint_t wc)
+cutext_iswctype(cu_wint_t wc, cutext_wctype_t wctype)
 {
-    return cutext_iswdigit(wc)
-	|| (0x41 <= wc && wc <= 0x46)
-	|| (0x61 <= wc && wc <= 0x66);
+    return _wc_has_wctype(wc, wctype);
 }
 
-cu_bool_t
-cutext_iswblank(cu_wint_t wc)
+/* Returns the length of the initial segment of arr[0 .. len - 1] for which
+ * membership in wctype equals want.  Runs in typical text are short, so a
+ * tight loop over _ascii_wctype beats block-wise SIMD tests, as the latter
+ * still needs a table lookup per character. */
+CU_SINLINE size_t
+_wcs_span(cu_wchar_t const *arr, size_t len, cutext_wctype_t wctype,
+	  unsigned int want)
 {
-    cutext_wccat_t cat = cutext_wchar_wccat(wc);
-    return !!(cutext_wctype_singleton(cat) & CUTEXT_WCTYPE_BLANK)
-	|| 0x9 == wc;
+    size_t i;
+    for (i = 0; i < len; ++i)
+	if (_wc_has_wctype(arr[i], wctype) != want)
+	    return i;
+    return len;
 }
 
-cu_bool_t
-cutext_iswspace(cu_wint_t wc)
+size_t
+cutext_wcsspn_wctype(cu_wchar_t const *arr, size_t len,
+		     cutext_wctype_t wctype)
+{
+    return _wcs_span(arr, len, wctype, 1);
+}
+
+size_t
+cutext_wcscspn_wctype(cu_wchar_t const *arr, size_t len,
+		      cutext_wctype_t wctype)
 {
-    cutext_wccat_t cat = cutext_wchar_wccat(wc);
-    return !!(cutext_wctype_singleton(cat) & CUTEXT_WCTYPE_SPACE)
-	|| (0x9 <= wc && wc <= 0xd);
+    return _wcs_span(arr, len, wctype, 0);
 }
 
 #define DEF_ISX(fn, wctype) \
     cu_bool_t \
     fn(cu_wint_t wc) \
     { \
-	cutext_wccat_t cat = cutext_wchar_wccat(wc); \
-	return !!(cutext_wctype_singleton(cat) & wctype); \
+	return _wc_has_wctype(wc, wctype); \
     }
 
 DEF_ISX(cutext_iswalnum, CUTEXT_WCTYPE_ALNUM)
 DEF_ISX(cutext_iswalpha, CUTEXT_WCTYPE_ALPHA)
+DEF_ISX(cutext_iswblank, CUTEXT_WCTYPE_BLANK)
 DEF_ISX(cutext_iswcntrl, CUTEXT_WCTYPE_CNTRL)
 DEF_ISX(cutext_iswgraph, CUTEXT_WCTYPE_GRAPH)
 DEF_ISX(cutext_iswlower, CUTEXT_WCTYPE_LOWER)
 DEF_ISX(cutext_iswprint, CUTEXT_WCTYPE_PRINT)
 DEF_ISX(cutext_iswpunct, CUTEXT_WCTYPE_PUNCT)
+DEF_ISX(cutext_iswspace, CUTEXT_WCTYPE_SPACE)
 DEF_ISX(cutext_iswupper, CUTEXT_WCTYPE_UPPER)
+DEF_ISX(cutext_iswxdigit, CUTEXT_WCTYPE_XDIGIT)
@@ -18,7 +18,7 @@
 #ifndef CUTEXT_WCTYPE_H
 #define CUTEXT_WCTYPE_H
 
-#include <cu/wchar.h>
+#include <cutext/wccat.h>
 
 CU_BEGIN_DECLARATIONS
 /** \defgroup cutext_wctype_h cutext/wctype.h: Unicode Character Types
@@ -33,6 +33,83 @@ CU_BEGIN_DECLARATIONS
  ** revision.
  **/
 
+/** A set of character types, represented as a bitmask with one bit per
+ ** general category in addition to a few bits for ASCII-specific classes.
+ ** See \ref cutext_iswctype. */
+typedef uint_least64_t cutext_wctype_t;
+
+/** The \ref cutext_wctype_t containing the single general category \a cat. */
+#define cutext_wctype_singleton(cat) (UINT64_C(1) << (cat))
+
+/* The general categories do not use the values 1 to 7, so the corresponding
+ * bits are used for the C99 classes which are defined in terms of ASCII
+ * codepoints. */
+#define CUTEXTP_WCTYPE_HT	(UINT64_C(1) << 1) /* U+0009 */
+#define CUTEXTP_WCTYPE_VSPACE	(UINT64_C(1) << 2) /* U+000A to U+000D */
+#define CUTEXTP_WCTYPE_DIGIT	(UINT64_C(1) << 3) /* U+0030 to U+0039 */
+#define CUTEXTP_WCTYPE_XALPHA	(UINT64_C(1) << 4) /* A to F and a to f */
+
+#define CUTEXT_WCTYPE_UPPER	( cutext_wctype_singleton(CUTEXT_WCCAT_LU) \
+				| cutext_wctype_singleton(CUTEXT_WCCAT_LT) )
+#define CUTEXT_WCTYPE_LOWER	( cutext_wctype_singleton(CUTEXT_WCCAT_LL) )
+#define CUTEXT_WCTYPE_ALPHA	( CUTEXT_WCTYPE_UPPER | CUTEXT_WCTYPE_LOWER \
+				| cutext_wctype_singleton(CUTEXT_WCCAT_LM) \
+				| cutext_wctype_singleton(CUTEXT_WCCAT_LO) )
+#define CUTEXT_WCTYPE_NUMBER	( cutext_wctype_singleton(CUTEXT_WCCAT_ND) \
+				| cutext_wctype_singleton(CUTEXT_WCCAT_NL) \
+				| cutext_wctype_singleton(CUTEXT_WCCAT_NO) )
+#define CUTEXT_WCTYPE_MARK	( cutext_wctype_singleton(CUTEXT_WCCAT_MN) \
+				| cutext_wctype_singleton(CUTEXT_WCCAT_MC) \
+				| cutext_wctype_singleton(CUTEXT_WCCAT_ME) )
+#define CUTEXT_WCTYPE_ALNUM	( CUTEXT_WCTYPE_ALPHA | CUTEXT_WCTYPE_NUMBER )
+#define CUTEXT_WCTYPE_SEPARATOR	( cutext_wctype_singleton(CUTEXT_WCCAT_ZS) \
+				| cutext_wctype_singleton(CUTEXT_WCCAT_ZL) \
+				| cutext_wctype_singleton(CUTEXT_WCCAT_ZP) )
+#define CUTEXT_WCTYPE_BLANK	( cutext_wctype_singleton(CUTEXT_WCCAT_ZS) \
+				| CUTEXTP_WCTYPE_HT )
+#define CUTEXT_WCTYPE_SPACE	( CUTEXT_WCTYPE_SEPARATOR \
+				| CUTEXTP_WCTYPE_HT | CUTEXTP_WCTYPE_VSPACE )
+#define CUTEXT_WCTYPE_PUNCT	( cutext_wctype_singleton(CUTEXT_WCCAT_PC) \
+				| cutext_wctype_singleton(CUTEXT_WCCAT_PD) \
+				| cutext_wctype_singleton(CUTEXT_WCCAT_PS) \
+				| cutext_wctype_singleton(CUTEXT_WCCAT_PE) \
+				| cutext_wctype_singleton(CUTEXT_WCCAT_PI) \
+				| cutext_wctype_singleton(CUTEXT_WCCAT_PF) \
+				| cutext_wctype_singleton(CUTEXT_WCCAT_PO) \
+				| cutext_wctype_singleton(CUTEXT_WCCAT_SM) \
+				| cutext_wctype_singleton(CUTEXT_WCCAT_SC) \
+				| cutext_wctype_singleton(CUTEXT_WCCAT_SK) \
+				| cutext_wctype_singleton(CUTEXT_WCCAT_SO) )
+#define CUTEXT_WCTYPE_GRAPH	( CUTEXT_WCTYPE_ALNUM | CUTEXT_WCTYPE_PUNCT )
+#define CUTEXT_WCTYPE_PRINT	( CUTEXT_WCTYPE_GRAPH \
+				| CUTEXT_WCTYPE_SEPARATOR )
+#define CUTEXT_WCTYPE_CNTRL	( cutext_wctype_singleton(CUTEXT_WCCAT_CC) )
+#define CUTEXT_WCTYPE_DIGIT	( CUTEXTP_WCTYPE_DIGIT )
+#define CUTEXT_WCTYPE_XDIGIT	( CUTEXTP_WCTYPE_DIGIT \
+				| CUTEXTP_WCTYPE_XALPHA )
+
+/* NOTE. The "mark" and some of the "other" categories are not included in
+ * either cntrl or print. */
+
+/** True iff \a wc has one of the types in \a wctype.  The \c cutext_isw*
+ ** predicates are equivalent to this function with the corresponding
+ ** \c CUTEXT_WCTYPE_* mask. */
+cu_bool_t cutext_iswctype(cu_wint_t wc, cutext_wctype_t wctype);
+
+/** Returns the length of the initial segment of the \a len characters at
+ ** \a arr which has types in \a wctype, i.e. the index of the first
+ ** character which does not match, or \a len if all match.  This is meant
+ ** for lexers to skip runs of e.g. identifier characters or white space in
+ ** one call, and has a fast path for ASCII text. */
+size_t cutext_wcsspn_wctype(cu_wchar_t const *arr, size_t len,
+			    cutext_wctype_t wctype);
+
+/** Returns the length of the initial segment of the \a len characters at
+ ** \a arr which does not have types in \a wctype, i.e. the index of the
+ ** first matching character, or \a len if none match. */
+size_t cutext_wcscspn_wctype(cu_wchar_t const *arr, size_t len,
+			     cutext_wctype_t wctype);
+
 cu_bool_t cutext_iswalnum(cu_wint_t wc);
 cu_bool_t cutext_iswalpha(cu_wint_t wc);
 cu_bool_t cutext_iswblank(cu_wint_t wc);
@@ -0,0 +1,134 @@
+/* Part of the culibs project, <http://www.eideticdew.org/culibs/>.
+ * Copyright (C) 2026  Petter Urkedal <paurkedal@eideticdew.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Compares per-character classification with the bulk functions on
+ * identifier-like texts of different composition. */
+
+#include <cutext/wccat.h>
+#include <cutext/wctype.h>
+#include <cu/test.h>
+#include <cu/memory.h>
+#include <stdio.h>
+#include <time.h>
+
+#define TEXT_CNT ((size_t)1 << 22)
+#define REPEAT 16
+
+static double
+_mcps(clock_t t)
+{
+    return REPEAT*TEXT_CNT/(1e6*t/CLOCKS_PER_SEC);
+}
+
+/* Words of mean length word_len - 1 drawn from [ch_min, ch_max) with a
+ * fraction of 1/non_ascii_freq and otherwise from ASCII letters and digits,
+ * separated by single spaces. */
+static cu_wchar_t *
+_make_text(int word_len, int non_ascii_freq,
+	   cu_wchar_t ch_min, cu_wchar_t ch_max)
+{
+    cu_wchar_t *arr = cu_galloc_atomic(TEXT_CNT*sizeof(cu_wchar_t));
+    size_t i;
+    for (i = 0; i < TEXT_CNT; ++i) {
+	if (lrand48() % word_len == 0)
+	    arr[i] = ' ';
+	else if (non_ascii_freq && lrand48() % non_ascii_freq == 0)
+	    arr[i] = ch_min + lrand48() % (ch_max - ch_min);
+	else
+	    arr[i] = "abcdefghijklmnopqrstuvwxyz0123456789"[lrand48() % 36];
+    }
+    return arr;
+}
+
+static void
+_bench(char const *name, cu_wchar_t *arr)
+{
+    unsigned char *cat_arr = cu_galloc_atomic(TEXT_CNT);
+    size_t i, word_cnt0 = 0, word_cnt1 = 0;
+    unsigned int sum = 0;
+    clock_t t;
+    int r;
+
+    printf("%s\n", name);
+
+    t = -clock();
+    for (r = 0; r < REPEAT; ++r)
+	for (i = 0; i < TEXT_CNT; ++i)
+	    cat_arr[i] = cutext_wchar_wccat(arr[i]);
+    t += clock();
+    printf("    wccat, per char:  %8.1lf Mchar/s\n", _mcps(t));
+
+    t = -clock();
+    for (r = 0; r < REPEAT; ++r)
+	cutext_wcs_wccat(arr, TEXT_CNT, cat_arr);
+    t += clock();
+    printf("    wccat, bulk:      %8.1lf Mchar/s\n", _mcps(t));
+    for (i = 0; i < TEXT_CNT; ++i)
+	sum += cat_arr[i];
+
+    t = -clock();
+    for (r = 0; r < REPEAT; ++r) {
+	i = 0;
+	while (i < TEXT_CNT) {
+	    while (i < TEXT_CNT && cutext_iswspace(arr[i]))
+		++i;
+	    if (i < TEXT_CNT)
+		++word_cnt0;
+	    while (i < TEXT_CNT && cutext_iswalnum(arr[i]))
+		++i;
+	    while (i < TEXT_CNT
+		   && !cutext_iswalnum(arr[i]) && !cutext_iswspace(arr[i]))
+		++i;
+	}
+    }
+    t += clock();
+    printf("    tokenise, per char: %6.1lf Mchar/s\n", _mcps(t));
+
+    t = -clock();
+    for (r = 0; r < REPEAT; ++r) {
+	i = 0;
+	while (i < TEXT_CNT) {
+	    i += cutext_wcsspn_wctype(arr + i, TEXT_CNT - i,
+				      CUTEXT_WCTYPE_SPACE);
+	    if (i < TEXT_CNT)
+		++word_cnt1;
+	    i += cutext_wcsspn_wctype(arr + i, TEXT_CNT - i,
+				      CUTEXT_WCTYPE_ALNUM);
+	    i += cutext_wcscspn_wctype(arr + i, TEXT_CNT - i,
+				       CUTEXT_WCTYPE_ALNUM
+				       | CUTEXT_WCTYPE_SPACE);
+	}
+    }
+    t += clock();
+    printf("    tokenise, bulk:   %8.1lf Mchar/s\n", _mcps(t));
+    cu_test_assert_size_eq(word_cnt0, word_cnt1);
+    if (sum == 0)
+	printf("    (no categories)\n");
+}
+
+int
+main()
+{
+    cutext_init();
+    _bench("ASCII", _make_text(12, 0, 0, 0));
+    _bench("ASCII, long words", _make_text(64, 0, 0, 0));
+    _bench("Mostly ASCII, 1/16 Latin and Greek",
+	   _make_text(12, 16, 0xc0, 0x3d0));
+    _bench("CJK", _make_text(12, 1, 0x4e00, 0x9fa0));
+    _bench("Mixed, 1/2 up to U+10FFFF", _make_text(12, 2, 0x80, 0x10ffff));
+    return 2*!!cu_test_bug_count();
+}
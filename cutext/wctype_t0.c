@@ -36,6 +36,100 @@ struct {
 #undef D
 };
 
+#define BULK_LEN 0x2000
+
+/* Non-ASCII characters with their general category and whether they are
+ * alnum or space, as given by the Unicode character database. */
+static struct {
+    cu_wint_t ch;
+    cutext_wccat_t cat;
+    cu_bool_t is_alnum, is_space;
+} _sample_arr[] = {
+    {0x00a0, CUTEXT_WCCAT_ZS, cu_false, cu_true},	/* no-break space */
+    {0x00b7, CUTEXT_WCCAT_PO, cu_false, cu_false},	/* middle dot */
+    {0x00bd, CUTEXT_WCCAT_NO, cu_true, cu_false},	/* one half */
+    {0x00e9, CUTEXT_WCCAT_LL, cu_true, cu_false},	/* e acute */
+    {0x0301, CUTEXT_WCCAT_MN, cu_false, cu_false},	/* combining acute */
+    {0x0416, CUTEXT_WCCAT_LU, cu_true, cu_false},	/* cyrillic zhe */
+    {0x0663, CUTEXT_WCCAT_ND, cu_true, cu_false},	/* arabic-indic 3 */
+    {0x2003, CUTEXT_WCCAT_ZS, cu_false, cu_true},	/* em space */
+    {0x2014, CUTEXT_WCCAT_PD, cu_false, cu_false},	/* em dash */
+    {0x2028, CUTEXT_WCCAT_ZL, cu_false, cu_true},	/* line separator */
+    {0x2029, CUTEXT_WCCAT_ZP, cu_false, cu_true},	/* para separator */
+    {0x20ac, CUTEXT_WCCAT_SC, cu_false, cu_false},	/* euro sign */
+    {0x2163, CUTEXT_WCCAT_NL, cu_true, cu_false},	/* roman numeral 4 */
+    {0x3000, CUTEXT_WCCAT_ZS, cu_false, cu_true},	/* ideographic space */
+    {0x4e00, CUTEXT_WCCAT_LO, cu_true, cu_false},	/* CJK one */
+    {0x1d400, CUTEXT_WCCAT_LU, cu_true, cu_false},	/* math bold A */
+    {0x1f600, CUTEXT_WCCAT_SO, cu_false, cu_false},	/* grinning face */
+};
+#define SAMPLE_COUNT (sizeof(_sample_arr)/sizeof(_sample_arr[0]))
+
+/* The expected category of an ASCII character is derived from the C
+ * library, with punctuation only checked to be in CUTEXT_WCTYPE_PUNCT. */
+static cu_bool_t
+_ascii_cat_ok(int ch, cutext_wccat_t cat)
+{
+    if (isupper(ch))	return cat == CUTEXT_WCCAT_LU;
+    if (islower(ch))	return cat == CUTEXT_WCCAT_LL;
+    if (isdigit(ch))	return cat == CUTEXT_WCCAT_ND;
+    if (iscntrl(ch))	return cat == CUTEXT_WCCAT_CC;
+    if (ch == ' ')	return cat == CUTEXT_WCCAT_ZS;
+    return !!(cutext_wctype_singleton(cat) & CUTEXT_WCTYPE_PUNCT);
+}
+
+static void
+_test_bulk(int stride)
+{
+    static cu_wchar_t arr[BULK_LEN];
+    static unsigned char cat_arr[BULK_LEN];
+    static cu_bool_t is_alnum[BULK_LEN], is_space[BULK_LEN];
+    size_t i, j;
+
+    /* Mostly ASCII with sparse non-ASCII characters, in order to exercise
+     * both the block-wise and the per-character paths.  The expected
+     * classification comes from the C library for ASCII and from
+     * _sample_arr otherwise, so it is independent of the cutext tables. */
+    for (i = 0; i < BULK_LEN; ++i)
+	if (i % stride == stride - 1) {
+	    size_t k = (i/stride) % SAMPLE_COUNT;
+	    arr[i] = _sample_arr[k].ch;
+	    is_alnum[i] = _sample_arr[k].is_alnum;
+	    is_space[i] = _sample_arr[k].is_space;
+	}
+	else {
+	    arr[i] = i % 128;
+	    is_alnum[i] = !!isalnum(i % 128);
+	    is_space[i] = !!isspace(i % 128);
+	}
+
+    cutext_wcs_wccat(arr, BULK_LEN, cat_arr);
+    for (i = 0; i < BULK_LEN; ++i) {
+	cu_bool_t ok;
+	if (arr[i] < 128)
+	    ok = _ascii_cat_ok(arr[i], cat_arr[i]);
+	else
+	    ok = cat_arr[i] == _sample_arr[(i/stride) % SAMPLE_COUNT].cat;
+	if (!ok)
+	    cu_test_bugf("cutext_wcs_wccat gives unexpected category %d "
+			 "for 0x%x.", cat_arr[i], arr[i]);
+    }
+
+    for (i = 0; i < BULK_LEN; i += 7) {
+	size_t n = BULK_LEN - i;
+	size_t k_spn = cutext_wcsspn_wctype(arr + i, n, CUTEXT_WCTYPE_ALNUM);
+	size_t k_cspn = cutext_wcscspn_wctype(arr + i, n, CUTEXT_WCTYPE_SPACE);
+	for (j = 0; j < n && is_alnum[i + j]; ++j);
+	if (k_spn != j)
+	    cu_test_bugf("cutext_wcsspn_wctype at %zd gives %zd, "
+			 "expected %zd.", i, k_spn, j);
+	for (j = 0; j < n && !is_space[i + j]; ++j);
+	if (k_cspn != j)
+	    cu_test_bugf("cutext_wcscspn_wctype at %zd gives %zd, "
+			 "expected %zd.", i, k_cspn, j);
+    }
+}
+
 int
 main(int argc, char **argv)
 {
@@ -69,5 +163,8 @@ main(int argc, char **argv)
 			     cutext_wchar_wccat(ch));
 	}
     }
+    _test_bulk(37);
+    _test_bulk(5);
+    _test_bulk(1);
     return 2*!!cu_test_bug_count();
 }